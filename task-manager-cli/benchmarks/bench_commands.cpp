@@ -0,0 +1,109 @@
+// Measures one invocation of each command against a large task file, the way
+// main runs it: a fresh repository and manager, then the command. "eager"
+// loads the whole list before the command, as the manager used to on
+// construction; "lazy" leaves loading to the command.
+//
+// Usage: bench-commands [task count]
+
+#include "cli.h"
+#include "command_runner.h"
+#include "file_task_repository.h"
+#include "paged_task_repository.h"
+#include "task_manager.h"
+#include <chrono>
+#include <filesystem>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// Discards output while still paying for formatting it
+class NullBuffer : public std::streambuf {
+protected:
+    int overflow(int c) override { return c; }
+    std::streamsize xsputn(const char*, std::streamsize n) override { return n; }
+};
+
+using RepositoryFactory = std::function<std::unique_ptr<ITaskRepository>()>;
+
+// Time one command on a fresh copy of the seed file, in milliseconds
+double runCommand(const RepositoryFactory& open, const fs::path& seed, const fs::path& file,
+                  std::vector<std::string> words, bool eager) {
+    fs::copy_file(seed, file, fs::copy_options::overwrite_existing);
+
+    NullBuffer discard;
+    std::ostream out(&discard);
+    auto start = std::chrono::steady_clock::now();
+    {
+        std::unique_ptr<ITaskRepository> repository = open();
+        TaskManager manager(*repository);
+        if (eager) {
+            manager.load();
+        }
+        CLI cli;
+        Command cmd = cli.parseWords(words);
+        CommandRunner runner(manager, cli);
+        runner.execute(cmd, out);
+    }
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+void benchmark(const char* name, const RepositoryFactory& open, const fs::path& seed,
+               const fs::path& file, std::size_t count) {
+    std::cout << "\n" << name << "\n";
+    std::cout << std::left << std::setw(14) << "command" << std::right
+              << std::setw(12) << "eager ms" << std::setw(12) << "lazy ms" << "\n";
+
+    const std::vector<std::vector<std::string>> commands = {
+        {"add", "Benchmark", "task"},
+        {"complete", std::to_string(count / 2)},
+        {"list"},
+        {"clear"},
+        {"--help"},
+    };
+    for (const auto& words : commands) {
+        double eager = runCommand(open, seed, file, words, true);
+        double lazy = runCommand(open, seed, file, words, false);
+        std::cout << std::left << std::setw(14) << words[0] << std::right << std::fixed
+                  << std::setprecision(1) << std::setw(12) << eager << std::setw(12) << lazy << "\n";
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::size_t count = argc > 1 ? std::stoul(argv[1]) : 1000000;
+    fs::path dir = fs::temp_directory_path();
+
+    TaskList tasks;
+    tasks.reserve(count);
+    for (std::size_t i = 1; i <= count; i++) {
+        tasks.emplace_back(static_cast<int>(i), "Review pull request " + std::to_string(i % 1000), i % 3 == 0);
+    }
+    std::cout << count << " tasks\n";
+
+    fs::path jsonSeed = dir / "bench-commands-seed.json";
+    fs::path jsonFile = dir / "bench-commands.json";
+    FileTaskRepository(jsonSeed.string()).saveTasks(tasks);
+    benchmark("tasks.json", [&] { return std::make_unique<FileTaskRepository>(jsonFile.string()); },
+              jsonSeed, jsonFile, count);
+
+    fs::path pagedSeed = dir / "bench-commands-seed.db";
+    fs::path pagedFile = dir / "bench-commands.db";
+    PagedTaskRepository(pagedSeed.string()).saveTasks(tasks);
+    benchmark("tasks.db (paged)", [&] { return std::make_unique<PagedTaskRepository>(pagedFile.string()); },
+              pagedSeed, pagedFile, count);
+
+    for (const auto& path : {jsonSeed, jsonFile, pagedSeed, pagedFile}) {
+        fs::remove(path);
+    }
+    return 0;
+}
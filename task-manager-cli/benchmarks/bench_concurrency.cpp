@@ -0,0 +1,230 @@
+// Measures TaskManager throughput when several threads share it, as in a
+// service embedding the manager. Each thread runs a fixed number of
+// operations: lookups by ID (findTask) as reads, completions (completeTask)
+// as writes, mixed at the given read ratio. Saves are deferred, as a
+// service saves on an interval, so the numbers are those of the locking
+// and the in-memory work rather than of writing the file.
+//
+// A second table has every thread complete tasks with each change saved
+// before the call returns: directly, where each completion rewrites the
+// file, through a MutationQueue, whose writer saves once per batch, and
+// through a MutationQueue whose manager saves with an AsyncTaskRepository,
+// so the writer applies the next batch while the last one is written.
+//
+// A third has one thread completing tasks for a second while others list
+// every task over and over (forEachTask), to see whether listing holds up
+// changes: completions per second and the longest a completion took.
+//
+// Usage: bench-concurrency [task count] [operations per thread]
+
+#include "async_task_repository.h"
+#include "file_task_repository.h"
+#include "mutation_queue.h"
+#include "task_manager.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// Total operations per second of all threads, in millions
+double run(TaskManager& manager, int threads, std::size_t operations, int readPercent, int taskCount) {
+    std::vector<std::thread> workers;
+    auto start = std::chrono::steady_clock::now();
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&, t] {
+            std::mt19937 random(static_cast<std::uint32_t>(t + 1));
+            std::uniform_int_distribution<int> id(1, taskCount);
+            std::uniform_int_distribution<int> percent(0, 99);
+            for (std::size_t i = 0; i < operations; i++) {
+                if (percent(random) < readPercent) {
+                    manager.findTask(id(random));
+                } else {
+                    manager.completeTask(id(random));
+                }
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return static_cast<double>(operations) * threads / elapsed.count() / 1e6;
+}
+
+// Saved completions per second of all threads: each thread waits for its
+// change to be saved before the next
+double runSaved(TaskManager& manager, MutationQueue* queue, int threads, int operations, int taskCount) {
+    std::vector<std::thread> workers;
+    auto start = std::chrono::steady_clock::now();
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&, t] {
+            std::mt19937 random(static_cast<std::uint32_t>(t + 1));
+            std::uniform_int_distribution<int> id(1, taskCount);
+            for (int i = 0; i < operations; i++) {
+                if (queue) {
+                    queue->completeTask(id(random)).get();
+                } else {
+                    manager.completeTask(id(random));
+                }
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return static_cast<double>(operations) * threads / elapsed.count();
+}
+
+struct ListingResult {
+    double completions = 0; // Per second
+    double maxMillis = 0;   // Slowest completion
+    double listings = 0;    // Full listings per second, all threads together
+};
+
+ListingResult runListing(TaskManager& manager, int listers, int taskCount) {
+    // Everyone stops at the deadline, as a writer may not get in at all
+    auto start = std::chrono::steady_clock::now();
+    auto deadline = start + std::chrono::seconds(1);
+    std::atomic<std::size_t> listings{0};
+    std::vector<std::thread> workers;
+    for (int t = 0; t < listers; t++) {
+        workers.emplace_back([&] {
+            while (std::chrono::steady_clock::now() < deadline) {
+                std::size_t seen = 0;
+                manager.forEachTask([&](const TaskView&) {
+                    seen++;
+                });
+                if (seen > 0) {
+                    listings.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+        });
+    }
+
+    std::mt19937 random(1);
+    std::uniform_int_distribution<int> id(1, taskCount);
+    std::size_t completions = 0;
+    ListingResult result;
+    for (auto now = start; now < deadline; completions++) {
+        manager.completeTask(id(random));
+        auto done = std::chrono::steady_clock::now();
+        std::chrono::duration<double, std::milli> took = done - now;
+        result.maxMillis = std::max(result.maxMillis, took.count());
+        now = done;
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    result.completions = static_cast<double>(completions) / elapsed.count();
+    result.listings = static_cast<double>(listings.load()) / elapsed.count();
+    return result;
+}
+
+void seedFile(const fs::path& file, int taskCount) {
+    FileTaskRepository seed(file.string());
+    TaskList tasks;
+    tasks.reserve(static_cast<std::size_t>(taskCount));
+    for (int i = 1; i <= taskCount; i++) {
+        tasks.emplace_back(i, "Benchmark task " + std::to_string(i), false);
+    }
+    seed.saveTasks(tasks);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    int taskCount = argc > 1 ? std::stoi(argv[1]) : 100000;
+    std::size_t operations = argc > 2 ? std::stoul(argv[2]) : 200000;
+    const std::vector<int> threadCounts = {1, 2, 4, 8, 16, 32, 64};
+    const std::vector<int> readPercents = {100, 99, 90, 50};
+
+    fs::path file = fs::temp_directory_path() / "bench-concurrency.json";
+    seedFile(file, taskCount);
+
+    FileTaskRepository repository(file.string());
+    TaskManager manager(repository);
+    manager.setAutoSave(false);
+    manager.load();
+
+    std::cout << taskCount << " tasks, " << operations << " operations per thread, "
+              << std::thread::hardware_concurrency() << " hardware threads\n";
+    std::cout << "Million operations per second by share of reads\n";
+    std::cout << std::setw(8) << "threads";
+    for (int percent : readPercents) {
+        std::cout << std::setw(11) << (std::to_string(percent) + "% read");
+    }
+    std::cout << "\n";
+
+    for (int threads : threadCounts) {
+        std::cout << std::setw(8) << threads;
+        for (int percent : readPercents) {
+            double rate = run(manager, threads, operations, percent, taskCount);
+            std::cout << std::fixed << std::setprecision(2) << std::setw(11) << rate;
+        }
+        std::cout << "\n";
+    }
+
+    std::cout << "\nCompletions per second while other threads list all tasks\n";
+    std::cout << std::setw(8) << "listers" << std::setw(14) << "completions" << std::setw(11) << "max ms"
+              << std::setw(11) << "lists" << "\n";
+    for (int listers : {0, 1, 4, 16}) {
+        ListingResult result = runListing(manager, listers, taskCount);
+        std::cout << std::setw(8) << listers << std::fixed << std::setprecision(0) << std::setw(14)
+                  << result.completions << std::setprecision(1) << std::setw(11) << result.maxMillis
+                  << std::setw(11) << result.listings << "\n";
+    }
+
+    // Saving rewrites the whole file, so this uses a smaller one
+    constexpr int kSavedTasks = 1000;
+    constexpr int kSavedOperations = 50;
+    seedFile(file, kSavedTasks);
+    std::cout << "\nSaved completions per second (" << kSavedTasks << " tasks, "
+              << kSavedOperations << " per thread)\n";
+    std::cout << std::setw(8) << "threads" << std::setw(11) << "direct" << std::setw(11) << "queued"
+              << std::setw(11) << "batch" << std::setw(11) << "overlapped" << std::setw(11) << "batch"
+              << "\n";
+    for (int threads : threadCounts) {
+        FileTaskRepository savedRepository(file.string());
+        TaskManager saved(savedRepository);
+        saved.load();
+        double direct = runSaved(saved, nullptr, threads, kSavedOperations, kSavedTasks);
+
+        MutationQueue queue(saved);
+        double queued = runSaved(saved, &queue, threads, kSavedOperations, kSavedTasks);
+        MutationQueue::Stats stats = queue.getStats();
+        queue.stop();
+
+        AsyncTaskRepository asyncRepository(savedRepository);
+        TaskManager overlapping(savedRepository);
+        overlapping.load();
+        overlapping.setAsyncRepository(&asyncRepository);
+        MutationQueue overlappingQueue(overlapping);
+        double overlapped = runSaved(overlapping, &overlappingQueue, threads, kSavedOperations, kSavedTasks);
+        MutationQueue::Stats overlappedStats = overlappingQueue.getStats();
+        overlappingQueue.stop();
+
+        std::cout << std::setw(8) << threads << std::fixed << std::setprecision(0)
+                  << std::setw(11) << direct << std::setw(11) << queued << std::setprecision(1)
+                  << std::setw(11) << static_cast<double>(stats.mutations) / stats.batches
+                  << std::setprecision(0) << std::setw(11) << overlapped << std::setprecision(1)
+                  << std::setw(11) << static_cast<double>(overlappedStats.mutations) / overlappedStats.batches
+                  << "\n";
+    }
+
+    fs::remove(file);
+    fs::remove(file.string() + ".lock");
+    return 0;
+}
@@ -0,0 +1,114 @@
+// Measures what change notifications cost the thread making the changes.
+// Completes tasks one at a time on a manager with saving deferred, with no
+// subscribers, with a synchronous subscriber that counts events, with one
+// that spends a while on each call, and with asynchronous subscribers
+// delivering every event, or gathering them into batches over a window.
+// Prints completions per second, the handler calls made, and how long the
+// asynchronous subscribers took to catch up once the changes were done.
+//
+// Usage: bench-events [tasks] [handler work in microseconds]
+
+#include "file_task_repository.h"
+#include "task_events.h"
+#include "task_manager.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+struct Config {
+    const char* name;
+    bool subscribe;
+    TaskEventDispatcher::Settings settings;
+    bool slow;
+};
+
+void spin(std::chrono::microseconds work) {
+    auto until = std::chrono::steady_clock::now() + work;
+    while (std::chrono::steady_clock::now() < until) {
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    int count = argc > 1 ? std::stoi(argv[1]) : 200000;
+    std::chrono::microseconds work(argc > 2 ? std::stoi(argv[2]) : 5);
+    fs::path file = fs::temp_directory_path() / "bench-events.json";
+
+    fs::remove(file);
+    fs::remove(file.string() + ".lock");
+    {
+        FileTaskRepository repository(file.string());
+        TaskList tasks;
+        for (int id = 1; id <= count; id++) {
+            tasks.emplace_back(id, "Benchmark task number " + std::to_string(id), false);
+        }
+        repository.saveTasks(tasks);
+    }
+
+    TaskEventDispatcher::Settings sync;
+    TaskEventDispatcher::Settings async;
+    async.delivery = TaskEventDispatcher::Delivery::ASYNC;
+    TaskEventDispatcher::Settings windowed = async;
+    windowed.maxBatch = 256;
+    windowed.window = std::chrono::milliseconds(1);
+    std::vector<Config> configs = {
+        {"none", false, sync, false},
+        {"sync", true, sync, false},
+        {"sync slow", true, sync, true},
+        {"async", true, async, false},
+        {"async slow", true, async, true},
+        {"async batched", true, windowed, false},
+        {"async batched slow", true, windowed, true},
+    };
+
+    std::cout << count << " completions, " << work.count() << " us per slow handler call, "
+              << std::thread::hardware_concurrency() << " hardware threads\n";
+    std::cout << std::setw(20) << "subscriber" << std::setw(14) << "changes/s" << std::setw(12) << "calls"
+              << std::setw(14) << "catch-up ms" << "\n";
+    for (const Config& config : configs) {
+        FileTaskRepository repository(file.string());
+        TaskManager manager(repository);
+        manager.setAutoSave(false);
+        manager.load();
+
+        std::atomic<std::uint64_t> seen{0};
+        if (config.subscribe) {
+            bool slow = config.slow;
+            manager.subscribe([&seen, slow, work](const std::vector<TaskEvent>& batch) {
+                if (slow) {
+                    spin(work);
+                }
+                seen.fetch_add(batch.size(), std::memory_order_relaxed);
+            }, config.settings);
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        for (int id = 1; id <= count; id++) {
+            manager.completeTask(id);
+        }
+        auto changed = std::chrono::steady_clock::now();
+        manager.flushEvents();
+        auto caughtUp = std::chrono::steady_clock::now();
+
+        std::chrono::duration<double> elapsed = changed - start;
+        std::chrono::duration<double, std::milli> catchUp = caughtUp - changed;
+        std::cout << std::setw(20) << config.name << std::fixed << std::setprecision(0) << std::setw(14)
+                  << count / elapsed.count() << std::setw(12) << manager.getEventStats().batches
+                  << std::setprecision(1) << std::setw(14) << catchUp.count() << "\n";
+    }
+
+    fs::remove(file);
+    fs::remove(file.string() + ".lock");
+    return 0;
+}
@@ -0,0 +1,128 @@
+// Measures durable adds: every thread adds tasks to one manager, each call
+// returning once its task is synced to the device. Without durability the
+// add returns once written; with it, callers share syncs, gathering others
+// for the commit window or until a batch is pending. Reports throughput,
+// the latency callers see, and how many writes each sync covered.
+//
+// Usage: bench-group-commit [adds per thread] [directory]
+// The directory (default: the system temporary directory) should be on the
+// device being measured.
+
+#include "file_task_repository.h"
+#include "task_manager.h"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+struct Setting {
+    std::string name;
+    bool durable;
+    GroupCommit::Settings commit;
+};
+
+struct Result {
+    double perSecond = 0;
+    double meanMicros = 0;
+    double p99Micros = 0;
+    double writesPerSync = 0;
+};
+
+Result run(const fs::path& file, const Setting& setting, int threads, int adds) {
+    fs::remove(file);
+    FileTaskRepository repository(file.string());
+    repository.setDurable(setting.durable, setting.commit);
+    TaskManager manager(repository);
+    manager.addTask("Seed");
+    GroupCommit::Stats before = repository.getSyncStats();
+
+    std::vector<std::vector<double>> latencies(static_cast<std::size_t>(threads));
+    std::vector<std::thread> workers;
+    auto start = std::chrono::steady_clock::now();
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&, t] {
+            auto& own = latencies[static_cast<std::size_t>(t)];
+            own.reserve(static_cast<std::size_t>(adds));
+            for (int i = 0; i < adds; i++) {
+                auto begin = std::chrono::steady_clock::now();
+                manager.addTask("Benchmark task " + std::to_string(i));
+                std::chrono::duration<double, std::micro> latency = std::chrono::steady_clock::now() - begin;
+                own.push_back(latency.count());
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    std::vector<double> all;
+    for (const auto& own : latencies) {
+        all.insert(all.end(), own.begin(), own.end());
+    }
+    std::sort(all.begin(), all.end());
+    Result result;
+    result.perSecond = static_cast<double>(all.size()) / elapsed.count();
+    for (double latency : all) {
+        result.meanMicros += latency;
+    }
+    result.meanMicros /= static_cast<double>(all.size());
+    result.p99Micros = all[all.size() * 99 / 100];
+
+    GroupCommit::Stats after = repository.getSyncStats();
+    if (after.syncs > before.syncs) {
+        result.writesPerSync = static_cast<double>(after.writes - before.writes) /
+                               static_cast<double>(after.syncs - before.syncs);
+    }
+    return result;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    int adds = argc > 1 ? std::stoi(argv[1]) : 200;
+    fs::path directory = argc > 2 ? fs::path(argv[2]) : fs::temp_directory_path();
+    fs::path file = directory / "bench-group-commit.json";
+
+    auto durable = [](std::string name, long windowMicros, std::size_t batchSize) {
+        GroupCommit::Settings commit;
+        commit.window = std::chrono::microseconds(windowMicros);
+        commit.batchSize = batchSize;
+        return Setting{std::move(name), true, commit};
+    };
+    const std::vector<Setting> settings = {
+        {"not durable", false, GroupCommit::Settings()},
+        durable("no window", 0, 64),
+        durable("100us/64", 100, 64),
+        durable("1ms/64", 1000, 64),
+        durable("1ms/8", 1000, 8),
+    };
+    const std::vector<int> threadCounts = {1, 4, 16, 64};
+
+    std::cout << adds << " adds per thread, " << std::thread::hardware_concurrency()
+              << " hardware threads, file in " << directory.string() << "\n";
+    std::cout << std::setw(8) << "threads" << std::setw(13) << "setting" << std::setw(11) << "adds/s"
+              << std::setw(11) << "mean us" << std::setw(11) << "p99 us" << std::setw(11) << "per sync"
+              << "\n";
+    for (int threads : threadCounts) {
+        for (const auto& setting : settings) {
+            Result result = run(file, setting, threads, adds);
+            std::cout << std::setw(8) << threads << std::setw(13) << setting.name << std::fixed
+                      << std::setprecision(0) << std::setw(11) << result.perSecond << std::setw(11)
+                      << result.meanMicros << std::setw(11) << result.p99Micros << std::setprecision(1)
+                      << std::setw(11) << result.writesPerSync << "\n";
+        }
+    }
+
+    fs::remove(file);
+    fs::remove(file.string() + ".lock");
+    return 0;
+}
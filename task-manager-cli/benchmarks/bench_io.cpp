@@ -0,0 +1,99 @@
+// Measures adds through each I/O backend: one thread adds tasks to a manager
+// over the JSON and the paged repository, written by std::fstream, by pwrite
+// or through io_uring, with and without durability (a sync per add, as with
+// a commit batch of one). Reports throughput, mean latency and the system
+// calls each add took to write and sync (not counted for streams).
+//
+// Usage: bench-io [adds] [directory]
+// The directory (default: the system temporary directory) should be on the
+// device being measured.
+
+#include "file_task_repository.h"
+#include "paged_task_repository.h"
+#include "repository_capabilities.h"
+#include "task_manager.h"
+#include <chrono>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+struct Result {
+    double perSecond = 0;
+    double meanMicros = 0;
+    double callsPerAdd = 0;
+};
+
+std::unique_ptr<ITaskRepository> openRepository(const fs::path& file, bool paged) {
+    if (paged) {
+        return std::make_unique<PagedTaskRepository>(file.string());
+    }
+    return std::make_unique<FileTaskRepository>(file.string());
+}
+
+Result run(const fs::path& file, bool paged, IoBackend backend, bool durable, int adds) {
+    fs::remove(file);
+    std::unique_ptr<ITaskRepository> repository = openRepository(file, paged);
+    auto* fileBacked = capabilityOf<IFileBackedRepository>(*repository);
+    fileBacked->setIoBackend(backend);
+    GroupCommit::Settings commit;
+    commit.batchSize = 1;
+    capabilityOf<IDurableRepository>(*repository)->setDurable(durable, commit);
+    TaskManager manager(*repository);
+    manager.addTask("Seed");
+    FileWriter::Stats before = fileBacked->getIoStats();
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < adds; i++) {
+        manager.addTask("Benchmark task " + std::to_string(i));
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    Result result;
+    result.perSecond = adds / elapsed.count();
+    result.meanMicros = elapsed.count() * 1e6 / adds;
+    FileWriter::Stats after = fileBacked->getIoStats();
+    result.callsPerAdd = static_cast<double>(after.systemCalls - before.systemCalls) / adds;
+    return result;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    int adds = argc > 1 ? std::stoi(argv[1]) : 2000;
+    fs::path directory = argc > 2 ? fs::path(argv[2]) : fs::temp_directory_path();
+    const std::vector<IoBackend> backends = {IoBackend::STREAM, IoBackend::PWRITE, IoBackend::IO_URING};
+
+    std::cout << adds << " adds, " << std::thread::hardware_concurrency() << " hardware threads, file in "
+              << directory.string() << "\n";
+    std::cout << std::setw(7) << "store" << std::setw(9) << "backend" << std::setw(9) << "durable"
+              << std::setw(11) << "adds/s" << std::setw(11) << "mean us" << std::setw(11) << "calls/add"
+              << "\n";
+    for (bool paged : {false, true}) {
+        fs::path file = directory / (paged ? "bench-io.db" : "bench-io.json");
+        for (bool durable : {false, true}) {
+            for (IoBackend backend : backends) {
+                Result result = run(file, paged, backend, durable, adds);
+                std::cout << std::setw(7) << (paged ? "paged" : "json") << std::setw(9) << ioBackendName(backend)
+                          << std::setw(9) << (durable ? "yes" : "no") << std::fixed << std::setprecision(0)
+                          << std::setw(11) << result.perSecond << std::setw(11) << result.meanMicros;
+                if (backend == IoBackend::STREAM) {
+                    std::cout << std::setw(11) << "-";
+                } else {
+                    std::cout << std::setprecision(1) << std::setw(11) << result.callsPerAdd;
+                }
+                std::cout << "\n";
+            }
+        }
+        fs::remove(file);
+        fs::remove(file.string() + ".lock");
+    }
+    return 0;
+}
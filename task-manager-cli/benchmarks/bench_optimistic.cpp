@@ -0,0 +1,111 @@
+// Measures optimistic saves against holding the lock from load to save.
+// Each thread plays a series of command-line invocations on one tasks.json:
+// every command opens the file afresh, as a process does, and either lists
+// the tasks or completes one, at the given share of completions. With the
+// lock held from load to save, a completion keeps readers and other writers
+// out while it reads the file; optimistically, it reads under a shared lock
+// and holds the lock alone only to write, loading again when another
+// command saved first. Prints commands per second, completions that had to
+// be made again, and the time spent waiting for the lock.
+//
+// Usage: bench-optimistic [tasks] [commands per thread] [directory]
+
+#include "file_task_repository.h"
+#include "task_manager.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+struct Result {
+    double commandsPerSecond = 0;
+    std::size_t conflicts = 0;
+    double waitMs = 0;
+};
+
+Result run(const std::string& file, bool optimistic, int threads, int commands, int writePercent, int count) {
+    std::atomic<std::size_t> conflicts{0};
+    std::atomic<std::int64_t> waitMicros{0};
+    std::vector<std::thread> workers;
+    auto start = std::chrono::steady_clock::now();
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&, t] {
+            std::mt19937 random(static_cast<std::uint32_t>(t + 1));
+            std::uniform_int_distribution<int> id(1, count);
+            std::uniform_int_distribution<int> percent(0, 99);
+            for (int i = 0; i < commands; i++) {
+                FileTaskRepository repository(file);
+                repository.setOptimistic(optimistic);
+                TaskManager manager(repository);
+                if (percent(random) < writePercent) {
+                    manager.completeTask(id(random));
+                } else {
+                    manager.listTasks();
+                }
+                conflicts += manager.getConflictCount();
+                waitMicros += static_cast<std::int64_t>(repository.getLockStats().waitSeconds * 1e6);
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    Result result;
+    result.commandsPerSecond = threads * commands / elapsed.count();
+    result.conflicts = conflicts;
+    result.waitMs = static_cast<double>(waitMicros) / 1000;
+    return result;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    int count = argc > 1 ? std::stoi(argv[1]) : 1000;
+    int commands = argc > 2 ? std::stoi(argv[2]) : 200;
+    fs::path directory = argc > 3 ? fs::path(argv[3]) : fs::temp_directory_path();
+    std::string file = (directory / "bench-optimistic.json").string();
+
+    fs::remove(file);
+    fs::remove(file + ".lock");
+    {
+        FileTaskRepository repository(file);
+        TaskList tasks;
+        for (int id = 1; id <= count; id++) {
+            tasks.emplace_back(id, "Benchmark task number " + std::to_string(id), false);
+        }
+        repository.saveTasks(tasks);
+    }
+
+    std::cout << count << " tasks, " << commands << " commands per thread, " << std::thread::hardware_concurrency()
+              << " hardware threads\n";
+    std::cout << std::setw(8) << "threads" << std::setw(9) << "writes" << std::setw(14) << "locked cmd/s"
+              << std::setw(11) << "wait ms" << std::setw(18) << "optimistic cmd/s" << std::setw(11) << "wait ms"
+              << std::setw(11) << "retried" << "\n";
+    for (int threads : {1, 2, 4, 8}) {
+        for (int writePercent : {10, 50}) {
+            Result locked = run(file, false, threads, commands, writePercent, count);
+            Result optimistic = run(file, true, threads, commands, writePercent, count);
+            std::cout << std::setw(8) << threads << std::setw(8) << writePercent << "%" << std::fixed
+                      << std::setprecision(0) << std::setw(14) << locked.commandsPerSecond << std::setprecision(1)
+                      << std::setw(11) << locked.waitMs << std::setprecision(0) << std::setw(18)
+                      << optimistic.commandsPerSecond << std::setprecision(1) << std::setw(11) << optimistic.waitMs
+                      << std::setw(11) << optimistic.conflicts << "\n";
+        }
+    }
+
+    fs::remove(file);
+    fs::remove(file + ".lock");
+    return 0;
+}
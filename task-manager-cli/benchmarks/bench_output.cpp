@@ -0,0 +1,128 @@
+// Measures printing a task list: the previous per-field iostream formatting,
+// CLI::displayTasks through OutputBuffer, and a single write() of the same
+// bytes as the I/O bound; then NDJSON through OutputBuffer against building
+// a json object per task.
+//
+// Usage: bench-output [task count] [output file]
+// The output file defaults to a temporary file; pass /dev/null to leave the
+// device out of the measurement.
+
+#include "cli.h"
+#include "task.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <nlohmann/json.hpp>
+#include <sstream>
+#include <string>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr int kRepetitions = 5;
+
+// Best wall-clock time of kRepetitions runs, in seconds
+double bestOf(const std::function<void()>& run) {
+    double best = 1e30;
+    for (int i = 0; i < kRepetitions; i++) {
+        auto start = std::chrono::steady_clock::now();
+        run();
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        best = std::min(best, elapsed.count());
+    }
+    return best;
+}
+
+// CLI::displayTask as it was: a temporary status string and five insertions per line
+void displayTaskIostream(const TaskView& task, std::ostream& out) {
+    std::string status = task.completed ? "[X]" : "[ ]";
+    out << "[" << task.id << "] " << status << " "
+        << task.description << "\n";
+}
+
+void report(const char* name, double seconds, std::size_t bytes, std::size_t tasks) {
+    std::cout << std::left << std::setw(22) << name << std::right << std::fixed
+              << std::setprecision(1) << std::setw(10) << seconds * 1000 << " ms"
+              << std::setw(10) << bytes / seconds / (1024 * 1024) << " MiB/s"
+              << std::setw(12) << std::setprecision(0) << tasks / seconds << " tasks/s\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::size_t count = argc > 1 ? std::stoul(argv[1]) : 1000000;
+    std::string path = argc > 2 ? argv[2] : (fs::temp_directory_path() / "bench-output.txt").string();
+
+    TaskList tasks;
+    tasks.reserve(count);
+    for (std::size_t i = 1; i <= count; i++) {
+        tasks.emplace_back(static_cast<int>(i), "Review pull request " + std::to_string(i % 1000), i % 3 == 0);
+    }
+
+    // The expected bytes, for the raw write and to size the report
+    std::ostringstream expected;
+    CLI cli;
+    cli.displayTasks(tasks, expected);
+    std::string bytes = expected.str();
+
+    std::cout << count << " tasks, " << bytes.size() / (1024 * 1024) << " MiB to " << path << "\n";
+
+    double iostreamTime = bestOf([&] {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        for (const auto& task : tasks) {
+            displayTaskIostream(task.view(), out);
+        }
+    });
+    report("iostream per field", iostreamTime, bytes.size(), count);
+
+    double bufferedTime = bestOf([&] {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        cli.displayTasks(tasks, out);
+    });
+    report("OutputBuffer", bufferedTime, bytes.size(), count);
+
+    double rawTime = bestOf([&] {
+        std::FILE* file = std::fopen(path.c_str(), "wb");
+        std::fwrite(bytes.data(), 1, bytes.size(), file);
+        std::fclose(file);
+    });
+    report("single write (bound)", rawTime, bytes.size(), count);
+
+    std::ostringstream expectedNdjson;
+    {
+        OutputBuffer buffer(expectedNdjson);
+        for (const auto& task : tasks) {
+            cli.displayTask(task.view(), OutputFormat::NDJSON, buffer);
+        }
+    }
+    std::size_t ndjsonBytes = expectedNdjson.str().size();
+
+    double jsonTime = bestOf([&] {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        for (const auto& task : tasks) {
+            out << task.toJson().dump() << "\n";
+        }
+    });
+    report("ndjson via json", jsonTime, ndjsonBytes, count);
+
+    double ndjsonTime = bestOf([&] {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        OutputBuffer buffer(out);
+        for (const auto& task : tasks) {
+            cli.displayTask(task.view(), OutputFormat::NDJSON, buffer);
+        }
+    });
+    report("ndjson OutputBuffer", ndjsonTime, ndjsonBytes, count);
+
+    if (argc <= 2) {
+        fs::remove(path);
+    }
+    return 0;
+}
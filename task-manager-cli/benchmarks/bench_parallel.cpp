@@ -0,0 +1,145 @@
+// Measures how bulk operations scale over the work-stealing pool: loading
+// (parsing) and saving (formatting) a large tasks.json, searching the loaded
+// tasks, and exporting them to NDJSON and importing that, with 1 (no pool)
+// to 16 threads. Reports the time of each and its speed-up over one thread.
+// The speed-up is bounded by the hardware threads printed in the first line.
+//
+// Usage: bench-parallel [tasks] [directory]
+
+#include "cli.h"
+#include "file_task_repository.h"
+#include "task_exporter.h"
+#include "task_importer.h"
+#include "task_manager.h"
+#include "work_stealing_pool.h"
+#include <chrono>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+template <typename Operation>
+double bestOfThree(Operation operation) {
+    double best = 0;
+    for (int run = 0; run < 3; run++) {
+        auto start = std::chrono::steady_clock::now();
+        operation();
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        if (run == 0 || elapsed.count() < best) {
+            best = elapsed.count();
+        }
+    }
+    return best;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    int count = argc > 1 ? std::stoi(argv[1]) : 1000000;
+    fs::path directory = argc > 2 ? fs::path(argv[2]) : fs::temp_directory_path();
+    fs::path file = directory / "bench-parallel.json";
+    fs::path imported = directory / "bench-parallel-import.json";
+    CLI cli;
+
+    TaskList tasks;
+    tasks.reserve(static_cast<std::size_t>(count));
+    for (int id = 1; id <= count; id++) {
+        tasks.emplace_back(id, "Benchmark task number " + std::to_string(id) + (id % 10 == 0 ? " urgent" : ""),
+                           id % 3 == 0);
+    }
+    fs::remove(file);
+    {
+        FileTaskRepository repository(file.string());
+        repository.saveTasks(tasks);
+    }
+
+    std::cout << count << " tasks (" << fs::file_size(file) / (1024 * 1024) << " MiB), "
+              << std::thread::hardware_concurrency() << " hardware threads\n";
+    std::cout << std::setw(8) << "threads" << std::setw(11) << "load ms" << std::setw(9) << "x" << std::setw(11)
+              << "save ms" << std::setw(9) << "x" << std::setw(11) << "search ms" << std::setw(9) << "x"
+              << std::setw(11) << "export ms" << std::setw(9) << "x" << std::setw(11) << "import ms"
+              << std::setw(9) << "x" << std::setw(10) << "stolen" << "\n";
+
+    double baseLoad = 0;
+    double baseSave = 0;
+    double baseSearch = 0;
+    double baseExport = 0;
+    double baseImport = 0;
+    for (std::size_t threads : {1, 2, 4, 8, 16}) {
+        std::unique_ptr<WorkStealingPool> pool;
+        if (threads > 1) {
+            pool = std::make_unique<WorkStealingPool>(threads);
+        }
+        FileTaskRepository repository(file.string());
+        repository.setThreadPool(pool.get());
+
+        TaskList loaded;
+        double load = bestOfThree([&] {
+            loaded = repository.loadTasks();
+        });
+        double save = bestOfThree([&] {
+            repository.saveTasks(loaded);
+        });
+
+        TaskManager manager(repository);
+        manager.setThreadPool(pool.get());
+        manager.load();
+        std::size_t found = 0;
+        double search = bestOfThree([&] {
+            found = manager.searchTasks("URGENT").size();
+        });
+        if (found != static_cast<std::size_t>(count / 10)) {
+            std::cerr << "Search found " << found << " tasks\n";
+            return 1;
+        }
+
+        std::string ndjson;
+        double exported = bestOfThree([&] {
+            std::ostringstream out;
+            TaskExporter(manager, cli).exportToStream(out, ExportFormat::NDJSON);
+            ndjson = out.str();
+        });
+        // Imported into memory, so only the parsing is timed
+        std::size_t added = 0;
+        double import = bestOfThree([&] {
+            fs::remove(imported);
+            FileTaskRepository target(imported.string());
+            TaskManager importer(target);
+            importer.setAutoSave(false);
+            importer.setThreadPool(pool.get());
+            std::istringstream in(ndjson);
+            added = TaskImporter(importer).run(in, OutputFormat::NDJSON).tasks;
+        });
+        if (added != static_cast<std::size_t>(count)) {
+            std::cerr << "Import added " << added << " tasks\n";
+            return 1;
+        }
+
+        if (threads == 1) {
+            baseLoad = load;
+            baseSave = save;
+            baseSearch = search;
+            baseExport = exported;
+            baseImport = import;
+        }
+        std::cout << std::setw(8) << threads << std::fixed << std::setprecision(1) << std::setw(11) << load
+                  << std::setw(9) << baseLoad / load << std::setw(11) << save << std::setw(9) << baseSave / save
+                  << std::setw(11) << search << std::setw(9) << baseSearch / search << std::setw(11) << exported
+                  << std::setw(9) << baseExport / exported << std::setw(11) << import << std::setw(9)
+                  << baseImport / import << std::setw(10) << (pool ? pool->getStats().stolen : 0) << "\n";
+    }
+
+    fs::remove(file);
+    fs::remove(file.string() + ".lock");
+    fs::remove(imported);
+    fs::remove(imported.string() + ".lock");
+    return 0;
+}
@@ -0,0 +1,123 @@
+// Measures sharded storage against one tasks.json: loading every task, and
+// completing and adding tasks one at a time with each change saved before
+// it returns. With shards, a change rewrites only the shard it lands in, so
+// its cost follows the shard's size rather than the whole list's. Loads read
+// the shards on a pool with a thread per hardware thread.
+//
+// Usage: bench-sharded [tasks] [changes] [directory]
+
+#include "file_task_repository.h"
+#include "sharded_task_repository.h"
+#include "repository_capabilities.h"
+#include "task_manager.h"
+#include "work_stealing_pool.h"
+#include <chrono>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+struct Layout {
+    std::string name;
+    std::size_t shards; // 0 for one tasks.json
+    ShardRouting routing;
+};
+
+struct Result {
+    double loadMs = 0;
+    double completeMs = 0;
+    double addMs = 0;
+};
+
+std::unique_ptr<ITaskRepository> open(const fs::path& directory, const Layout& layout) {
+    if (layout.shards == 0) {
+        return std::make_unique<FileTaskRepository>((directory / "bench-sharded.json").string());
+    }
+    return std::make_unique<ShardedTaskRepository>((directory / "bench-sharded").string(), layout.shards,
+                                                   layout.routing);
+}
+
+void removeFiles(const fs::path& directory) {
+    for (const auto& entry : fs::directory_iterator(directory)) {
+        if (entry.path().filename().string().rfind("bench-sharded", 0) == 0) {
+            fs::remove(entry.path());
+        }
+    }
+}
+
+double millisSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+Result run(const fs::path& directory, const Layout& layout, int count, int changes, WorkStealingPool* pool) {
+    removeFiles(directory);
+    {
+        std::unique_ptr<ITaskRepository> repository = open(directory, layout);
+        TaskList tasks;
+        for (int id = 1; id <= count; id++) {
+            tasks.emplace_back(id, "Benchmark task number " + std::to_string(id), false);
+        }
+        repository->saveTasks(tasks);
+    }
+
+    Result result;
+    std::unique_ptr<ITaskRepository> repository = open(directory, layout);
+    capabilityOf<IParallelRepository>(*repository)->setThreadPool(pool);
+    TaskManager manager(*repository);
+    auto start = std::chrono::steady_clock::now();
+    manager.load();
+    result.loadMs = millisSince(start);
+
+    std::mt19937 random(42);
+    std::uniform_int_distribution<int> ids(1, count);
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < changes; i++) {
+        manager.completeTask(ids(random));
+    }
+    result.completeMs = millisSince(start) / changes;
+
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < changes; i++) {
+        manager.addTask("Added task " + std::to_string(i));
+    }
+    result.addMs = millisSince(start) / changes;
+    return result;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    int count = argc > 1 ? std::stoi(argv[1]) : 100000;
+    int changes = argc > 2 ? std::stoi(argv[2]) : 50;
+    fs::path directory = argc > 3 ? fs::path(argv[3]) : fs::temp_directory_path();
+    WorkStealingPool pool;
+
+    const std::vector<Layout> layouts = {
+        {"one file", 0, ShardRouting::HASH},
+        {"hash/4", 4, ShardRouting::HASH},
+        {"hash/16", 16, ShardRouting::HASH},
+        {"hash/64", 64, ShardRouting::HASH},
+        {"range/16", 16, ShardRouting::RANGE},
+    };
+
+    std::cout << count << " tasks, " << changes << " changes of each kind, " << pool.getThreadCount()
+              << " pool threads, files in " << directory.string() << "\n";
+    std::cout << std::setw(10) << "layout" << std::setw(11) << "load ms" << std::setw(13) << "complete ms"
+              << std::setw(10) << "add ms" << "\n";
+    for (const auto& layout : layouts) {
+        Result result = run(directory, layout, count, changes, &pool);
+        std::cout << std::setw(10) << layout.name << std::fixed << std::setprecision(1) << std::setw(11)
+                  << result.loadMs << std::setprecision(2) << std::setw(13) << result.completeMs
+                  << std::setw(10) << result.addMs << "\n";
+    }
+    removeFiles(directory);
+    return 0;
+}
@@ -0,0 +1,136 @@
+// Measures the fixed cost of running the task-manager binary: spawns it
+// repeatedly with output discarded and reports wall-clock percentiles.
+// Commands run in an empty temporary directory, so "list" finds no tasks
+// file and measures start-up rather than loading. Given several binaries,
+// it takes turns between them run by run, so drift in the machine's load
+// over the measurement falls on all of them alike.
+//
+// Usage: bench-startup [runs] [binary...]
+// The binary defaults to the task-manager target of this build.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+extern char** environ;
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+
+#ifndef _WIN32
+
+// Spawn the binary once with stdout and stderr sent to /dev/null; returns microseconds
+double runOnce(const std::string& binary, const std::vector<std::string>& args) {
+    std::vector<char*> argv;
+    argv.push_back(const_cast<char*>(binary.c_str()));
+    for (const auto& arg : args) {
+        argv.push_back(const_cast<char*>(arg.c_str()));
+    }
+    argv.push_back(nullptr);
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+    posix_spawn_file_actions_addopen(&actions, STDERR_FILENO, "/dev/null", O_WRONLY, 0);
+
+    auto start = std::chrono::steady_clock::now();
+    pid_t pid;
+    if (posix_spawn(&pid, binary.c_str(), &actions, nullptr, argv.data(), environ) != 0) {
+        posix_spawn_file_actions_destroy(&actions);
+        throw std::runtime_error("Cannot run " + binary);
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+    std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+
+    posix_spawn_file_actions_destroy(&actions);
+    return elapsed.count();
+}
+
+void measure(const std::vector<std::string>& binaries, const std::vector<std::string>& args, int runs) {
+    // Warm the page cache and the dynamic loader's caches first
+    for (const auto& binary : binaries) {
+        for (int i = 0; i < 10; i++) {
+            runOnce(binary, args);
+        }
+    }
+
+    std::vector<std::vector<double>> samples(binaries.size());
+    for (auto& binarySamples : samples) {
+        binarySamples.reserve(static_cast<std::size_t>(runs));
+    }
+    for (int i = 0; i < runs; i++) {
+        // Start each round with the next binary, so none always runs first
+        for (std::size_t turn = 0; turn < binaries.size(); turn++) {
+            std::size_t index = (static_cast<std::size_t>(i) + turn) % binaries.size();
+            samples[index].push_back(runOnce(binaries[index], args));
+        }
+    }
+
+    std::string label;
+    for (const auto& arg : args) {
+        label += (label.empty() ? "" : " ") + arg;
+    }
+    for (std::size_t index = 0; index < binaries.size(); index++) {
+        std::vector<double>& sorted = samples[index];
+        std::sort(sorted.begin(), sorted.end());
+        auto percentile = [&sorted](double p) {
+            std::size_t at = static_cast<std::size_t>(p * static_cast<double>(sorted.size() - 1));
+            return sorted[at];
+        };
+        std::cout << std::left << std::setw(10) << label << std::right << std::setw(8) << index + 1
+                  << std::fixed << std::setprecision(0) << std::setw(10) << percentile(0.5)
+                  << std::setw(10) << percentile(0.99) << std::setw(10) << sorted.back() << "\n";
+    }
+}
+
+#endif
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+#ifdef _WIN32
+    std::cerr << "bench-startup needs posix_spawn and is not available on Windows\n";
+    return 1;
+#else
+    int runs = argc > 1 ? std::stoi(argv[1]) : 1000;
+    std::vector<std::string> binaries;
+    for (int i = 2; i < argc; i++) {
+        binaries.push_back(fs::absolute(argv[i]).string());
+    }
+    if (binaries.empty()) {
+        binaries.push_back(fs::absolute(TASK_MANAGER_BINARY).string());
+    }
+
+    // An empty working directory, so nothing is loaded or forwarded
+    fs::path dir = fs::temp_directory_path() / "bench-startup";
+    fs::create_directories(dir);
+    fs::current_path(dir);
+
+    for (std::size_t index = 0; index < binaries.size(); index++) {
+        std::cout << index + 1 << ": " << binaries[index] << "\n";
+    }
+    std::cout << runs << " runs each (microseconds)\n";
+    std::cout << std::left << std::setw(10) << "command" << std::right << std::setw(8) << "binary"
+              << std::setw(10) << "p50" << std::setw(10) << "p99" << std::setw(10) << "max" << "\n";
+    measure(binaries, {"--help"}, runs);
+    fs::remove(dir / "tasks.json");
+    measure(binaries, {"list"}, runs);
+
+    fs::current_path(fs::temp_directory_path());
+    fs::remove_all(dir);
+    return 0;
+#endif
+}
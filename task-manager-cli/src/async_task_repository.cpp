@@ -0,0 +1,135 @@
+#include "async_task_repository.h"
+#include "repository_capabilities.h"
+#include <exception>
+#include <utility>
+
+AsyncTaskRepository::AsyncTaskRepository(ITaskRepository& repository)
+    : repository(repository), stopping(false) {
+    worker = std::thread(&AsyncTaskRepository::run, this);
+}
+
+AsyncTaskRepository::~AsyncTaskRepository() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    queued.notify_one();
+    worker.join();
+}
+
+std::future<TaskList> AsyncTaskRepository::loadTasks(std::pmr::memory_resource* resource,
+                                                     StringInterner* interner) {
+    Request request;
+    request.kind = Kind::LOAD;
+    request.resource = resource;
+    request.interner = interner;
+    std::future<TaskList> result = request.loaded.get_future();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        requests.push_back(std::move(request));
+    }
+    queued.notify_one();
+    return result;
+}
+
+std::shared_future<void> AsyncTaskRepository::saveTasks(TaskList tasks) {
+    return queueSave(std::move(tasks), TaskSnapshot());
+}
+
+std::shared_future<void> AsyncTaskRepository::saveSnapshot(TaskSnapshot tasks) {
+    return queueSave(std::nullopt, std::move(tasks));
+}
+
+std::shared_future<void> AsyncTaskRepository::queueSave(std::optional<TaskList> tasks, TaskSnapshot snapshot) {
+    std::shared_future<void> result;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stats.saves++;
+        // Every save replaces the whole list, so one still waiting only
+        // needs the newer tasks; its callers hear back with this one's
+        if (!requests.empty() && requests.back().kind == Kind::SAVE) {
+            Request& waiting = requests.back();
+            waiting.tasks = std::move(tasks);
+            waiting.snapshot = std::move(snapshot);
+            return waiting.savedFuture;
+        }
+        Request request;
+        request.kind = Kind::SAVE;
+        request.tasks = std::move(tasks);
+        request.snapshot = std::move(snapshot);
+        request.savedFuture = request.saved.get_future().share();
+        result = request.savedFuture;
+        requests.push_back(std::move(request));
+    }
+    queued.notify_one();
+    return result;
+}
+
+void AsyncTaskRepository::run() {
+    for (;;) {
+        Request request;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            queued.wait(lock, [this] {
+                return !requests.empty() || stopping;
+            });
+            if (requests.empty()) {
+                return;
+            }
+            request = std::move(requests.front());
+            requests.pop_front();
+        }
+        if (request.kind == Kind::LOAD) {
+            load(request);
+        } else {
+            save(request);
+        }
+    }
+}
+
+void AsyncTaskRepository::load(Request& request) {
+    try {
+        RepositoryLockScope scope(repository, LockMode::SHARED);
+        request.loaded.set_value(repository.loadTasks(request.resource, request.interner));
+    } catch (...) {
+        request.loaded.set_exception(std::current_exception());
+    }
+}
+
+void AsyncTaskRepository::save(Request& request) {
+    std::exception_ptr error;
+    try {
+        {
+            RepositoryLockScope scope(repository, LockMode::EXCLUSIVE);
+            if (request.tasks) {
+                repository.saveTasks(*request.tasks);
+            } else {
+                repository.saveSnapshot(request.snapshot);
+            }
+        }
+        // Synced after the lock is released, as TaskManager does
+        if (auto* durable = capabilityOf<IDurableRepository>(repository)) {
+            durable->sync();
+        }
+    } catch (...) {
+        error = std::current_exception();
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stats.writes++;
+    }
+    // Unpinned before the callers hear back, so the version's owner can
+    // change it in place again
+    request.tasks.reset();
+    request.snapshot = TaskSnapshot();
+    if (error) {
+        request.saved.set_exception(error);
+    } else {
+        request.saved.set_value();
+    }
+}
+
+AsyncTaskRepository::Stats AsyncTaskRepository::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return stats;
+}
@@ -0,0 +1,76 @@
+#ifndef ASYNC_TASK_REPOSITORY_H
+#define ASYNC_TASK_REPOSITORY_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <future>
+#include <memory_resource>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include "i_async_task_repository.h"
+#include "i_task_repository.h"
+
+/**
+ * Makes any ITaskRepository asynchronous: loads and saves run in order on one
+ * I/O thread, and a queued save is replaced by the next. Nothing else may call
+ * the repository while requests are pending.
+ */
+class AsyncTaskRepository : public IAsyncTaskRepository {
+public:
+    struct Stats {
+        std::size_t saves = 0;  // Saves requested
+        std::size_t writes = 0; // Saves carried out, after merging
+    };
+
+private:
+    enum class Kind {
+        LOAD,
+        SAVE
+    };
+
+    struct Request {
+        Kind kind = Kind::LOAD;
+        std::pmr::memory_resource* resource = nullptr;
+        StringInterner* interner = nullptr;
+        std::promise<TaskList> loaded;
+        // A list to save, or else the snapshot
+        std::optional<TaskList> tasks;
+        TaskSnapshot snapshot;
+        std::promise<void> saved;
+        std::shared_future<void> savedFuture;
+    };
+
+    ITaskRepository& repository;
+    mutable std::mutex mutex;
+    std::condition_variable queued;
+    std::deque<Request> requests;
+    bool stopping;
+    Stats stats;
+    std::thread worker;
+
+    std::shared_future<void> queueSave(std::optional<TaskList> tasks, TaskSnapshot snapshot);
+    void run();
+    void load(Request& request);
+    void save(Request& request);
+
+public:
+    // Start the I/O thread; the repository must outlive the adapter
+    explicit AsyncTaskRepository(ITaskRepository& repository);
+
+    // Carry out every queued request, then stop
+    ~AsyncTaskRepository() override;
+
+    AsyncTaskRepository(const AsyncTaskRepository&) = delete;
+    AsyncTaskRepository& operator=(const AsyncTaskRepository&) = delete;
+
+    std::future<TaskList> loadTasks(std::pmr::memory_resource* resource = std::pmr::get_default_resource(),
+                                    StringInterner* interner = nullptr) override;
+    std::shared_future<void> saveTasks(TaskList tasks) override;
+    std::shared_future<void> saveSnapshot(TaskSnapshot tasks) override;
+
+    Stats getStats() const;
+};
+
+#endif // ASYNC_TASK_REPOSITORY_H
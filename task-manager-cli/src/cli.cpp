@@ -1,10 +1,96 @@
 #include "cli.h"
-#include <sstream>
+#include <cctype>
+#include <charconv>
+#include <iomanip>
 
-Command CLI::parseCommand(int argc, char* argv[]) {
-    Command cmd;
-    cmd.type = CommandType::INVALID;
-    cmd.argument = "";
+namespace {
+
+// Collect --name[=value] options from argv[first..]; the first other word
+// becomes the command argument
+void parseOptions(Command& cmd, int argc, char* argv[], int first) {
+    for (int i = first; i < argc; i++) {
+        std::string word = argv[i];
+        if (word.size() > 2 && word.compare(0, 2, "--") == 0) {
+            std::size_t equals = word.find('=');
+            if (equals == std::string::npos) {
+                cmd.options[word.substr(2)] = "";
+            } else {
+                cmd.options[word.substr(2, equals - 2)] = word.substr(equals + 1);
+            }
+        } else if (cmd.argument.empty()) {
+            cmd.argument = word;
+        }
+    }
+}
+
+// Append text with JSON string escaping: quote, backslash and control characters
+void appendJsonEscaped(std::string_view text, OutputBuffer& out) {
+    static constexpr char kHex[] = "0123456789abcdef";
+    std::size_t runStart = 0;
+    for (std::size_t i = 0; i < text.size(); i++) {
+        unsigned char c = static_cast<unsigned char>(text[i]);
+        if (c >= 0x20 && c != '"' && c != '\\') {
+            continue;
+        }
+        out.append(text.substr(runStart, i - runStart));
+        runStart = i + 1;
+        switch (c) {
+            case '"':  out.append(std::string_view("\\\"")); break;
+            case '\\': out.append(std::string_view("\\\\")); break;
+            case '\n': out.append(std::string_view("\\n")); break;
+            case '\r': out.append(std::string_view("\\r")); break;
+            case '\t': out.append(std::string_view("\\t")); break;
+            case '\b': out.append(std::string_view("\\b")); break;
+            case '\f': out.append(std::string_view("\\f")); break;
+            default: {
+                char escape[] = {'\\', 'u', '0', '0', kHex[c >> 4], kHex[c & 0xf]};
+                out.append(std::string_view(escape, sizeof(escape)));
+            }
+        }
+    }
+    out.append(text.substr(runStart));
+}
+
+// Append a CSV field, quoted (with quotes doubled) only when it needs to be
+void appendCsvField(std::string_view text, OutputBuffer& out) {
+    if (text.find_first_of(",\"\r\n") == std::string_view::npos) {
+        out.append(text);
+        return;
+    }
+    out.append('"');
+    std::size_t runStart = 0;
+    for (std::size_t quote = text.find('"'); quote != std::string_view::npos;
+         quote = text.find('"', quote + 1)) {
+        out.append(text.substr(runStart, quote + 1 - runStart));
+        out.append('"');
+        runStart = quote + 1;
+    }
+    out.append(text.substr(runStart));
+    out.append('"');
+}
+
+// Append a TSV field with tab, newline, carriage return and backslash escaped
+void appendTsvField(std::string_view text, OutputBuffer& out) {
+    std::size_t runStart = 0;
+    for (std::size_t i = text.find_first_of("\t\n\r\\"); i != std::string_view::npos;
+         i = text.find_first_of("\t\n\r\\", i + 1)) {
+        out.append(text.substr(runStart, i - runStart));
+        out.append('\\');
+        switch (text[i]) {
+            case '\t': out.append('t'); break;
+            case '\n': out.append('n'); break;
+            case '\r': out.append('r'); break;
+            default: out.append('\\');
+        }
+        runStart = i + 1;
+    }
+    out.append(text.substr(runStart));
+}
+
+} // namespace
+
+Command CLI::parseCommand(int argc, char* argv[], std::pmr::memory_resource* resource) {
+    Command cmd{CommandType::INVALID, std::pmr::string(resource), {}};
 
     if (argc < 2) {
         return cmd;
@@ -17,19 +103,36 @@ Command CLI::parseCommand(int argc, char* argv[]) {
             return cmd;
         }
         
-        // Join all arguments after "add" into a single description
-        std::stringstream ss;
+        // Join all arguments after "add" into a single description,
+        // sized up front so it takes at most one allocation
+        std::size_t length = static_cast<std::size_t>(argc - 3);
+        for (int i = 2; i < argc; i++) {
+            length += std::strlen(argv[i]);
+        }
+        cmd.argument.reserve(length);
         for (int i = 2; i < argc; i++) {
-            if (i > 2) ss << " ";
-            ss << argv[i];
+            if (i > 2) cmd.argument += ' ';
+            cmd.argument += argv[i];
         }
         
         cmd.type = CommandType::ADD;
-        cmd.argument = ss.str();
     }
     else if (command == "list") {
+        parseOptions(cmd, argc, argv, 2);
         cmd.type = CommandType::LIST;
     }
+    else if (command == "search") {
+        if (argc < 3) {
+            return cmd;
+        }
+
+        // Words after "search" form the text searched for, as with add
+        for (int i = 2; i < argc; i++) {
+            if (i > 2) cmd.argument += ' ';
+            cmd.argument += argv[i];
+        }
+        cmd.type = CommandType::SEARCH;
+    }
     else if (command == "complete") {
         if (argc < 3) {
             return cmd;
@@ -41,6 +144,38 @@ Command CLI::parseCommand(int argc, char* argv[]) {
     else if (command == "clear") {
         cmd.type = CommandType::CLEAR;
     }
+    else if (command == "batch") {
+        // Script file, or standard input when omitted or "-"
+        parseOptions(cmd, argc, argv, 2);
+        if (cmd.argument.empty()) {
+            cmd.argument = "-";
+        }
+        cmd.type = CommandType::BATCH;
+    }
+    else if (command == "import") {
+        // CSV, TSV or NDJSON file, or standard input when omitted or "-"
+        parseOptions(cmd, argc, argv, 2);
+        if (cmd.argument.empty()) {
+            cmd.argument = "-";
+        }
+        cmd.type = CommandType::IMPORT;
+    }
+    else if (command == "export") {
+        // Destination file, or standard output when omitted or "-"
+        parseOptions(cmd, argc, argv, 2);
+        if (cmd.argument.empty()) {
+            cmd.argument = "-";
+        }
+        cmd.type = CommandType::EXPORT;
+    }
+    else if (command == "serve") {
+        parseOptions(cmd, argc, argv, 2);
+        cmd.type = CommandType::SERVE;
+    }
+    else if (command == "shell") {
+        parseOptions(cmd, argc, argv, 2);
+        cmd.type = CommandType::SHELL;
+    }
     else if (command == "--help" || command == "-h") {
         cmd.type = CommandType::HELP;
     }
@@ -51,34 +186,169 @@ Command CLI::parseCommand(int argc, char* argv[]) {
     return cmd;
 }
 
+std::vector<std::string> CLI::splitCommandLine(const std::string& line) {
+    std::vector<std::string> words;
+    std::string word;
+    bool inWord = false;
+    char quote = '\0';
+
+    for (char c : line) {
+        if (quote != '\0') {
+            if (c == quote) {
+                quote = '\0';
+            } else {
+                word += c;
+            }
+        } else if (c == '"' || c == '\'') {
+            quote = c;
+            inWord = true;
+        } else if (std::isspace(static_cast<unsigned char>(c))) {
+            if (inWord) {
+                words.push_back(word);
+                word.clear();
+                inWord = false;
+            }
+        } else {
+            word += c;
+            inWord = true;
+        }
+    }
+    if (inWord) {
+        words.push_back(word);
+    }
+    return words;
+}
+
+Command CLI::parseWords(std::vector<std::string>& words, std::pmr::memory_resource* resource) {
+    std::vector<char*> argv;
+    argv.reserve(words.size() + 1);
+    argv.push_back(const_cast<char*>("task-manager"));
+    for (auto& word : words) {
+        argv.push_back(word.data());
+    }
+    return parseCommand(static_cast<int>(argv.size()), argv.data(), resource);
+}
+
 void CLI::displayHelp(std::ostream& out) {
     out << "Task Manager CLI - Simple task management\n\n";
     out << "Usage:\n";
     out << "  task-manager add <description>    Add a new task\n";
     out << "  task-manager list                  List all tasks\n";
+    out << "        [--format=text|ndjson|csv|tsv] Print in a machine-readable format\n";
+    out << "        [--follow]                   Keep printing tasks as they are added or changed\n";
+    out << "  task-manager search <text>         List tasks whose description contains text\n";
     out << "  task-manager complete <id>         Mark a task as completed\n";
     out << "  task-manager clear                 Clear all tasks\n";
+    out << "  task-manager batch [file|-]        Run one command per line from a file or stdin\n";
+    out << "        [--save-every=N]             Save every N commands instead of only at the end\n";
+    out << "  task-manager import [file|-]       Add tasks from CSV, TSV or NDJSON (new IDs)\n";
+    out << "        [--format=csv|tsv|ndjson]    Input format (detected when omitted)\n";
+    out << "  task-manager export [file|-]       Write all tasks to a file or stdout\n";
+    out << "        [--format=json|ndjson|binary] tasks.json array (default), NDJSON or tasks.db\n";
+    out << "  task-manager serve                 Keep tasks loaded and serve other invocations\n";
+    out << "  task-manager shell                 Run commands interactively against loaded tasks\n";
+    out << "        [--save-interval=MS]         Save changes every MS milliseconds (0 = immediately)\n";
+    out << "        [--timing]                   Print how long each command took\n";
     out << "  task-manager --help                Show this help message\n\n";
     out << "Examples:\n";
     out << "  task-manager add Buy groceries\n";
     out << "  task-manager list\n";
+    out << "  task-manager search groceries\n";
     out << "  task-manager complete 1\n";
     out << "  task-manager clear\n";
+    out << "  task-manager batch commands.txt\n";
+    out << "  task-manager import tasks.csv\n";
 }
 
-void CLI::displayTasks(const std::vector<Task>& tasks, std::ostream& out) {
+void CLI::displayTasks(const TaskList& tasks, std::ostream& out) {
     if (tasks.empty()) {
-        out << "No tasks found.\n";
+        displayNoTasks(out);
         return;
     }
 
+    OutputBuffer buffer(out);
     for (const auto& task : tasks) {
-        std::string status = task.isCompleted() ? "[X]" : "[ ]";
-        out << "[" << task.getId() << "] " << status << " " 
-            << task.getDescription() << "\n";
+        displayTask(task.view(), buffer);
+    }
+}
+
+void CLI::displayTask(const TaskView& task, OutputBuffer& out) {
+    out.append('[');
+    out.append(task.id);
+    out.append(task.completed ? std::string_view("] [X] ") : std::string_view("] [ ] "));
+    out.append(task.description);
+    out.append('\n');
+}
+
+std::optional<std::size_t> CLI::parseCount(std::string_view text, std::size_t min) {
+    std::size_t value = 0;
+    const char* end = text.data() + text.size();
+    auto [parsed, error] = std::from_chars(text.data(), end, value);
+    if (text.empty() || error != std::errc() || parsed != end || value < min) {
+        return std::nullopt;
+    }
+    return value;
+}
+
+std::optional<OutputFormat> CLI::parseOutputFormat(std::string_view name) {
+    if (name == "text") return OutputFormat::TEXT;
+    if (name == "ndjson") return OutputFormat::NDJSON;
+    if (name == "csv") return OutputFormat::CSV;
+    if (name == "tsv") return OutputFormat::TSV;
+    return std::nullopt;
+}
+
+void CLI::displayHeader(OutputFormat format, OutputBuffer& out) {
+    if (format == OutputFormat::CSV) {
+        out.append(std::string_view("id,description,completed\n"));
+    } else if (format == OutputFormat::TSV) {
+        out.append(std::string_view("id\tdescription\tcompleted\n"));
+    }
+}
+
+void CLI::displayTaskJson(const TaskView& task, OutputBuffer& out) {
+    out.append(std::string_view("{\"id\":"));
+    out.append(task.id);
+    out.append(std::string_view(",\"description\":\""));
+    appendJsonEscaped(task.description, out);
+    out.append(std::string_view("\",\"completed\":"));
+    out.append(std::string_view(task.completed ? "true" : "false"));
+    out.append('}');
+}
+
+void CLI::displayTask(const TaskView& task, OutputFormat format, OutputBuffer& out) {
+    std::string_view completed = task.completed ? "true" : "false";
+    switch (format) {
+        case OutputFormat::TEXT:
+            displayTask(task, out);
+            return;
+        case OutputFormat::NDJSON:
+            displayTaskJson(task, out);
+            out.append('\n');
+            return;
+        case OutputFormat::CSV:
+            out.append(task.id);
+            out.append(',');
+            appendCsvField(task.description, out);
+            out.append(',');
+            out.append(completed);
+            out.append('\n');
+            return;
+        case OutputFormat::TSV:
+            out.append(task.id);
+            out.append('\t');
+            appendTsvField(task.description, out);
+            out.append('\t');
+            out.append(completed);
+            out.append('\n');
+            return;
     }
 }
 
+void CLI::displayNoTasks(std::ostream& out) {
+    out << "No tasks found.\n";
+}
+
 void CLI::displaySuccess(const std::string& message, std::ostream& out) {
     out << message << "\n";
 }
@@ -86,3 +356,10 @@ void CLI::displaySuccess(const std::string& message, std::ostream& out) {
 void CLI::displayError(const std::string& message, std::ostream& out) {
     out << "Error: " << message << "\n";
 }
+
+void CLI::displayLockStats(const LockStats& stats, std::ostream& out) {
+    out << "Lock: " << stats.acquisitions << " acquired, " << stats.contended << " contended, "
+        << stats.timeouts << " timed out, waited " << std::fixed << std::setprecision(3)
+        << stats.waitSeconds * 1000 << " ms (max " << stats.maxWaitSeconds * 1000 << " ms)\n";
+    out.unsetf(std::ios::floatfield);
+}
@@ -2,36 +2,85 @@
 #define CLI_H
 
 #include <string>
+#include <string_view>
+#include <cstddef>
+#include <optional>
+#include <memory_resource>
 #include <vector>
+#include <map>
 #include <iostream>
 #include "task.h"
+#include "output_buffer.h"
+#include "file_lock.h"
 
 enum class CommandType {
     ADD,
     LIST,
+    SEARCH,
     COMPLETE,
     CLEAR,
+    BATCH,
+    IMPORT,
+    EXPORT,
+    SERVE,
+    SHELL,
     HELP,
     INVALID
 };
 
+// Output formats of the list command
+enum class OutputFormat {
+    TEXT,    // [id] [X] description
+    NDJSON,  // one JSON object per line
+    CSV,     // RFC 4180, with a header line
+    TSV      // tab-separated with a header line; \t \n \r \\ escaped
+};
+
 struct Command {
     CommandType type;
-    std::string argument;
+    std::pmr::string argument;
+    // Options given as --name or --name=value (empty value)
+    std::map<std::string, std::string> options;
 };
 
 class CLI {
 public:
     CLI() = default;
 
-    // Parse command-line arguments
-    Command parseCommand(int argc, char* argv[]);
+    // Parse command-line arguments; the argument string is allocated from resource
+    Command parseCommand(int argc, char* argv[],
+                         std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    // Split one line of a command script into arguments. Words are separated by
+    // whitespace; single or double quotes group words and are removed.
+    static std::vector<std::string> splitCommandLine(const std::string& line);
+
+    // Parse words split from a script line, as if they followed the program
+    // name on the command line
+    Command parseWords(std::vector<std::string>& words,
+                       std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    // A whole decimal number of at least min, as options and settings take;
+    // nothing for anything else (signs, spaces, other characters, overflow)
+    static std::optional<std::size_t> parseCount(std::string_view text, std::size_t min = 0);
 
     // Display functions
     void displayHelp(std::ostream& out = std::cout);
-    void displayTasks(const std::vector<Task>& tasks, std::ostream& out = std::cout);
+    void displayTasks(const TaskList& tasks, std::ostream& out = std::cout);
+    void displayTask(const TaskView& task, OutputBuffer& out);
+
+    // Machine-readable output; the header is the CSV/TSV column line (nothing
+    // for the other formats), and descriptions are escaped for the format
+    static std::optional<OutputFormat> parseOutputFormat(std::string_view name);
+    void displayHeader(OutputFormat format, OutputBuffer& out);
+    void displayTask(const TaskView& task, OutputFormat format, OutputBuffer& out);
+    // One JSON object with id, description and completed, without a line break
+    void displayTaskJson(const TaskView& task, OutputBuffer& out);
+    void displayNoTasks(std::ostream& out = std::cout);
     void displaySuccess(const std::string& message, std::ostream& out = std::cout);
     void displayError(const std::string& message, std::ostream& out = std::cout);
+    // One line of lock activity: acquisitions, how many waited and for how long
+    void displayLockStats(const LockStats& stats, std::ostream& out = std::cerr);
 };
 
 #endif // CLI_H
@@ -0,0 +1,266 @@
+#include "command_runner.h"
+#include "repository_exceptions.h"
+#include "task_exporter.h"
+#include "task_importer.h"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <memory_resource>
+#include <sstream>
+#include <string>
+#include <vector>
+
+CommandRunner::CommandRunner(TaskManager& manager, CLI& cli, std::istream& input)
+    : manager(manager), cli(cli), input(input) {
+}
+
+int CommandRunner::execute(Command& cmd, std::ostream& out, bool helpOnError) {
+    switch (cmd.type) {
+        case CommandType::ADD: {
+            int id = manager.addTask(std::move(cmd.argument));
+            cli.displaySuccess("Task added with ID: " + std::to_string(id), out);
+            return 0;
+        }
+
+        case CommandType::LIST: {
+            if (cmd.options.count("follow") > 0) {
+                cli.displayError("list --follow can only be started from the command line", out);
+                return 1;
+            }
+
+            OutputFormat format = OutputFormat::TEXT;
+            auto option = cmd.options.find("format");
+            if (option != cmd.options.end()) {
+                std::optional<OutputFormat> parsed = CLI::parseOutputFormat(option->second);
+                if (!parsed) {
+                    cli.displayError("Unknown format: " + option->second +
+                                     " (expected text, ndjson, csv or tsv)", out);
+                    return 1;
+                }
+                format = *parsed;
+            }
+
+            // Stream the tasks straight to the output instead of copying the list
+            std::size_t count = 0;
+            {
+                OutputBuffer buffer(out);
+                cli.displayHeader(format, buffer);
+                manager.forEachTask([&](const TaskView& task) {
+                    cli.displayTask(task, format, buffer);
+                    count++;
+                });
+            }
+            if (count == 0 && format == OutputFormat::TEXT) {
+                cli.displayNoTasks(out);
+            }
+            return 0;
+        }
+
+        case CommandType::SEARCH: {
+            cli.displayTasks(manager.searchTasks(cmd.argument), out);
+            return 0;
+        }
+
+        case CommandType::COMPLETE: {
+            int id = std::stoi(std::string(cmd.argument));
+            bool success = manager.completeTask(id);
+
+            if (success) {
+                cli.displaySuccess("Task " + std::to_string(id) + " marked as completed", out);
+                return 0;
+            }
+            cli.displayError("Task not found: " + std::to_string(id), out);
+            if (helpOnError) {
+                cli.displayHelp(out);
+            }
+            return 1;
+        }
+
+        case CommandType::CLEAR: {
+            manager.clearAllTasks();
+            cli.displaySuccess("All tasks cleared", out);
+            return 0;
+        }
+
+        case CommandType::BATCH: {
+            std::size_t saveEvery = 0;
+            auto option = cmd.options.find("save-every");
+            if (option != cmd.options.end()) {
+                std::optional<std::size_t> parsed = CLI::parseCount(option->second);
+                if (!parsed) {
+                    cli.displayError("Invalid --save-every: " + option->second, out);
+                    return 1;
+                }
+                saveEvery = *parsed;
+            }
+
+            if (cmd.argument == "-") {
+                return runBatch(input, out, saveEvery);
+            }
+            std::ifstream script{std::string(cmd.argument)};
+            if (!script.is_open()) {
+                cli.displayError("Cannot open batch file: " + std::string(cmd.argument), out);
+                return 1;
+            }
+            return runBatch(script, out, saveEvery);
+        }
+
+        case CommandType::IMPORT: {
+            std::optional<OutputFormat> format;
+            auto option = cmd.options.find("format");
+            if (option != cmd.options.end()) {
+                format = CLI::parseOutputFormat(option->second);
+                if (!format || *format == OutputFormat::TEXT) {
+                    cli.displayError("Unknown format: " + option->second +
+                                     " (expected csv, tsv or ndjson)", out);
+                    return 1;
+                }
+            }
+
+            TaskImporter importer(manager);
+            TaskImporter::Result result;
+            if (cmd.argument == "-") {
+                result = importer.run(input, format);
+            } else {
+                std::ifstream file{std::string(cmd.argument), std::ios::binary};
+                if (!file.is_open()) {
+                    cli.displayError("Cannot open import file: " + std::string(cmd.argument), out);
+                    return 1;
+                }
+                result = importer.run(file, format);
+            }
+
+            if (!result.error.empty()) {
+                cli.displayError(result.error, out);
+            }
+            std::ostringstream summary;
+            summary << "Imported " << result.tasks << " tasks";
+            if (result.tasks > 0) {
+                summary << " (IDs " << result.firstId << "-"
+                        << result.firstId + static_cast<int>(result.tasks) - 1 << ")";
+            }
+            double seconds = std::max(result.seconds, 1e-9);
+            summary << " in " << std::fixed << std::setprecision(3) << result.seconds << " s, "
+                    << std::setprecision(0) << result.tasks / seconds << " tasks/s, "
+                    << std::setprecision(1) << result.bytes / seconds / (1024 * 1024) << " MiB/s";
+            cli.displaySuccess(summary.str(), out);
+            return result.error.empty() ? 0 : 1;
+        }
+
+        case CommandType::EXPORT: {
+            ExportFormat format = ExportFormat::JSON;
+            auto option = cmd.options.find("format");
+            if (option != cmd.options.end()) {
+                std::optional<ExportFormat> parsed = TaskExporter::parseFormat(option->second);
+                if (!parsed) {
+                    cli.displayError("Unknown format: " + option->second +
+                                     " (expected json, ndjson or binary)", out);
+                    return 1;
+                }
+                format = *parsed;
+            }
+
+            TaskExporter exporter(manager, cli);
+            if (cmd.argument == "-") {
+                if (format == ExportFormat::BINARY) {
+                    cli.displayError("Binary exports need a destination file", out);
+                    return 1;
+                }
+                exporter.exportToStream(out, format);
+                return 0;
+            }
+
+            std::string path(cmd.argument);
+            TaskExporter::Result result = exporter.exportToFile(path, format);
+            std::ostringstream summary;
+            if (result.copied) {
+                summary << "Copied the tasks file to " << path;
+            } else {
+                summary << "Exported " << result.tasks << " tasks to " << path;
+            }
+            summary << " (" << std::fixed << std::setprecision(1)
+                    << static_cast<double>(result.bytes) / (1024 * 1024) << " MiB) in "
+                    << std::setprecision(3) << result.seconds << " s";
+            cli.displaySuccess(summary.str(), out);
+            return 0;
+        }
+
+        case CommandType::SERVE:
+        case CommandType::SHELL: {
+            cli.displayError("serve and shell can only be started from the command line", out);
+            return 1;
+        }
+
+        case CommandType::HELP: {
+            cli.displayHelp(out);
+            return 0;
+        }
+
+        case CommandType::INVALID:
+        default: {
+            cli.displayError("Invalid command", out);
+            if (helpOnError) {
+                cli.displayHelp(out);
+            }
+            return 1;
+        }
+    }
+}
+
+int CommandRunner::runBatch(std::istream& in, std::ostream& out, std::size_t saveEvery) {
+    // Saved at the checkpoints below; the deferral ends however the batch
+    // does, even on a repository error
+    SaveDeferral deferral(manager);
+
+    int status = 0;
+    std::size_t lineNumber = 0;
+    std::size_t executed = 0;
+    std::string line;
+    std::pmr::monotonic_buffer_resource lineArena;
+
+    while (std::getline(in, line)) {
+        lineNumber++;
+        std::vector<std::string> words = CLI::splitCommandLine(line);
+        if (words.empty() || words[0][0] == '#') {
+            continue;
+        }
+
+        // Scripts use the command-line grammar
+        Command cmd = cli.parseWords(words, &lineArena);
+        if (cmd.type == CommandType::BATCH || cmd.type == CommandType::SERVE ||
+            cmd.type == CommandType::SHELL) {
+            cli.displayError("line " + std::to_string(lineNumber) + ": " + words[0] + " cannot be nested", out);
+            status = 1;
+            continue;
+        }
+
+        try {
+            if (execute(cmd, out, false) != 0) {
+                status = 1;
+            }
+        } catch (const RepositoryException&) {
+            // The batch stops here, keeping what the lines before did
+            std::string stopped = "line " + std::to_string(lineNumber) + " stopped the batch; the changes of the " +
+                                  std::to_string(executed) + " commands before it ";
+            try {
+                manager.save();
+                cli.displayError(stopped + "are saved", out);
+            } catch (const std::exception& e) {
+                cli.displayError(stopped + "could not be saved: " + e.what(), out);
+            }
+            throw;
+        } catch (const std::exception& e) {
+            cli.displayError("line " + std::to_string(lineNumber) + ": " + e.what(), out);
+            status = 1;
+        }
+        lineArena.release();
+
+        executed++;
+        if (saveEvery > 0 && executed % saveEvery == 0) {
+            manager.save();
+        }
+    }
+
+    manager.save();
+    return status;
+}
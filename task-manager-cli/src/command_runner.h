@@ -0,0 +1,42 @@
+#ifndef COMMAND_RUNNER_H
+#define COMMAND_RUNNER_H
+
+#include <cstddef>
+#include <iostream>
+#include "cli.h"
+#include "task_manager.h"
+
+/**
+ * Executes parsed commands against a TaskManager. Shared by the one-shot
+ * command line and by modes that run many commands in one process.
+ */
+class CommandRunner {
+private:
+    TaskManager& manager;
+    CLI& cli;
+    std::istream& input;
+
+public:
+    // Constructor; input is read by commands that take "-" for standard input
+    CommandRunner(TaskManager& manager, CLI& cli, std::istream& input = std::cin);
+
+    /**
+     * Execute a parsed command
+     * @param cmd The command; its argument may be moved from
+     * @param out Stream receiving the command's output
+     * @param helpOnError Show the help text after usage errors
+     * @return Exit status (0 on success)
+     */
+    int execute(Command& cmd, std::ostream& out = std::cout, bool helpOnError = true);
+
+    /**
+     * Run newline-separated commands, written as on the command line without
+     * the program name, against the resident manager. Changes are saved every
+     * saveEvery commands (0 = never in between) and once at the end.
+     * Blank lines and lines starting with '#' are skipped.
+     * @return 0 when every command succeeded, 1 otherwise
+     */
+    int runBatch(std::istream& in, std::ostream& out = std::cout, std::size_t saveEvery = 0);
+};
+
+#endif // COMMAND_RUNNER_H
@@ -0,0 +1,20 @@
+#include "deferred_changes.h"
+
+DeferredChanges::DeferredChanges() : conflicts(0), retrying(false) {
+}
+
+void DeferredChanges::record(Kind kind, int id, std::string_view description, bool completed) {
+    // Nothing before a clear needs making again
+    if (kind == Kind::CLEAR) {
+        changes.clear();
+    }
+    changes.push_back(Change{kind, id, std::string(description), completed});
+}
+
+void DeferredChanges::clear() {
+    changes.clear();
+}
+
+std::size_t DeferredChanges::getConflictCount() const {
+    return conflicts;
+}
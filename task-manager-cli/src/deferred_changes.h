@@ -0,0 +1,102 @@
+#ifndef DEFERRED_CHANGES_H
+#define DEFERRED_CHANGES_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "repository_exceptions.h"
+
+/**
+ * Changes whose saves are deferred, made again (with new IDs for adds) on
+ * fresh tasks when a save finds another writer saved first.
+ */
+class DeferredChanges {
+public:
+    // Saves that conflict are tried again until this many have failed
+    static constexpr std::size_t kMaxAttempts = 8;
+
+    enum class Kind { ADD, COMPLETE, CLEAR };
+
+private:
+    struct Change {
+        Kind kind;
+        int id;                  // Task completed
+        std::string description; // Task added
+        bool completed;          // Whether the task was added completed
+    };
+
+    std::vector<Change> changes;
+    // Saves that found another writer had saved first
+    std::size_t conflicts;
+    // Whether an attempt is being tried, and tried again on conflict
+    bool retrying;
+
+public:
+    DeferredChanges();
+
+    // Keep a change until clear(); nothing before a clear is kept
+    void record(Kind kind, int id, std::string_view description = {}, bool completed = false);
+
+    // Forget the changes, once saved or undone
+    void clear();
+
+    /**
+     * Make the changes again, in order
+     * @param add Called with each added task's description and completion
+     * @param complete Called with each completed task's ID
+     * @param clearTasks Called for each clear
+     */
+    template <typename Add, typename Complete, typename Clear>
+    void replay(Add add, Complete complete, Clear clearTasks) const {
+        for (const auto& change : changes) {
+            switch (change.kind) {
+                case Kind::ADD:
+                    add(change.description, change.completed);
+                    break;
+                case Kind::COMPLETE:
+                    complete(change.id);
+                    break;
+                case Kind::CLEAR:
+                    clearTasks();
+                    break;
+            }
+        }
+    }
+
+    /**
+     * Run attempt, and while it conflicts, rebase and run it again, up to
+     * kMaxAttempts times. An attempt nested in another runs once and is
+     * tried again by the outer one.
+     * @throws ConflictException once the last attempt conflicted
+     */
+    template <typename Attempt, typename Rebase>
+    auto retry(Attempt attempt, Rebase rebase) {
+        if (retrying) {
+            return attempt();
+        }
+        retrying = true;
+        struct Reset {
+            bool& flag;
+            ~Reset() {
+                flag = false;
+            }
+        } reset{retrying};
+
+        for (std::size_t attempts = 1;; attempts++) {
+            try {
+                return attempt();
+            } catch (const ConflictException&) {
+                conflicts++;
+                if (attempts == kMaxAttempts) {
+                    throw;
+                }
+                rebase();
+            }
+        }
+    }
+
+    std::size_t getConflictCount() const;
+};
+
+#endif // DEFERRED_CHANGES_H
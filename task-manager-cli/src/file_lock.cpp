@@ -0,0 +1,261 @@
+#include "file_lock.h"
+#include "repository_exceptions.h"
+#include "error_logger.h"
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// Back-off between attempts while another process holds the lock: short at
+// first, as most holders only write one file, growing for long imports
+constexpr std::chrono::milliseconds kFirstRetryDelay{1};
+constexpr std::chrono::milliseconds kMaxRetryDelay{32};
+
+// The counter is written as fixed-width decimal text at the start of the
+// lock file, so a smaller value overwrites a larger one whole
+constexpr std::size_t kCounterDigits = 20;
+
+std::string formatCounter(std::uint64_t value) {
+    std::string digits = std::to_string(value);
+    return std::string(kCounterDigits - digits.size(), '0') + digits;
+}
+
+std::uint64_t parseCounter(const char* text, std::size_t size) {
+    std::uint64_t value = 0;
+    for (std::size_t i = 0; i < size && text[i] >= '0' && text[i] <= '9'; i++) {
+        value = value * 10 + static_cast<std::uint64_t>(text[i] - '0');
+    }
+    return value;
+}
+
+} // namespace
+
+FileLock::FileLock(std::string path, std::chrono::milliseconds timeout)
+    : path(std::move(path)), timeout(timeout),
+#ifdef _WIN32
+      handle(INVALID_HANDLE_VALUE),
+#else
+      fd(-1),
+#endif
+      mode(LockMode::SHARED), depth(0) {
+}
+
+FileLock::~FileLock() {
+    if (depth > 0) {
+        release();
+    }
+#ifdef _WIN32
+    if (handle != INVALID_HANDLE_VALUE) {
+        ::CloseHandle(handle);
+    }
+#else
+    if (fd >= 0) {
+        ::close(fd);
+    }
+#endif
+}
+
+#ifdef _WIN32
+
+void FileLock::openFile() {
+    if (handle != INVALID_HANDLE_VALUE) {
+        return;
+    }
+    handle = ::CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE,
+                           FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                           nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (handle == INVALID_HANDLE_VALUE) {
+        std::string errorMsg = "Cannot open lock file: " + path;
+        ErrorLogger::logError("FileLock", errorMsg);
+        throw FileIOException(errorMsg);
+    }
+}
+
+bool FileLock::tryLock(LockMode requested) {
+    OVERLAPPED overlapped = {};
+    DWORD flags = LOCKFILE_FAIL_IMMEDIATELY;
+    if (requested == LockMode::EXCLUSIVE) {
+        flags |= LOCKFILE_EXCLUSIVE_LOCK;
+    }
+    if (::LockFileEx(handle, flags, 0, MAXDWORD, MAXDWORD, &overlapped)) {
+        return true;
+    }
+    if (::GetLastError() == ERROR_LOCK_VIOLATION) {
+        return false;
+    }
+    std::string errorMsg = "Cannot lock " + path;
+    ErrorLogger::logError("FileLock", errorMsg);
+    throw FileIOException(errorMsg);
+}
+
+void FileLock::release() {
+    OVERLAPPED overlapped = {};
+    ::UnlockFileEx(handle, 0, MAXDWORD, MAXDWORD, &overlapped);
+}
+
+std::uint64_t FileLock::readCounter(std::size_t slot) {
+    openFile();
+    char text[kCounterDigits];
+    OVERLAPPED overlapped = {};
+    overlapped.Offset = static_cast<DWORD>(slot * kCounterDigits);
+    DWORD count = 0;
+    if (!::ReadFile(handle, text, kCounterDigits, &count, &overlapped)) {
+        return 0;
+    }
+    return parseCounter(text, count);
+}
+
+bool FileLock::writeCounter(std::uint64_t value, std::size_t slot) {
+    openFile();
+    std::string text = formatCounter(value);
+    OVERLAPPED overlapped = {};
+    overlapped.Offset = static_cast<DWORD>(slot * kCounterDigits);
+    DWORD count = 0;
+    return ::WriteFile(handle, text.data(), static_cast<DWORD>(text.size()), &count, &overlapped) &&
+           count == text.size();
+}
+
+#else
+
+void FileLock::openFile() {
+    if (fd >= 0) {
+        return;
+    }
+    fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        // flock needs no write access, so a read-only lock file will do
+        fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    }
+    if (fd < 0) {
+        std::string errorMsg = "Cannot open lock file: " + path;
+        ErrorLogger::logError("FileLock", errorMsg);
+        throw FileIOException(errorMsg);
+    }
+}
+
+bool FileLock::tryLock(LockMode requested) {
+    int operation = (requested == LockMode::EXCLUSIVE ? LOCK_EX : LOCK_SH) | LOCK_NB;
+    while (::flock(fd, operation) != 0) {
+        if (errno == EWOULDBLOCK) {
+            return false;
+        }
+        if (errno != EINTR) {
+            std::string errorMsg = "Cannot lock " + path;
+            ErrorLogger::logError("FileLock", errorMsg);
+            throw FileIOException(errorMsg);
+        }
+    }
+    return true;
+}
+
+void FileLock::release() {
+    ::flock(fd, LOCK_UN);
+}
+
+std::uint64_t FileLock::readCounter(std::size_t slot) {
+    openFile();
+    char text[kCounterDigits];
+    ssize_t count;
+    do {
+        count = ::pread(fd, text, kCounterDigits, static_cast<off_t>(slot * kCounterDigits));
+    } while (count < 0 && errno == EINTR);
+    return count > 0 ? parseCounter(text, static_cast<std::size_t>(count)) : 0;
+}
+
+bool FileLock::writeCounter(std::uint64_t value, std::size_t slot) {
+    openFile();
+    std::string text = formatCounter(value);
+    ssize_t count;
+    do {
+        count = ::pwrite(fd, text.data(), text.size(), static_cast<off_t>(slot * kCounterDigits));
+    } while (count < 0 && errno == EINTR);
+    return count == static_cast<ssize_t>(text.size());
+}
+
+#endif // _WIN32
+
+bool FileLock::lock(LockMode requested) {
+    if (depth > 0) {
+        if (requested == LockMode::EXCLUSIVE && mode == LockMode::SHARED) {
+            // Converting would let another writer in between the two locks
+            throw std::logic_error("Cannot take an exclusive lock while holding a shared one: " + path);
+        }
+        depth++;
+        return false;
+    }
+
+    openFile();
+    auto start = std::chrono::steady_clock::now();
+    auto deadline = start + timeout;
+    auto delay = kFirstRetryDelay;
+    bool waited = false;
+    while (!tryLock(requested)) {
+        auto now = std::chrono::steady_clock::now();
+        if (now >= deadline) {
+            stats.timeouts++;
+            std::chrono::duration<double> waitedFor = now - start;
+            stats.waitSeconds += waitedFor.count();
+            std::string errorMsg = "Timed out after " + std::to_string(timeout.count()) +
+                                   " ms waiting for " + path;
+            ErrorLogger::logError("FileLock", errorMsg);
+            throw LockTimeoutException(errorMsg);
+        }
+        waited = true;
+        std::this_thread::sleep_for(std::min<std::chrono::steady_clock::duration>(delay, deadline - now));
+        delay = std::min(delay * 2, kMaxRetryDelay);
+    }
+
+    stats.acquisitions++;
+    if (waited) {
+        std::chrono::duration<double> waitedFor = std::chrono::steady_clock::now() - start;
+        stats.contended++;
+        stats.waitSeconds += waitedFor.count();
+        stats.maxWaitSeconds = std::max(stats.maxWaitSeconds, waitedFor.count());
+    }
+    mode = requested;
+    depth = 1;
+    return true;
+}
+
+void FileLock::unlock() {
+    if (depth == 0) {
+        return;
+    }
+    if (--depth == 0) {
+        release();
+    }
+}
+
+std::size_t FileLock::getDepth() const {
+    return depth;
+}
+
+void FileLock::setTimeout(std::chrono::milliseconds timeout) {
+    this->timeout = timeout;
+}
+
+std::chrono::milliseconds FileLock::getTimeout() const {
+    return timeout;
+}
+
+const std::string& FileLock::getPath() const {
+    return path;
+}
+
+const LockStats& FileLock::getStats() const {
+    return stats;
+}
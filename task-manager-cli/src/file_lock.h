@@ -0,0 +1,105 @@
+#ifndef FILE_LOCK_H
+#define FILE_LOCK_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Readers share a lock; a writer holds it alone
+enum class LockMode {
+    SHARED,
+    EXCLUSIVE
+};
+
+/**
+ * Lock activity counters, to see how much processes contend for a file
+ */
+struct LockStats {
+    std::size_t acquisitions = 0; // Locks taken (nested calls are not counted)
+    std::size_t contended = 0;    // Acquisitions that had to wait for another holder
+    std::size_t timeouts = 0;     // Waits that gave up
+    double waitSeconds = 0;       // Total time spent waiting
+    double maxWaitSeconds = 0;    // Longest single wait
+};
+
+/**
+ * Advisory inter-process lock on a lock file (flock, or LockFileEx on
+ * Windows), with bounded waits and nested calls. The lock file also holds
+ * counters that repositories use for their store's generation.
+ */
+class FileLock {
+public:
+    static constexpr std::chrono::milliseconds kDefaultTimeout{10000};
+
+private:
+    std::string path;
+    std::chrono::milliseconds timeout;
+#ifdef _WIN32
+    void* handle;
+#else
+    int fd;
+#endif
+    LockMode mode;
+    std::size_t depth;
+    LockStats stats;
+
+    void openFile();
+    bool tryLock(LockMode requested);
+    void release();
+
+public:
+    // Constructor; the lock file is opened when first locked
+    explicit FileLock(std::string path, std::chrono::milliseconds timeout = kDefaultTimeout);
+    ~FileLock();
+
+    FileLock(const FileLock&) = delete;
+    FileLock& operator=(const FileLock&) = delete;
+
+    /**
+     * Take the lock, waiting at most the timeout; returns true when this call
+     * took it rather than nesting in a lock already held
+     * @throws LockTimeoutException if another holder keeps it past the timeout
+     * @throws FileIOException if the lock file cannot be opened
+     * @throws std::logic_error when asking for an exclusive lock under a shared one
+     */
+    bool lock(LockMode requested);
+
+    // Undo one lock() call, releasing the lock with the outermost one
+    void unlock();
+
+    // Number of lock() calls not yet undone
+    std::size_t getDepth() const;
+
+    // A counter kept in the lock file, 0 until first written; slots are
+    // independent counters side by side. Only call with the lock held
+    // (exclusive to write). A read-only lock file keeps its counters, and
+    // writeCounter returns false.
+    std::uint64_t readCounter(std::size_t slot = 0);
+    bool writeCounter(std::uint64_t value, std::size_t slot = 0);
+
+    void setTimeout(std::chrono::milliseconds timeout);
+    std::chrono::milliseconds getTimeout() const;
+
+    const std::string& getPath() const;
+    const LockStats& getStats() const;
+};
+
+// Holds a lock on a FileLock, repository or manager for the enclosing scope
+template <typename Lockable>
+class LockScope {
+    Lockable& target;
+
+public:
+    LockScope(Lockable& target, LockMode mode) : target(target) {
+        target.lock(mode);
+    }
+    ~LockScope() {
+        target.unlock();
+    }
+
+    LockScope(const LockScope&) = delete;
+    LockScope& operator=(const LockScope&) = delete;
+};
+
+#endif // FILE_LOCK_H
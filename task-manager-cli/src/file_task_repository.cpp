@@ -4,21 +4,341 @@
 #include <nlohmann/json.hpp>
 #include <fstream>
 #include <filesystem>
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <iterator>
+#include <string_view>
+#include <system_error>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 using json = nlohmann::json;
 namespace fs = std::filesystem;
 
+namespace {
+
+// Build a task from a dictionary-encoded entry, which references its
+// description by index into the file's "descriptions" section
+Task taskFromDictionaryEntry(const json& taskJson, const json& descriptions,
+                             const Task::allocator_type& alloc, StringInterner* interner) {
+    int id = taskJson.at("id").get<int>();
+    std::size_t index = taskJson.at("descriptionRef").get<std::size_t>();
+    std::string_view description(descriptions.at(index).get_ref<const std::string&>());
+    bool completed = taskJson.at("completed").get<bool>();
+
+    if (interner) {
+        return Task(id, description, completed, *interner, alloc);
+    }
+    return Task(id, description, completed, alloc);
+}
+
+// Finds the largest task ID of a plain-array file without building any tasks.
+// Parsing stops at an object at the top level (a dictionary-encoded file).
+class MaxIdScanner : public nlohmann::json_sax<json> {
+    int depth = 0;
+    bool idKey = false;
+
+    bool value() {
+        idKey = false;
+        return true;
+    }
+
+public:
+    int maxId = 0;
+    bool plainArray = false;
+
+    bool null() override { return value(); }
+    bool boolean(bool) override { return value(); }
+    bool number_float(number_float_t, const string_t&) override { return value(); }
+    bool string(string_t&) override { return value(); }
+    bool binary(binary_t&) override { return value(); }
+
+    bool number_integer(number_integer_t id) override {
+        if (idKey && id > maxId) {
+            maxId = static_cast<int>(id);
+        }
+        return value();
+    }
+
+    bool number_unsigned(number_unsigned_t id) override {
+        return number_integer(static_cast<number_integer_t>(id));
+    }
+
+    bool start_object(std::size_t) override {
+        return depth++ > 0;
+    }
+
+    bool end_object() override {
+        depth--;
+        return true;
+    }
+
+    bool start_array(std::size_t) override {
+        plainArray = plainArray || depth == 0;
+        depth++;
+        return true;
+    }
+
+    bool end_array() override {
+        depth--;
+        return true;
+    }
+
+    bool key(string_t& name) override {
+        idKey = depth == 2 && name == "id";
+        return true;
+    }
+
+    bool parse_error(std::size_t, const std::string&, const nlohmann::detail::exception&) override {
+        plainArray = false;
+        return false;
+    }
+};
+
+// Whole elements of the top-level array in text, split into runs of about
+// size / pieces bytes at the commas between elements; nothing when text is
+// not a single array (which parsing it whole then reports)
+std::vector<std::pair<std::size_t, std::size_t>> splitArray(const std::string& text, std::size_t pieces) {
+    std::vector<std::pair<std::size_t, std::size_t>> runs;
+    std::size_t pos = text.find_first_not_of(" \t\r\n");
+    if (pos == std::string::npos || text[pos] != '[') {
+        return runs;
+    }
+
+    std::size_t step = std::max<std::size_t>(text.size() / pieces, 1);
+    std::size_t start = pos + 1;
+    std::size_t nextSplit = start + step;
+    int depth = 0;
+    bool inString = false;
+    for (std::size_t i = start; i < text.size(); i++) {
+        char c = text[i];
+        if (inString) {
+            if (c == '\\') {
+                i++;
+            } else if (c == '"') {
+                inString = false;
+            }
+            continue;
+        }
+        switch (c) {
+            case '"':
+                inString = true;
+                break;
+            case '{':
+            case '[':
+                depth++;
+                break;
+            case '}':
+            case ']':
+                if (depth-- > 0) {
+                    break;
+                }
+                // The closing bracket; only whitespace may follow
+                if (text.find_first_not_of(" \t\r\n", i + 1) != std::string::npos) {
+                    return {};
+                }
+                runs.emplace_back(start, i);
+                return runs;
+            case ',':
+                if (depth == 0 && i >= nextSplit) {
+                    runs.emplace_back(start, i);
+                    start = i + 1;
+                    nextSplit = i + step;
+                }
+                break;
+            default:
+                break;
+        }
+    }
+    return {};
+}
+
+// A plain array an append was cut short in (by a crash, a full disk or a
+// short write), trimmed to its last whole element and closed again; empty
+// when text is not such an array. Appends return only once written, so the
+// part dropped was never reported saved.
+std::string closeTornArray(const std::string& text) {
+    std::size_t pos = text.find_first_not_of(" \t\r\n");
+    if (pos == std::string::npos || text[pos] != '[') {
+        return {};
+    }
+
+    std::size_t wholeEnd = pos + 1;
+    int depth = 0;
+    bool inString = false;
+    for (std::size_t i = pos + 1; i < text.size(); i++) {
+        char c = text[i];
+        if (inString) {
+            if (c == '\\') {
+                i++;
+            } else if (c == '"') {
+                inString = false;
+            }
+            continue;
+        }
+        if (depth > 0) {
+            if (c == '"') {
+                inString = true;
+            } else if (c == '{' || c == '[') {
+                depth++;
+            } else if ((c == '}' || c == ']') && --depth == 0) {
+                wholeEnd = i + 1;
+            }
+            continue;
+        }
+        // Between elements, where an append leaves only a comma before a
+        // record it did not finish
+        if (c == '{' || c == '[') {
+            depth++;
+        } else if (c == ']') {
+            if (text.find_first_not_of(" \t\r\n", i + 1) != std::string::npos) {
+                return {};
+            }
+            break;
+        } else if (c != ',' && !std::isspace(static_cast<unsigned char>(c))) {
+            return {};
+        }
+    }
+
+    // Anything after the whole elements must be the start of a record as
+    // appends write it; other damage is reported, not cut away
+    const std::string_view recordStart = "\n  {\"completed\":";
+    std::string_view tail(text);
+    tail.remove_prefix(wholeEnd);
+    if (!tail.empty() && tail.front() == ',') {
+        tail.remove_prefix(1);
+    }
+    if (tail.substr(0, recordStart.size()) != recordStart) {
+        // Cut short before the record's first field; a short write may
+        // leave the old closing bracket behind it
+        std::size_t end = tail.find_last_not_of(" \t\r\n]");
+        tail = tail.substr(0, end == std::string_view::npos ? 0 : end + 1);
+        if (recordStart.substr(0, tail.size()) != tail) {
+            return {};
+        }
+    }
+    return text.substr(0, wholeEnd) + "\n]";
+}
+
+// Append tasks as the elements of a JSON array pretty-printed with an
+// indent of 2, as json::dump(2) writes them
+void formatArrayElements(const Task* begin, const Task* end, std::string& out) {
+    for (const Task* task = begin; task != end; ++task) {
+        if (task != begin) {
+            out += ",\n";
+        }
+        out += "  ";
+        std::string element = task->toJson().dump(2);
+        std::size_t runStart = 0;
+        for (std::size_t newline = element.find('\n'); newline != std::string::npos;
+             newline = element.find('\n', runStart)) {
+            out.append(element, runStart, newline + 1 - runStart);
+            out += "  ";
+            runStart = newline + 1;
+        }
+        out.append(element, runStart, std::string::npos);
+    }
+}
+
+// Runs of consecutive tasks, of at most TaskVersion::kChunkSize each
+std::vector<std::pair<const Task*, const Task*>> taskRuns(const TaskList& tasks) {
+    std::vector<std::pair<const Task*, const Task*>> runs;
+    for (std::size_t begin = 0; begin < tasks.size(); begin += TaskVersion::kChunkSize) {
+        std::size_t end = std::min(tasks.size(), begin + TaskVersion::kChunkSize);
+        runs.emplace_back(tasks.data() + begin, tasks.data() + end);
+    }
+    return runs;
+}
+
+std::vector<std::pair<const Task*, const Task*>> taskRuns(const TaskSnapshot& tasks) {
+    std::vector<std::pair<const Task*, const Task*>> runs;
+    for (std::size_t index = 0; index < tasks.chunkCount(); index++) {
+        const TaskList& chunk = tasks.chunk(index);
+        runs.emplace_back(chunk.data(), chunk.data() + chunk.size());
+    }
+    return runs;
+}
+
+// The tasks as json::dump(2) writes a plain array of them, each run
+// formatted on the pool
+template <typename Tasks>
+std::string formatArray(const Tasks& tasks, WorkStealingPool* pool) {
+    std::vector<std::pair<const Task*, const Task*>> runs = taskRuns(tasks);
+    if (runs.empty()) {
+        return "[]";
+    }
+    std::vector<std::string> texts(runs.size());
+    parallelChunks(pool, runs.size(), 1, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t run = begin; run < end; run++) {
+            formatArrayElements(runs[run].first, runs[run].second, texts[run]);
+        }
+    });
+
+    std::size_t size = 4;
+    for (const auto& text : texts) {
+        size += text.size() + 2;
+    }
+    std::string out;
+    out.reserve(size);
+    out += "[\n";
+    for (std::size_t run = 0; run < texts.size(); run++) {
+        if (run > 0) {
+            out += ",\n";
+        }
+        out += texts[run];
+    }
+    out += "\n]";
+    return out;
+}
+
+// Lock file slot of the generation the file was last rewritten at by a
+// save; appends in place advance the generation but leave this
+constexpr std::size_t kRewrittenSlot = 1;
+
+// Walk back over whitespace from pos to the character before it; -1 and
+// '\0' when there is none
+std::pair<std::streamoff, char> previousNonSpace(std::istream& file, std::streamoff pos) {
+    char c = '\0';
+    while (pos > 0) {
+        file.seekg(--pos);
+        file.get(c);
+        if (!std::isspace(static_cast<unsigned char>(c))) {
+            return {pos, c};
+        }
+    }
+    return {-1, '\0'};
+}
+
+// Offset just past the last element of a plain array (or its opening
+// bracket when it is empty), or -1 unless the file ends in a bracket
+std::streamoff arrayEnd(std::istream& file, std::streamoff size) {
+    auto [closing, last] = previousNonSpace(file, size);
+    if (last != ']') {
+        return -1;
+    }
+    std::streamoff lastElement = previousNonSpace(file, closing).first;
+    return lastElement < 0 ? -1 : lastElement + 1;
+}
+
+} // namespace
+
 FileTaskRepository::FileTaskRepository(const std::string& filePath)
-    : filePath(filePath), maxId(0) {
+    : filePath(filePath), maxId(0), maxIdKnown(false), dictionaryEncoding(false),
+      fileLock(filePath + ".lock"), released(0), durable(false), commit([this] { syncFile(this->filePath); }),
+      threadPool(nullptr), generation(0), optimistic(false) {
 }
 
-std::vector<Task> FileTaskRepository::loadTasks() {
-    std::vector<Task> tasks;
+TaskList FileTaskRepository::loadTasks(std::pmr::memory_resource* resource, StringInterner* interner) {
+    LockScope scope(*this, LockMode::SHARED);
+    TaskList tasks(resource);
+    generation = fileLock.readCounter();
 
     // Check if file exists
     if (!fs::exists(filePath)) {
         try {
-            // Create empty file
+            // Create empty file (readers racing to create it all write the same)
             std::ofstream file(filePath);
             if (!file.is_open()) {
                 std::string errorMsg = "Cannot create file: " + filePath;
@@ -27,6 +347,7 @@ std::vector<Task> FileTaskRepository::loadTasks() {
             }
             file << "[]";
             file.close();
+            maxIdKnown = true;
             return tasks;
         } catch (const std::filesystem::filesystem_error& e) {
             std::string errorMsg = "Filesystem error creating file '" + filePath + "': " + e.what();
@@ -36,30 +357,104 @@ std::vector<Task> FileTaskRepository::loadTasks() {
     }
 
     // Read file
-    std::ifstream file(filePath);
+    std::ifstream file(filePath, std::ios::binary);
     if (!file.is_open()) {
         std::string errorMsg = "Cannot open file for reading: " + filePath;
         ErrorLogger::logError("loadTasks", errorMsg);
         throw FileIOException(errorMsg);
     }
 
+    auto addTasks = [&](const json& taskArray) {
+        for (const auto& taskJson : taskArray) {
+            // Parsed task is moved into place; its description is not copied again
+            const Task& task = tasks.emplace_back(Task::fromJson(taskJson, resource, interner));
+
+            // Track max ID
+            if (task.getId() > maxId) {
+                maxId = task.getId();
+            }
+        }
+    };
+
     json j;
     try {
-        file >> j;
-        
+        // A large plain array is parsed in pieces on the pool. The tasks are
+        // then built in order on this thread, as resource and interner are
+        // not shared between threads.
+        std::vector<std::pair<std::size_t, std::size_t>> runs;
+        std::string text;
+        std::error_code sizeError;
+        std::uintmax_t size = fs::file_size(filePath, sizeError);
+        if (threadPool && !sizeError && size >= kParallelLoadBytes) {
+            text.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+            runs = splitArray(text, threadPool->getThreadCount() * 4);
+        }
+
+        if (!runs.empty()) {
+            std::vector<json> pieces(runs.size());
+            parallelChunks(threadPool, runs.size(), 1, [&](std::size_t begin, std::size_t end) {
+                for (std::size_t run = begin; run < end; run++) {
+                    std::string piece;
+                    piece.reserve(runs[run].second - runs[run].first + 2);
+                    piece += '[';
+                    piece.append(text, runs[run].first, runs[run].second - runs[run].first);
+                    piece += ']';
+                    pieces[run] = json::parse(piece);
+                }
+            });
+
+            std::size_t count = 0;
+            for (const auto& piece : pieces) {
+                count += piece.size();
+            }
+            tasks.reserve(count);
+            for (const auto& piece : pieces) {
+                addTasks(piece);
+            }
+            file.close();
+            maxIdKnown = true;
+            return tasks;
+        }
+        try {
+            j = text.empty() ? json::parse(file) : json::parse(text);
+        } catch (const nlohmann::json::parse_error&) {
+            if (text.empty()) {
+                file.clear();
+                file.seekg(0);
+                text.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+            }
+            std::string closed = closeTornArray(text);
+            if (closed.empty()) {
+                throw;
+            }
+            // The next save or append writes the file whole again
+            j = json::parse(closed);
+            ErrorLogger::logError("loadTasks", "Recovered '" + filePath +
+                                  "' from an interrupted append; its unfinished last record was dropped");
+        }
+
         // Parse tasks from JSON array
         if (j.is_array()) {
-            for (const auto& taskJson : j) {
-                Task task = Task::fromJson(taskJson);
-                tasks.push_back(task);
-                
+            tasks.reserve(j.size());
+            addTasks(j);
+        } else if (j.is_object() && j.contains("descriptions") && j.contains("tasks")) {
+            // Dictionary-encoded file; keep the format on the next save
+            dictionaryEncoding = true;
+            const json& descriptions = j.at("descriptions");
+            const json& taskArray = j.at("tasks");
+
+            tasks.reserve(taskArray.size());
+            for (const auto& taskJson : taskArray) {
+                const Task& task = tasks.emplace_back(
+                    taskFromDictionaryEntry(taskJson, descriptions, resource, interner));
+
                 // Track max ID
                 if (task.getId() > maxId) {
                     maxId = task.getId();
                 }
             }
         } else {
-            std::string errorMsg = "Invalid JSON format: expected array";
+            std::string errorMsg = "Invalid JSON format: expected array or dictionary-encoded object";
             ErrorLogger::logError("loadTasks", errorMsg);
             throw JsonParseException(errorMsg);
         }
@@ -75,38 +470,121 @@ std::vector<Task> FileTaskRepository::loadTasks() {
     }
 
     file.close();
+    maxIdKnown = true;
     return tasks;
 }
 
-void FileTaskRepository::saveTasks(const std::vector<Task>& tasks) {
+void FileTaskRepository::saveTasks(const TaskList& tasks) {
+    writeTasks(tasks);
+}
+
+void FileTaskRepository::saveSnapshot(const TaskSnapshot& tasks) {
+    writeTasks(tasks);
+}
+
+template <typename Tasks>
+void FileTaskRepository::writeTasks(const Tasks& tasks) {
+    LockScope scope(*this, LockMode::EXCLUSIVE);
+    std::uint64_t current = fileLock.readCounter();
+    if (optimistic && current != generation) {
+        std::string errorMsg = "'" + filePath + "' was saved at generation " + std::to_string(current) +
+                               " since this list was loaded at generation " + std::to_string(generation);
+        // Conflicts are expected now and then and retried, so not logged
+        throw ConflictException(errorMsg);
+    }
     json j = json::array();
+    bool formatsInParallel = !dictionaryEncoding && threadPool && tasks.size() >= kParallelSaveTasks;
 
     try {
+        if (dictionaryEncoding) {
+            // Write each distinct description once and reference it by index
+            json descriptions = json::array();
+            json taskArray = json::array();
+            std::unordered_map<std::string_view, std::size_t> indexByDescription;
+            dictionaryStats = DictionaryStats{};
+
+            for (const auto& task : tasks) {
+                std::string_view description = task.getDescription();
+                auto [entry, inserted] = indexByDescription.try_emplace(description, descriptions.size());
+                if (inserted) {
+                    descriptions.push_back(description);
+                } else {
+                    dictionaryStats.savedBytes += description.size();
+                }
+
+                taskArray.push_back(json{
+                    {"id", task.getId()},
+                    {"descriptionRef", entry->second},
+                    {"completed", task.isCompleted()}
+                });
+            }
+
+            dictionaryStats.descriptions = tasks.size();
+            dictionaryStats.uniqueDescriptions = descriptions.size();
+            j = json{
+                {"descriptions", std::move(descriptions)},
+                {"tasks", std::move(taskArray)}
+            };
+        } else if (!formatsInParallel) {
+            for (const auto& task : tasks) {
+                j.push_back(task.toJson());
+            }
+        }
+
+        // Update maxId while saving
         for (const auto& task : tasks) {
-            j.push_back(task.toJson());
-            
-            // Update maxId while saving
             if (task.getId() > maxId) {
                 maxId = task.getId();
             }
         }
 
-        std::ofstream file(filePath);
-        if (!file.is_open()) {
-            std::string errorMsg = "Cannot open file for writing: " + filePath;
-            ErrorLogger::logError("saveTasks", errorMsg);
-            throw FileIOException(errorMsg);
-        }
-        
-        file << j.dump(2); // Pretty print with 2-space indent
-        
-        if (file.fail()) {
-            std::string errorMsg = "Failed to write to file: " + filePath;
-            ErrorLogger::logError("saveTasks", errorMsg);
-            throw FileIOException(errorMsg);
+        // Pretty print with 2-space indent
+        std::string text = formatsInParallel ? formatArray(tasks, threadPool) : j.dump(2);
+        // Advanced first, so a save failing part way still shows as a change
+        fileLock.writeCounter(current + 1);
+        fileLock.writeCounter(current + 1, kRewrittenSlot);
+        // Written to a temporary file renamed over the old one, so a crash or
+        // a full disk part way leaves the old file whole. A durable save
+        // syncs the new file before the rename and the directory after it.
+        std::string temporary = filePath + ".tmp";
+        try {
+            if (writer) {
+                writer->open(temporary, true);
+                writer->write(0, text.data(), text.size());
+                writer->submit(durable);
+                writer->close();
+            } else {
+                std::ofstream file(temporary);
+                if (!file.is_open()) {
+                    std::string errorMsg = "Cannot open file for writing: " + temporary;
+                    ErrorLogger::logError("saveTasks", errorMsg);
+                    throw FileIOException(errorMsg);
+                }
+
+                file << text;
+                file.close();
+
+                if (file.fail()) {
+                    std::string errorMsg = "Failed to write to file: " + temporary;
+                    ErrorLogger::logError("saveTasks", errorMsg);
+                    throw FileIOException(errorMsg);
+                }
+                if (durable) {
+                    syncFile(temporary);
+                }
+            }
+        } catch (...) {
+            if (writer) {
+                writer->close();
+            }
+            std::error_code error;
+            fs::remove(temporary, error);
+            throw;
         }
-        
-        file.close();
+        replaceFile(temporary, filePath, durable);
+        generation = current + 1;
+        maxIdKnown = true;
+        recordWrite(durable);
     } catch (const nlohmann::json::exception& e) {
         std::string errorMsg = "Failed to serialize tasks to JSON: " + std::string(e.what());
         ErrorLogger::logError("saveTasks", errorMsg);
@@ -124,4 +602,328 @@ int FileTaskRepository::getNextId() const {
 
 void FileTaskRepository::resetIdCounter() {
     maxId = 0;
+    maxIdKnown = true;
+}
+
+bool FileTaskRepository::supportsAppend() const {
+    return !dictionaryEncoding;
+}
+
+bool FileTaskRepository::scanMaxId() {
+    std::ifstream file(filePath, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    MaxIdScanner scanner;
+    if (!json::sax_parse(file, &scanner) || !scanner.plainArray) {
+        return false;
+    }
+    maxId = std::max(maxId, scanner.maxId);
+    maxIdKnown = true;
+    return true;
+}
+
+int FileTaskRepository::appendTask(std::string_view description) {
+    TaskList tasks;
+    tasks.emplace_back(0, description, false);
+    return appendTasks(tasks);
+}
+
+int FileTaskRepository::appendTasks(const TaskList& tasks) {
+    LockScope scope(*this, LockMode::EXCLUSIVE);
+    if (tasks.empty()) {
+        return maxId + 1;
+    }
+
+    // Anything but an existing, well-formed plain array takes the general path,
+    // which also reports corrupted files
+    if (dictionaryEncoding || !fs::exists(filePath) || (!maxIdKnown && !scanMaxId())) {
+        return appendByRewriting(tasks);
+    }
+
+    std::fstream file(filePath, std::ios::in | std::ios::out | std::ios::binary);
+    if (!file.is_open()) {
+        std::string errorMsg = "Cannot open file for appending: " + filePath;
+        ErrorLogger::logError("appendTasks", errorMsg);
+        throw FileIOException(errorMsg);
+    }
+
+    // Walk back over trailing whitespace to the closing bracket, then to the
+    // character before it to see whether the array is empty
+    file.seekg(0, std::ios::end);
+    std::streamoff size = file.tellg();
+    auto [closing, last] = previousNonSpace(file, size);
+    if (last != ']') {
+        file.close();
+        return appendByRewriting(tasks);
+    }
+    // Records are written right after the last element (or the opening bracket)
+    auto [lastElement, before] = previousNonSpace(file, closing);
+    if (before != '[' && before != '}') {
+        // Left by an append cut short; loading recovers it
+        file.close();
+        return appendByRewriting(tasks);
+    }
+    bool empty = before == '[';
+    std::streamoff writeAt = lastElement + 1;
+
+    // All records go out in one write
+    int first = maxId + 1;
+    int id = first;
+    std::string record;
+    try {
+        // Written field by field, in the key order Task::toJson produces,
+        // to skip building a json object per task
+        for (const auto& task : tasks) {
+            record += empty ? "\n  {\"completed\":" : ",\n  {\"completed\":";
+            record += task.isCompleted() ? "true" : "false";
+            record += ",\"description\":";
+            record += json(task.getDescription()).dump();
+            record += ",\"id\":";
+            record += std::to_string(id++);
+            record += '}';
+            empty = false;
+        }
+        record += "\n]";
+    } catch (const nlohmann::json::exception& e) {
+        std::string errorMsg = "Failed to serialize task to JSON: " + std::string(e.what());
+        ErrorLogger::logError("appendTasks", errorMsg);
+        throw JsonParseException(errorMsg);
+    }
+
+    std::streamoff end = writeAt + static_cast<std::streamoff>(record.size());
+    std::uint64_t current = fileLock.readCounter();
+    fileLock.writeCounter(current + 1);
+    bool synced = syncsWithWrites();
+    if (writer) {
+        file.close();
+        writer->open(filePath, false);
+        writer->write(static_cast<std::uint64_t>(writeAt), record.data(), record.size());
+        // Drop what is left of the old tail before the sync
+        if (end < size) {
+            writer->truncate(static_cast<std::uint64_t>(end));
+        }
+        writer->submit(synced);
+        writer->close();
+    } else {
+        file.seekp(writeAt);
+        file.write(record.data(), static_cast<std::streamsize>(record.size()));
+        file.close();
+        if (file.fail()) {
+            std::string errorMsg = "Failed to append to file: " + filePath;
+            ErrorLogger::logError("appendTasks", errorMsg);
+            throw FileIOException(errorMsg);
+        }
+
+        // Drop what is left of the old tail
+        if (end < size) {
+            fs::resize_file(filePath, static_cast<std::uintmax_t>(end));
+        }
+    }
+
+    maxId = id - 1;
+    // Tasks loaded before another writer's save are still behind it
+    if (generation == current) {
+        generation = current + 1;
+    }
+    recordWrite(synced);
+    return first;
+}
+
+int FileTaskRepository::appendByRewriting(const TaskList& tasks) {
+    // The load and save in between must not make a list loaded before
+    // another writer's save look current
+    std::uint64_t loadedAt = generation;
+    bool current = fileLock.readCounter() == generation;
+    int first = ITaskRepository::appendTasks(tasks);
+    if (!current) {
+        generation = loadedAt;
+    }
+    return first;
+}
+
+bool FileTaskRepository::markAppends(AppendMark& mark) {
+    LockScope scope(*this, LockMode::SHARED);
+    if (dictionaryEncoding) {
+        return false;
+    }
+    std::ifstream file(filePath, std::ios::binary);
+    file.seekg(0, std::ios::end);
+    std::streamoff end = file ? arrayEnd(file, file.tellg()) : -1;
+    if (end < 0) {
+        return false;
+    }
+    mark.valid = true;
+    mark.generation = fileLock.readCounter();
+    mark.rewritten = fileLock.readCounter(kRewrittenSlot);
+    mark.offset = static_cast<std::uint64_t>(end);
+    return true;
+}
+
+bool FileTaskRepository::forEachAppended(AppendMark& mark, const TaskVisitor& visitor) {
+    LockScope scope(*this, LockMode::SHARED);
+    if (!mark.valid || dictionaryEncoding || fileLock.readCounter(kRewrittenSlot) != mark.rewritten) {
+        return false;
+    }
+    std::ifstream file(filePath, std::ios::binary);
+    file.seekg(0, std::ios::end);
+    std::streamoff size = file ? static_cast<std::streamoff>(file.tellg()) : -1;
+    auto offset = static_cast<std::streamoff>(mark.offset);
+    if (size < offset) {
+        return false;
+    }
+    std::uint64_t current = fileLock.readCounter();
+    if (current == mark.generation) {
+        return true;
+    }
+
+    // Appends wrote ",\n  {...}" records (no comma after an empty array)
+    // over the closing bracket, so the tail with a bracket in front of it is
+    // an array of just the new tasks
+    std::string tail = "[";
+    file.seekg(offset);
+    tail.append(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    std::size_t first = tail.find_first_not_of(" \t\r\n", 1);
+    if (first != std::string::npos && tail[first] == ',') {
+        tail[first] = ' ';
+    }
+    TaskList tasks;
+    try {
+        json records = json::parse(tail);
+        if (!records.is_array()) {
+            return false;
+        }
+        for (const auto& record : records) {
+            tasks.push_back(Task::fromJson(record));
+        }
+    } catch (const nlohmann::json::exception&) {
+        // Not the appends expected; the caller reads the whole file
+        return false;
+    }
+    file.clear();
+    std::streamoff end = arrayEnd(file, size);
+    if (end < offset) {
+        return false;
+    }
+
+    for (const auto& task : tasks) {
+        visitor(task.view());
+    }
+    mark.generation = current;
+    mark.offset = static_cast<std::uint64_t>(end);
+    return true;
+}
+
+std::string FileTaskRepository::exportFile(ExportFormat format) const {
+    if (format != ExportFormat::JSON || dictionaryEncoding) {
+        return {};
+    }
+
+    // A dictionary-encoded file starts with an object rather than the array
+    std::ifstream file(filePath, std::ios::binary);
+    char c = '\0';
+    while (file.get(c) && std::isspace(static_cast<unsigned char>(c))) {
+    }
+    return file && c == '[' ? filePath : std::string();
+}
+
+void FileTaskRepository::lock(LockMode mode) {
+    // Compared by generation rather than size and time, which a rewrite of
+    // the same size within the file system's time resolution would not change
+    if (fileLock.lock(mode) && fileLock.readCounter() != released) {
+        // Another process wrote the file since; the counter may be behind
+        maxId = 0;
+        maxIdKnown = false;
+    }
+}
+
+void FileTaskRepository::unlock() {
+    if (fileLock.getDepth() == 1) {
+        released = fileLock.readCounter();
+    }
+    fileLock.unlock();
+}
+
+bool FileTaskRepository::isStale() {
+    return fileLock.readCounter() != generation;
+}
+
+void FileTaskRepository::setLockTimeout(std::chrono::milliseconds timeout) {
+    fileLock.setTimeout(timeout);
+}
+
+LockStats FileTaskRepository::getLockStats() const {
+    return fileLock.getStats();
+}
+
+void FileTaskRepository::setDurable(bool enabled, GroupCommit::Settings settings) {
+    durable = enabled;
+    commit.setSettings(settings);
+}
+
+void FileTaskRepository::sync() {
+    if (durable) {
+        commit.sync();
+    }
+}
+
+GroupCommit::Stats FileTaskRepository::getSyncStats() const {
+    return commit.getStats();
+}
+
+bool FileTaskRepository::syncsWithWrites() const {
+    // Batches of one are synced alone anyway, so in the write's submission
+    return durable && writer && commit.getSettings().batchSize == 1;
+}
+
+void FileTaskRepository::recordWrite(bool synced) {
+    if (!durable) {
+        return;
+    }
+    if (synced) {
+        commit.recordSyncedWrite();
+    } else {
+        commit.recordWrite();
+    }
+}
+
+void FileTaskRepository::setIoBackend(IoBackend backend) {
+    writer = FileWriter::create(backend);
+}
+
+FileWriter::Stats FileTaskRepository::getIoStats() const {
+    return writer ? writer->getStats() : FileWriter::Stats();
+}
+
+void FileTaskRepository::setOptimistic(bool enabled) {
+    optimistic = enabled;
+}
+
+bool FileTaskRepository::isOptimistic() const {
+    return optimistic;
+}
+
+std::uint64_t FileTaskRepository::getGeneration() const {
+    return generation;
+}
+
+std::uint64_t FileTaskRepository::readGeneration() {
+    LockScope scope(*this, LockMode::SHARED);
+    return fileLock.readCounter();
+}
+
+void FileTaskRepository::setThreadPool(WorkStealingPool* pool) {
+    threadPool = pool;
+}
+
+void FileTaskRepository::setDictionaryEncoding(bool enabled) {
+    dictionaryEncoding = enabled;
+}
+
+bool FileTaskRepository::usesDictionaryEncoding() const {
+    return dictionaryEncoding;
+}
+
+const FileTaskRepository::DictionaryStats& FileTaskRepository::getDictionaryStats() const {
+    return dictionaryStats;
 }
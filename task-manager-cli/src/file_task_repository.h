@@ -2,30 +2,135 @@
 #define FILE_TASK_REPOSITORY_H
 
 #include <string>
-#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <chrono>
+#include <memory>
+#include <memory_resource>
 #include "task.h"
 #include "i_task_repository.h"
+#include "repository_capabilities.h"
+
+class FileTaskRepository : public ITaskRepository, public ILockableRepository, public IDurableRepository,
+                           public IFileBackedRepository, public IVersionedRepository,
+                           public IParallelRepository, public ITailReadableRepository {
+public:
+    // With a thread pool, plain-array files at least this large are parsed
+    // in pieces on its threads, and saves of at least kParallelSaveTasks
+    // tasks are formatted on them
+    static constexpr std::size_t kParallelLoadBytes = 256 * 1024;
+    static constexpr std::size_t kParallelSaveTasks = 4096;
+
+    /**
+     * Size of the description dictionary written by the last dictionary-encoded save
+     */
+    struct DictionaryStats {
+        std::size_t descriptions = 0;       // Descriptions referenced by tasks
+        std::size_t uniqueDescriptions = 0; // Entries written to the dictionary
+        std::size_t savedBytes = 0;         // Description characters not written again
+    };
 
-class FileTaskRepository : public ITaskRepository {
 private:
     std::string filePath;
     int maxId;
+    // Whether maxId reflects the file (after a load, save or reset)
+    bool maxIdKnown;
+    bool dictionaryEncoding;
+    DictionaryStats dictionaryStats;
+    FileLock fileLock;
+    // Generation of the file when this repository last released the lock
+    std::uint64_t released;
+    bool durable;
+    GroupCommit commit;
+    // Writes through streams while null
+    std::unique_ptr<FileWriter> writer;
+    WorkStealingPool* threadPool;
+    // Generation of the file at this repository's last load or save; the
+    // counter in the lock file holds the file's own
+    std::uint64_t generation;
+    bool optimistic;
+
+    bool scanMaxId();
+    int appendByRewriting(const TaskList& tasks);
+    bool syncsWithWrites() const;
+    void recordWrite(bool synced);
+    template <typename Tasks>
+    void writeTasks(const Tasks& tasks);
 
 public:
     // Constructor
     explicit FileTaskRepository(const std::string& filePath);
 
-    // Load tasks from file
-    std::vector<Task> loadTasks() override;
+    // Load tasks from file (plain array or dictionary-encoded)
+    TaskList loadTasks(std::pmr::memory_resource* resource = std::pmr::get_default_resource(),
+                       StringInterner* interner = nullptr) override;
 
-    // Save tasks to file
-    void saveTasks(const std::vector<Task>& tasks) override;
+    // Save tasks to file; a snapshot is written straight from its chunks.
+    // The new file is written next to the old one and renamed over it.
+    void saveTasks(const TaskList& tasks) override;
+    void saveSnapshot(const TaskSnapshot& tasks) override;
 
     // Get next available ID
     int getNextId() const override;
 
     // Reset ID counter to 0 (next ID will be 1)
     void resetIdCounter() override;
+
+    // Plain-array files are appended to in place: the new tasks are written over
+    // the closing bracket, and the next ID comes from the counter or, before
+    // the first load, from a scan of the task IDs. Dictionary-encoded files are
+    // loaded and rewritten.
+    bool supportsAppend() const override;
+    int appendTask(std::string_view description) override;
+    int appendTasks(const TaskList& tasks) override;
+
+    // Saves record their generation as the file's last rewrite, so tasks
+    // appended in place since a mark are read from the end of the file
+    bool markAppends(AppendMark& mark) override;
+    bool forEachAppended(AppendMark& mark, const TaskVisitor& visitor) override;
+
+    // A plain-array tasks.json is itself a JSON export
+    std::string exportFile(ExportFormat format) const override;
+
+    // Locks filePath + ".lock": shared for loads, exclusive for saves and
+    // appends. When another process saved or appended while the lock was not
+    // held (the generation moved on), the ID counter is found again from the file.
+    void lock(LockMode mode) override;
+    void unlock() override;
+    void setLockTimeout(std::chrono::milliseconds timeout) override;
+    LockStats getLockStats() const override;
+
+    // Sync each change to the device before sync() returns, sharing syncs
+    // between callers as settings allow
+    void setDurable(bool enabled, GroupCommit::Settings settings = GroupCommit::Settings()) override;
+    void sync() override;
+    GroupCommit::Stats getSyncStats() const override;
+
+    // Saves and appends go through a FileWriter unless backend is STREAM;
+    // the file is opened for each of them, as with streams
+    void setIoBackend(IoBackend backend) override;
+    FileWriter::Stats getIoStats() const override;
+
+    // The generation is kept in the lock file. Appends in place advance it
+    // too, but leave this repository's generation behind when another
+    // writer saved since its last load, so its next optimistic save fails.
+    void setOptimistic(bool enabled) override;
+    bool isOptimistic() const override;
+    std::uint64_t getGeneration() const override;
+    bool isStale() override;
+    // The generation the file is at now
+    std::uint64_t readGeneration();
+
+    // Large loads and saves of plain arrays are split over the pool's threads
+    void setThreadPool(WorkStealingPool* pool) override;
+
+    // Write identical descriptions once, in a dictionary section referenced by index.
+    // Loading a dictionary-encoded file turns this on so the format is kept.
+    void setDictionaryEncoding(bool enabled);
+    bool usesDictionaryEncoding() const;
+
+    // Savings of the last dictionary-encoded save
+    const DictionaryStats& getDictionaryStats() const;
 };
 
 #endif // FILE_TASK_REPOSITORY_H
@@ -0,0 +1,474 @@
+#include "file_writer.h"
+#include "repository_exceptions.h"
+#include "error_logger.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define TASK_MANAGER_IO_URING 1
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#endif
+
+std::optional<IoBackend> parseIoBackend(std::string_view name) {
+    if (name == "stream") {
+        return IoBackend::STREAM;
+    }
+    if (name == "pwrite") {
+        return IoBackend::PWRITE;
+    }
+    if (name == "uring" || name == "io_uring") {
+        return IoBackend::IO_URING;
+    }
+    return std::nullopt;
+}
+
+const char* ioBackendName(IoBackend backend) {
+    switch (backend) {
+    case IoBackend::PWRITE:
+        return "pwrite";
+    case IoBackend::IO_URING:
+        return "uring";
+    case IoBackend::STREAM:
+    default:
+        return "stream";
+    }
+}
+
+#ifdef _WIN32
+
+// Windows keeps the std::fstream path; no writer is ever made
+
+FileWriter::FileWriter() : fd(-1) {
+}
+
+FileWriter::~FileWriter() = default;
+
+std::unique_ptr<FileWriter> FileWriter::create(IoBackend) {
+    return nullptr;
+}
+
+void FileWriter::fail(const std::string& operation, int) const {
+    std::string errorMsg = operation + ": " + path;
+    ErrorLogger::logError("FileWriter", errorMsg);
+    throw FileIOException(errorMsg);
+}
+
+void FileWriter::writeFully(std::uint64_t, const char*, std::size_t) {
+    fail("Positioned writes are not supported", 0);
+}
+
+void FileWriter::open(const std::string& filePath, bool) {
+    path = filePath;
+    fail("Positioned writes are not supported", 0);
+}
+
+void FileWriter::close() {
+}
+
+bool FileWriter::isOpen() const {
+    return false;
+}
+
+void FileWriter::truncate(std::uint64_t) {
+    fail("Positioned writes are not supported", 0);
+}
+
+#else
+
+namespace {
+
+// One pwrite per write, then an fsync
+class PwriteFileWriter : public FileWriter {
+    struct Pending {
+        std::uint64_t offset;
+        const char* data;
+        std::size_t size;
+    };
+
+    std::vector<Pending> pending;
+
+public:
+    void write(std::uint64_t offset, const char* data, std::size_t size) override {
+        pending.push_back(Pending{offset, data, size});
+        stats.writes++;
+        stats.bytes += size;
+    }
+
+    void submit(bool sync) override {
+        std::vector<Pending> writes;
+        writes.swap(pending);
+        for (const auto& write : writes) {
+            writeFully(write.offset, write.data, write.size);
+        }
+        if (sync) {
+            stats.systemCalls++;
+            stats.syncs++;
+            if (::fsync(fd) != 0) {
+                fail("Failed to sync file", errno);
+            }
+        }
+    }
+
+    IoBackend getBackend() const override {
+        return IoBackend::PWRITE;
+    }
+};
+
+#ifdef TASK_MANAGER_IO_URING
+
+int ioUringSetup(unsigned entries, io_uring_params* params) {
+    return static_cast<int>(::syscall(__NR_io_uring_setup, entries, params));
+}
+
+int ioUringEnter(int ring, unsigned toSubmit, unsigned minComplete, unsigned flags) {
+    return static_cast<int>(::syscall(__NR_io_uring_enter, ring, toSubmit, minComplete, flags, nullptr, 0));
+}
+
+int ioUringRegister(int ring, unsigned opcode, const void* arg, unsigned count) {
+    return static_cast<int>(::syscall(__NR_io_uring_register, ring, opcode, arg, count));
+}
+
+/**
+ * Writes copied into one registered buffer and submitted together: each
+ * write as IORING_OP_WRITE_FIXED, and a sync as IORING_OP_FSYNC linked
+ * behind them (IOSQE_IO_LINK), so it runs only once they all succeeded.
+ * A short write cancels the rest of the chain; what is left is then
+ * written, and synced, by pwrite and fsync.
+ */
+class UringFileWriter : public FileWriter {
+    static constexpr unsigned kEntries = 64;
+    static constexpr std::size_t kBufferSize = 1024 * 1024;
+
+    struct Pending {
+        std::uint64_t offset;
+        std::size_t start; // Position in the buffer
+        std::size_t size;
+    };
+
+    int ring = -1;
+    void* sqRing = MAP_FAILED;
+    std::size_t sqRingSize = 0;
+    void* cqRing = MAP_FAILED;
+    std::size_t cqRingSize = 0;
+    io_uring_sqe* sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+    std::size_t sqesSize = 0;
+    unsigned* sqTail = nullptr;
+    unsigned sqMask = 0;
+    unsigned* cqHead = nullptr;
+    unsigned* cqTail = nullptr;
+    unsigned cqMask = 0;
+    io_uring_cqe* cqes = nullptr;
+    char* buffer = static_cast<char*>(MAP_FAILED);
+
+    std::vector<Pending> pending;
+    std::size_t used = 0;
+
+    bool setUp() {
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+        ring = ioUringSetup(kEntries, &params);
+        if (ring < 0) {
+            return false;
+        }
+
+        sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool single = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (single) {
+            sqRingSize = std::max(sqRingSize, cqRingSize);
+        }
+        sqRing = ::mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring,
+                        IORING_OFF_SQ_RING);
+        if (sqRing == MAP_FAILED) {
+            return false;
+        }
+        if (single) {
+            cqRing = sqRing;
+        } else {
+            cqRing = ::mmap(nullptr, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring,
+                            IORING_OFF_CQ_RING);
+            if (cqRing == MAP_FAILED) {
+                return false;
+            }
+        }
+        sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+        sqes = static_cast<io_uring_sqe*>(::mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE,
+                                                 MAP_SHARED | MAP_POPULATE, ring, IORING_OFF_SQES));
+        if (sqes == MAP_FAILED) {
+            return false;
+        }
+
+        char* sq = static_cast<char*>(sqRing);
+        sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sqMask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        // Submission slots map one to one onto the entries
+        unsigned* array = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        for (unsigned i = 0; i < params.sq_entries; i++) {
+            array[i] = i;
+        }
+        char* cq = static_cast<char*>(cqRing);
+        cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cqMask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+        // Registered once, so the kernel keeps the pages mapped for every write
+        buffer = static_cast<char*>(::mmap(nullptr, kBufferSize, PROT_READ | PROT_WRITE,
+                                           MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+        if (buffer == MAP_FAILED) {
+            return false;
+        }
+        iovec registered{buffer, kBufferSize};
+        return ioUringRegister(ring, IORING_REGISTER_BUFFERS, &registered, 1) == 0;
+    }
+
+    io_uring_sqe& nextEntry(unsigned& tail) {
+        io_uring_sqe& entry = sqes[tail & sqMask];
+        std::memset(&entry, 0, sizeof(entry));
+        tail++;
+        return entry;
+    }
+
+public:
+    // A writer with its ring set up, or nullptr when the kernel refuses one
+    static std::unique_ptr<FileWriter> create() {
+        std::unique_ptr<UringFileWriter> writer(new UringFileWriter());
+        if (!writer->setUp()) {
+            return nullptr;
+        }
+        return writer;
+    }
+
+    ~UringFileWriter() override {
+        if (buffer != MAP_FAILED) {
+            ::munmap(buffer, kBufferSize);
+        }
+        if (sqes != MAP_FAILED) {
+            ::munmap(sqes, sqesSize);
+        }
+        if (cqRing != MAP_FAILED && cqRing != sqRing) {
+            ::munmap(cqRing, cqRingSize);
+        }
+        if (sqRing != MAP_FAILED) {
+            ::munmap(sqRing, sqRingSize);
+        }
+        if (ring >= 0) {
+            ::close(ring);
+        }
+    }
+
+    void write(std::uint64_t offset, const char* data, std::size_t size) override {
+        stats.writes++;
+        stats.bytes += size;
+        // Larger writes go out in buffer-sized pieces; one entry stays free
+        // for the sync
+        while (size > 0) {
+            if (used == kBufferSize || pending.size() == kEntries - 1) {
+                submit(false);
+            }
+            std::size_t piece = std::min(size, kBufferSize - used);
+            std::memcpy(buffer + used, data, piece);
+            pending.push_back(Pending{offset, used, piece});
+            used += piece;
+            offset += piece;
+            data += piece;
+            size -= piece;
+        }
+    }
+
+    void submit(bool sync) override {
+        std::vector<Pending> writes;
+        writes.swap(pending);
+        used = 0;
+        if (writes.empty() && !sync) {
+            return;
+        }
+
+        // Completions left behind by a submission that failed part way
+        __atomic_store_n(cqHead, __atomic_load_n(cqTail, __ATOMIC_ACQUIRE), __ATOMIC_RELEASE);
+
+        unsigned tail = *sqTail;
+        for (std::size_t i = 0; i < writes.size(); i++) {
+            io_uring_sqe& entry = nextEntry(tail);
+            entry.opcode = IORING_OP_WRITE_FIXED;
+            entry.fd = fd;
+            entry.addr = reinterpret_cast<std::uint64_t>(buffer + writes[i].start);
+            entry.len = static_cast<std::uint32_t>(writes[i].size);
+            entry.off = writes[i].offset;
+            entry.buf_index = 0;
+            entry.user_data = i;
+            // Chained only when a sync has to wait for them
+            entry.flags = sync ? IOSQE_IO_LINK : 0;
+        }
+        if (sync) {
+            io_uring_sqe& entry = nextEntry(tail);
+            entry.opcode = IORING_OP_FSYNC;
+            entry.fd = fd;
+            entry.user_data = writes.size();
+            stats.syncs++;
+        }
+        // The kernel reads the entries once it sees the new tail
+        __atomic_store_n(sqTail, tail, __ATOMIC_RELEASE);
+
+        unsigned count = static_cast<unsigned>(writes.size()) + (sync ? 1 : 0);
+        std::vector<int> results(count, 0);
+        unsigned submitted = 0;
+        unsigned completed = 0;
+        int error = 0;
+        while (completed < count) {
+            stats.systemCalls++;
+            int entered = ioUringEnter(ring, count - submitted, count - completed, IORING_ENTER_GETEVENTS);
+            if (entered < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                error = errno;
+                break;
+            }
+            submitted += static_cast<unsigned>(entered);
+
+            unsigned head = *cqHead;
+            unsigned available = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+            for (; head != available; head++) {
+                const io_uring_cqe& completion = cqes[head & cqMask];
+                if (completion.user_data < count) {
+                    results[completion.user_data] = completion.res;
+                    completed++;
+                }
+            }
+            __atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+        }
+        if (error != 0) {
+            fail("Failed to submit writes to io_uring", error);
+        }
+
+        // A short write cancels the rest of the chain; those are finished by hand
+        bool cancelled = false;
+        for (std::size_t i = 0; i < writes.size(); i++) {
+            int result = results[i];
+            if (result == -ECANCELED) {
+                result = 0;
+                cancelled = true;
+            } else if (result < 0) {
+                fail("Failed to write file", -result);
+            }
+            std::size_t written = static_cast<std::size_t>(result);
+            if (written < writes[i].size) {
+                cancelled = true;
+                writeFully(writes[i].offset + written, buffer + writes[i].start + written,
+                           writes[i].size - written);
+            }
+        }
+        if (sync) {
+            int result = results[writes.size()];
+            if (result == -ECANCELED || (cancelled && result == 0)) {
+                stats.systemCalls++;
+                if (::fsync(fd) != 0) {
+                    fail("Failed to sync file", errno);
+                }
+            } else if (result < 0) {
+                fail("Failed to sync file", -result);
+            }
+        }
+    }
+
+    IoBackend getBackend() const override {
+        return IoBackend::IO_URING;
+    }
+};
+
+#endif // TASK_MANAGER_IO_URING
+
+} // namespace
+
+FileWriter::FileWriter() : fd(-1) {
+}
+
+FileWriter::~FileWriter() {
+    close();
+}
+
+std::unique_ptr<FileWriter> FileWriter::create(IoBackend backend) {
+    switch (backend) {
+    case IoBackend::IO_URING:
+#ifdef TASK_MANAGER_IO_URING
+        if (auto writer = UringFileWriter::create()) {
+            return writer;
+        }
+#endif
+        return std::make_unique<PwriteFileWriter>();
+    case IoBackend::PWRITE:
+        return std::make_unique<PwriteFileWriter>();
+    case IoBackend::STREAM:
+    default:
+        return nullptr;
+    }
+}
+
+void FileWriter::fail(const std::string& operation, int code) const {
+    std::string errorMsg = operation + " '" + path + "': " + std::strerror(code);
+    ErrorLogger::logError("FileWriter", errorMsg);
+    throw FileIOException(errorMsg);
+}
+
+void FileWriter::writeFully(std::uint64_t offset, const char* data, std::size_t size) {
+    while (size > 0) {
+        stats.systemCalls++;
+        ssize_t written = ::pwrite(fd, data, size, static_cast<off_t>(offset));
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            fail("Failed to write file", errno);
+        }
+        offset += static_cast<std::uint64_t>(written);
+        data += written;
+        size -= static_cast<std::size_t>(written);
+    }
+}
+
+void FileWriter::open(const std::string& filePath, bool truncate) {
+    close();
+    path = filePath;
+    int flags = O_WRONLY | O_CREAT | O_CLOEXEC | (truncate ? O_TRUNC : 0);
+    fd = ::open(path.c_str(), flags, 0644);
+    if (fd < 0) {
+        fail("Cannot open file for writing", errno);
+    }
+}
+
+void FileWriter::close() {
+    if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+}
+
+bool FileWriter::isOpen() const {
+    return fd >= 0;
+}
+
+void FileWriter::truncate(std::uint64_t size) {
+    submit(false);
+    stats.systemCalls++;
+    if (::ftruncate(fd, static_cast<off_t>(size)) != 0) {
+        fail("Failed to resize file", errno);
+    }
+}
+
+#endif // _WIN32
+
+const FileWriter::Stats& FileWriter::getStats() const {
+    return stats;
+}
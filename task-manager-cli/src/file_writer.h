@@ -0,0 +1,92 @@
+#ifndef FILE_WRITER_H
+#define FILE_WRITER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+
+// How file repositories write their files
+enum class IoBackend {
+    STREAM,  // std::fstream, synced separately by path (the default; every platform)
+    PWRITE,  // pwrite and fsync on one descriptor (POSIX)
+    IO_URING // Batched io_uring submissions (Linux), else as PWRITE
+};
+
+// "stream", "pwrite" or "uring"; nothing for other names
+std::optional<IoBackend> parseIoBackend(std::string_view name);
+const char* ioBackendName(IoBackend backend);
+
+/**
+ * Positioned writes to one file at a time: write() queues, submit() hands
+ * the queue (and a sync, if asked) to the kernel at once. Not thread-safe;
+ * repositories call it under their lock.
+ */
+class FileWriter {
+public:
+    struct Stats {
+        std::size_t writes = 0;      // Writes queued
+        std::size_t syncs = 0;       // Syncs made after writes
+        std::size_t systemCalls = 0; // Calls into the kernel to write and sync
+        std::uint64_t bytes = 0;     // Bytes written
+    };
+
+protected:
+    int fd;
+    std::string path;
+    Stats stats;
+
+    FileWriter();
+
+    // Logs and throws a FileIOException for the failed operation, with the
+    // system's error for code (an errno value)
+    [[noreturn]] void fail(const std::string& operation, int code) const;
+
+    // Write the rest of a write by pwrite, after a short or cancelled one
+    void writeFully(std::uint64_t offset, const char* data, std::size_t size);
+
+public:
+    /**
+     * A writer for the backend: IO_URING falls back to PWRITE when the
+     * kernel offers no ring (or forbids it), and STREAM, like any backend on
+     * platforms without pwrite, gives nullptr
+     */
+    static std::unique_ptr<FileWriter> create(IoBackend backend);
+
+    virtual ~FileWriter();
+
+    FileWriter(const FileWriter&) = delete;
+    FileWriter& operator=(const FileWriter&) = delete;
+
+    /**
+     * Open path for writing, creating it when missing; truncate empties it.
+     * Any file open before is closed.
+     * @throws FileIOException if the file cannot be opened
+     */
+    void open(const std::string& path, bool truncate);
+    void close();
+    bool isOpen() const;
+
+    // Queue a write of size bytes at offset; data must stay valid until
+    // submit() returns
+    virtual void write(std::uint64_t offset, const char* data, std::size_t size) = 0;
+
+    /**
+     * Carry out the queued writes, followed by an fsync when sync is set,
+     * and wait for them
+     * @throws FileIOException if a write or the sync fails; the queue is
+     *         emptied either way
+     */
+    virtual void submit(bool sync) = 0;
+
+    // Cut the file to size; queued writes are submitted first
+    // @throws FileIOException if the file cannot be resized
+    void truncate(std::uint64_t size);
+
+    virtual IoBackend getBackend() const = 0;
+    const Stats& getStats() const;
+};
+
+#endif // FILE_WRITER_H
@@ -0,0 +1,221 @@
+#include "group_commit.h"
+#include "repository_exceptions.h"
+#include "error_logger.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <system_error>
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// Drop the temporary file and report why it could not replace the original
+[[noreturn]] void failReplace(const std::string& temporary, const std::string& errorMsg) {
+    std::error_code error;
+    fs::remove(temporary, error);
+    ErrorLogger::logError("replaceFile", errorMsg);
+    throw FileIOException(errorMsg);
+}
+
+// Give a replacement file the permissions of the one it replaces
+void copyPermissions(const std::string& from, const std::string& to) {
+    std::error_code error;
+    fs::file_status status = fs::status(from, error);
+    if (!error && fs::exists(status)) {
+        fs::permissions(to, status.permissions(), error);
+    }
+}
+
+} // namespace
+
+#ifdef _WIN32
+
+void syncFile(const std::string& path) {
+    // FlushFileBuffers needs a handle open for writing
+    HANDLE handle = ::CreateFileA(path.c_str(), GENERIC_WRITE,
+                                  FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                  nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (handle == INVALID_HANDLE_VALUE) {
+        std::string errorMsg = "Cannot open file to sync: " + path;
+        ErrorLogger::logError("syncFile", errorMsg);
+        throw FileIOException(errorMsg);
+    }
+    bool flushed = ::FlushFileBuffers(handle) != 0;
+    ::CloseHandle(handle);
+    if (!flushed) {
+        std::string errorMsg = "Failed to sync file: " + path;
+        ErrorLogger::logError("syncFile", errorMsg);
+        throw FileIOException(errorMsg);
+    }
+}
+
+void replaceFile(const std::string& temporary, const std::string& path, bool) {
+    copyPermissions(path, temporary);
+    // Written through, so the rename is on the device when it returns
+    if (!::MoveFileExA(temporary.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH)) {
+        failReplace(temporary, "Cannot replace " + path + " with " + temporary);
+    }
+}
+
+#else
+
+void syncFile(const std::string& path) {
+    // Any descriptor of the file flushes all of its written pages
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::string errorMsg = "Cannot open file to sync: " + path;
+        ErrorLogger::logError("syncFile", errorMsg);
+        throw FileIOException(errorMsg);
+    }
+#ifdef __APPLE__
+    // fsync leaves the data in the drive's cache on macOS
+    bool flushed = ::fcntl(fd, F_FULLFSYNC) == 0 || ::fsync(fd) == 0;
+#else
+    bool flushed = ::fsync(fd) == 0;
+#endif
+    ::close(fd);
+    if (!flushed) {
+        std::string errorMsg = "Failed to sync file: " + path;
+        ErrorLogger::logError("syncFile", errorMsg);
+        throw FileIOException(errorMsg);
+    }
+}
+
+void replaceFile(const std::string& temporary, const std::string& path, bool durable) {
+    copyPermissions(path, temporary);
+    if (::rename(temporary.c_str(), path.c_str()) != 0) {
+        failReplace(temporary, "Cannot replace " + path + " with " + temporary + ": " + std::strerror(errno));
+    }
+    if (!durable) {
+        return;
+    }
+    // The rename is a change to the directory, synced like a file's data
+    fs::path parent = fs::path(path).parent_path();
+    std::string directory = parent.empty() ? "." : parent.string();
+    int fd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY);
+    bool flushed = fd >= 0 && ::fsync(fd) == 0;
+    if (fd >= 0) {
+        ::close(fd);
+    }
+    if (!flushed) {
+        std::string errorMsg = "Failed to sync directory: " + directory;
+        ErrorLogger::logError("replaceFile", errorMsg);
+        throw FileIOException(errorMsg);
+    }
+}
+
+#endif
+
+GroupCommit::GroupCommit(std::function<void()> syncFunction)
+    : GroupCommit(std::move(syncFunction), Settings()) {
+}
+
+GroupCommit::GroupCommit(std::function<void()> syncFunction, Settings settings)
+    : syncFunction(std::move(syncFunction)), settings(settings), written(0), synced(0),
+      syncing(false), rounds(0), roundCovered(0), syncCount(0) {
+    if (this->settings.batchSize == 0) {
+        this->settings.batchSize = 1;
+    }
+}
+
+void GroupCommit::recordWrite() {
+    std::lock_guard<std::mutex> lock(mutex);
+    written++;
+    // A leader gathering a batch counts pending writes
+    if (syncing) {
+        changed.notify_all();
+    }
+}
+
+void GroupCommit::recordSyncedWrite() {
+    std::lock_guard<std::mutex> lock(mutex);
+    written++;
+    syncCount++;
+    synced = written;
+    changed.notify_all();
+}
+
+void GroupCommit::sync() {
+    std::unique_lock<std::mutex> lock(mutex);
+    std::uint64_t target = written;
+    while (synced < target) {
+        if (!syncing) {
+            lead(lock);
+            continue;
+        }
+        std::uint64_t round = rounds;
+        changed.wait(lock, [&] { return rounds != round || synced >= target; });
+        if (synced < target && roundError && roundCovered >= target) {
+            std::rethrow_exception(roundError);
+        }
+    }
+}
+
+void GroupCommit::lead(std::unique_lock<std::mutex>& lock) {
+    syncing = true;
+    if (settings.window.count() > 0) {
+        auto deadline = std::chrono::steady_clock::now() + settings.window;
+        changed.wait_until(lock, deadline, [this] {
+            return written - synced >= settings.batchSize;
+        });
+    }
+
+    // Writes recorded from here on may miss this sync
+    std::uint64_t covered = written;
+    std::exception_ptr error;
+    lock.unlock();
+    try {
+        syncFunction();
+    } catch (...) {
+        error = std::current_exception();
+    }
+    lock.lock();
+
+    syncing = false;
+    rounds++;
+    syncCount++;
+    roundCovered = covered;
+    roundError = error;
+    if (!error) {
+        // A synced write may have been recorded meanwhile
+        synced = std::max(synced, covered);
+    }
+    changed.notify_all();
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+void GroupCommit::setSettings(Settings newSettings) {
+    std::lock_guard<std::mutex> lock(mutex);
+    settings = newSettings;
+    if (settings.batchSize == 0) {
+        settings.batchSize = 1;
+    }
+}
+
+GroupCommit::Settings GroupCommit::getSettings() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return settings;
+}
+
+GroupCommit::Stats GroupCommit::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    Stats stats;
+    stats.writes = written;
+    stats.syncs = syncCount;
+    return stats;
+}
@@ -0,0 +1,87 @@
+#ifndef GROUP_COMMIT_H
+#define GROUP_COMMIT_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <string>
+
+// Flush what has been written to a file through to the device (fsync on
+// POSIX, FlushFileBuffers on Windows)
+// @throws FileIOException if the file cannot be opened or synced
+void syncFile(const std::string& path);
+
+// Rename temporary over path, so readers never see a partial file; when
+// durable, temporary must be synced already and the directory is synced after
+// @throws FileIOException if the rename or the sync fails
+void replaceFile(const std::string& temporary, const std::string& path, bool durable);
+
+/**
+ * Shares one sync between writers that finish at about the same time: the
+ * first caller of sync() waits up to the window for more writes, then syncs
+ * once for all of them.
+ */
+class GroupCommit {
+public:
+    struct Settings {
+        // How long a leader waits for more writes before syncing
+        std::chrono::microseconds window{0};
+        // Pending writes that end the wait early
+        std::size_t batchSize = 64;
+    };
+
+    struct Stats {
+        std::uint64_t writes = 0; // Writes recorded
+        std::uint64_t syncs = 0;  // Syncs run, each covering every write before it started
+    };
+
+private:
+    std::function<void()> syncFunction;
+    Settings settings;
+    mutable std::mutex mutex;
+    std::condition_variable changed;
+    std::uint64_t written;
+    std::uint64_t synced;
+    bool syncing;
+    // Ends of syncs, and what the last one covered and how it failed, for
+    // the callers that waited on it
+    std::uint64_t rounds;
+    std::uint64_t roundCovered;
+    std::exception_ptr roundError;
+    std::uint64_t syncCount;
+
+    void lead(std::unique_lock<std::mutex>& lock);
+
+public:
+    // Constructor; syncFunction makes every recorded write durable
+    explicit GroupCommit(std::function<void()> syncFunction);
+    GroupCommit(std::function<void()> syncFunction, Settings settings);
+
+    GroupCommit(const GroupCommit&) = delete;
+    GroupCommit& operator=(const GroupCommit&) = delete;
+
+    // Count a write that has reached the operating system
+    void recordWrite();
+
+    // Count a write that was synced along with the file's earlier writes
+    // (the caller synced the file itself), so waiters need no other sync
+    void recordSyncedWrite();
+
+    /**
+     * Block until every write recorded before this call is synced
+     * @throws the sync's error when the sync covering those writes failed;
+     *         a later call tries again
+     */
+    void sync();
+
+    void setSettings(Settings settings);
+    Settings getSettings() const;
+
+    Stats getStats() const;
+};
+
+#endif // GROUP_COMMIT_H
@@ -0,0 +1,28 @@
+#ifndef I_ASYNC_TASK_REPOSITORY_H
+#define I_ASYNC_TASK_REPOSITORY_H
+
+#include <future>
+#include <memory_resource>
+#include "task.h"
+#include "string_interner.h"
+#include "task_snapshot.h"
+
+/**
+ * Asynchronous counterpart of ITaskRepository's loads and saves; each call
+ * returns a future at once, and waiting saves may be merged.
+ */
+class IAsyncTaskRepository {
+public:
+    virtual ~IAsyncTaskRepository() = default;
+
+    // Load tasks, allocating them from resource (which must be thread-safe)
+    virtual std::future<TaskList> loadTasks(std::pmr::memory_resource* resource = std::pmr::get_default_resource(),
+                                            StringInterner* interner = nullptr) = 0;
+
+    // Save tasks; the snapshot form keeps the caller's version pinned
+    // instead of copying it, until the save is done
+    virtual std::shared_future<void> saveTasks(TaskList tasks) = 0;
+    virtual std::shared_future<void> saveSnapshot(TaskSnapshot tasks) = 0;
+};
+
+#endif // I_ASYNC_TASK_REPOSITORY_H
@@ -2,28 +2,123 @@
 #define I_TASK_REPOSITORY_H
 
 #include <string>
-#include <vector>
+#include <string_view>
+#include <functional>
+#include <memory_resource>
 #include "task.h"
+#include "string_interner.h"
+#include "task_snapshot.h"
+
+// Callback receiving each task when tasks are streamed
+using TaskVisitor = std::function<void(const TaskView&)>;
+
+// Formats tasks can be exported in: a plain JSON array as in tasks.json,
+// one JSON object per line, or the paged binary layout of tasks.db
+enum class ExportFormat {
+    JSON,
+    NDJSON,
+    BINARY
+};
 
 /**
  * Abstract interface for task repository operations.
  * This allows for dependency inversion and better testability.
+ * Optional capabilities are separate interfaces (repository_capabilities.h).
  */
 class ITaskRepository {
 public:
     virtual ~ITaskRepository() = default;
 
-    // Load tasks from storage
-    virtual std::vector<Task> loadTasks() = 0;
+    // Load tasks from storage, allocating the list and its tasks from resource;
+    // descriptions are shared through interner when one is given
+    virtual TaskList loadTasks(std::pmr::memory_resource* resource = std::pmr::get_default_resource(),
+                               StringInterner* interner = nullptr) = 0;
 
     // Save tasks to storage
-    virtual void saveTasks(const std::vector<Task>& tasks) = 0;
+    virtual void saveTasks(const TaskList& tasks) = 0;
+
+    // Save a snapshot's tasks, as TaskManager keeps them; by default through
+    // a copy into one list
+    virtual void saveSnapshot(const TaskSnapshot& tasks) {
+        saveTasks(tasks.toList());
+    }
 
     // Get next available ID
     virtual int getNextId() const = 0;
 
     // Reset ID counter to 0 (next ID will be 1)
     virtual void resetIdCounter() = 0;
+
+    // Whether the operations below run without holding every task in
+    // memory, so TaskManager keeps no list of its own
+    virtual bool supportsStreaming() const {
+        return false;
+    }
+
+    // Visit every task in storage order
+    virtual void forEachTask(const TaskVisitor& visitor) {
+        for (const auto& task : loadTasks()) {
+            visitor(task.view());
+        }
+    }
+
+    // Whether appendTask adds a task without loading and rewriting the others
+    virtual bool supportsAppend() const {
+        return supportsStreaming();
+    }
+
+    // Append a new task and return its ID
+    virtual int appendTask(std::string_view description) {
+        TaskList tasks = loadTasks();
+        int id = getNextId();
+        tasks.emplace_back(id, description, false);
+        saveTasks(tasks);
+        return id;
+    }
+
+    // Append tasks with consecutive new IDs, keeping their descriptions and
+    // completion but not the IDs they carry; returns the first new ID.
+    // Bulk imports call this once per block of tasks.
+    virtual int appendTasks(const TaskList& tasks) {
+        TaskList all = loadTasks();
+        int first = getNextId();
+        int id = first;
+        all.reserve(all.size() + tasks.size());
+        for (const auto& task : tasks) {
+            all.emplace_back(id++, task.getDescription(), task.isCompleted());
+        }
+        saveTasks(all);
+        return first;
+    }
+
+    // Set a task's completion status; returns false when no task has this ID
+    virtual bool setTaskCompleted(int id, bool completed) {
+        TaskList tasks = loadTasks();
+        for (auto& task : tasks) {
+            if (task.getId() == id) {
+                task.setCompleted(completed);
+                saveTasks(tasks);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Forget anything cached from storage, so the next read sees changes
+    // other processes have saved since
+    virtual void reload() {}
+
+    // File that already holds every task in exactly this format, so an export
+    // can copy it byte for byte; empty when the tasks must be streamed out
+    virtual std::string exportFile(ExportFormat) const {
+        return {};
+    }
+
+    // Remove all tasks and reset the ID counter
+    virtual void clearTasks() {
+        resetIdCounter();
+        saveTasks(TaskList());
+    }
 };
 
 #endif // I_TASK_REPOSITORY_H
@@ -1,74 +1,300 @@
 #include "cli.h"
+#include "command_runner.h"
 #include "task_manager.h"
 #include "file_task_repository.h"
+#include "paged_task_repository.h"
+#include "sharded_task_repository.h"
+#include "repository_capabilities.h"
 #include "repository_exceptions.h"
+#include "shell.h"
+#include "task_client.h"
+#include "task_follower.h"
+#include "task_server.h"
+#include "work_stealing_pool.h"
+#include <chrono>
+#include <csignal>
 #include <iostream>
-#include <filesystem>
+#include <memory_resource>
+#include <cstddef>
+#include <cstdlib>
+#include <utility>
+#include <memory>
+#include <optional>
+#include <string>
 
-namespace fs = std::filesystem;
+// Size of the first block of the per-command arena; larger task lists
+// grow it with further blocks from the upstream resource
+static constexpr std::size_t kArenaInitialSize = 64 * 1024;
+
+// --save-interval=MS of shell; nothing, once reported, when MS is
+// not a whole number
+static std::optional<std::chrono::milliseconds> saveIntervalOption(CLI& cli, const Command& cmd,
+                                                                   std::chrono::milliseconds defaultInterval) {
+    auto option = cmd.options.find("save-interval");
+    if (option == cmd.options.end()) {
+        return defaultInterval;
+    }
+    std::optional<std::size_t> interval = CLI::parseCount(option->second);
+    if (!interval) {
+        cli.displayError("Invalid --save-interval: " + option->second);
+        return std::nullopt;
+    }
+    return std::chrono::milliseconds(*interval);
+}
+
+// A switch set in the environment: unset, empty or "0" is off, anything else on
+static bool envFlag(const char* name) {
+    const char* value = std::getenv(name);
+    return value != nullptr && *value != '\0' && std::string(value) != "0";
+}
+
+// A number set in the environment, or fallback when it is unset or empty;
+// nothing, once reported, when it is not a whole number of at least min
+static std::optional<std::size_t> envCount(CLI& cli, const char* name, std::size_t fallback,
+                                           std::size_t min = 0) {
+    const char* value = std::getenv(name);
+    if (value == nullptr || *value == '\0') {
+        return fallback;
+    }
+    std::optional<std::size_t> parsed = CLI::parseCount(value, min);
+    if (!parsed) {
+        cli.displayError(std::string("Invalid ") + name + ": " + value);
+    }
+    return parsed;
+}
+
+// Server stopped by SIGINT/SIGTERM so it can save before exiting
+static TaskServer* activeServer = nullptr;
+
+extern "C" void stopActiveServer(int) {
+    if (activeServer) {
+        activeServer->stop();
+    }
+}
 
 int main(int argc, char* argv[]) {
-    try {
-        // Determine executable directory for tasks.json
-        fs::path exePath = fs::current_path();
-        std::string tasksFile = (exePath / "tasks.json").string();
+    // Nothing here writes through C stdio, so iostreams can keep their own buffers
+    std::ios::sync_with_stdio(false);
 
-        // Initialize repository and manager
-        FileTaskRepository repository(tasksFile);
-        TaskManager manager(repository);
+    try {
+        // All allocations for this command (parsed tasks, listed copies) come from
+        // one bump arena that is released as a whole when the command finishes
+        std::pmr::monotonic_buffer_resource arena(kArenaInitialSize);
 
         // Parse command
         CLI cli;
-        Command cmd = cli.parseCommand(argc, argv);
+        Command cmd = cli.parseCommand(argc, argv, &arena);
 
-        // Execute command
-        switch (cmd.type) {
-            case CommandType::ADD: {
-                int id = manager.addTask(cmd.argument);
-                cli.displaySuccess("Task added with ID: " + std::to_string(id));
-                break;
-            }
+        // Help and usage errors need no tasks, so answer them before any set-up
+        if (cmd.type == CommandType::HELP) {
+            cli.displayHelp();
+            return 0;
+        }
+        if (cmd.type == CommandType::INVALID) {
+            cli.displayError("Invalid command");
+            cli.displayHelp();
+            return 1;
+        }
+
+        // Files live in the working directory; relative names save resolving it
+        const std::string tasksFile = "tasks.json";
 
-            case CommandType::LIST: {
-                std::vector<Task> tasks = manager.listTasks();
-                cli.displayTasks(tasks);
-                break;
+        // Hand the command to a running server, which has the tasks loaded
+        // already; without one, or with other TASK_MANAGER_* settings that
+        // the server would not apply, fall through to the tasks file.
+        // TASK_MANAGER_SOCKET overrides the socket path
+        const char* socketEnv = std::getenv("TASK_MANAGER_SOCKET");
+        std::string socketPath = socketEnv ? socketEnv : "task-manager.sock";
+        if (TaskClient::shouldForward(cmd) && !TaskClient::hasLocalSettings()) {
+            if (auto status = TaskClient::forward(socketPath, cmd, argc, argv)) {
+                return *status;
             }
+        }
 
-            case CommandType::COMPLETE: {
-                int id = std::stoi(cmd.argument);
-                bool success = manager.completeTask(id);
-                
-                if (success) {
-                    cli.displaySuccess("Task " + std::to_string(id) + " marked as completed");
-                } else {
-                    cli.displayError("Task not found: " + std::to_string(id));
-                    cli.displayHelp();
+        // A server, shell or follower lives on, so its tasks come from a pool
+        // that reuses freed blocks rather than from the bump arena
+        bool serve = cmd.type == CommandType::SERVE;
+        bool follow = cmd.type == CommandType::LIST && cmd.options.count("follow") > 0;
+        bool resident = serve || follow || cmd.type == CommandType::SHELL;
+        std::pmr::unsynchronized_pool_resource pool;
+        std::pmr::memory_resource* resource = resident ? static_cast<std::pmr::memory_resource*>(&pool) : &arena;
+
+        // Large loads, saves and searches are split over TASK_MANAGER_THREADS
+        // threads (default: one per hardware thread; 1 runs them on this
+        // thread). The threads start only when such work first comes up.
+        std::optional<std::size_t> threads =
+            envCount(cli, "TASK_MANAGER_THREADS", WorkStealingPool::defaultThreadCount(), 1);
+        if (!threads) {
+            return 1;
+        }
+        std::unique_ptr<WorkStealingPool> threadPool;
+        if (*threads > 1) {
+            threadPool = std::make_unique<WorkStealingPool>(*threads);
+        }
+
+        // TASK_MANAGER_DICTIONARY=1 shares identical descriptions in memory
+        // and writes them once, as a dictionary section, in tasks.json
+        bool dictionary = envFlag("TASK_MANAGER_DICTIONARY");
+        StringInterner interner(resource);
+
+        // Initialize repository and manager. TASK_MANAGER_STORAGE=paged keeps the
+        // tasks out of core in tasks.db, read through a page cache of
+        // TASK_MANAGER_CACHE_BYTES (default 1 MiB). TASK_MANAGER_STORAGE=sharded
+        // spreads them over TASK_MANAGER_SHARDS files (default 8), tasks.0.json
+        // and on, placed by TASK_MANAGER_SHARD_BY (hash, the default, or range)
+        std::unique_ptr<ITaskRepository> repository;
+        std::string storePath = tasksFile;
+        const char* storage = std::getenv("TASK_MANAGER_STORAGE");
+        if (storage && std::string(storage) == "paged") {
+            std::optional<std::size_t> cacheBytes =
+                envCount(cli, "TASK_MANAGER_CACHE_BYTES", PagedTaskRepository::kDefaultCacheBytes, 1);
+            if (!cacheBytes) {
+                return 1;
+            }
+            storePath = "tasks.db";
+            repository = std::make_unique<PagedTaskRepository>(storePath, *cacheBytes);
+        } else if (storage && std::string(storage) == "sharded") {
+            if (follow) {
+                cli.displayError("list --follow needs tasks.json or tasks.db, not sharded storage");
+                return 1;
+            }
+            std::optional<std::size_t> shardCount =
+                envCount(cli, "TASK_MANAGER_SHARDS", ShardedTaskRepository::kDefaultShards, 1);
+            if (!shardCount) {
+                return 1;
+            }
+            ShardRouting routing = ShardRouting::HASH;
+            if (const char* shardBy = std::getenv("TASK_MANAGER_SHARD_BY")) {
+                std::optional<ShardRouting> parsed = parseShardRouting(shardBy);
+                if (!parsed) {
+                    cli.displayError(std::string("Unknown shard routing: ") + shardBy + " (use hash or range)");
                     return 1;
                 }
-                break;
+                routing = *parsed;
+            }
+            repository = std::make_unique<ShardedTaskRepository>("tasks", *shardCount, routing);
+        } else {
+            auto fileRepository = std::make_unique<FileTaskRepository>(tasksFile);
+            if (dictionary) {
+                fileRepository->setDictionaryEncoding(true);
+            }
+            repository = std::move(fileRepository);
+        }
+        // Other processes hold tasks.json (or tasks.db) locked while they write
+        // it; TASK_MANAGER_LOCK_TIMEOUT_MS bounds the wait (default 10000), and
+        // TASK_MANAGER_LOCK_STATS=1 reports the time spent waiting on stderr
+        std::optional<std::size_t> lockTimeout = envCount(
+            cli, "TASK_MANAGER_LOCK_TIMEOUT_MS", static_cast<std::size_t>(FileLock::kDefaultTimeout.count()));
+        if (!lockTimeout) {
+            return 1;
+        }
+        auto* lockable = capabilityOf<ILockableRepository>(*repository);
+        if (lockable) {
+            lockable->setLockTimeout(std::chrono::milliseconds(*lockTimeout));
+        }
+        bool lockStats = envFlag("TASK_MANAGER_LOCK_STATS");
+        // TASK_MANAGER_OPTIMISTIC=1 locks tasks.json only to read it and to
+        // write it, not in between; a save finding that another process saved
+        // meanwhile makes its change again on the fresh tasks
+        auto* versioned = capabilityOf<IVersionedRepository>(*repository);
+        if (versioned && envFlag("TASK_MANAGER_OPTIMISTIC")) {
+            versioned->setOptimistic(true);
+        }
+        // TASK_MANAGER_DURABLE=1 syncs every change to the device before it is
+        // acknowledged. Changes made together share a sync: one gathers others
+        // for up to TASK_MANAGER_COMMIT_WINDOW_US (default 0), or until
+        // TASK_MANAGER_COMMIT_BATCH (default 64) are pending
+        auto* durable = capabilityOf<IDurableRepository>(*repository);
+        if (durable && envFlag("TASK_MANAGER_DURABLE")) {
+            GroupCommit::Settings commit;
+            std::optional<std::size_t> window = envCount(
+                cli, "TASK_MANAGER_COMMIT_WINDOW_US", static_cast<std::size_t>(commit.window.count()));
+            if (!window) {
+                return 1;
+            }
+            std::optional<std::size_t> batch = envCount(cli, "TASK_MANAGER_COMMIT_BATCH", commit.batchSize, 1);
+            if (!batch) {
+                return 1;
+            }
+            commit.window = std::chrono::microseconds(*window);
+            commit.batchSize = *batch;
+            durable->setDurable(true, commit);
+        }
+        // TASK_MANAGER_IO=pwrite or uring writes with positioned writes,
+        // batched into io_uring submissions where the kernel allows, instead
+        // of file streams (stream, the default)
+        if (const char* io = std::getenv("TASK_MANAGER_IO")) {
+            std::optional<IoBackend> backend = parseIoBackend(io);
+            if (!backend) {
+                cli.displayError(std::string("Unknown I/O backend: ") + io + " (use stream, pwrite or uring)");
+                return 1;
             }
+            if (auto* fileBacked = capabilityOf<IFileBackedRepository>(*repository)) {
+                fileBacked->setIoBackend(*backend);
+            }
+        }
+        if (auto* parallel = capabilityOf<IParallelRepository>(*repository)) {
+            parallel->setThreadPool(threadPool.get());
+        }
+        TaskManager manager(*repository, resource, dictionary ? &interner : nullptr);
+        manager.setThreadPool(threadPool.get());
+
+        if (serve || cmd.type == CommandType::SHELL) {
+            manager.load();
+        }
 
-            case CommandType::CLEAR: {
-                manager.clearAllTasks();
-                cli.displaySuccess("All tasks cleared");
-                break;
+        if (follow) {
+            OutputFormat format = OutputFormat::TEXT;
+            auto option = cmd.options.find("format");
+            if (option != cmd.options.end()) {
+                std::optional<OutputFormat> parsed = CLI::parseOutputFormat(option->second);
+                if (!parsed) {
+                    cli.displayError("Unknown format: " + option->second +
+                                     " (expected text, ndjson, csv or tsv)");
+                    return 1;
+                }
+                format = *parsed;
             }
+            TaskFollower follower(manager, cli, storePath, format);
+            follower.run();
+            return 0;
+        }
 
-            case CommandType::HELP: {
-                cli.displayHelp();
-                break;
+        if (cmd.type == CommandType::SHELL) {
+            std::optional<std::chrono::milliseconds> saveInterval =
+                saveIntervalOption(cli, cmd, Shell::kDefaultSaveInterval);
+            if (!saveInterval) {
+                return 1;
             }
+            Shell shell(manager, cli, *saveInterval);
+            shell.setTiming(cmd.options.count("timing") > 0);
+            return shell.run();
+        }
 
-            case CommandType::INVALID:
-            default: {
-                cli.displayError("Invalid command");
-                cli.displayHelp();
+        if (serve) {
+            TaskServer server(manager, cli, socketPath);
+            try {
+                server.start();
+            } catch (const std::runtime_error& e) {
+                std::cerr << "Server Error: " << e.what() << "\n";
                 return 1;
             }
+            activeServer = &server;
+            std::signal(SIGINT, stopActiveServer);
+            std::signal(SIGTERM, stopActiveServer);
+            std::cout << "Serving tasks on " << socketPath << "\n" << std::flush;
+            server.run();
+            activeServer = nullptr;
+            return 0;
         }
 
-        return 0;
+        // Execute command
+        CommandRunner runner(manager, cli);
+        int status = runner.execute(cmd);
+        if (lockStats && lockable) {
+            cli.displayLockStats(lockable->getLockStats());
+        }
+        return status;
     }
     catch (const JsonParseException& e) {
         std::cerr << "JSON Error: " << e.what() << "\n";
@@ -0,0 +1,253 @@
+#include "mutation_queue.h"
+#include <chrono>
+#include <exception>
+#include <stdexcept>
+#include <utility>
+
+MutationQueue::MutationQueue(TaskManager& manager, std::size_t batchSize)
+    : manager(manager), batchSize(batchSize > 0 ? batchSize : 1),
+      head(new Node), tail(head.load()),
+      stopping(false), pushing(0), sleeping(false), mutations(0), batches(0) {
+    writer = std::thread(&MutationQueue::run, this);
+}
+
+MutationQueue::~MutationQueue() {
+    stop();
+    while (tail) {
+        Node* next = tail->next.load();
+        delete tail;
+        tail = next;
+    }
+}
+
+void MutationQueue::push(Node* node) {
+    // Linked in two steps: a popper that sees the exchange before the link
+    // finds the queue empty until the link is stored
+    Node* previous = head.exchange(node, std::memory_order_acq_rel);
+    previous->next.store(node);
+
+    // Pairs with run() announcing its sleep before it checks the queue, so
+    // either the writer sees this node or this sees the writer asleep
+    if (sleeping.load()) {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        wake.notify_one();
+    }
+}
+
+void MutationQueue::submit(Node* node) {
+    // Counted before stopping is checked: stop() sets stopping before the
+    // writer reads the count, so either this sees stopping or the writer
+    // waits for this node
+    pushing.fetch_add(1);
+    if (stopping.load()) {
+        pushing.fetch_sub(1);
+        delete node;
+        throw std::logic_error("Mutation queue is stopped");
+    }
+    push(node);
+    pushing.fetch_sub(1);
+}
+
+bool MutationQueue::pop(Mutation& mutation) {
+    Node* next = tail->next.load(std::memory_order_acquire);
+    if (!next) {
+        return false;
+    }
+    // The popped node becomes the new, already consumed, tail
+    mutation = std::move(next->mutation);
+    delete tail;
+    tail = next;
+    return true;
+}
+
+bool MutationQueue::drained() const {
+    // Read after stopping: a push not counted any more has linked its node
+    return pushing.load() == 0 && head.load() == tail;
+}
+
+std::future<int> MutationQueue::addTask(std::string description) {
+    auto* node = new Node;
+    node->mutation.kind = Kind::ADD;
+    node->mutation.description = std::move(description);
+    std::future<int> result = node->mutation.added.get_future();
+    submit(node);
+    return result;
+}
+
+std::future<bool> MutationQueue::completeTask(int id) {
+    auto* node = new Node;
+    node->mutation.kind = Kind::COMPLETE;
+    node->mutation.id = id;
+    std::future<bool> result = node->mutation.completed.get_future();
+    submit(node);
+    return result;
+}
+
+void MutationQueue::run() {
+    std::vector<Mutation> batch;
+    batch.reserve(batchSize);
+    for (;;) {
+        Mutation mutation;
+        while (batch.size() < batchSize && pop(mutation)) {
+            batch.push_back(std::move(mutation));
+        }
+        if (!batch.empty()) {
+            apply(batch);
+            batch.clear();
+            batch.reserve(batchSize);
+            completeSaved(false);
+            continue;
+        }
+        // Nothing else to do before the saves in flight are done
+        if (!saving.empty()) {
+            completeSaved(true);
+            continue;
+        }
+        if (stopping.load()) {
+            if (drained()) {
+                return;
+            }
+            // A producer that got in before stop() is still linking its node
+            std::this_thread::yield();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(wakeMutex);
+        sleeping.store(true);
+        wake.wait(lock, [this] {
+            return tail->next.load() != nullptr || stopping.load();
+        });
+        sleeping.store(false);
+    }
+}
+
+void MutationQueue::applyAll(std::vector<Mutation>& batch, Applied& applied, bool background) {
+    // Saved once for the batch below; changes other threads make directly
+    // are still saved as they are made
+    SaveDeferral deferral(manager);
+    for (std::size_t i = 0; i < batch.size(); i++) {
+        try {
+            if (batch[i].kind == Kind::ADD) {
+                applied.ids[i] = manager.addTask(std::string_view(batch[i].description));
+            } else {
+                applied.found[i] = manager.completeTask(batch[i].id);
+            }
+        } catch (...) {
+            applied.errors[i] = std::current_exception();
+        }
+    }
+    try {
+        if (background) {
+            applied.saved = manager.saveAsync();
+        } else {
+            manager.save();
+        }
+    } catch (...) {
+        applied.saveError = std::current_exception();
+    }
+}
+
+void MutationQueue::apply(std::vector<Mutation>& batch) {
+    Applied applied;
+    applied.errors.resize(batch.size());
+    applied.ids.assign(batch.size(), 0);
+    applied.found.assign(batch.size(), false);
+    bool background = manager.savesAsynchronously();
+    if (background) {
+        // A save in the background takes the repository's lock itself, and
+        // holding it here would wait for the last one
+        applyAll(batch, applied, true);
+    } else {
+        // One lock for the whole batch, for other threads and other processes
+        LockScope<TaskManager> scope(manager, LockMode::EXCLUSIVE);
+        applyAll(batch, applied, false);
+    }
+    // Synced once the lock is released, so readers are not kept waiting
+    if (!background && !applied.saveError) {
+        try {
+            manager.sync();
+        } catch (...) {
+            applied.saveError = std::current_exception();
+        }
+    }
+    mutations.fetch_add(batch.size(), std::memory_order_relaxed);
+    batches.fetch_add(1, std::memory_order_relaxed);
+
+    applied.mutations = std::move(batch);
+    if (applied.saved.valid()) {
+        saving.push_back(std::move(applied));
+    } else {
+        complete(applied);
+    }
+}
+
+void MutationQueue::complete(Applied& applied) {
+    if (applied.saved.valid()) {
+        try {
+            applied.saved.get();
+        } catch (...) {
+            applied.saveError = std::current_exception();
+        }
+    }
+    // Callers hear back only after the save (and sync)
+    for (std::size_t i = 0; i < applied.mutations.size(); i++) {
+        Mutation& mutation = applied.mutations[i];
+        std::exception_ptr error = applied.errors[i] ? applied.errors[i] : applied.saveError;
+        if (mutation.kind == Kind::ADD) {
+            if (error) {
+                mutation.added.set_exception(error);
+            } else {
+                mutation.added.set_value(applied.ids[i]);
+            }
+        } else {
+            if (error) {
+                mutation.completed.set_exception(error);
+            } else {
+                mutation.completed.set_value(applied.found[i]);
+            }
+        }
+    }
+}
+
+void MutationQueue::completeSaved(bool wait) {
+    // Saves finish in order, so waiting is only ever for the oldest
+    while (!saving.empty()) {
+        Applied& oldest = saving.front();
+        if (!wait && oldest.saved.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            return;
+        }
+        complete(oldest);
+        saving.pop_front();
+        wait = false;
+    }
+}
+
+void MutationQueue::stop() {
+    if (!writer.joinable()) {
+        return;
+    }
+    stopping.store(true);
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        wake.notify_one();
+    }
+    writer.join();
+
+    // The writer leaves nothing queued, but no caller is ever left waiting
+    Mutation mutation;
+    while (pop(mutation)) {
+        auto stopped = std::make_exception_ptr(std::logic_error("Mutation queue is stopped"));
+        if (mutation.kind == Kind::ADD) {
+            mutation.added.set_exception(stopped);
+        } else {
+            mutation.completed.set_exception(stopped);
+        }
+    }
+}
+
+MutationQueue::Stats MutationQueue::getStats() const {
+    Stats stats;
+    stats.mutations = mutations.load(std::memory_order_relaxed);
+    stats.batches = batches.load(std::memory_order_relaxed);
+    return stats;
+}
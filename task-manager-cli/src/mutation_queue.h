@@ -0,0 +1,117 @@
+#ifndef MUTATION_QUEUE_H
+#define MUTATION_QUEUE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "task_manager.h"
+
+/**
+ * Funnels changes from many threads through one writer thread over a
+ * lock-free MPSC queue. The writer applies a batch under one lock and saves
+ * it once; a change's future is ready when its batch is saved.
+ */
+class MutationQueue {
+public:
+    static constexpr std::size_t kDefaultBatchSize = 1024;
+
+    struct Stats {
+        std::size_t mutations = 0; // Changes applied
+        std::size_t batches = 0;   // Saves, one per batch
+    };
+
+private:
+    enum class Kind {
+        ADD,
+        COMPLETE
+    };
+
+    struct Mutation {
+        Kind kind = Kind::ADD;
+        std::string description;
+        int id = 0;
+        std::promise<int> added;
+        std::promise<bool> completed;
+    };
+
+    // A batch's outcome, kept until its save is done
+    struct Applied {
+        std::vector<Mutation> mutations;
+        std::vector<std::exception_ptr> errors;
+        std::vector<int> ids;
+        std::vector<bool> found;
+        // Valid while the save runs in the background
+        std::shared_future<void> saved;
+        std::exception_ptr saveError;
+    };
+
+    struct Node {
+        std::atomic<Node*> next{nullptr};
+        Mutation mutation;
+    };
+
+    TaskManager& manager;
+    std::size_t batchSize;
+    // Producers push at head; the writer pops after tail, a node already consumed
+    std::atomic<Node*> head;
+    Node* tail;
+    std::atomic<bool> stopping;
+    // Producers between their check of stopping and their node being linked;
+    // the writer stops only once none are left and the queue is empty
+    std::atomic<std::size_t> pushing;
+    std::atomic<bool> sleeping;
+    std::mutex wakeMutex;
+    std::condition_variable wake;
+    std::atomic<std::size_t> mutations;
+    std::atomic<std::size_t> batches;
+    // Batches whose saves are in flight, oldest first (writer thread only)
+    std::deque<Applied> saving;
+    std::thread writer;
+
+    void push(Node* node);
+    void submit(Node* node);
+    bool pop(Mutation& mutation);
+    bool drained() const;
+    void run();
+    void apply(std::vector<Mutation>& batch);
+    // Apply a batch and save it (in the background or not)
+    void applyAll(std::vector<Mutation>& batch, Applied& applied, bool background);
+    void complete(Applied& applied);
+    void completeSaved(bool wait);
+
+public:
+    // Start the writer thread; the manager must outlive the queue
+    explicit MutationQueue(TaskManager& manager, std::size_t batchSize = kDefaultBatchSize);
+
+    // Apply and save everything queued, then stop
+    ~MutationQueue();
+
+    MutationQueue(const MutationQueue&) = delete;
+    MutationQueue& operator=(const MutationQueue&) = delete;
+
+    /**
+     * Queue a change; the future gives the new task's ID (or whether the task
+     * was found) once the change is saved, or rethrows the error applying or
+     * saving it. A change whose save failed stays applied and is saved with
+     * the next batch.
+     * @throws std::logic_error once the queue is stopped
+     */
+    std::future<int> addTask(std::string description);
+    std::future<bool> completeTask(int id);
+
+    // Apply and save everything queued and stop the writer thread. A change
+    // submitted while stop() runs is either applied and saved or refused
+    // with std::logic_error.
+    void stop();
+
+    Stats getStats() const;
+};
+
+#endif // MUTATION_QUEUE_H
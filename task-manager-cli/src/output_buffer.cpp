@@ -0,0 +1,19 @@
+#include "output_buffer.h"
+#include <algorithm>
+
+OutputBuffer::OutputBuffer(std::ostream& out, std::size_t capacity)
+    : out(out), capacity(std::max(capacity, kMaxIntegerLength)), used(0) {
+    // Left uninitialized; only the used prefix is ever read
+    buffer.reset(new char[this->capacity]);
+}
+
+OutputBuffer::~OutputBuffer() {
+    flush();
+}
+
+void OutputBuffer::flush() {
+    if (used > 0) {
+        out.write(buffer.get(), static_cast<std::streamsize>(used));
+        used = 0;
+    }
+}
@@ -0,0 +1,73 @@
+#ifndef OUTPUT_BUFFER_H
+#define OUTPUT_BUFFER_H
+
+#include <charconv>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <ostream>
+#include <string_view>
+
+/**
+ * Collects output in one reusable block and hands it to the stream in large
+ * write() calls. Integers are formatted with std::to_chars, so appending
+ * never allocates. Text longer than the block bypasses it. Whatever is still
+ * buffered is written when the buffer is destroyed.
+ */
+class OutputBuffer {
+public:
+    static constexpr std::size_t kDefaultCapacity = 64 * 1024;
+
+private:
+    std::ostream& out;
+    std::unique_ptr<char[]> buffer;
+    std::size_t capacity;
+    std::size_t used;
+
+    // Longest decimal form of a long long, with sign
+    static constexpr std::size_t kMaxIntegerLength = 20;
+
+public:
+    // Constructor; capacity is clamped so that one integer always fits
+    explicit OutputBuffer(std::ostream& out, std::size_t capacity = kDefaultCapacity);
+    ~OutputBuffer();
+
+    OutputBuffer(const OutputBuffer&) = delete;
+    OutputBuffer& operator=(const OutputBuffer&) = delete;
+
+    void append(char c) {
+        if (used == capacity) {
+            flush();
+        }
+        buffer[used++] = c;
+    }
+
+    void append(std::string_view text) {
+        if (text.size() > capacity - used) {
+            flush();
+            if (text.size() > capacity) {
+                out.write(text.data(), static_cast<std::streamsize>(text.size()));
+                return;
+            }
+        }
+        std::memcpy(buffer.get() + used, text.data(), text.size());
+        used += text.size();
+    }
+
+    void append(long long value) {
+        if (capacity - used < kMaxIntegerLength) {
+            flush();
+        }
+        char* end = std::to_chars(buffer.get() + used, buffer.get() + capacity, value).ptr;
+        used = static_cast<std::size_t>(end - buffer.get());
+    }
+
+    void append(int value) {
+        append(static_cast<long long>(value));
+    }
+
+    // Hand the buffered bytes to the stream
+    void flush();
+};
+
+#endif // OUTPUT_BUFFER_H
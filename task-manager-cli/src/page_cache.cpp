@@ -0,0 +1,114 @@
+#include "page_cache.h"
+#include "repository_exceptions.h"
+#include "error_logger.h"
+#include <algorithm>
+#include <cstring>
+
+PageCache::PageCache(std::fstream& file, std::size_t pageSize, std::size_t budgetBytes)
+    : file(file), writer(nullptr), pageSize(pageSize), capacity(std::max<std::size_t>(1, budgetBytes / pageSize)) {
+}
+
+char* PageCache::getPage(std::uint64_t pageNumber) {
+    auto cached = index.find(pageNumber);
+    if (cached != index.end()) {
+        stats.hits++;
+        pages.splice(pages.begin(), pages, cached->second);
+        return pages.front().data.get();
+    }
+
+    stats.misses++;
+
+    // Reuse the least recently used page's buffer once the budget is reached
+    std::unique_ptr<char[]> data;
+    if (pages.size() >= capacity) {
+        Page& victim = pages.back();
+        writeBack(victim);
+        // Out before its buffer is reused
+        if (writer) {
+            writer->submit(false);
+        }
+        index.erase(victim.number);
+        data = std::move(victim.data);
+        pages.pop_back();
+        stats.evictions++;
+    } else {
+        data = std::make_unique<char[]>(pageSize);
+    }
+
+    // Read the page; anything past the end of the file reads as zeros
+    std::memset(data.get(), 0, pageSize);
+    file.clear();
+    file.seekg(static_cast<std::streamoff>(pageNumber * pageSize));
+    file.read(data.get(), static_cast<std::streamsize>(pageSize));
+    if (file.bad()) {
+        std::string errorMsg = "Failed to read page " + std::to_string(pageNumber);
+        ErrorLogger::logError("PageCache", errorMsg);
+        throw FileIOException(errorMsg);
+    }
+    file.clear();
+
+    pages.push_front(Page{pageNumber, false, std::move(data)});
+    index[pageNumber] = pages.begin();
+    return pages.front().data.get();
+}
+
+void PageCache::markDirty(std::uint64_t pageNumber) {
+    auto cached = index.find(pageNumber);
+    if (cached != index.end()) {
+        cached->second->dirty = true;
+    }
+}
+
+void PageCache::flush() {
+    for (auto& page : pages) {
+        writeBack(page);
+    }
+    if (!writer) {
+        file.flush();
+    }
+}
+
+void PageCache::setWriter(FileWriter* pageWriter) {
+    writer = pageWriter;
+}
+
+void PageCache::clear() {
+    pages.clear();
+    index.clear();
+}
+
+void PageCache::writeBack(Page& page) {
+    if (!page.dirty) {
+        return;
+    }
+
+    if (writer) {
+        writer->write(page.number * pageSize, page.data.get(), pageSize);
+        page.dirty = false;
+        stats.writes++;
+        return;
+    }
+
+    file.clear();
+    file.seekp(static_cast<std::streamoff>(page.number * pageSize));
+    file.write(page.data.get(), static_cast<std::streamsize>(pageSize));
+    if (file.fail()) {
+        std::string errorMsg = "Failed to write page " + std::to_string(page.number);
+        ErrorLogger::logError("PageCache", errorMsg);
+        throw FileIOException(errorMsg);
+    }
+    page.dirty = false;
+    stats.writes++;
+}
+
+std::size_t PageCache::getPageSize() const {
+    return pageSize;
+}
+
+std::size_t PageCache::getCapacity() const {
+    return capacity;
+}
+
+const PageCache::Stats& PageCache::getStats() const {
+    return stats;
+}
@@ -0,0 +1,81 @@
+#ifndef PAGE_CACHE_H
+#define PAGE_CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include "file_writer.h"
+
+/**
+ * Bounded write-back cache of fixed-size file pages with LRU eviction.
+ * At most budgetBytes / pageSize pages (minimum one) are held in memory;
+ * dirty pages are written back when evicted or flushed.
+ */
+class PageCache {
+public:
+    /**
+     * Cache activity counters
+     */
+    struct Stats {
+        std::size_t hits = 0;
+        std::size_t misses = 0;
+        std::size_t evictions = 0;
+        std::size_t writes = 0;
+    };
+
+private:
+    struct Page {
+        std::uint64_t number;
+        bool dirty;
+        std::unique_ptr<char[]> data;
+    };
+
+    std::fstream& file;
+    // Takes the write-backs when set; reads still go through the stream
+    FileWriter* writer;
+    std::size_t pageSize;
+    std::size_t capacity;
+    // Most recently used page at the front
+    std::list<Page> pages;
+    std::unordered_map<std::uint64_t, std::list<Page>::iterator> index;
+    Stats stats;
+
+    void writeBack(Page& page);
+
+public:
+    // Constructor; file must be open for binary reading and writing
+    PageCache(std::fstream& file, std::size_t pageSize, std::size_t budgetBytes);
+
+    PageCache(const PageCache&) = delete;
+    PageCache& operator=(const PageCache&) = delete;
+
+    /**
+     * Get a page, reading it from the file on a miss. Pages past the end of
+     * the file read as zeros. The pointer is valid until the next call to
+     * getPage, clear or the cache's destruction.
+     */
+    char* getPage(std::uint64_t pageNumber);
+
+    // Mark a cached page as modified so it is written back
+    void markDirty(std::uint64_t pageNumber);
+
+    // Write all dirty pages back to the file. With a writer they are only
+    // queued to it, for the owner to submit with its own writes.
+    void flush();
+
+    // Write pages back through writer (opened on the same file) instead of
+    // the stream, or through the stream again with nullptr
+    void setWriter(FileWriter* writer);
+
+    // Drop all cached pages without writing them back
+    void clear();
+
+    std::size_t getPageSize() const;
+    std::size_t getCapacity() const;
+    const Stats& getStats() const;
+};
+
+#endif // PAGE_CACHE_H
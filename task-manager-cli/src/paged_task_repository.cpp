@@ -0,0 +1,472 @@
+#include "paged_task_repository.h"
+#include "repository_exceptions.h"
+#include "error_logger.h"
+#include <cstring>
+#include <filesystem>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr char kMagic[4] = {'T', 'M', 'P', 'G'};
+constexpr std::uint32_t kVersion = 1;
+constexpr std::uint32_t kFlagSortedById = 1;
+
+// Header field offsets within page 0
+constexpr std::size_t kMagicOffset = 0;
+constexpr std::size_t kVersionOffset = 4;
+constexpr std::size_t kPageSizeOffset = 8;
+constexpr std::size_t kFlagsOffset = 12;
+constexpr std::size_t kMaxIdOffset = 16;
+constexpr std::size_t kTaskCountOffset = 24;
+constexpr std::size_t kPageCountOffset = 32;
+constexpr std::size_t kHeaderSize = 40;
+
+template <typename T>
+T readField(const char* data, std::size_t offset) {
+    T value;
+    std::memcpy(&value, data + offset, sizeof(T));
+    return value;
+}
+
+template <typename T>
+void writeField(char* data, std::size_t offset, T value) {
+    std::memcpy(data + offset, &value, sizeof(T));
+}
+
+} // namespace
+
+PagedTaskRepository::PagedTaskRepository(const std::string& filePath, std::size_t cacheBytes)
+    : filePath(filePath), cache(file, kPageSize, cacheBytes), fileLock(filePath + ".lock"),
+      released(0), durable(false), commit([this] { syncFile(this->filePath); }), headerPage{} {
+    // Exclusive, as the file may be created here
+    LockScope scope(fileLock, LockMode::EXCLUSIVE);
+    open(filePath, false);
+    released = fileLock.readCounter();
+}
+
+void PagedTaskRepository::open(const std::string& path, bool truncate) {
+    bool exists = !truncate && fs::exists(path);
+
+    // Read/write mode only creates the file when combined with truncation
+    std::ios::openmode mode = std::ios::in | std::ios::out | std::ios::binary;
+    if (!exists) {
+        mode |= std::ios::trunc;
+    }
+
+    file.open(path, mode);
+    if (!file.is_open()) {
+        std::string errorMsg = "Cannot open paged task file: " + path;
+        ErrorLogger::logError("PagedTaskRepository", errorMsg);
+        throw FileIOException(errorMsg);
+    }
+    if (writer) {
+        writer->open(path, false);
+    }
+
+    if (exists) {
+        readHeader();
+    } else {
+        header = Header{};
+        writeHeader();
+        if (writer) {
+            writer->submit(false);
+        } else {
+            file.flush();
+        }
+    }
+}
+
+void PagedTaskRepository::reopen() {
+    // The file may have been replaced, leaving the open one unlinked
+    cache.clear();
+    file.close();
+    open(filePath, false);
+}
+
+void PagedTaskRepository::rewrite(const TaskList& tasks, int maxId) {
+    // Built in a temporary file renamed over the old one, so a crash or a
+    // full disk part way leaves the old file whole. A durable rewrite syncs
+    // the new file before the rename and the directory after it.
+    std::string temporary = filePath + ".tmp";
+    // Advanced first, so a rewrite failing part way still shows as a change
+    fileLock.writeCounter(fileLock.readCounter() + 1);
+    cache.clear();
+    file.close();
+    try {
+        open(temporary, true);
+        for (const auto& task : tasks) {
+            appendRecord(task.getId(), task.getDescription(), task.isCompleted());
+        }
+        if (maxId > header.maxId) {
+            header.maxId = maxId;
+        }
+        cache.flush();
+        writeHeader();
+        if (writer) {
+            writer->submit(durable);
+            writer->close();
+        } else {
+            file.flush();
+            if (file.fail()) {
+                std::string errorMsg = "Failed to write paged task file: " + temporary;
+                ErrorLogger::logError("PagedTaskRepository", errorMsg);
+                throw FileIOException(errorMsg);
+            }
+        }
+        file.close();
+        if (durable && !writer) {
+            syncFile(temporary);
+        }
+        replaceFile(temporary, filePath, durable);
+    } catch (...) {
+        std::error_code error;
+        fs::remove(temporary, error);
+        reopen();
+        throw;
+    }
+    reopen();
+    if (durable) {
+        commit.recordSyncedWrite();
+    }
+}
+
+void PagedTaskRepository::readHeader() {
+    char data[kHeaderSize] = {};
+    file.clear();
+    file.seekg(0);
+    file.read(data, kHeaderSize);
+
+    if (file.gcount() != static_cast<std::streamsize>(kHeaderSize) ||
+        std::memcmp(data + kMagicOffset, kMagic, sizeof(kMagic)) != 0 ||
+        readField<std::uint32_t>(data, kVersionOffset) != kVersion ||
+        readField<std::uint32_t>(data, kPageSizeOffset) != kPageSize) {
+        std::string errorMsg = "Invalid paged task file: " + filePath;
+        ErrorLogger::logError("PagedTaskRepository", errorMsg);
+        throw RepositoryException(errorMsg);
+    }
+    file.clear();
+
+    header.maxId = readField<std::int32_t>(data, kMaxIdOffset);
+    header.taskCount = readField<std::uint64_t>(data, kTaskCountOffset);
+    header.pageCount = readField<std::uint64_t>(data, kPageCountOffset);
+    header.sortedById = (readField<std::uint32_t>(data, kFlagsOffset) & kFlagSortedById) != 0;
+}
+
+void PagedTaskRepository::writeHeader() {
+    char* data = headerPage;
+    std::memcpy(data + kMagicOffset, kMagic, sizeof(kMagic));
+    writeField<std::uint32_t>(data, kVersionOffset, kVersion);
+    writeField<std::uint32_t>(data, kPageSizeOffset, static_cast<std::uint32_t>(kPageSize));
+    writeField<std::uint32_t>(data, kFlagsOffset, header.sortedById ? kFlagSortedById : 0);
+    writeField<std::int32_t>(data, kMaxIdOffset, header.maxId);
+    writeField<std::uint64_t>(data, kTaskCountOffset, header.taskCount);
+    writeField<std::uint64_t>(data, kPageCountOffset, header.pageCount);
+
+    // Padded to a full page while there are no data pages, so they start at
+    // a page boundary
+    std::size_t size = header.pageCount == 1 ? kPageSize : kHeaderSize;
+    if (writer) {
+        writer->write(0, data, size);
+        return;
+    }
+    file.clear();
+    file.seekp(0);
+    file.write(data, static_cast<std::streamsize>(size));
+    if (file.fail()) {
+        std::string errorMsg = "Failed to write header of paged task file: " + filePath;
+        ErrorLogger::logError("PagedTaskRepository", errorMsg);
+        throw FileIOException(errorMsg);
+    }
+}
+
+void PagedTaskRepository::flush() {
+    fileLock.writeCounter(fileLock.readCounter() + 1);
+    cache.flush();
+    writeHeader();
+    bool synced = syncsWithWrites();
+    if (writer) {
+        // The pages and the header together, and the sync linked behind them
+        writer->submit(synced);
+    } else {
+        file.flush();
+    }
+    if (!durable) {
+        return;
+    }
+    if (synced) {
+        commit.recordSyncedWrite();
+    } else {
+        commit.recordWrite();
+    }
+}
+
+bool PagedTaskRepository::syncsWithWrites() const {
+    // Batches of one are synced alone anyway, so in the write's submission
+    return durable && writer && commit.getSettings().batchSize == 1;
+}
+
+void PagedTaskRepository::appendRecord(int id, std::string_view description, bool completed) {
+    if (description.size() > kMaxDescriptionSize) {
+        std::string errorMsg = "Description too long for paged storage (" +
+                               std::to_string(description.size()) + " bytes, max " +
+                               std::to_string(kMaxDescriptionSize) + ")";
+        ErrorLogger::logError("PagedTaskRepository", errorMsg);
+        throw RepositoryException(errorMsg);
+    }
+
+    std::size_t recordSize = kRecordHeaderSize + description.size();
+
+    // Append to the last data page, or start a new one when it is full
+    std::uint64_t pageNumber = header.pageCount - 1;
+    char* page = nullptr;
+    std::uint16_t used = 0;
+    if (pageNumber > 0) {
+        page = cache.getPage(pageNumber);
+        used = readField<std::uint16_t>(page, 2);
+    }
+    if (pageNumber == 0 || used + recordSize > kPageSize) {
+        pageNumber = header.pageCount++;
+        page = cache.getPage(pageNumber);
+        used = kPageHeaderSize;
+        writeField<std::uint16_t>(page, 0, 0);
+    }
+
+    char* record = page + used;
+    writeField<std::int32_t>(record, 0, id);
+    record[4] = completed ? 1 : 0;
+    record[5] = 0;
+    writeField<std::uint16_t>(record, 6, static_cast<std::uint16_t>(description.size()));
+    if (!description.empty()) {
+        std::memcpy(record + kRecordHeaderSize, description.data(), description.size());
+    }
+
+    writeField<std::uint16_t>(page, 0, readField<std::uint16_t>(page, 0) + 1);
+    writeField<std::uint16_t>(page, 2, static_cast<std::uint16_t>(used + recordSize));
+    cache.markDirty(pageNumber);
+
+    header.taskCount++;
+    if (id > header.maxId) {
+        header.maxId = id;
+    } else {
+        header.sortedById = false;
+    }
+}
+
+std::uint64_t PagedTaskRepository::findPage(int id) {
+    // Returns the only page that can hold id, or 0 when every page must be scanned
+    if (header.sortedById) {
+        // Binary search for the last page whose first record ID is <= id
+        std::uint64_t low = 1;
+        std::uint64_t high = header.pageCount;
+        while (high - low > 1) {
+            std::uint64_t mid = low + (high - low) / 2;
+            int firstId = readField<std::int32_t>(cache.getPage(mid), kPageHeaderSize);
+            if (firstId <= id) {
+                low = mid;
+            } else {
+                high = mid;
+            }
+        }
+        return low;
+    }
+    return 0;
+}
+
+TaskList PagedTaskRepository::loadTasks(std::pmr::memory_resource* resource, StringInterner* interner) {
+    LockScope scope(*this, LockMode::SHARED);
+    TaskList tasks(resource);
+    tasks.reserve(static_cast<std::size_t>(header.taskCount));
+    forEachTask([&](const TaskView& task) {
+        if (interner) {
+            tasks.emplace_back(task.id, task.description, task.completed, *interner);
+        } else {
+            tasks.emplace_back(task.id, task.description, task.completed);
+        }
+    });
+    return tasks;
+}
+
+void PagedTaskRepository::saveTasks(const TaskList& tasks) {
+    LockScope scope(*this, LockMode::EXCLUSIVE);
+    // Like the JSON repository, saving never lowers the ID counter
+    rewrite(tasks, header.maxId);
+}
+
+int PagedTaskRepository::getNextId() const {
+    return header.maxId + 1;
+}
+
+void PagedTaskRepository::resetIdCounter() {
+    LockScope scope(*this, LockMode::EXCLUSIVE);
+    header.maxId = 0;
+    if (header.taskCount > 0) {
+        header.sortedById = false;
+    }
+    flush();
+}
+
+bool PagedTaskRepository::supportsStreaming() const {
+    return true;
+}
+
+void PagedTaskRepository::forEachTask(const TaskVisitor& visitor) {
+    LockScope scope(*this, LockMode::SHARED);
+    for (std::uint64_t pageNumber = 1; pageNumber < header.pageCount; pageNumber++) {
+        const char* page = cache.getPage(pageNumber);
+        std::uint16_t count = readField<std::uint16_t>(page, 0);
+
+        const char* record = page + kPageHeaderSize;
+        for (std::uint16_t i = 0; i < count; i++) {
+            std::uint16_t length = readField<std::uint16_t>(record, 6);
+            visitor(TaskView{
+                readField<std::int32_t>(record, 0),
+                std::string_view(record + kRecordHeaderSize, length),
+                record[4] != 0
+            });
+            record += kRecordHeaderSize + length;
+        }
+    }
+}
+
+int PagedTaskRepository::appendTask(std::string_view description) {
+    LockScope scope(*this, LockMode::EXCLUSIVE);
+    int id = getNextId();
+    appendRecord(id, description, false);
+    flush();
+    return id;
+}
+
+int PagedTaskRepository::appendTasks(const TaskList& tasks) {
+    LockScope scope(*this, LockMode::EXCLUSIVE);
+    int first = getNextId();
+    int id = first;
+    for (const auto& task : tasks) {
+        appendRecord(id++, task.getDescription(), task.isCompleted());
+    }
+    flush();
+    return first;
+}
+
+bool PagedTaskRepository::setTaskCompleted(int id, bool completed) {
+    LockScope scope(*this, LockMode::EXCLUSIVE);
+    if (header.taskCount == 0) {
+        return false;
+    }
+
+    // With sorted IDs only one page can hold the task; otherwise scan them all
+    std::uint64_t first = 1;
+    std::uint64_t last = header.pageCount - 1;
+    if (std::uint64_t page = findPage(id); page != 0) {
+        first = page;
+        last = page;
+    }
+
+    for (std::uint64_t pageNumber = first; pageNumber <= last; pageNumber++) {
+        char* page = cache.getPage(pageNumber);
+        std::uint16_t count = readField<std::uint16_t>(page, 0);
+
+        char* record = page + kPageHeaderSize;
+        for (std::uint16_t i = 0; i < count; i++) {
+            if (readField<std::int32_t>(record, 0) == id) {
+                record[4] = completed ? 1 : 0;
+                cache.markDirty(pageNumber);
+                flush();
+                return true;
+            }
+            record += kRecordHeaderSize + readField<std::uint16_t>(record, 6);
+        }
+    }
+    return false;
+}
+
+void PagedTaskRepository::clearTasks() {
+    LockScope scope(*this, LockMode::EXCLUSIVE);
+    rewrite(TaskList(), 0);
+}
+
+void PagedTaskRepository::reload() {
+    LockScope scope(*this, LockMode::SHARED);
+    reopen();
+}
+
+void PagedTaskRepository::appendRecords(const TaskList& tasks) {
+    LockScope scope(*this, LockMode::EXCLUSIVE);
+    for (const auto& task : tasks) {
+        appendRecord(task.getId(), task.getDescription(), task.isCompleted());
+    }
+    flush();
+}
+
+void PagedTaskRepository::lock(LockMode mode) {
+    // Compared by generation rather than size and time, which a change of
+    // the same size within the file system's time resolution would not change
+    if (!fileLock.lock(mode) || fileLock.readCounter() == released) {
+        return;
+    }
+    // Another process wrote the file since, perhaps replacing it; cached
+    // pages and counts are stale
+    try {
+        reopen();
+    } catch (...) {
+        fileLock.unlock();
+        throw;
+    }
+}
+
+void PagedTaskRepository::unlock() {
+    if (fileLock.getDepth() == 1) {
+        released = fileLock.readCounter();
+    }
+    fileLock.unlock();
+}
+
+void PagedTaskRepository::setLockTimeout(std::chrono::milliseconds timeout) {
+    fileLock.setTimeout(timeout);
+}
+
+LockStats PagedTaskRepository::getLockStats() const {
+    return fileLock.getStats();
+}
+
+void PagedTaskRepository::setDurable(bool enabled, GroupCommit::Settings settings) {
+    durable = enabled;
+    commit.setSettings(settings);
+}
+
+void PagedTaskRepository::sync() {
+    if (durable) {
+        commit.sync();
+    }
+}
+
+GroupCommit::Stats PagedTaskRepository::getSyncStats() const {
+    return commit.getStats();
+}
+
+void PagedTaskRepository::setIoBackend(IoBackend backend) {
+    LockScope scope(*this, LockMode::EXCLUSIVE);
+    file.flush();
+    writer = FileWriter::create(backend);
+    if (writer) {
+        writer->open(filePath, false);
+    }
+    cache.setWriter(writer.get());
+}
+
+FileWriter::Stats PagedTaskRepository::getIoStats() const {
+    return writer ? writer->getStats() : FileWriter::Stats();
+}
+
+std::string PagedTaskRepository::exportFile(ExportFormat format) const {
+    // Every change is flushed before the call that made it returns
+    return format == ExportFormat::BINARY ? filePath : std::string();
+}
+
+std::uint64_t PagedTaskRepository::getTaskCount() const {
+    return header.taskCount;
+}
+
+const PageCache::Stats& PagedTaskRepository::getCacheStats() const {
+    return cache.getStats();
+}
@@ -0,0 +1,135 @@
+#ifndef PAGED_TASK_REPOSITORY_H
+#define PAGED_TASK_REPOSITORY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <memory_resource>
+#include "task.h"
+#include "i_task_repository.h"
+#include "repository_capabilities.h"
+#include "page_cache.h"
+
+/**
+ * Out-of-core task repository: records in fixed-size pages of a binary file,
+ * read through a bounded PageCache.
+ *
+ * File layout (native byte order):
+ *   page 0     header: magic "TMPG", version, page size, flags, max ID,
+ *              task count, page count
+ *   page 1..n  uint16 record count, uint16 bytes used, then records of
+ *              int32 id, uint8 completed, uint8 reserved, uint16 length,
+ *              description bytes
+ * Records never span pages, which bounds a description to kMaxDescriptionSize.
+ */
+class PagedTaskRepository : public ITaskRepository, public ILockableRepository, public IDurableRepository,
+                            public IFileBackedRepository {
+public:
+    static constexpr std::size_t kPageSize = 4096;
+    static constexpr std::size_t kDefaultCacheBytes = 1024 * 1024;
+    static constexpr std::size_t kPageHeaderSize = 4;
+    static constexpr std::size_t kRecordHeaderSize = 8;
+    static constexpr std::size_t kMaxDescriptionSize = kPageSize - kPageHeaderSize - kRecordHeaderSize;
+
+private:
+    struct Header {
+        int maxId = 0;
+        std::uint64_t taskCount = 0;
+        // Pages in the file, including the header page
+        std::uint64_t pageCount = 1;
+        // Records are in increasing ID order, so lookups can binary search pages
+        bool sortedById = true;
+    };
+
+    std::string filePath;
+    std::fstream file;
+    PageCache cache;
+    Header header;
+    FileLock fileLock;
+    // Generation of the file when this repository last released the lock
+    std::uint64_t released;
+    bool durable;
+    GroupCommit commit;
+    // Writes through the stream while null
+    std::unique_ptr<FileWriter> writer;
+    // Page 0 as last written; zeros past the header
+    char headerPage[kPageSize];
+
+    void open(const std::string& path, bool truncate);
+    void reopen();
+    void rewrite(const TaskList& tasks, int maxId);
+    void readHeader();
+    void writeHeader();
+    void flush();
+    bool syncsWithWrites() const;
+    void appendRecord(int id, std::string_view description, bool completed);
+    std::uint64_t findPage(int id);
+
+public:
+    // Constructor; opens or creates the file. At most cacheBytes of pages are cached.
+    explicit PagedTaskRepository(const std::string& filePath,
+                                 std::size_t cacheBytes = kDefaultCacheBytes);
+
+    // Load every task (materializes the whole store; prefer forEachTask)
+    TaskList loadTasks(std::pmr::memory_resource* resource = std::pmr::get_default_resource(),
+                       StringInterner* interner = nullptr) override;
+
+    // Replace the stored tasks, writing a new file page by page and renaming
+    // it over the old one
+    void saveTasks(const TaskList& tasks) override;
+
+    // Get next available ID
+    int getNextId() const override;
+
+    // Reset ID counter to 0 (next ID will be 1)
+    void resetIdCounter() override;
+
+    // Streaming operations; each mutation touches a single page plus the header
+    bool supportsStreaming() const override;
+    void forEachTask(const TaskVisitor& visitor) override;
+    int appendTask(std::string_view description) override;
+    int appendTasks(const TaskList& tasks) override;
+    bool setTaskCompleted(int id, bool completed) override;
+    void clearTasks() override;
+
+    // Reopen the file and drop cached pages (pending changes are lost)
+    void reload() override;
+
+    // Locks filePath + ".lock": shared for reads, exclusive for changes. Each
+    // change advances the lock file's generation; when another process moved
+    // it while the lock was not held, the file is reopened and cached pages
+    // are dropped.
+    void lock(LockMode mode) override;
+    void unlock() override;
+    void setLockTimeout(std::chrono::milliseconds timeout) override;
+    LockStats getLockStats() const override;
+
+    // Sync each change to the device before sync() returns, sharing syncs
+    // between callers as settings allow
+    void setDurable(bool enabled, GroupCommit::Settings settings = GroupCommit::Settings()) override;
+    void sync() override;
+    GroupCommit::Stats getSyncStats() const override;
+
+    // Dirty pages and the header go out through a FileWriter unless backend
+    // is STREAM, in one submission per change; pages are still read through
+    // the stream
+    void setIoBackend(IoBackend backend) override;
+    FileWriter::Stats getIoStats() const override;
+
+    // Append tasks keeping their IDs, for copying them in from another store
+    void appendRecords(const TaskList& tasks);
+
+    // The file is a binary export as it stands
+    std::string exportFile(ExportFormat format) const override;
+
+    // Number of stored tasks
+    std::uint64_t getTaskCount() const;
+
+    // Page cache counters
+    const PageCache::Stats& getCacheStats() const;
+};
+
+#endif // PAGED_TASK_REPOSITORY_H
@@ -0,0 +1,130 @@
+#ifndef REPOSITORY_CAPABILITIES_H
+#define REPOSITORY_CAPABILITIES_H
+
+#include <chrono>
+#include <cstdint>
+#include "i_task_repository.h"
+#include "file_lock.h"
+#include "group_commit.h"
+#include "file_writer.h"
+#include "work_stealing_pool.h"
+
+// Optional repository capabilities, implemented next to ITaskRepository and
+// found with capabilityOf; a repository without one behaves as if its calls
+// were no-ops.
+
+// The capability of this type, or nullptr when the repository lacks it
+template <typename Capability>
+Capability* capabilityOf(ITaskRepository& repository) {
+    return dynamic_cast<Capability*>(&repository);
+}
+
+/**
+ * Inter-process locking: shared while reading, exclusive while writing.
+ * Held across several calls so no other process writes in between; calls nest.
+ */
+class ILockableRepository {
+public:
+    virtual ~ILockableRepository() = default;
+
+    virtual void lock(LockMode mode) = 0;
+    virtual void unlock() = 0;
+
+    // Bound how long lock() waits for other processes
+    virtual void setLockTimeout(std::chrono::milliseconds timeout) = 0;
+    virtual LockStats getLockStats() const = 0;
+};
+
+// Holds a repository's lock for the enclosing scope, if it has one
+class RepositoryLockScope {
+    ILockableRepository* target;
+
+public:
+    RepositoryLockScope(ITaskRepository& repository, LockMode mode)
+        : target(capabilityOf<ILockableRepository>(repository)) {
+        if (target) {
+            target->lock(mode);
+        }
+    }
+    ~RepositoryLockScope() {
+        if (target) {
+            target->unlock();
+        }
+    }
+
+    RepositoryLockScope(const RepositoryLockScope&) = delete;
+    RepositoryLockScope& operator=(const RepositoryLockScope&) = delete;
+};
+
+/**
+ * Durability: writes are synced to the device by sync(), which callers
+ * finishing at about the same time share (see GroupCommit).
+ */
+class IDurableRepository {
+public:
+    virtual ~IDurableRepository() = default;
+
+    virtual void setDurable(bool enabled, GroupCommit::Settings settings = GroupCommit::Settings()) = 0;
+    virtual void sync() = 0;
+    virtual GroupCommit::Stats getSyncStats() const = 0;
+};
+
+// File-backed repositories writing through a FileWriter backend
+class IFileBackedRepository {
+public:
+    virtual ~IFileBackedRepository() = default;
+
+    virtual void setIoBackend(IoBackend backend) = 0;
+    virtual FileWriter::Stats getIoStats() const = 0;
+};
+
+/**
+ * Generations: every save and append advances the store's generation. Once
+ * optimistic, a save finding a later generation than its last load or save
+ * throws ConflictException instead of overwriting another writer's changes.
+ */
+class IVersionedRepository {
+public:
+    virtual ~IVersionedRepository() = default;
+
+    virtual void setOptimistic(bool enabled) = 0;
+    virtual bool isOptimistic() const = 0;
+    virtual std::uint64_t getGeneration() const = 0;
+
+    // Whether another process saved or appended since the last load or
+    // save; asked with the lock held
+    virtual bool isStale() = 0;
+};
+
+// Repositories that parse and format large files on a thread pool
+class IParallelRepository {
+public:
+    virtual ~IParallelRepository() = default;
+
+    // nullptr for none; the pool must outlive the repository's use of it
+    virtual void setThreadPool(WorkStealingPool* pool) = 0;
+};
+
+// Where a reader left off in a store that grows by appends
+struct AppendMark {
+    bool valid = false;
+    std::uint64_t generation = 0; // Of the store when it was read
+    std::uint64_t rewritten = 0;  // Generation of its last rewrite then
+    std::uint64_t offset = 0;     // Just past the last task read
+};
+
+/**
+ * Tail reads for followers. Both calls return false, visiting nothing, when
+ * the store was rewritten since the mark; the caller then reads everything.
+ */
+class ITailReadableRepository {
+public:
+    virtual ~ITailReadableRepository() = default;
+
+    // Note where the store ends now
+    virtual bool markAppends(AppendMark& mark) = 0;
+    // Visit the tasks appended since the mark and move it on
+    virtual bool forEachAppended(AppendMark& mark, const TaskVisitor& visitor) = 0;
+};
+
+#endif // REPOSITORY_CAPABILITIES_H
@@ -31,4 +31,24 @@ public:
         : RepositoryException("File I/O error: " + message) {}
 };
 
+/**
+ * Exception thrown when another process holds the tasks file's lock too long
+ */
+class LockTimeoutException : public RepositoryException {
+public:
+    explicit LockTimeoutException(const std::string& message)
+        : RepositoryException("Lock timeout: " + message) {}
+};
+
+/**
+ * Exception thrown by an optimistic save when another writer saved the
+ * store after this repository loaded it; loading again and making the
+ * change on the fresh tasks lets the save succeed
+ */
+class ConflictException : public RepositoryException {
+public:
+    explicit ConflictException(const std::string& message)
+        : RepositoryException("Conflict: " + message) {}
+};
+
 #endif // REPOSITORY_EXCEPTIONS_H
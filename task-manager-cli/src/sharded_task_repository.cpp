@@ -0,0 +1,372 @@
+#include "sharded_task_repository.h"
+#include "repository_exceptions.h"
+#include "error_logger.h"
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <queue>
+#include <tuple>
+#include <utility>
+
+using json = nlohmann::json;
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr std::uint64_t kFingerprintSeed = 0xcbf29ce484222325ULL;
+
+std::uint64_t combine(std::uint64_t seed, std::uint64_t value) {
+    return seed ^ (value + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2));
+}
+
+// Fingerprint of the tasks so far, extended by task
+std::uint64_t addToFingerprint(std::uint64_t fingerprint, const Task& task) {
+    fingerprint = combine(fingerprint, static_cast<std::uint64_t>(task.getId()) * 2 + (task.isCompleted() ? 1 : 0));
+    return combine(fingerprint, std::hash<std::string_view>()(task.getDescription()));
+}
+
+} // namespace
+
+std::optional<ShardRouting> parseShardRouting(std::string_view name) {
+    if (name == "hash") {
+        return ShardRouting::HASH;
+    }
+    if (name == "range") {
+        return ShardRouting::RANGE;
+    }
+    return std::nullopt;
+}
+
+const char* shardRoutingName(ShardRouting routing) {
+    return routing == ShardRouting::RANGE ? "range" : "hash";
+}
+
+ShardedTaskRepository::ShardedTaskRepository(const std::string& basePath, std::size_t shardCount,
+                                             ShardRouting routing, int rangeSize)
+    : basePath(basePath), routing(routing), rangeSize(std::max(rangeSize, 1)), maxId(0), lockDepth(0),
+      lastWritten(0), threadPool(nullptr), optimistic(false) {
+    shards.resize(std::max<std::size_t>(shardCount, 1));
+    for (std::size_t index = 0; index < shards.size(); index++) {
+        Shard& shard = shards[index];
+        shard.path = basePath + "." + std::to_string(index) + ".json";
+        shard.repository = std::make_unique<FileTaskRepository>(shard.path);
+    }
+    checkManifest();
+}
+
+void ShardedTaskRepository::checkManifest() {
+    std::string manifestPath = basePath + ".shards.json";
+    json expected = {
+        {"shards", shards.size()},
+        {"routing", shardRoutingName(routing)},
+        {"rangeSize", rangeSize}
+    };
+
+    if (!fs::exists(manifestPath)) {
+        std::ofstream file(manifestPath);
+        file << expected.dump(2);
+        if (!file) {
+            std::string errorMsg = "Cannot write shard manifest: " + manifestPath;
+            ErrorLogger::logError("ShardedTaskRepository", errorMsg);
+            throw FileIOException(errorMsg);
+        }
+        return;
+    }
+
+    std::ifstream file(manifestPath);
+    json manifest;
+    try {
+        file >> manifest;
+        // The range size only places tasks when routing by range
+        if (routing == ShardRouting::HASH && manifest.value("routing", "") == "hash") {
+            manifest["rangeSize"] = rangeSize;
+        }
+    } catch (const nlohmann::json::exception& e) {
+        std::string errorMsg = "Failed to parse shard manifest '" + manifestPath + "': " + e.what();
+        ErrorLogger::logError("ShardedTaskRepository", errorMsg);
+        throw JsonParseException(errorMsg);
+    }
+    if (manifest != expected) {
+        std::string errorMsg = manifestPath + " describes " + manifest.dump() + ", not " + expected.dump() +
+                               "; the tasks would be looked for in the wrong shards";
+        ErrorLogger::logError("ShardedTaskRepository", errorMsg);
+        throw RepositoryException(errorMsg);
+    }
+}
+
+TaskList ShardedTaskRepository::loadTasks(std::pmr::memory_resource* resource, StringInterner* interner) {
+    LockScope scope(*this, LockMode::SHARED);
+
+    // Shards are read on the pool into lists of their own; resource and
+    // interner are only used below, on this thread
+    std::vector<TaskList> loaded(shards.size());
+    parallelChunks(threadPool, shards.size(), 1, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t index = begin; index < end; index++) {
+            loaded[index] = shards[index].repository->loadTasks();
+            std::uint64_t fingerprint = kFingerprintSeed;
+            for (const auto& task : loaded[index]) {
+                fingerprint = addToFingerprint(fingerprint, task);
+            }
+            shards[index].fingerprint = fingerprint;
+        }
+    });
+
+    // Merge the shards, each in ID order as saved, by taking the lowest next ID
+    using Next = std::tuple<int, std::size_t, std::size_t>; // ID, shard, position
+    std::priority_queue<Next, std::vector<Next>, std::greater<Next>> next;
+    std::size_t total = 0;
+    for (std::size_t index = 0; index < loaded.size(); index++) {
+        total += loaded[index].size();
+        if (!loaded[index].empty()) {
+            next.emplace(loaded[index][0].getId(), index, 0);
+        }
+    }
+
+    TaskList tasks(resource);
+    tasks.reserve(total);
+    while (!next.empty()) {
+        auto [id, index, position] = next.top();
+        next.pop();
+        const Task& task = loaded[index][position];
+        if (interner) {
+            tasks.emplace_back(id, task.getDescription(), task.isCompleted(), *interner);
+        } else {
+            tasks.emplace_back(id, task.getDescription(), task.isCompleted());
+        }
+        maxId = std::max(maxId, id);
+        if (++position < loaded[index].size()) {
+            next.emplace(loaded[index][position].getId(), index, position);
+        }
+    }
+    return tasks;
+}
+
+void ShardedTaskRepository::saveTasks(const TaskList& tasks) {
+    writeShards(tasks);
+}
+
+void ShardedTaskRepository::saveSnapshot(const TaskSnapshot& tasks) {
+    writeShards(tasks);
+}
+
+template <typename Tasks>
+void ShardedTaskRepository::writeShards(const Tasks& tasks) {
+    LockScope scope(*this, LockMode::EXCLUSIVE);
+    if (optimistic) {
+        for (auto& shard : shards) {
+            std::uint64_t current = shard.repository->readGeneration();
+            if (current != shard.repository->getGeneration()) {
+                std::string errorMsg = "'" + shard.path + "' was saved at generation " + std::to_string(current) +
+                                       " since this list was loaded at generation " +
+                                       std::to_string(shard.repository->getGeneration());
+                throw ConflictException(errorMsg);
+            }
+        }
+    }
+
+    // Route the tasks, fingerprinting each shard's share as it goes
+    std::vector<std::vector<const Task*>> routed(shards.size());
+    std::vector<std::uint64_t> fingerprints(shards.size(), kFingerprintSeed);
+    for (const auto& task : tasks) {
+        std::size_t index = getShard(task.getId());
+        routed[index].push_back(&task);
+        fingerprints[index] = addToFingerprint(fingerprints[index], task);
+        maxId = std::max(maxId, task.getId());
+    }
+
+    std::vector<std::size_t> changed;
+    for (std::size_t index = 0; index < shards.size(); index++) {
+        if (shards[index].fingerprint != fingerprints[index]) {
+            changed.push_back(index);
+        }
+    }
+
+    // A shard failing to save keeps no fingerprint, so it is written again
+    // next time; the others' saves stand
+    lastWritten = changed.size();
+    parallelChunks(threadPool, changed.size(), 1, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t position = begin; position < end; position++) {
+            Shard& shard = shards[changed[position]];
+            shard.fingerprint.reset();
+            TaskList shardTasks;
+            shardTasks.reserve(routed[changed[position]].size());
+            for (const Task* task : routed[changed[position]]) {
+                shardTasks.push_back(*task);
+            }
+            shard.repository->saveTasks(shardTasks);
+            shard.fingerprint = fingerprints[changed[position]];
+        }
+    });
+}
+
+int ShardedTaskRepository::getNextId() const {
+    int largest = maxId;
+    for (const auto& shard : shards) {
+        largest = std::max(largest, shard.repository->getNextId() - 1);
+    }
+    return largest + 1;
+}
+
+void ShardedTaskRepository::resetIdCounter() {
+    maxId = 0;
+    for (auto& shard : shards) {
+        shard.repository->resetIdCounter();
+    }
+}
+
+void ShardedTaskRepository::lock(LockMode mode) {
+    // Always in shard order, so two holders cannot each wait for the other
+    for (std::size_t index = 0; index < shards.size(); index++) {
+        try {
+            shards[index].repository->lock(mode);
+        } catch (...) {
+            while (index-- > 0) {
+                shards[index].repository->unlock();
+            }
+            throw;
+        }
+    }
+    if (lockDepth++ == 0) {
+        for (auto& shard : shards) {
+            if (shard.repository->readGeneration() != shard.released) {
+                // Another process wrote the shard since; its tasks are unknown
+                shard.fingerprint.reset();
+            }
+        }
+    }
+}
+
+void ShardedTaskRepository::unlock() {
+    if (lockDepth == 1) {
+        for (auto& shard : shards) {
+            shard.released = shard.repository->readGeneration();
+        }
+    }
+    lockDepth--;
+    for (std::size_t index = shards.size(); index-- > 0;) {
+        shards[index].repository->unlock();
+    }
+}
+
+bool ShardedTaskRepository::isStale() {
+    for (auto& shard : shards) {
+        if (shard.repository->isStale()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void ShardedTaskRepository::setLockTimeout(std::chrono::milliseconds timeout) {
+    for (auto& shard : shards) {
+        shard.repository->setLockTimeout(timeout);
+    }
+}
+
+LockStats ShardedTaskRepository::getLockStats() const {
+    LockStats total;
+    for (const auto& shard : shards) {
+        LockStats stats = shard.repository->getLockStats();
+        total.acquisitions += stats.acquisitions;
+        total.contended += stats.contended;
+        total.timeouts += stats.timeouts;
+        total.waitSeconds += stats.waitSeconds;
+        total.maxWaitSeconds = std::max(total.maxWaitSeconds, stats.maxWaitSeconds);
+    }
+    return total;
+}
+
+void ShardedTaskRepository::setDurable(bool enabled, GroupCommit::Settings settings) {
+    for (auto& shard : shards) {
+        shard.repository->setDurable(enabled, settings);
+    }
+}
+
+void ShardedTaskRepository::sync() {
+    // Shards without writes since their last sync return at once
+    parallelChunks(threadPool, shards.size(), 1, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t index = begin; index < end; index++) {
+            shards[index].repository->sync();
+        }
+    });
+}
+
+GroupCommit::Stats ShardedTaskRepository::getSyncStats() const {
+    GroupCommit::Stats total;
+    for (const auto& shard : shards) {
+        GroupCommit::Stats stats = shard.repository->getSyncStats();
+        total.writes += stats.writes;
+        total.syncs += stats.syncs;
+    }
+    return total;
+}
+
+void ShardedTaskRepository::setIoBackend(IoBackend backend) {
+    for (auto& shard : shards) {
+        shard.repository->setIoBackend(backend);
+    }
+}
+
+FileWriter::Stats ShardedTaskRepository::getIoStats() const {
+    FileWriter::Stats total;
+    for (const auto& shard : shards) {
+        FileWriter::Stats stats = shard.repository->getIoStats();
+        total.writes += stats.writes;
+        total.syncs += stats.syncs;
+        total.systemCalls += stats.systemCalls;
+        total.bytes += stats.bytes;
+    }
+    return total;
+}
+
+void ShardedTaskRepository::setThreadPool(WorkStealingPool* pool) {
+    threadPool = pool;
+    for (auto& shard : shards) {
+        shard.repository->setThreadPool(pool);
+    }
+}
+
+void ShardedTaskRepository::setOptimistic(bool enabled) {
+    optimistic = enabled;
+    for (auto& shard : shards) {
+        shard.repository->setOptimistic(enabled);
+    }
+}
+
+bool ShardedTaskRepository::isOptimistic() const {
+    return optimistic;
+}
+
+std::uint64_t ShardedTaskRepository::getGeneration() const {
+    std::uint64_t total = 0;
+    for (const auto& shard : shards) {
+        total += shard.repository->getGeneration();
+    }
+    return total;
+}
+
+std::size_t ShardedTaskRepository::getShardCount() const {
+    return shards.size();
+}
+
+ShardRouting ShardedTaskRepository::getRouting() const {
+    return routing;
+}
+
+const std::string& ShardedTaskRepository::getShardPath(std::size_t shard) const {
+    return shards[shard].path;
+}
+
+std::size_t ShardedTaskRepository::getShard(int id) const {
+    auto key = static_cast<unsigned int>(id);
+    if (routing == ShardRouting::RANGE) {
+        key = (key - 1) / static_cast<unsigned int>(rangeSize);
+    }
+    return key % shards.size();
+}
+
+std::size_t ShardedTaskRepository::getLastWritten() const {
+    return lastWritten;
+}
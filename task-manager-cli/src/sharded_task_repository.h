@@ -0,0 +1,111 @@
+#ifndef SHARDED_TASK_REPOSITORY_H
+#define SHARDED_TASK_REPOSITORY_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "file_task_repository.h"
+#include "i_task_repository.h"
+#include "repository_capabilities.h"
+
+// How a sharded repository picks the shard of a task
+enum class ShardRouting {
+    HASH, // ID modulo the shard count: tasks spread evenly, neighbours apart
+    RANGE // Runs of rangeSize consecutive IDs share a shard, runs dealt round
+};
+
+// "hash" or "range"; nothing for other names
+std::optional<ShardRouting> parseShardRouting(std::string_view name);
+const char* shardRoutingName(ShardRouting routing);
+
+/**
+ * Tasks partitioned over JSON files base.0.json to base.N-1.json, loaded in
+ * parallel; a save rewrites only the shards whose tasks changed. The layout
+ * is recorded in base.shards.json, and IDs stay global.
+ */
+class ShardedTaskRepository : public ITaskRepository, public ILockableRepository, public IDurableRepository,
+                              public IFileBackedRepository, public IVersionedRepository,
+                              public IParallelRepository {
+public:
+    static constexpr std::size_t kDefaultShards = 8;
+    static constexpr int kDefaultRangeSize = 4096;
+
+private:
+    struct Shard {
+        std::unique_ptr<FileTaskRepository> repository;
+        std::string path;
+        // Of the tasks the file holds, when known
+        std::optional<std::uint64_t> fingerprint;
+        // Generation of the shard when this repository last released the lock
+        std::uint64_t released = 0;
+    };
+
+    std::string basePath;
+    ShardRouting routing;
+    int rangeSize;
+    std::vector<Shard> shards;
+    int maxId;
+    std::size_t lockDepth;
+    std::size_t lastWritten;
+    WorkStealingPool* threadPool;
+    bool optimistic;
+
+    void checkManifest();
+    template <typename Tasks>
+    void writeShards(const Tasks& tasks);
+
+public:
+    /**
+     * Open or create the shards of basePath
+     * @throws RepositoryException if basePath was sharded differently
+     * @throws FileIOException if the manifest cannot be read or written
+     */
+    explicit ShardedTaskRepository(const std::string& basePath, std::size_t shardCount = kDefaultShards,
+                                   ShardRouting routing = ShardRouting::HASH, int rangeSize = kDefaultRangeSize);
+
+    // Every task of every shard, in ID order
+    TaskList loadTasks(std::pmr::memory_resource* resource = std::pmr::get_default_resource(),
+                       StringInterner* interner = nullptr) override;
+
+    // Rewrite the shards whose tasks changed, in parallel on the pool
+    void saveTasks(const TaskList& tasks) override;
+    void saveSnapshot(const TaskSnapshot& tasks) override;
+
+    int getNextId() const override;
+    void resetIdCounter() override;
+
+    void lock(LockMode mode) override;
+    void unlock() override;
+    void setLockTimeout(std::chrono::milliseconds timeout) override;
+    // Summed over the shards; the longest wait is the longest of any shard
+    LockStats getLockStats() const override;
+
+    // Passed on to every shard; stats are summed
+    void setDurable(bool enabled, GroupCommit::Settings settings = GroupCommit::Settings()) override;
+    void sync() override;
+    GroupCommit::Stats getSyncStats() const override;
+    void setIoBackend(IoBackend backend) override;
+    FileWriter::Stats getIoStats() const override;
+    void setThreadPool(WorkStealingPool* pool) override;
+    // The generation is the sum of the shards'
+    void setOptimistic(bool enabled) override;
+    bool isOptimistic() const override;
+    std::uint64_t getGeneration() const override;
+    bool isStale() override;
+
+    std::size_t getShardCount() const;
+    ShardRouting getRouting() const;
+    const std::string& getShardPath(std::size_t shard) const;
+    // The shard holding the task with this ID
+    std::size_t getShard(int id) const;
+    // Shards rewritten by the last save
+    std::size_t getLastWritten() const;
+};
+
+#endif // SHARDED_TASK_REPOSITORY_H
@@ -0,0 +1,123 @@
+#include "shell.h"
+#include "repository_exceptions.h"
+#include <iomanip>
+#include <memory_resource>
+#include <optional>
+#include <string>
+#include <vector>
+
+Shell::Shell(TaskManager& manager, CLI& cli, std::chrono::milliseconds saveInterval)
+    : manager(manager), cli(cli), saveInterval(saveInterval), timing(false) {
+}
+
+void Shell::setTiming(bool enabled) {
+    timing = enabled;
+}
+
+void Shell::displayShellHelp(std::ostream& out) {
+    out << "Commands:\n";
+    out << "  add <description>    Add a new task\n";
+    out << "  list                 List all tasks\n";
+    out << "  complete <id>        Mark a task as completed\n";
+    out << "  clear                Clear all tasks\n";
+    out << "  batch <file>         Run one command per line from a file\n";
+    out << "  save                 Save pending changes now\n";
+    out << "  timing on|off        Print how long each command took\n";
+    out << "  exit, quit           Save and leave\n";
+}
+
+int Shell::run(std::istream& in, std::ostream& out, bool prompt) {
+    using Clock = std::chrono::steady_clock;
+
+    // Saved on the interval below instead; the deferral ends however the
+    // session does
+    std::optional<SaveDeferral> deferral;
+    if (saveInterval.count() > 0) {
+        deferral.emplace(manager);
+    }
+    Clock::time_point lastSave = Clock::now();
+
+    // "batch -" reads the rest of the shell's input as its script
+    CommandRunner runner(manager, cli, in);
+    std::string line;
+    std::pmr::monotonic_buffer_resource lineArena;
+
+    while (true) {
+        if (prompt) {
+            out << "task> " << std::flush;
+        }
+        if (!std::getline(in, line)) {
+            if (prompt) {
+                out << "\n";
+            }
+            break;
+        }
+
+        std::vector<std::string> words = CLI::splitCommandLine(line);
+        if (words.empty() || words[0][0] == '#') {
+            continue;
+        }
+
+        // Shell built-ins
+        const std::string& name = words[0];
+        if (name == "exit" || name == "quit") {
+            break;
+        }
+        if (name == "help") {
+            displayShellHelp(out);
+            continue;
+        }
+        if (name == "timing") {
+            if (words.size() > 1 && (words[1] == "on" || words[1] == "off")) {
+                timing = words[1] == "on";
+            } else {
+                timing = !timing;
+            }
+            out << "Timing is " << (timing ? "on" : "off") << "\n";
+            continue;
+        }
+
+        Clock::time_point start = Clock::now();
+        try {
+            if (name == "save") {
+                manager.save();
+                lastSave = Clock::now();
+                cli.displaySuccess("Changes saved", out);
+            } else {
+                Command cmd = cli.parseWords(words, &lineArena);
+                if (cmd.type == CommandType::SERVE || cmd.type == CommandType::SHELL) {
+                    cli.displayError(name + " cannot be started from the shell", out);
+                } else {
+                    runner.execute(cmd, out, false);
+                }
+            }
+        } catch (const std::exception& e) {
+            // Report and keep the session; nothing is lost while the tasks stay loaded
+            cli.displayError(e.what(), out);
+        }
+        lineArena.release();
+
+        if (timing) {
+            std::chrono::duration<double, std::milli> elapsed = Clock::now() - start;
+            out << "(" << std::fixed << std::setprecision(3) << elapsed.count() << " ms)\n";
+            out.unsetf(std::ios::floatfield);
+        }
+
+        if (manager.hasUnsavedChanges() && Clock::now() - lastSave >= saveInterval) {
+            try {
+                manager.save();
+            } catch (const RepositoryException& e) {
+                cli.displayError(std::string("Save failed, will retry: ") + e.what(), out);
+            }
+            lastSave = Clock::now();
+        }
+    }
+
+    try {
+        manager.save();
+    } catch (const RepositoryException& e) {
+        cli.displayError(std::string("Save failed, changes not saved: ") + e.what(), out);
+        return 1;
+    }
+    return 0;
+}
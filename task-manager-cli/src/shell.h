@@ -0,0 +1,47 @@
+#ifndef SHELL_H
+#define SHELL_H
+
+#include <chrono>
+#include <iostream>
+#include "cli.h"
+#include "command_runner.h"
+#include "task_manager.h"
+
+/**
+ * Interactive loop running command lines against a resident TaskManager;
+ * also understands help, save, timing on|off, exit and quit.
+ */
+class Shell {
+public:
+    static constexpr std::chrono::milliseconds kDefaultSaveInterval{5000};
+
+private:
+    TaskManager& manager;
+    CLI& cli;
+    std::chrono::milliseconds saveInterval;
+    bool timing;
+
+    void displayShellHelp(std::ostream& out);
+
+public:
+    /**
+     * Constructor; the manager and CLI must outlive the shell
+     * @param saveInterval Pending changes are saved after the first command
+     *        finishing this long after the last save (zero saves every change)
+     */
+    Shell(TaskManager& manager, CLI& cli,
+          std::chrono::milliseconds saveInterval = kDefaultSaveInterval);
+
+    // Print each command's wall-clock time after its output
+    void setTiming(bool enabled);
+
+    /**
+     * Read and run commands until exit or end of input, then save
+     * @param prompt Print a prompt before each command
+     * @return 0, or 1 when the final save failed (command failures are
+     *         reported and the shell carries on)
+     */
+    int run(std::istream& in = std::cin, std::ostream& out = std::cout, bool prompt = true);
+};
+
+#endif // SHELL_H
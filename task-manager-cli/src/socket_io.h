@@ -0,0 +1,258 @@
+#ifndef SOCKET_IO_H
+#define SOCKET_IO_H
+
+#ifndef _WIN32
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <streambuf>
+#include <string>
+#include <string_view>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+/**
+ * Framing shared by TaskServer and TaskClient: native byte order, strings as
+ * uint32 length and bytes, streams as chunks ended by an empty string.
+ *
+ * Request:  uint32 argc, argc strings (argv), uint8 hasInput,
+ *           input chunks and an empty string if hasInput
+ * Response: output chunks and an empty string, int32 exit status
+ */
+namespace socket_io {
+
+// Upper bound for a single string, so a bad peer cannot make us allocate without limit
+constexpr std::uint32_t kMaxStringSize = 256u * 1024 * 1024;
+
+// Largest piece of streamed input or output
+constexpr std::uint32_t kChunkSize = 64 * 1024;
+
+#ifdef MSG_NOSIGNAL
+constexpr int kSendFlags = MSG_NOSIGNAL;
+#else
+constexpr int kSendFlags = 0;
+#endif
+
+// Keep a peer that went away from raising SIGPIPE where send() cannot suppress it
+inline void configureSocket(int fd) {
+#ifdef SO_NOSIGPIPE
+    int on = 1;
+    ::setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#else
+    (void)fd;
+#endif
+}
+
+// Fill in a Unix socket address; fails when the path does not fit
+inline bool makeAddress(const std::string& path, sockaddr_un& address) {
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (path.empty() || path.size() >= sizeof(address.sun_path)) {
+        return false;
+    }
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    return true;
+}
+
+inline bool writeAll(int fd, const void* data, std::size_t size) {
+    const char* bytes = static_cast<const char*>(data);
+    while (size > 0) {
+        ssize_t written = ::send(fd, bytes, size, kSendFlags);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        bytes += written;
+        size -= static_cast<std::size_t>(written);
+    }
+    return true;
+}
+
+inline bool readAll(int fd, void* data, std::size_t size) {
+    char* bytes = static_cast<char*>(data);
+    while (size > 0) {
+        ssize_t received = ::recv(fd, bytes, size, 0);
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+        if (received <= 0) {
+            return false;
+        }
+        bytes += received;
+        size -= static_cast<std::size_t>(received);
+    }
+    return true;
+}
+
+inline bool writeUint32(int fd, std::uint32_t value) {
+    return writeAll(fd, &value, sizeof(value));
+}
+
+inline bool readUint32(int fd, std::uint32_t& value) {
+    return readAll(fd, &value, sizeof(value));
+}
+
+inline bool writeString(int fd, std::string_view value) {
+    if (value.size() > kMaxStringSize) {
+        return false;
+    }
+    return writeUint32(fd, static_cast<std::uint32_t>(value.size())) &&
+           writeAll(fd, value.data(), value.size());
+}
+
+inline bool readString(int fd, std::string& value) {
+    std::uint32_t size = 0;
+    if (!readUint32(fd, size) || size > kMaxStringSize) {
+        return false;
+    }
+    value.resize(size);
+    return readAll(fd, value.data(), size);
+}
+
+// Send what in holds as chunks, then the empty string that ends them
+inline bool writeChunks(int fd, std::istream& in) {
+    std::string chunk(kChunkSize, '\0');
+    while (in) {
+        in.read(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+        std::size_t count = static_cast<std::size_t>(in.gcount());
+        if (count > 0 && !writeString(fd, std::string_view(chunk.data(), count))) {
+            return false;
+        }
+    }
+    return writeUint32(fd, 0);
+}
+
+// Copy chunks to out as they arrive, up to the empty string that ends them
+inline bool readChunks(int fd, std::ostream& out) {
+    std::string chunk;
+    for (;;) {
+        std::uint32_t size = 0;
+        if (!readUint32(fd, size) || size > kChunkSize) {
+            return false;
+        }
+        if (size == 0) {
+            return true;
+        }
+        chunk.resize(size);
+        if (!readAll(fd, chunk.data(), size)) {
+            return false;
+        }
+        out.write(chunk.data(), static_cast<std::streamsize>(size));
+    }
+}
+
+/**
+ * Stream buffer over chunked input, receiving each chunk when the reader
+ * gets to it. A connection that breaks before the empty chunk throws
+ * std::runtime_error rather than ending the input, so give the istream
+ * badbit in exceptions() and a cut-off upload is not taken for a short one.
+ */
+class ChunkReader : public std::streambuf {
+    int fd;
+    bool finished;
+    std::string chunk;
+
+    // Receive the next chunk into the get area; false after the last one
+    bool nextChunk() {
+        if (finished) {
+            return false;
+        }
+        std::uint32_t size = 0;
+        if (!readUint32(fd, size) || size > kChunkSize) {
+            throw std::runtime_error("Connection lost while receiving input");
+        }
+        if (size == 0) {
+            finished = true;
+            return false;
+        }
+        chunk.resize(size);
+        if (!readAll(fd, chunk.data(), size)) {
+            throw std::runtime_error("Connection lost while receiving input");
+        }
+        setg(chunk.data(), chunk.data(), chunk.data() + size);
+        return true;
+    }
+
+protected:
+    int_type underflow() override {
+        if (gptr() == egptr() && !nextChunk()) {
+            return traits_type::eof();
+        }
+        return traits_type::to_int_type(*gptr());
+    }
+
+public:
+    // hasInput false reads as empty input without touching the socket
+    ChunkReader(int fd, bool hasInput) : fd(fd), finished(!hasInput) {}
+
+    // Skip the chunks nobody read, so the response follows the whole request
+    bool drain() {
+        try {
+            while (nextChunk()) {
+            }
+            return true;
+        } catch (const std::runtime_error&) {
+            return false;
+        }
+    }
+};
+
+/**
+ * Stream buffer sending what is written as chunks of up to kChunkSize bytes,
+ * each as it fills or the stream is flushed. Once the peer has gone away
+ * the rest is dropped, so the command writing it still runs to the end.
+ */
+class ChunkWriter : public std::streambuf {
+    int fd;
+    bool failed;
+    std::string chunk;
+
+    void sendChunk() {
+        std::size_t size = static_cast<std::size_t>(pptr() - pbase());
+        if (size > 0 && !failed) {
+            failed = !writeString(fd, std::string_view(pbase(), size));
+        }
+        setp(chunk.data(), chunk.data() + chunk.size());
+    }
+
+protected:
+    int_type overflow(int_type c) override {
+        sendChunk();
+        if (!traits_type::eq_int_type(c, traits_type::eof())) {
+            *pptr() = traits_type::to_char_type(c);
+            pbump(1);
+        }
+        return traits_type::not_eof(c);
+    }
+
+    int sync() override {
+        sendChunk();
+        return 0;
+    }
+
+public:
+    explicit ChunkWriter(int fd) : fd(fd), failed(false), chunk(kChunkSize, '\0') {
+        setp(chunk.data(), chunk.data() + chunk.size());
+    }
+
+    // Send what is left and the empty string ending the output; false when
+    // the peer did not get all of it
+    bool finish() {
+        sendChunk();
+        return !failed && writeUint32(fd, 0);
+    }
+};
+
+} // namespace socket_io
+
+#endif // _WIN32
+
+#endif // SOCKET_IO_H
@@ -0,0 +1,35 @@
+#include "string_interner.h"
+#include <cstring>
+
+StringInterner::StringInterner(std::pmr::memory_resource* upstream)
+    : storage(upstream), strings(upstream) {
+}
+
+const std::string_view& StringInterner::intern(std::string_view value) {
+    stats.references++;
+
+    auto existing = strings.find(value);
+    if (existing != strings.end()) {
+        stats.savedBytes += value.size();
+        return *existing;
+    }
+
+    // Copy the characters into the table's own storage before indexing them
+    char* data = static_cast<char*>(storage.allocate(value.size() + 1, alignof(char)));
+    if (!value.empty()) {
+        std::memcpy(data, value.data(), value.size());
+    }
+    data[value.size()] = '\0';
+
+    stats.uniqueStrings++;
+    stats.storedBytes += value.size();
+    return *strings.emplace(data, value.size()).first;
+}
+
+std::size_t StringInterner::size() const {
+    return strings.size();
+}
+
+const StringInterner::Stats& StringInterner::getStats() const {
+    return stats;
+}
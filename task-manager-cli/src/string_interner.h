@@ -0,0 +1,53 @@
+#ifndef STRING_INTERNER_H
+#define STRING_INTERNER_H
+
+#include <cstddef>
+#include <string_view>
+#include <unordered_set>
+#include <memory_resource>
+
+/**
+ * Table of unique strings. Interning a string returns a reference to the
+ * single stored copy, so identical task descriptions share one buffer.
+ * References stay valid for the lifetime of the interner, which must
+ * therefore outlive every task that uses it.
+ */
+class StringInterner {
+public:
+    /**
+     * Counters describing how much storage interning saved
+     */
+    struct Stats {
+        std::size_t uniqueStrings = 0; // Distinct strings stored in the table
+        std::size_t references = 0;    // Number of intern() calls
+        std::size_t storedBytes = 0;   // Characters held by the table
+        std::size_t savedBytes = 0;    // Characters duplicates did not have to store
+    };
+
+private:
+    std::pmr::monotonic_buffer_resource storage;
+    std::pmr::unordered_set<std::string_view> strings;
+    Stats stats;
+
+public:
+    // Constructor; the table and the string characters are allocated from upstream
+    explicit StringInterner(std::pmr::memory_resource* upstream = std::pmr::get_default_resource());
+
+    StringInterner(const StringInterner&) = delete;
+    StringInterner& operator=(const StringInterner&) = delete;
+
+    /**
+     * Get the shared copy of a string, storing it on first use
+     * @param value The string to intern
+     * @return Reference to the stored view; stable until the interner is destroyed
+     */
+    const std::string_view& intern(std::string_view value);
+
+    // Number of distinct strings stored
+    std::size_t size() const;
+
+    // Storage counters
+    const Stats& getStats() const;
+};
+
+#endif // STRING_INTERNER_H
@@ -1,21 +1,56 @@
 #include "task.h"
 
-Task::Task(int id, const std::string& description, bool completed)
-    : id(id), description(description), completed(completed) {
+Task::Task(int id, std::string_view description, bool completed, const allocator_type& alloc)
+    : id(id), completed(completed), description(description, alloc), interned(nullptr) {
+}
+
+Task::Task(int id, const char* description, bool completed, const allocator_type& alloc)
+    : Task(id, std::string_view(description), completed, alloc) {
+}
+
+Task::Task(int id, std::pmr::string&& description, bool completed, const allocator_type& alloc)
+    : id(id), completed(completed), description(std::move(description), alloc), interned(nullptr) {
+}
+
+Task::Task(int id, std::string_view description, bool completed, StringInterner& interner,
+           const allocator_type& alloc)
+    : id(id), completed(completed), description(alloc), interned(&interner.intern(description)) {
+}
+
+Task::Task(const Task& other, const allocator_type& alloc)
+    : id(other.id), completed(other.completed), description(other.description, alloc),
+      interned(other.interned) {
+}
+
+Task::Task(Task&& other, const allocator_type& alloc)
+    : id(other.id), completed(other.completed), description(std::move(other.description), alloc),
+      interned(other.interned) {
 }
 
 int Task::getId() const {
     return id;
 }
 
-std::string Task::getDescription() const {
-    return description;
+std::string_view Task::getDescription() const {
+    return interned ? *interned : std::string_view(description);
 }
 
 bool Task::isCompleted() const {
     return completed;
 }
 
+bool Task::hasInternedDescription() const {
+    return interned != nullptr;
+}
+
+Task::allocator_type Task::get_allocator() const {
+    return description.get_allocator();
+}
+
+TaskView Task::view() const {
+    return TaskView{id, getDescription(), completed};
+}
+
 void Task::setCompleted(bool completed) {
     this->completed = completed;
 }
@@ -23,15 +58,20 @@ void Task::setCompleted(bool completed) {
 json Task::toJson() const {
     return json{
         {"id", id},
-        {"description", description},
+        {"description", getDescription()},
         {"completed", completed}
     };
 }
 
-Task Task::fromJson(const json& j) {
-    return Task(
-        j.at("id").get<int>(),
-        j.at("description").get<std::string>(),
-        j.at("completed").get<bool>()
-    );
+Task Task::fromJson(const json& j, const allocator_type& alloc, StringInterner* interner) {
+    // Read the description in place so it is copied at most once, into alloc
+    // or into the interner
+    int id = j.at("id").get<int>();
+    std::string_view description(j.at("description").get_ref<const std::string&>());
+    bool completed = j.at("completed").get<bool>();
+
+    if (interner) {
+        return Task(id, description, completed, *interner, alloc);
+    }
+    return Task(id, description, completed, alloc);
 }
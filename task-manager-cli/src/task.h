@@ -2,31 +2,76 @@
 #define TASK_H
 
 #include <string>
+#include <string_view>
+#include <vector>
+#include <memory_resource>
 #include <nlohmann/json.hpp>
+#include "string_interner.h"
 
 using json = nlohmann::json;
 
+// Non-owning view of a task, handed out when tasks are streamed instead of
+// materialized; the description is only valid for the duration of the visit
+struct TaskView {
+    int id;
+    std::string_view description;
+    bool completed;
+};
+
 class Task {
+public:
+    // Allocator for the task's storage; lets std::pmr containers hand
+    // their memory resource down to the tasks they hold
+    using allocator_type = std::pmr::polymorphic_allocator<char>;
+
 private:
     int id;
-    std::string description;
     bool completed;
+    std::pmr::string description;
+    // Shared description from a StringInterner; when set, description stays empty
+    const std::string_view* interned;
 
 public:
-    // Constructor
-    Task(int id, const std::string& description, bool completed = false);
+    // Constructors; the string_view and C string forms copy the description once,
+    // the rvalue form adopts the buffer when it lives in the same memory resource
+    Task(int id, std::string_view description, bool completed = false,
+         const allocator_type& alloc = {});
+    Task(int id, const char* description, bool completed = false,
+         const allocator_type& alloc = {});
+    Task(int id, std::pmr::string&& description, bool completed = false,
+         const allocator_type& alloc = {});
+
+    // Constructor for a description shared through an interner
+    Task(int id, std::string_view description, bool completed, StringInterner& interner,
+         const allocator_type& alloc = {});
+
+    // Copy and move, including the allocator-extended forms used by std::pmr containers
+    Task(const Task& other) = default;
+    Task(Task&& other) noexcept = default;
+    Task(const Task& other, const allocator_type& alloc);
+    Task(Task&& other, const allocator_type& alloc);
+    Task& operator=(const Task& other) = default;
+    Task& operator=(Task&& other) = default;
 
     // Getters
     int getId() const;
-    std::string getDescription() const;
+    std::string_view getDescription() const;
     bool isCompleted() const;
+    bool hasInternedDescription() const;
+    allocator_type get_allocator() const;
+    TaskView view() const;
 
     // Setters
     void setCompleted(bool completed);
 
     // JSON serialization
     json toJson() const;
-    static Task fromJson(const json& j);
+    static Task fromJson(const json& j, const allocator_type& alloc = {},
+                         StringInterner* interner = nullptr);
 };
 
+// Task container used throughout the pipeline; the tasks and their
+// descriptions are allocated from the list's memory resource
+using TaskList = std::pmr::vector<Task>;
+
 #endif // TASK_H
@@ -0,0 +1,160 @@
+#include "task_client.h"
+#include "socket_io.h"
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+bool TaskClient::shouldForward(const Command& cmd) {
+    switch (cmd.type) {
+        case CommandType::LIST:
+            // Following watches the file, which the server saves to
+            return cmd.options.count("follow") == 0;
+        case CommandType::ADD:
+        case CommandType::SEARCH:
+        case CommandType::COMPLETE:
+        case CommandType::CLEAR:
+        case CommandType::BATCH:
+        case CommandType::IMPORT:
+        case CommandType::EXPORT:
+            return true;
+        default:
+            return false;
+    }
+}
+
+#ifdef _WIN32
+
+bool TaskClient::hasLocalSettings() {
+    return false;
+}
+
+std::optional<int> TaskClient::forward(const std::string&, const Command&, int, char*[],
+                                       std::ostream&, std::istream&) {
+    return std::nullopt;
+}
+
+#else
+
+extern char** environ;
+
+bool TaskClient::hasLocalSettings() {
+    constexpr std::string_view prefix = "TASK_MANAGER_";
+    constexpr std::string_view socket = "TASK_MANAGER_SOCKET=";
+    for (char** variable = environ; *variable; variable++) {
+        std::string_view entry(*variable);
+        if (entry.compare(0, prefix.size(), prefix) == 0 && entry.compare(0, socket.size(), socket) != 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+namespace {
+
+// Closes the connection on every return path
+class SocketGuard {
+    int fd;
+
+public:
+    explicit SocketGuard(int fd) : fd(fd) {}
+    ~SocketGuard() { ::close(fd); }
+    SocketGuard(const SocketGuard&) = delete;
+    SocketGuard& operator=(const SocketGuard&) = delete;
+};
+
+// Sends input on its own thread while the output is read, since the server
+// may answer before it has all of the input; waits for it on every path
+class InputSender {
+    int fd;
+    std::thread thread;
+
+public:
+    InputSender(int fd, std::istream* input) : fd(fd) {
+        if (input) {
+            thread = std::thread([fd, input] {
+                socket_io::writeChunks(fd, *input);
+            });
+        }
+    }
+    ~InputSender() {
+        if (thread.joinable()) {
+            // Unblocks a send the server will never read when the response broke off
+            ::shutdown(fd, SHUT_WR);
+            thread.join();
+        }
+    }
+    InputSender(const InputSender&) = delete;
+    InputSender& operator=(const InputSender&) = delete;
+};
+
+} // namespace
+
+std::optional<int> TaskClient::forward(const std::string& socketPath, const Command& cmd,
+                                       int argc, char* argv[],
+                                       std::ostream& out, std::istream& in) {
+    sockaddr_un address;
+    if (!socket_io::makeAddress(socketPath, address)) {
+        return std::nullopt;
+    }
+
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return std::nullopt;
+    }
+    SocketGuard guard(fd);
+    socket_io::configureSocket(fd);
+
+    // No server listening; the caller falls back to the tasks file
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        return std::nullopt;
+    }
+
+    std::uint8_t hasInput = 0;
+    std::ifstream script;
+    std::istream* input = &in;
+    if (cmd.type == CommandType::BATCH || cmd.type == CommandType::IMPORT) {
+        hasInput = 1;
+        if (cmd.argument != "-") {
+            script.open(std::string(cmd.argument), std::ios::binary);
+            if (!script.is_open()) {
+                // Let the direct path report the missing file
+                return std::nullopt;
+            }
+            input = &script;
+        }
+    }
+
+    std::vector<std::string> args(argv, argv + argc);
+    if (cmd.type == CommandType::EXPORT && cmd.argument != "-") {
+        // The server runs in its own directory, so a relative destination is resolved here
+        for (int i = 2; i < argc; i++) {
+            if (std::string_view(args[i]) == cmd.argument) {
+                args[i] = std::filesystem::absolute(args[i]).string();
+                break;
+            }
+        }
+    }
+
+    bool sent = socket_io::writeUint32(fd, static_cast<std::uint32_t>(argc));
+    for (int i = 0; sent && i < argc; i++) {
+        sent = socket_io::writeString(fd, args[i]);
+    }
+    sent = sent && socket_io::writeAll(fd, &hasInput, sizeof(hasInput));
+
+    // Past this point the server may have run the command, so retrying locally could apply it twice
+    std::int32_t status = 1;
+    {
+        InputSender sender(fd, sent && hasInput ? input : nullptr);
+        sent = sent && socket_io::readChunks(fd, out) && socket_io::readAll(fd, &status, sizeof(status));
+    }
+    if (!sent) {
+        throw std::runtime_error("Lost connection to the task server on " + socketPath);
+    }
+    return status;
+}
+
+#endif // _WIN32
@@ -0,0 +1,33 @@
+#ifndef TASK_CLIENT_H
+#define TASK_CLIENT_H
+
+#include <iostream>
+#include <optional>
+#include <string>
+#include "cli.h"
+
+/**
+ * Thin client that hands a command line to a running TaskServer instead of
+ * loading the tasks file in this process.
+ */
+class TaskClient {
+public:
+    // Whether a command is run by the daemon when one is listening
+    static bool shouldForward(const Command& cmd);
+
+    // Whether the environment sets any TASK_MANAGER_* variable besides
+    // TASK_MANAGER_SOCKET. The server would run the command with its own
+    // storage settings instead, so such commands are not forwarded.
+    static bool hasLocalSettings();
+
+    /**
+     * Run a command line on the server, streaming its input and output
+     * @return The exit status, or nullopt when the caller should run it itself
+     * @throws std::runtime_error if the connection breaks after the request was sent
+     */
+    static std::optional<int> forward(const std::string& socketPath, const Command& cmd,
+                                      int argc, char* argv[],
+                                      std::ostream& out = std::cout, std::istream& in = std::cin);
+};
+
+#endif // TASK_CLIENT_H
@@ -0,0 +1,236 @@
+#include "task_events.h"
+#include "error_logger.h"
+#include <algorithm>
+#include <exception>
+#include <string>
+#include <utility>
+
+const char* taskEventTypeName(TaskEventType type) {
+    switch (type) {
+        case TaskEventType::ADDED:
+            return "added";
+        case TaskEventType::COMPLETED:
+            return "completed";
+        case TaskEventType::CLEARED:
+            return "cleared";
+        case TaskEventType::RELOADED:
+            return "reloaded";
+    }
+    return "unknown";
+}
+
+TaskEventDispatcher::TaskEventDispatcher()
+    : subscriptions(std::make_shared<const SubscriptionList>()), subscriberCount(0), nextId(1), eventCount(0),
+      batchCount(0) {
+}
+
+TaskEventDispatcher::~TaskEventDispatcher() {
+    std::shared_ptr<const SubscriptionList> list;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        list = std::move(subscriptions);
+        subscriberCount = 0;
+    }
+    for (const auto& subscription : *list) {
+        subscription->active = false;
+        stop(*subscription);
+    }
+}
+
+std::shared_ptr<const TaskEventDispatcher::SubscriptionList> TaskEventDispatcher::currentList() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return subscriptions;
+}
+
+TaskEventDispatcher::SubscriptionId TaskEventDispatcher::subscribe(TaskEventHandler handler) {
+    return subscribe(std::move(handler), Settings());
+}
+
+TaskEventDispatcher::SubscriptionId TaskEventDispatcher::subscribe(TaskEventHandler handler, Settings settings) {
+    auto subscription = std::make_shared<Subscription>();
+    subscription->handler = std::move(handler);
+    subscription->settings = settings;
+    if (settings.delivery == Delivery::ASYNC) {
+        // The thread keeps the subscription alive, in case it is detached
+        // by unsubscribing from its own handler
+        subscription->thread = std::thread([this, subscription] {
+            run(*subscription);
+        });
+        subscription->threadId = subscription->thread.get_id();
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    subscription->id = nextId++;
+    auto list = std::make_shared<SubscriptionList>(*subscriptions);
+    list->push_back(subscription);
+    subscriptions = std::move(list);
+    subscriberCount = subscriptions->size();
+    return subscription->id;
+}
+
+bool TaskEventDispatcher::unsubscribe(SubscriptionId id) {
+    std::shared_ptr<Subscription> removed;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto list = std::make_shared<SubscriptionList>();
+        for (const auto& subscription : *subscriptions) {
+            if (subscription->id == id) {
+                removed = subscription;
+            } else {
+                list->push_back(subscription);
+            }
+        }
+        if (!removed) {
+            return false;
+        }
+        subscriptions = std::move(list);
+        subscriberCount = subscriptions->size();
+    }
+    // A publish that took the list before may still reach it
+    removed->active = false;
+    stop(*removed);
+    return true;
+}
+
+bool TaskEventDispatcher::hasSubscribers() const {
+    return subscriberCount.load(std::memory_order_acquire) > 0;
+}
+
+void TaskEventDispatcher::publish(const std::vector<TaskEvent>& events) {
+    if (events.empty() || !hasSubscribers()) {
+        return;
+    }
+    std::shared_ptr<const SubscriptionList> list = currentList();
+    eventCount += events.size();
+    for (const auto& subscription : *list) {
+        if (!subscription->active) {
+            continue;
+        }
+        std::size_t limit = subscription->settings.maxBatch;
+        if (subscription->settings.delivery == Delivery::ASYNC) {
+            {
+                std::lock_guard<std::mutex> lock(subscription->mutex);
+                subscription->queue.insert(subscription->queue.end(), events.begin(), events.end());
+            }
+            subscription->wake.notify_one();
+        } else if (limit == 0 || events.size() <= limit) {
+            deliver(*subscription, events);
+        } else {
+            for (std::size_t begin = 0; begin < events.size() && subscription->active; begin += limit) {
+                std::size_t end = std::min(events.size(), begin + limit);
+                deliver(*subscription, std::vector<TaskEvent>(events.begin() + begin, events.begin() + end));
+            }
+        }
+    }
+}
+
+void TaskEventDispatcher::deliver(Subscription& subscription, const std::vector<TaskEvent>& batch) {
+    // Counted first: a handler that unsubscribed itself leaves its thread
+    // detached, and the dispatcher may be gone once it returns
+    batchCount++;
+    try {
+        subscription.handler(batch);
+    } catch (const std::exception& e) {
+        ErrorLogger::logError("TaskEventDispatcher",
+                              "Subscriber " + std::to_string(subscription.id) + " threw: " + e.what());
+    } catch (...) {
+        ErrorLogger::logError("TaskEventDispatcher", "Subscriber " + std::to_string(subscription.id) + " threw");
+    }
+}
+
+void TaskEventDispatcher::run(Subscription& subscription) {
+    const Settings& settings = subscription.settings;
+    std::vector<TaskEvent> batch;
+    std::unique_lock<std::mutex> lock(subscription.mutex);
+    for (;;) {
+        subscription.wake.wait(lock, [&] {
+            return subscription.stopping || !subscription.queue.empty();
+        });
+        if (settings.window.count() > 0 &&
+            (settings.maxBatch == 0 || subscription.queue.size() < settings.maxBatch)) {
+            subscription.wake.wait_for(lock, settings.window, [&] {
+                return subscription.stopping ||
+                       (settings.maxBatch != 0 && subscription.queue.size() >= settings.maxBatch);
+            });
+        }
+        if (subscription.stopping) {
+            return;
+        }
+
+        std::size_t count = subscription.queue.size();
+        if (settings.maxBatch != 0) {
+            count = std::min(count, settings.maxBatch);
+        }
+        auto end = subscription.queue.begin() + static_cast<std::ptrdiff_t>(count);
+        batch.assign(subscription.queue.begin(), end);
+        subscription.queue.erase(subscription.queue.begin(), end);
+        subscription.delivering = true;
+        lock.unlock();
+        deliver(subscription, batch);
+        lock.lock();
+        subscription.delivering = false;
+        if (subscription.queue.empty()) {
+            subscription.drained.notify_all();
+        }
+    }
+}
+
+void TaskEventDispatcher::stop(Subscription& subscription) {
+    if (!subscription.thread.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(subscription.mutex);
+        subscription.stopping = true;
+        subscription.queue.clear();
+    }
+    subscription.wake.notify_all();
+    subscription.drained.notify_all();
+    if (subscription.threadId == std::this_thread::get_id()) {
+        subscription.thread.detach();
+    } else {
+        subscription.thread.join();
+    }
+}
+
+void TaskEventDispatcher::flush() {
+    std::shared_ptr<const SubscriptionList> list = currentList();
+    for (const auto& subscription : *list) {
+        if (subscription->settings.delivery != Delivery::ASYNC ||
+            subscription->threadId == std::this_thread::get_id()) {
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(subscription->mutex);
+        subscription->drained.wait(lock, [&] {
+            return subscription->stopping || (subscription->queue.empty() && !subscription->delivering);
+        });
+    }
+}
+
+TaskEventDispatcher::Stats TaskEventDispatcher::getStats() const {
+    Stats stats;
+    stats.events = eventCount.load();
+    stats.batches = batchCount.load();
+    return stats;
+}
+
+TaskEventBuffer::TaskEventBuffer(TaskEventDispatcher& dispatcher) : dispatcher(dispatcher), sequence(0) {
+}
+
+void TaskEventBuffer::add(TaskEventType type, int firstId, int count) {
+    if (dispatcher.hasSubscribers()) {
+        pending.push_back(TaskEvent{type, firstId, count, ++sequence});
+    }
+}
+
+void TaskEventBuffer::discard() {
+    pending.clear();
+}
+
+void TaskEventBuffer::publish() {
+    while (!pending.empty()) {
+        publishing.clear();
+        publishing.swap(pending);
+        dispatcher.publish(publishing);
+    }
+}
@@ -0,0 +1,152 @@
+#ifndef TASK_EVENTS_H
+#define TASK_EVENTS_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// What a change did to the tasks
+enum class TaskEventType {
+    ADDED,     // Tasks firstId to firstId + count - 1 were added
+    COMPLETED, // Task firstId was marked completed
+    CLEARED,   // Every task was removed
+    RELOADED   // The tasks were read from storage again; anything may have changed
+};
+
+const char* taskEventTypeName(TaskEventType type);
+
+struct TaskEvent {
+    TaskEventType type = TaskEventType::ADDED;
+    int firstId = 0;
+    int count = 0;
+    // Numbers the events of one manager from 1, in the order of the changes
+    std::uint64_t sequence = 0;
+};
+
+// Receives events in batches, in order, each batch at least one event long
+using TaskEventHandler = std::function<void(const std::vector<TaskEvent>&)>;
+
+/**
+ * Hands task events to subscribers: synchronous ones on the publishing
+ * thread, asynchronous ones each on a thread of their own.
+ */
+class TaskEventDispatcher {
+public:
+    using SubscriptionId = std::uint64_t;
+
+    enum class Delivery {
+        SYNC, // On the publishing thread, under the manager's lock
+        ASYNC // On the subscription's own thread
+    };
+
+    struct Settings {
+        Delivery delivery = Delivery::SYNC;
+        // Most events per handler call (0: no bound). Synchronous batches
+        // hold what one change, or one lock() of the manager, published.
+        std::size_t maxBatch = 0;
+        // How long an asynchronous subscription waits for more events
+        // before delivering fewer than maxBatch
+        std::chrono::microseconds window{0};
+    };
+
+    struct Stats {
+        std::uint64_t events = 0;  // Events published while anyone subscribed
+        std::uint64_t batches = 0; // Handler calls, over all subscribers
+    };
+
+private:
+    struct Subscription {
+        SubscriptionId id = 0;
+        TaskEventHandler handler;
+        Settings settings;
+        std::atomic<bool> active{true};
+        // Asynchronous delivery
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::condition_variable drained;
+        std::deque<TaskEvent> queue;
+        bool delivering = false;
+        bool stopping = false;
+        std::thread thread;
+        std::thread::id threadId;
+    };
+    using SubscriptionList = std::vector<std::shared_ptr<Subscription>>;
+
+    std::mutex mutex;
+    std::shared_ptr<const SubscriptionList> subscriptions;
+    std::atomic<std::size_t> subscriberCount;
+    SubscriptionId nextId;
+    std::atomic<std::uint64_t> eventCount;
+    std::atomic<std::uint64_t> batchCount;
+
+    std::shared_ptr<const SubscriptionList> currentList();
+    void deliver(Subscription& subscription, const std::vector<TaskEvent>& batch);
+    void run(Subscription& subscription);
+    static void stop(Subscription& subscription);
+
+public:
+    TaskEventDispatcher();
+    // Stops the asynchronous subscriptions, dropping what they have not delivered
+    ~TaskEventDispatcher();
+
+    TaskEventDispatcher(const TaskEventDispatcher&) = delete;
+    TaskEventDispatcher& operator=(const TaskEventDispatcher&) = delete;
+
+    // Start delivering events published from now on to handler
+    SubscriptionId subscribe(TaskEventHandler handler);
+    SubscriptionId subscribe(TaskEventHandler handler, Settings settings);
+
+    // Stop delivering to the subscription; events it has not been handed are
+    // dropped. Waits for an asynchronous handler call in progress, unless
+    // called from that handler. Returns false for an unknown ID.
+    bool unsubscribe(SubscriptionId id);
+
+    bool hasSubscribers() const;
+
+    // Deliver events to every subscriber, in order
+    void publish(const std::vector<TaskEvent>& events);
+
+    // Wait until every asynchronous subscription has delivered the events
+    // published so far (a subscription's own handler does not wait for it)
+    void flush();
+
+    Stats getStats() const;
+};
+
+/**
+ * Events of a writer's changes, held while it has the manager and then
+ * published in order.
+ */
+class TaskEventBuffer {
+    TaskEventDispatcher& dispatcher;
+    std::vector<TaskEvent> pending;
+    std::vector<TaskEvent> publishing;
+    std::uint64_t sequence;
+
+public:
+    // Constructor; the dispatcher must outlive the buffer
+    explicit TaskEventBuffer(TaskEventDispatcher& dispatcher);
+
+    TaskEventBuffer(const TaskEventBuffer&) = delete;
+    TaskEventBuffer& operator=(const TaskEventBuffer&) = delete;
+
+    // Hold an event, numbered after the last; nothing while nobody subscribed
+    void add(TaskEventType type, int firstId = 0, int count = 0);
+
+    // Drop the events held, of changes undone
+    void discard();
+
+    // Publish the events held; those of changes synchronous handlers make
+    // meanwhile go out in the next round
+    void publish();
+};
+
+#endif // TASK_EVENTS_H
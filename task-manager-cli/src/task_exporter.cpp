@@ -0,0 +1,306 @@
+#include "task_exporter.h"
+#include "paged_task_repository.h"
+#include "repository_exceptions.h"
+#include "error_logger.h"
+#include "work_stealing_pool.h"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <memory_resource>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+#ifdef __linux__
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+
+[[noreturn]] void fail(const std::string& message) {
+    ErrorLogger::logError("TaskExporter", message);
+    throw FileIOException(message);
+}
+
+#ifdef __linux__
+
+// Closes a file descriptor on every return path
+class FileGuard {
+    int fd;
+
+public:
+    explicit FileGuard(int fd) : fd(fd) {}
+    ~FileGuard() { ::close(fd); }
+    FileGuard(const FileGuard&) = delete;
+    FileGuard& operator=(const FileGuard&) = delete;
+};
+
+// Copy inside the kernel: copy_file_range, or sendfile where the file
+// systems do not support it (before Linux 5.3, across file systems)
+void copyFile(const std::string& from, const std::string& to) {
+    int in = ::open(from.c_str(), O_RDONLY | O_CLOEXEC);
+    if (in < 0) {
+        fail("Cannot open " + from);
+    }
+    FileGuard inGuard(in);
+    int out = ::open(to.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (out < 0) {
+        fail("Cannot create export file: " + to);
+    }
+    FileGuard outGuard(out);
+
+    struct stat status;
+    if (::fstat(in, &status) != 0) {
+        fail("Cannot read size of " + from);
+    }
+
+    off_t remaining = status.st_size;
+    bool copyRange = true;
+    while (remaining > 0) {
+        ssize_t copied = copyRange
+            ? ::copy_file_range(in, nullptr, out, nullptr, static_cast<std::size_t>(remaining), 0)
+            : ::sendfile(out, in, nullptr, static_cast<std::size_t>(remaining));
+        if (copied < 0 && errno == EINTR) {
+            continue;
+        }
+        if (copied < 0 && copyRange &&
+            (errno == EXDEV || errno == ENOSYS || errno == EINVAL || errno == EOPNOTSUPP)) {
+            copyRange = false;
+            continue;
+        }
+        if (copied < 0) {
+            fail("Failed to copy " + from + " to " + to);
+        }
+        if (copied == 0) {
+            break;
+        }
+        remaining -= copied;
+    }
+}
+
+#else
+
+void copyFile(const std::string& from, const std::string& to) {
+    std::error_code error;
+    fs::copy_file(from, to, fs::copy_options::overwrite_existing, error);
+    if (error) {
+        fail("Failed to copy " + from + " to " + to + ": " + error.message());
+    }
+}
+
+#endif
+
+} // namespace
+
+TaskExporter::TaskExporter(TaskManager& manager, CLI& cli) : manager(manager), cli(cli) {
+}
+
+std::optional<ExportFormat> TaskExporter::parseFormat(std::string_view name) {
+    if (name == "json") return ExportFormat::JSON;
+    if (name == "ndjson") return ExportFormat::NDJSON;
+    if (name == "binary") return ExportFormat::BINARY;
+    return std::nullopt;
+}
+
+void TaskExporter::forEachTask(const TaskSnapshot* snapshot, const TaskVisitor& visitor) {
+    if (!snapshot) {
+        manager.forEachTask(visitor);
+        return;
+    }
+    for (const auto& task : *snapshot) {
+        visitor(task.view());
+    }
+}
+
+std::size_t TaskExporter::writeText(std::ostream& out, ExportFormat format, const TaskSnapshot* snapshot) {
+    WorkStealingPool* pool = manager.getThreadPool();
+    if (snapshot && pool && snapshot->size() >= 2 * kBlockSize) {
+        return writeTextBlocks(out, format, *snapshot, pool);
+    }
+
+    std::size_t count = 0;
+    OutputBuffer buffer(out, kBufferSize);
+    bool json = format == ExportFormat::JSON;
+    if (json) {
+        buffer.append('[');
+    }
+    forEachTask(snapshot, [&](const TaskView& task) {
+        if (json) {
+            buffer.append(std::string_view(count == 0 ? "\n  " : ",\n  "));
+        }
+        cli.displayTaskJson(task, buffer);
+        if (!json) {
+            buffer.append('\n');
+        }
+        count++;
+    });
+    if (json) {
+        buffer.append(std::string_view(count == 0 ? "]\n" : "\n]\n"));
+    }
+    return count;
+}
+
+std::size_t TaskExporter::writeTextBlocks(std::ostream& out, ExportFormat format, const TaskSnapshot& snapshot,
+                                          WorkStealingPool* pool) {
+    // A window of blocks is formatted on the pool, each into its own stream,
+    // and then written in order, so memory stays bounded by the window
+    std::size_t chunksPerBlock = std::max<std::size_t>(1, kBlockSize / TaskVersion::kChunkSize);
+    std::size_t blocks = (snapshot.chunkCount() + chunksPerBlock - 1) / chunksPerBlock;
+    std::size_t window = pool->getThreadCount() * 2;
+    std::vector<std::ostringstream> texts(window);
+    bool json = format == ExportFormat::JSON;
+    if (json) {
+        out.put('[');
+    }
+
+    for (std::size_t first = 0; first < blocks; first += window) {
+        std::size_t count = std::min(window, blocks - first);
+        parallelChunks(pool, count, 1, [&](std::size_t begin, std::size_t end) {
+            for (std::size_t slot = begin; slot < end; slot++) {
+                std::size_t block = first + slot;
+                std::size_t chunkEnd = std::min(snapshot.chunkCount(), (block + 1) * chunksPerBlock);
+                bool leading = block == 0;
+                texts[slot].str(std::string());
+                OutputBuffer buffer(texts[slot]);
+                for (std::size_t chunk = block * chunksPerBlock; chunk < chunkEnd; chunk++) {
+                    for (const Task& task : snapshot.chunk(chunk)) {
+                        if (json) {
+                            buffer.append(std::string_view(leading ? "\n  " : ",\n  "));
+                            leading = false;
+                        }
+                        cli.displayTaskJson(task.view(), buffer);
+                        if (!json) {
+                            buffer.append('\n');
+                        }
+                    }
+                }
+            }
+        });
+        for (std::size_t slot = 0; slot < count; slot++) {
+            std::string text = texts[slot].str();
+            out.write(text.data(), static_cast<std::streamsize>(text.size()));
+        }
+    }
+
+    if (json) {
+        out << (snapshot.empty() ? "]\n" : "\n]\n");
+    }
+    return snapshot.size();
+}
+
+std::size_t TaskExporter::writeBinary(const std::string& path, const TaskSnapshot* snapshot) {
+    // Blocks of tasks are appended as they are visited; their descriptions
+    // go back to the pool after each block, so memory stays bounded
+    std::size_t count = 0;
+    {
+        PagedTaskRepository target(path);
+        std::pmr::unsynchronized_pool_resource pool;
+        TaskList block(&pool);
+        block.reserve(kBlockSize);
+        forEachTask(snapshot, [&](const TaskView& task) {
+            block.emplace_back(task.id, task.description, task.completed);
+            if (block.size() == kBlockSize) {
+                target.appendRecords(block);
+                block.clear();
+            }
+            count++;
+        });
+        target.appendRecords(block);
+    }
+
+    // No other process knows the temporary file, so its lock file can go
+    std::error_code error;
+    fs::remove(path + ".lock", error);
+    return count;
+}
+
+void TaskExporter::writeFile(const std::string& path, ExportFormat format, const std::string& source,
+                             const TaskSnapshot* snapshot, Result& result) {
+    // Written next to the destination and renamed over it, so an existing
+    // backup is only replaced by a complete one
+    std::string temporary = path + ".tmp";
+    fs::remove(temporary);
+    try {
+        if (!source.empty()) {
+            copyFile(source, temporary);
+            result.copied = true;
+        } else if (format == ExportFormat::BINARY) {
+            result.tasks = writeBinary(temporary, snapshot);
+        } else {
+            std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+            if (!file.is_open()) {
+                fail("Cannot create export file: " + path);
+            }
+            result.tasks = writeText(file, format, snapshot);
+            file.close();
+            if (file.fail()) {
+                fail("Failed to write export file: " + path);
+            }
+        }
+        fs::rename(temporary, path);
+    } catch (...) {
+        std::error_code error;
+        fs::remove(temporary, error);
+        throw;
+    }
+}
+
+TaskExporter::Result TaskExporter::exportToFile(const std::string& path, ExportFormat format) {
+    auto start = std::chrono::steady_clock::now();
+    Result result;
+    // Every export is one consistent state: a copy of the file or a streaming
+    // read holds the lock throughout, while loaded tasks are pinned in a
+    // snapshot and written after the lock is released
+    std::optional<TaskSnapshot> snapshot;
+    {
+        LockScope scope(manager, LockMode::SHARED);
+        for (ExportFormat storage : {ExportFormat::JSON, ExportFormat::BINARY}) {
+            std::string source = manager.exportFile(storage);
+            std::error_code error;
+            if (!source.empty() && fs::equivalent(source, path, error)) {
+                throw std::runtime_error("Export destination is the tasks file itself: " + path);
+            }
+        }
+
+        std::string source = manager.exportFile(format);
+        if (source.empty() && !manager.isStreaming()) {
+            snapshot = manager.snapshot();
+        } else {
+            writeFile(path, format, source, nullptr, result);
+        }
+    }
+    if (snapshot) {
+        writeFile(path, format, std::string(), &*snapshot, result);
+    }
+
+    result.bytes = fs::file_size(path);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    result.seconds = elapsed.count();
+    return result;
+}
+
+TaskExporter::Result TaskExporter::exportToStream(std::ostream& out, ExportFormat format) {
+    if (format == ExportFormat::BINARY) {
+        throw std::invalid_argument("Binary exports need a destination file");
+    }
+    auto start = std::chrono::steady_clock::now();
+    Result result;
+    // Loaded tasks are written from a snapshot, without the lock
+    if (manager.isStreaming()) {
+        LockScope scope(manager, LockMode::SHARED);
+        result.tasks = writeText(out, format, nullptr);
+    } else {
+        TaskSnapshot snapshot = manager.snapshot();
+        result.tasks = writeText(out, format, &snapshot);
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    result.seconds = elapsed.count();
+    return result;
+}
@@ -0,0 +1,63 @@
+#ifndef TASK_EXPORTER_H
+#define TASK_EXPORTER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include "cli.h"
+#include "task_manager.h"
+
+/**
+ * Writes every task to a file or stream from a snapshot, without copying the
+ * list; a store already in the requested format is copied whole.
+ */
+class TaskExporter {
+public:
+    // Bytes handed to the destination per write
+    static constexpr std::size_t kBufferSize = 1024 * 1024;
+    // Tasks collected before each append to a binary export, and formatted
+    // by one job of a parallel text export
+    static constexpr std::size_t kBlockSize = 8192;
+
+    struct Result {
+        std::size_t tasks = 0;    // Tasks written (unknown, 0, when copied)
+        std::uintmax_t bytes = 0; // Size of the export file
+        double seconds = 0;       // Wall-clock time of the export
+        bool copied = false;      // Whether the repository's file was copied
+    };
+
+private:
+    TaskManager& manager;
+    CLI& cli;
+
+    // Tasks come from the snapshot when given, else from the manager
+    void forEachTask(const TaskSnapshot* snapshot, const TaskVisitor& visitor);
+    std::size_t writeText(std::ostream& out, ExportFormat format, const TaskSnapshot* snapshot);
+    std::size_t writeTextBlocks(std::ostream& out, ExportFormat format, const TaskSnapshot& snapshot,
+                                WorkStealingPool* pool);
+    std::size_t writeBinary(const std::string& path, const TaskSnapshot* snapshot);
+    // Write the export through a temporary file renamed over path: a copy of
+    // source when there is one, else the snapshot's tasks or the streamed ones
+    void writeFile(const std::string& path, ExportFormat format, const std::string& source,
+                   const TaskSnapshot* snapshot, Result& result);
+
+public:
+    TaskExporter(TaskManager& manager, CLI& cli);
+
+    static std::optional<ExportFormat> parseFormat(std::string_view name);
+
+    /**
+     * Export to the file at path, replacing it
+     * @throws FileIOException if the file cannot be written
+     * @throws std::runtime_error if path is the repository's own file
+     */
+    Result exportToFile(const std::string& path, ExportFormat format);
+
+    // Export JSON or NDJSON to a stream; binary exports need a file
+    Result exportToStream(std::ostream& out, ExportFormat format);
+};
+
+#endif // TASK_EXPORTER_H
@@ -0,0 +1,236 @@
+#include "task_follower.h"
+#include "repository_exceptions.h"
+#include <algorithm>
+#include <filesystem>
+#include <functional>
+#include <string_view>
+#include <thread>
+#include <utility>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// How often a blocked watch wakes up to check for stop()
+constexpr std::chrono::milliseconds kWakeInterval{100};
+
+// After a change, the file is read once it has been quiet this long, so a
+// save in progress is not read half-written
+constexpr std::chrono::milliseconds kSettleDelay{20};
+
+} // namespace
+
+TaskFollower::TaskFollower(TaskManager& manager, CLI& cli, std::string path, OutputFormat format)
+    : manager(manager), cli(cli), path(std::move(path)), format(format),
+      pollInterval(kDefaultPollInterval),
+#ifdef __linux__
+      polling(false),
+#else
+      polling(true),
+#endif
+      stopping(false), watching(false), refreshCount(0), tailReadCount(0), generation(0) {
+}
+
+void TaskFollower::setPolling(std::chrono::milliseconds interval) {
+    polling = true;
+    pollInterval = interval;
+}
+
+void TaskFollower::stop() {
+    stopping.store(true);
+}
+
+bool TaskFollower::isWatching() const {
+    return watching.load();
+}
+
+std::size_t TaskFollower::getRefreshCount() const {
+    return refreshCount.load();
+}
+
+std::size_t TaskFollower::getTailReadCount() const {
+    return tailReadCount.load();
+}
+
+void TaskFollower::run(std::ostream& out) {
+    {
+        OutputBuffer buffer(out);
+        cli.displayHeader(format, buffer);
+    }
+    refresh(out);
+    if (snapshot.empty() && format == OutputFormat::TEXT) {
+        cli.displayNoTasks(out);
+    }
+    out.flush();
+
+    if (polling) {
+        watchPolling(out);
+    } else {
+        watchInotify(out);
+    }
+    watching.store(false);
+}
+
+void TaskFollower::refresh(std::ostream& out) {
+    // Saves hold the lock exclusively, so the whole read sees one of them
+    LockScope scope(manager, LockMode::SHARED);
+
+    // A save by a process that does not lock truncates the file before it
+    // writes the new contents
+    std::error_code error;
+    if (fs::file_size(path, error) == 0 && !error && !snapshot.empty()) {
+        throw FileIOException("Tasks file is being rewritten: " + path);
+    }
+
+    // Adds appended in place are read from the end of the file; they are
+    // new tasks, so all of them are printed
+    bool appended = false;
+    {
+        OutputBuffer buffer(out);
+        appended = manager.forEachAppended(mark, [&](const TaskView& task) {
+            snapshot[task.id] =
+                TaskState{std::hash<std::string_view>{}(task.description), task.completed, generation};
+            cli.displayTask(task, format, buffer);
+        });
+    }
+    if (appended) {
+        tailReadCount++;
+        out.flush();
+        return;
+    }
+
+    manager.reload();
+    generation++;
+
+    std::size_t removed = 0;
+    {
+        OutputBuffer buffer(out);
+        manager.forEachTask([&](const TaskView& task) {
+            TaskState state{std::hash<std::string_view>{}(task.description), task.completed, generation};
+            auto [entry, added] = snapshot.try_emplace(task.id, state);
+            if (added || entry->second.completed != state.completed ||
+                entry->second.descriptionHash != state.descriptionHash) {
+                cli.displayTask(task, format, buffer);
+            }
+            entry->second = state;
+        });
+
+        mark = AppendMark();
+        manager.markAppends(mark);
+
+        // Tasks the read did not see were removed (cleared)
+        for (auto entry = snapshot.begin(); entry != snapshot.end();) {
+            if (entry->second.seen != generation) {
+                entry = snapshot.erase(entry);
+                removed++;
+            } else {
+                ++entry;
+            }
+        }
+    }
+
+    if (removed > 0 && format == OutputFormat::TEXT) {
+        cli.displaySuccess(std::to_string(removed) + " tasks removed", out);
+    }
+    out.flush();
+}
+
+void TaskFollower::watchPolling(std::ostream& out) {
+    auto stamp = [this] {
+        std::error_code error;
+        auto time = fs::last_write_time(path, error);
+        auto size = fs::file_size(path, error);
+        return std::make_pair(time, size);
+    };
+
+    auto last = stamp();
+    watching.store(true);
+    while (!stopping.load()) {
+        // Sleep in short slices so stop() is noticed quickly
+        for (auto slept = std::chrono::milliseconds(0); slept < pollInterval && !stopping.load();
+             slept += kWakeInterval) {
+            std::this_thread::sleep_for(std::min(kWakeInterval, pollInterval - slept));
+        }
+
+        auto current = stamp();
+        if (current != last && !stopping.load()) {
+            last = current;
+            try {
+                refresh(out);
+            } catch (const RepositoryException&) {
+                // Caught mid-save; the rest of the save changes the file again
+                last = {};
+            }
+            refreshCount++;
+        }
+    }
+}
+
+#ifdef __linux__
+
+void TaskFollower::watchInotify(std::ostream& out) {
+    int fd = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0) {
+        watchPolling(out);
+        return;
+    }
+
+    // The directory is watched rather than the file, which saves may replace
+    fs::path file(path);
+    std::string directory = file.has_parent_path() ? file.parent_path().string() : ".";
+    std::string name = file.filename().string();
+    if (::inotify_add_watch(fd, directory.c_str(),
+                            IN_MODIFY | IN_CLOSE_WRITE | IN_CREATE | IN_MOVED_TO | IN_DELETE) < 0) {
+        ::close(fd);
+        watchPolling(out);
+        return;
+    }
+
+    watching.store(true);
+    alignas(inotify_event) char events[4096];
+    bool changed = false;
+    while (!stopping.load()) {
+        pollfd pending{fd, POLLIN, 0};
+        auto timeout = changed ? kSettleDelay : kWakeInterval;
+        int ready = ::poll(&pending, 1, static_cast<int>(timeout.count()));
+
+        if (ready > 0) {
+            ssize_t length;
+            while ((length = ::read(fd, events, sizeof(events))) > 0) {
+                for (char* next = events; next < events + length;) {
+                    auto* event = reinterpret_cast<inotify_event*>(next);
+                    if (event->len > 0 && name == event->name) {
+                        changed = true;
+                    }
+                    next += sizeof(inotify_event) + event->len;
+                }
+            }
+            continue;
+        }
+
+        if (ready == 0 && changed) {
+            changed = false;
+            try {
+                refresh(out);
+            } catch (const RepositoryException&) {
+                // Caught mid-save; the rest of the save raises another event
+            }
+            refreshCount++;
+        }
+    }
+    ::close(fd);
+}
+
+#else
+
+void TaskFollower::watchInotify(std::ostream& out) {
+    watchPolling(out);
+}
+
+#endif // __linux__
@@ -0,0 +1,76 @@
+#ifndef TASK_FOLLOWER_H
+#define TASK_FOLLOWER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include "cli.h"
+#include "task_manager.h"
+
+/**
+ * Prints the task list, then watches the store (inotify, or polling) and
+ * prints only the tasks added or changed since.
+ */
+class TaskFollower {
+public:
+    // How often the file is checked when polling
+    static constexpr std::chrono::milliseconds kDefaultPollInterval{500};
+
+private:
+    // What the follower last printed for a task
+    struct TaskState {
+        std::size_t descriptionHash;
+        bool completed;
+        // Generation of the read that last saw the task; older entries were removed
+        std::size_t seen;
+    };
+
+    TaskManager& manager;
+    CLI& cli;
+    std::string path;
+    OutputFormat format;
+    std::chrono::milliseconds pollInterval;
+    bool polling;
+    std::atomic<bool> stopping;
+    std::atomic<bool> watching;
+    std::atomic<std::size_t> refreshCount;
+    std::atomic<std::size_t> tailReadCount;
+    std::size_t generation;
+    std::unordered_map<int, TaskState> snapshot;
+    // End of the store at the last read, when the repository keeps one
+    AppendMark mark;
+
+    void refresh(std::ostream& out);
+    void watchInotify(std::ostream& out);
+    void watchPolling(std::ostream& out);
+
+public:
+    // Constructor; path is the file the manager's repository reads
+    TaskFollower(TaskManager& manager, CLI& cli, std::string path,
+                 OutputFormat format = OutputFormat::TEXT);
+
+    TaskFollower(const TaskFollower&) = delete;
+    TaskFollower& operator=(const TaskFollower&) = delete;
+
+    // Poll every interval instead of using inotify
+    void setPolling(std::chrono::milliseconds interval);
+
+    // Print every task, then the added and changed ones until stop() is called
+    void run(std::ostream& out = std::cout);
+
+    // Ask run() to return; safe to call from other threads and signal handlers
+    void stop();
+
+    // Whether the initial list has been printed and changes are being watched
+    bool isWatching() const;
+
+    // Number of times the store was re-read after a change, and how many of
+    // those read only the tasks appended
+    std::size_t getRefreshCount() const;
+    std::size_t getTailReadCount() const;
+};
+
+#endif // TASK_FOLLOWER_H
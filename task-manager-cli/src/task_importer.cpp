@@ -0,0 +1,484 @@
+#include "task_importer.h"
+#include "work_stealing_pool.h"
+#include <algorithm>
+#include <chrono>
+#include <memory_resource>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+namespace {
+
+// A malformed record; reported with its line number
+class RecordError : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+// Picks the description and completion out of one NDJSON object without
+// building the object; other members are skipped
+class RecordParser : public nlohmann::json_sax<json> {
+    enum class Key { OTHER, DESCRIPTION, COMPLETED };
+
+    int depth = 0;
+    Key currentKey = Key::OTHER;
+
+    bool fail(const char* message) {
+        error = message;
+        return false;
+    }
+
+    // Any value other than the description string or the completed boolean
+    bool unexpected() {
+        if (depth == 0) {
+            return fail("expected a JSON object");
+        }
+        if (depth == 1 && currentKey == Key::DESCRIPTION) {
+            return fail("\"description\" must be a string");
+        }
+        if (depth == 1 && currentKey == Key::COMPLETED) {
+            return fail("\"completed\" must be true or false");
+        }
+        return true;
+    }
+
+public:
+    std::string description;
+    bool completed = false;
+    bool hasDescription = false;
+    std::string error;
+
+    void reset() {
+        depth = 0;
+        currentKey = Key::OTHER;
+        completed = false;
+        hasDescription = false;
+        error.clear();
+    }
+
+    bool null() override { return unexpected(); }
+    bool number_integer(number_integer_t) override { return unexpected(); }
+    bool number_unsigned(number_unsigned_t) override { return unexpected(); }
+    bool number_float(number_float_t, const string_t&) override { return unexpected(); }
+    bool binary(binary_t&) override { return unexpected(); }
+
+    bool boolean(bool value) override {
+        if (depth == 1 && currentKey == Key::COMPLETED) {
+            completed = value;
+            return true;
+        }
+        return unexpected();
+    }
+
+    bool string(string_t& value) override {
+        if (depth == 1 && currentKey == Key::DESCRIPTION) {
+            description = std::move(value);
+            hasDescription = true;
+            return true;
+        }
+        return unexpected();
+    }
+
+    bool start_object(std::size_t) override {
+        if (depth > 0 && !unexpected()) {
+            return false;
+        }
+        depth++;
+        return true;
+    }
+
+    bool end_object() override {
+        depth--;
+        return true;
+    }
+
+    bool start_array(std::size_t) override {
+        if (!unexpected()) {
+            return false;
+        }
+        depth++;
+        return true;
+    }
+
+    bool end_array() override {
+        depth--;
+        return true;
+    }
+
+    bool key(string_t& name) override {
+        if (depth == 1) {
+            currentKey = name == "description" ? Key::DESCRIPTION
+                       : name == "completed"   ? Key::COMPLETED
+                                               : Key::OTHER;
+        }
+        return true;
+    }
+
+    bool parse_error(std::size_t position, const std::string&, const nlohmann::detail::exception&) override {
+        error = "invalid JSON at column " + std::to_string(position);
+        return false;
+    }
+};
+
+// Parse one NDJSON line into parser's description and completion
+void parseRecord(RecordParser& parser, const std::string& line) {
+    parser.reset();
+    if (!json::sax_parse(line, &parser)) {
+        throw RecordError(parser.error);
+    }
+    if (!parser.hasDescription) {
+        throw RecordError("missing \"description\"");
+    }
+}
+
+bool parseCompleted(std::string_view text) {
+    if (text == "true" || text == "1") {
+        return true;
+    }
+    if (text.empty() || text == "false" || text == "0") {
+        return false;
+    }
+    throw RecordError("invalid completed value: " + std::string(text));
+}
+
+// Reads description and completion from records of any supported format
+class RecordReader {
+    std::istream& in;
+    std::optional<OutputFormat> format;
+    std::string line;
+    // The first NDJSON line is read to detect the format and parsed afterwards
+    bool pending = false;
+    bool started = false;
+
+    // CSV/TSV fields of the current record; the strings are reused across records
+    std::vector<std::string> fields;
+    std::size_t fieldCount = 0;
+    std::size_t descriptionColumn = 0;
+    std::optional<std::size_t> completedColumn;
+
+    RecordParser parser;
+
+public:
+    std::size_t lines = 0;
+    std::size_t bytes = 0;
+
+    RecordReader(std::istream& in, std::optional<OutputFormat> format) : in(in), format(format) {}
+
+    // Next non-blank line without its line ending; false at the end of input
+    bool nextLine() {
+        while (std::getline(in, line)) {
+            lines++;
+            bytes += line.size() + 1;
+            if (!line.empty() && line.back() == '\r') {
+                line.pop_back();
+            }
+            if (line.find_first_not_of(" \t") != std::string::npos) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Whether the records are NDJSON; reads the first line to tell
+    bool isNdjson() {
+        start();
+        return format == OutputFormat::NDJSON;
+    }
+
+    // Read the next record; false at the end of input
+    bool next(TaskList& block) {
+        start();
+        if (pending) {
+            pending = false;
+        } else if (!nextLine()) {
+            return false;
+        }
+
+        if (*format == OutputFormat::NDJSON) {
+            parseRecord(parser, line);
+            block.emplace_back(0, parser.description, parser.completed);
+            return true;
+        }
+
+        split();
+        std::size_t needed = std::max(descriptionColumn, completedColumn.value_or(0)) + 1;
+        if (fieldCount < needed) {
+            throw RecordError("expected " + std::to_string(needed) + " fields, found " +
+                              std::to_string(fieldCount));
+        }
+        bool completed = completedColumn && parseCompleted(fields[*completedColumn]);
+        block.emplace_back(0, fields[descriptionColumn], completed);
+        return true;
+    }
+
+    // The next NDJSON record unparsed, with its line number, for parsing on
+    // another thread; false at the end of input
+    bool nextJsonLine(std::string& record, std::size_t& number) {
+        start();
+        if (pending) {
+            pending = false;
+        } else if (!nextLine()) {
+            return false;
+        }
+        record.swap(line);
+        number = lines;
+        return true;
+    }
+
+private:
+    // Detect the format and read the CSV/TSV header, before the first record
+    void start() {
+        if (started) {
+            return;
+        }
+        started = true;
+        if (!nextLine()) {
+            return;
+        }
+        if (!format) {
+            std::size_t first = line.find_first_not_of(" \t");
+            format = line[first] == '{'                     ? OutputFormat::NDJSON
+                   : line.find('\t') != std::string::npos ? OutputFormat::TSV
+                                                            : OutputFormat::CSV;
+        }
+        if (*format == OutputFormat::NDJSON) {
+            pending = true;
+        } else {
+            readHeader();
+        }
+    }
+
+    void readHeader() {
+        split();
+        bool found = false;
+        for (std::size_t i = 0; i < fieldCount; i++) {
+            if (fields[i] == "description") {
+                descriptionColumn = i;
+                found = true;
+            } else if (fields[i] == "completed") {
+                completedColumn = i;
+            }
+        }
+        if (!found) {
+            throw RecordError("header has no \"description\" column");
+        }
+    }
+
+    std::string& nextField() {
+        if (fieldCount == fields.size()) {
+            fields.emplace_back();
+        }
+        std::string& field = fields[fieldCount++];
+        field.clear();
+        return field;
+    }
+
+    void split() {
+        fieldCount = 0;
+        if (*format == OutputFormat::TSV) {
+            splitTsv();
+        } else {
+            splitCsv();
+        }
+    }
+
+    // RFC 4180: quoted fields may hold commas, doubled quotes and line breaks
+    void splitCsv() {
+        std::string* field = &nextField();
+        bool quoted = false;
+        std::size_t i = 0;
+        while (true) {
+            if (i == line.size()) {
+                if (!quoted) {
+                    return;
+                }
+                // The quoted field continues on the next line
+                if (!std::getline(in, line)) {
+                    throw RecordError("unterminated quoted field");
+                }
+                lines++;
+                bytes += line.size() + 1;
+                if (!line.empty() && line.back() == '\r') {
+                    line.pop_back();
+                }
+                field->push_back('\n');
+                i = 0;
+                continue;
+            }
+
+            char c = line[i++];
+            if (quoted) {
+                if (c != '"') {
+                    field->push_back(c);
+                } else if (i < line.size() && line[i] == '"') {
+                    field->push_back('"');
+                    i++;
+                } else {
+                    quoted = false;
+                }
+            } else if (c == '"') {
+                quoted = true;
+            } else if (c == ',') {
+                field = &nextField();
+            } else {
+                field->push_back(c);
+            }
+        }
+    }
+
+    // Tab-separated, with \t \n \r and \\ escaped as list --format=tsv writes them
+    void splitTsv() {
+        std::string* field = &nextField();
+        for (std::size_t i = 0; i < line.size(); i++) {
+            char c = line[i];
+            if (c == '\t') {
+                field = &nextField();
+            } else if (c == '\\' && i + 1 < line.size()) {
+                switch (line[++i]) {
+                    case 't': field->push_back('\t'); break;
+                    case 'n': field->push_back('\n'); break;
+                    case 'r': field->push_back('\r'); break;
+                    case '\\': field->push_back('\\'); break;
+                    default:
+                        field->push_back('\\');
+                        field->push_back(line[i]);
+                }
+            } else {
+                field->push_back(c);
+            }
+        }
+    }
+};
+
+// Lines of one block of NDJSON records and what parsing them found; the
+// strings are reused across blocks
+struct JsonBlock {
+    std::vector<std::string> lines;
+    std::vector<std::size_t> lineNumbers;
+    std::vector<std::string> descriptions;
+    std::vector<char> completed;
+    std::vector<std::string> errors;
+};
+
+// Records parsed by one job of a parallel block
+constexpr std::size_t kRecordsPerJob = 512;
+
+// Read up to blockSize NDJSON records and parse them in parallel on pool,
+// adding them to block in input order. The records before a malformed one
+// are added and error describes it. False at the end of input.
+bool readJsonBlock(RecordReader& reader, JsonBlock& records, TaskList& block, std::size_t blockSize,
+                   WorkStealingPool* pool, std::string& error) {
+    std::size_t count = 0;
+    bool more = true;
+    while (count < blockSize) {
+        if (count == records.lines.size()) {
+            records.lines.emplace_back();
+            records.lineNumbers.emplace_back();
+        }
+        if (!(more = reader.nextJsonLine(records.lines[count], records.lineNumbers[count]))) {
+            break;
+        }
+        count++;
+    }
+
+    records.descriptions.resize(std::max(records.descriptions.size(), count));
+    records.completed.resize(count);
+    records.errors.resize(count);
+    parallelChunks(pool, count, kRecordsPerJob, [&](std::size_t begin, std::size_t end) {
+        RecordParser parser;
+        for (std::size_t i = begin; i < end; i++) {
+            records.errors[i].clear();
+            try {
+                parseRecord(parser, records.lines[i]);
+                records.descriptions[i].swap(parser.description);
+                records.completed[i] = parser.completed;
+            } catch (const RecordError& e) {
+                records.errors[i] = e.what();
+            }
+        }
+    });
+
+    for (std::size_t i = 0; i < count; i++) {
+        if (!records.errors[i].empty()) {
+            error = "line " + std::to_string(records.lineNumbers[i]) + ": " + records.errors[i];
+            return false;
+        }
+        block.emplace_back(0, records.descriptions[i], records.completed[i] != 0);
+    }
+    return more;
+}
+
+} // namespace
+
+TaskImporter::TaskImporter(TaskManager& manager, std::size_t blockSize)
+    : manager(manager), blockSize(blockSize > 0 ? blockSize : 1) {
+}
+
+TaskImporter::Result TaskImporter::run(std::istream& in, std::optional<OutputFormat> format) {
+    auto start = std::chrono::steady_clock::now();
+    Result result;
+    RecordReader reader(in, format);
+
+    // Other processes wait for the whole import, so its IDs are consecutive
+    // and a deferred save does not overwrite tasks they added meanwhile
+    LockScope scope(manager, LockMode::EXCLUSIVE);
+
+    // Blocks go to storage as they are read when the manager appends directly;
+    // otherwise they are held in memory and the import is saved once
+    bool deferSave = manager.isAutoSaveEnabled() && !manager.appendsDirectly();
+    if (deferSave) {
+        manager.setAutoSave(false);
+    }
+
+    // NDJSON records are parsed a block at a time on the manager's pool
+    WorkStealingPool* pool = manager.getThreadPool();
+    JsonBlock records;
+
+    try {
+        bool more = true;
+        while (more) {
+            // A block's descriptions live in an arena released with the block
+            std::pmr::monotonic_buffer_resource arena;
+            TaskList block(&arena);
+            block.reserve(blockSize);
+            try {
+                if (pool && reader.isNdjson()) {
+                    more = readJsonBlock(reader, records, block, blockSize, pool, result.error);
+                } else {
+                    while (block.size() < blockSize && (more = reader.next(block))) {
+                    }
+                }
+            } catch (const RecordError& e) {
+                result.error = "line " + std::to_string(reader.lines) + ": " + e.what();
+                more = false;
+            }
+
+            if (!block.empty()) {
+                int first = manager.addTasks(block);
+                if (result.tasks == 0) {
+                    result.firstId = first;
+                }
+                result.tasks += block.size();
+            }
+        }
+    } catch (...) {
+        if (deferSave) {
+            manager.setAutoSave(true);
+        }
+        throw;
+    }
+
+    if (deferSave) {
+        manager.save();
+        manager.setAutoSave(true);
+    }
+    // Changes under the lock leave syncing to us: once for the whole import
+    manager.sync();
+
+    result.lines = reader.lines;
+    result.bytes = reader.bytes;
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    result.seconds = elapsed.count();
+    return result;
+}
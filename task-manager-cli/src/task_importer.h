@@ -0,0 +1,40 @@
+#ifndef TASK_IMPORTER_H
+#define TASK_IMPORTER_H
+
+#include <cstddef>
+#include <iostream>
+#include <optional>
+#include <string>
+#include "cli.h"
+#include "task_manager.h"
+
+/**
+ * Bulk import of tasks from CSV, TSV or NDJSON, streamed and added in blocks
+ * of blockSize tasks with new IDs.
+ */
+class TaskImporter {
+public:
+    static constexpr std::size_t kDefaultBlockSize = 8192;
+
+    struct Result {
+        std::size_t tasks = 0;  // Tasks added
+        int firstId = 0;        // ID of the first added task (0 when none)
+        std::size_t lines = 0;  // Input lines read
+        std::size_t bytes = 0;  // Input bytes read
+        double seconds = 0;     // Wall-clock time of the whole import
+        std::string error;      // Why reading stopped early; empty on success
+    };
+
+private:
+    TaskManager& manager;
+    std::size_t blockSize;
+
+public:
+    explicit TaskImporter(TaskManager& manager, std::size_t blockSize = kDefaultBlockSize);
+
+    // Import every record of in, guessing the format when none is given;
+    // tasks read before a malformed record are kept
+    Result run(std::istream& in, std::optional<OutputFormat> format = std::nullopt);
+};
+
+#endif // TASK_IMPORTER_H
@@ -1,53 +1,758 @@
 #include "task_manager.h"
+#include "repository_exceptions.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <exception>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
-TaskManager::TaskManager(ITaskRepository& repository)
-    : repository(repository) {
-    // Load existing tasks from repository
-    tasks = repository.loadTasks();
+namespace {
+
+bool equalIgnoringCase(char a, char b) {
+    return std::tolower(static_cast<unsigned char>(a)) == std::tolower(static_cast<unsigned char>(b));
 }
 
-int TaskManager::addTask(const std::string& description) {
-    // Get next available ID
-    int id = repository.getNextId();
-    
-    // Create new task
-    Task newTask(id, description, false);
-    tasks.push_back(newTask);
-    
-    // Persist to repository
-    repository.saveTasks(tasks);
-    
-    return id;
+bool containsIgnoringCase(std::string_view text, std::string_view part) {
+    return std::search(text.begin(), text.end(), part.begin(), part.end(), equalIgnoringCase) != text.end();
 }
 
-std::vector<Task> TaskManager::listTasks() const {
-    return tasks;
+std::shared_future<void> readyFuture() {
+    std::promise<void> done;
+    done.set_value();
+    return done.get_future().share();
 }
 
-bool TaskManager::completeTask(int id) {
-    // Find task by ID
-    for (auto& task : tasks) {
-        if (task.getId() == id) {
-            task.setCompleted(true);
-            
-            // Persist changes
-            repository.saveTasks(tasks);
-            
-            return true;
+} // namespace
+
+// Shares the manager with other readers, unless this thread holds it alone
+class TaskManager::ReadGuard {
+    const TaskManager& manager;
+    bool shared;
+
+public:
+    explicit ReadGuard(const TaskManager& manager)
+        : manager(manager), shared(manager.writer.load(std::memory_order_relaxed) != std::this_thread::get_id()) {
+        if (shared) {
+            manager.mutex.lock_shared();
+        }
+    }
+    ~ReadGuard() {
+        if (shared) {
+            manager.mutex.unlock_shared();
+        }
+    }
+
+    ReadGuard(const ReadGuard&) = delete;
+    ReadGuard& operator=(const ReadGuard&) = delete;
+};
+
+// Holds the manager alone, for changes that do not go to the repository
+class TaskManager::WriteGuard {
+    const TaskManager& manager;
+
+public:
+    explicit WriteGuard(const TaskManager& manager) : manager(manager) {
+        manager.lockWriter();
+    }
+    ~WriteGuard() {
+        manager.unlockWriter();
+    }
+
+    WriteGuard(const WriteGuard&) = delete;
+    WriteGuard& operator=(const WriteGuard&) = delete;
+};
+
+// Holds the manager alone for a change, and the repository's lock as well
+// unless the change stays in memory (tasks loaded, saving deferred or
+// handed to the asynchronous repository) or its save is optimistic
+class TaskManager::ChangeGuard {
+    WriteGuard writer;
+    const TaskManager& manager;
+    bool locked;
+
+public:
+    explicit ChangeGuard(const TaskManager& manager)
+        : writer(manager), manager(manager),
+          locked(!manager.savesOptimistically() &&
+                 (manager.streaming || !manager.loaded || (manager.savesEachChange() && !manager.asyncRepository))) {
+        if (locked) {
+            manager.settleSaves(true);
+            manager.lockRepository(LockMode::EXCLUSIVE);
+            if (manager.repositoryDepth++ == 0) {
+                manager.dropIfStale();
+            }
         }
     }
-    
-    // Task not found
-    return false;
+    ~ChangeGuard() {
+        if (locked) {
+            manager.repositoryDepth--;
+            manager.unlockRepository();
+        }
+    }
+
+    ChangeGuard(const ChangeGuard&) = delete;
+    ChangeGuard& operator=(const ChangeGuard&) = delete;
+};
+
+TaskManager::TaskManager(ITaskRepository& repository, std::pmr::memory_resource* resource,
+                         StringInterner* interner)
+    : repository(repository), lockable(capabilityOf<ILockableRepository>(repository)),
+      durable(capabilityOf<IDurableRepository>(repository)),
+      versioned(capabilityOf<IVersionedRepository>(repository)),
+      tailReadable(capabilityOf<ITailReadableRepository>(repository)), resource(resource), interner(interner),
+      streaming(repository.supportsStreaming()), loaded(false), tasks(resource),
+      nextId(1), autoSave(true), unsavedChanges(false), asyncRepository(nullptr), writerDepth(0),
+      repositoryDepth(0), threadPool(nullptr), pendingEvents(events) {
 }
 
-void TaskManager::clearAllTasks() {
-    // Clear in-memory task list
+void TaskManager::lockWriter() const {
+    // Only this thread ever stores its own ID, so the relaxed check is exact
+    std::thread::id self = std::this_thread::get_id();
+    if (writer.load(std::memory_order_relaxed) == self) {
+        writerDepth++;
+        return;
+    }
+    mutex.lock();
+    writer.store(self, std::memory_order_relaxed);
+    writerDepth = 1;
+}
+
+void TaskManager::unlockWriter() const {
+    // Events go out as the outermost hold ends; those of changes made by
+    // synchronous handlers meanwhile go out in the next round
+    if (writerDepth == 1) {
+        pendingEvents.publish();
+    }
+    if (--writerDepth == 0) {
+        writer.store(std::thread::id(), std::memory_order_relaxed);
+        mutex.unlock();
+    }
+}
+
+template <typename Read>
+auto TaskManager::readLoaded(Read read) const {
+    for (;;) {
+        {
+            ReadGuard guard(*this);
+            if (loaded) {
+                return read();
+            }
+        }
+        // Loading changes the manager, so the first reader loads it alone;
+        // a reload() in between sends readers round again
+        LockScope scope(*this, LockMode::SHARED);
+        ensureLoaded();
+    }
+}
+
+template <typename Change>
+auto TaskManager::change(Change apply) {
+    // A change nested in lock() leaves the sync to the caller, after unlock(),
+    // and one saved in the background is synced by the repository saving it
+    bool outermost = writer.load(std::memory_order_relaxed) != std::this_thread::get_id();
+    bool sync = false;
+    if constexpr (std::is_void_v<decltype(apply())>) {
+        {
+            ChangeGuard guard(*this);
+            retryConflicts(apply);
+            sync = outermost && !pendingSave.valid();
+        }
+        if (sync) {
+            syncRepository();
+        }
+    } else {
+        auto result = [&] {
+            ChangeGuard guard(*this);
+            auto applied = retryConflicts(apply);
+            sync = outermost && !pendingSave.valid();
+            return applied;
+        }();
+        if (sync) {
+            syncRepository();
+        }
+        return result;
+    }
+}
+
+template <typename Attempt>
+auto TaskManager::retryConflicts(Attempt attempt) {
+    return deferredChanges.retry(attempt, [this] {
+        rebase();
+    });
+}
+
+void TaskManager::rebase() const {
+    // Start again from the tasks as saved now, with the deferred changes made
+    // again on them; the attempt that conflicted then makes its own change.
+    // Subscribers read the tasks again rather than hear of changes undone.
+    tasks.assign(repository.loadTasks(resource, interner));
+    pendingEvents.discard();
+    pendingEvents.add(TaskEventType::RELOADED);
+    nextId = repository.getNextId();
+    loaded = true;
+    deferredChanges.replay(
+        [this](const std::string& description, bool completed) {
+            int id = newId();
+            if (interner) {
+                tasks.emplace_back(id, description, completed, *interner);
+            } else {
+                tasks.emplace_back(id, description, completed);
+            }
+            nextId = id + 1;
+        },
+        [this](int id) {
+            if (Task* task = tasks.findForWrite(id)) {
+                task->setCompleted(true);
+            }
+        },
+        [this] {
+            tasks.clear();
+            repository.resetIdCounter();
+            nextId = 1;
+        });
+}
+
+void TaskManager::recordChange(DeferredChanges::Kind kind, int id, std::string_view description, bool completed) {
+    // Saved changes are made again by the attempt that conflicted
+    if (!savesEachChange()) {
+        deferredChanges.record(kind, id, description, completed);
+    }
+}
+
+void TaskManager::ensureLoaded() const {
+    // Streaming repositories are never loaded as a whole
+    if (loaded || streaming) {
+        return;
+    }
+    tasks.assign(repository.loadTasks(resource, interner));
+    nextId = repository.getNextId();
+    loaded = true;
+}
+
+void TaskManager::dropIfStale() const {
+    // A change to tasks loaded before another process saved would save over
+    // that process's changes, so they are read again first, with any unsaved
+    // changes made again on them
+    if (!loaded || streaming || !versioned || !versioned->isStale()) {
+        return;
+    }
+    if (!unsavedChanges) {
+        tasks.clear();
+        loaded = false;
+        pendingEvents.add(TaskEventType::RELOADED);
+    } else if (!asyncRepository) {
+        rebase();
+    }
+}
+
+void TaskManager::load() {
+    LockScope scope(*this, LockMode::SHARED);
+    ensureLoaded();
+}
+
+void TaskManager::reload() {
+    LockScope scope(*this, LockMode::SHARED);
+    repository.reload();
     tasks.clear();
-    
-    // Reset ID counter
-    repository.resetIdCounter();
-    
-    // Persist empty list
-    repository.saveTasks(tasks);
+    loaded = false;
+    unsavedChanges = false;
+    deferredChanges.clear();
+    pendingEvents.add(TaskEventType::RELOADED);
+}
+
+void TaskManager::persist() {
+    if (!savesEachChange()) {
+        unsavedChanges = true;
+    } else if (savesInBackground()) {
+        // Replaces the save in flight, if any: this one covers its changes
+        pendingSave = asyncRepository->saveSnapshot(tasks.snapshot());
+    } else {
+        repository.saveSnapshot(tasks.snapshot());
+        // Takes along the changes of threads deferring their saves
+        unsavedChanges = false;
+        deferredChanges.clear();
+    }
+}
+
+bool TaskManager::savesInBackground() const {
+    // Under the repository's lock the repository is called directly, and
+    // optimistic saves are, to be tried again when they conflict
+    return asyncRepository && !streaming && repositoryDepth == 0 && !(versioned && versioned->isOptimistic());
+}
+
+int TaskManager::newId() const {
+    // The repository may be saving in the background, so it is not asked
+    return savesInBackground() ? nextId : std::max(repository.getNextId(), nextId);
+}
+
+std::shared_future<void> TaskManager::startSave() {
+    // A save seen to have failed marks its changes unsaved, to try again
+    settleSaves(false);
+    if (unsavedChanges) {
+        pendingSave = asyncRepository->saveSnapshot(tasks.snapshot());
+        unsavedChanges = false;
+    }
+    return pendingSave.valid() ? pendingSave : readyFuture();
+}
+
+void TaskManager::settleSaves(bool wait) const {
+    if (!pendingSave.valid()) {
+        return;
+    }
+    if (!wait && pendingSave.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+        return;
+    }
+    try {
+        pendingSave.get();
+    } catch (...) {
+        // The error went to whoever waited on the save
+        unsavedChanges = true;
+    }
+    pendingSave = std::shared_future<void>();
+}
+
+bool TaskManager::appendsDirectly() const {
+    ReadGuard guard(*this);
+    // Changes are saved right away anyway, so a repository that appends
+    // writes just the new task instead of the whole list
+    return streaming || (savesEachChange() && !asyncRepository && !unsavedChanges && repository.supportsAppend());
+}
+
+int TaskManager::addTask(std::string_view description) {
+    return change([&] {
+        if (streaming || (!loaded && appendsDirectly())) {
+            int id = repository.appendTask(description);
+            pendingEvents.add(TaskEventType::ADDED, id, 1);
+            return id;
+        }
+        if (!interner) {
+            return addTask(std::pmr::string(description, resource));
+        }
+        ensureLoaded();
+
+        // Get next available ID, writing the task when the repository appends
+        bool append = appendsDirectly();
+        int id = append ? repository.appendTask(description) : newId();
+        nextId = id + 1;
+
+        // Create new task sharing the interned description
+        tasks.emplace_back(id, description, false, *interner);
+        pendingEvents.add(TaskEventType::ADDED, id, 1);
+
+        // Persist to repository
+        if (!append) {
+            recordChange(DeferredChanges::Kind::ADD, id, description);
+            persist();
+        }
+
+        return id;
+    });
+}
+
+int TaskManager::addTask(const char* description) {
+    return addTask(std::string_view(description));
+}
+
+int TaskManager::addTask(std::pmr::string&& description) {
+    return change([&] {
+        if (streaming || interner || (!loaded && appendsDirectly())) {
+            return addTask(std::string_view(description));
+        }
+        ensureLoaded();
+
+        // Get next available ID, writing the task when the repository appends
+        bool append = appendsDirectly();
+        int id = append ? repository.appendTask(description) : newId();
+        nextId = id + 1;
+
+        // Create new task in place
+        if (!append) {
+            recordChange(DeferredChanges::Kind::ADD, id, description);
+        }
+        tasks.emplace_back(id, std::move(description), false);
+        pendingEvents.add(TaskEventType::ADDED, id, 1);
+
+        // Persist to repository
+        if (!append) {
+            persist();
+        }
+
+        return id;
+    });
+}
+
+int TaskManager::addTasks(const TaskList& newTasks) {
+    return change([&] {
+        if (streaming || (!loaded && appendsDirectly())) {
+            int first = repository.appendTasks(newTasks);
+            if (!newTasks.empty()) {
+                pendingEvents.add(TaskEventType::ADDED, first, static_cast<int>(newTasks.size()));
+            }
+            return first;
+        }
+        ensureLoaded();
+
+        // One block of IDs for all of them, written in one append when possible
+        bool append = appendsDirectly();
+        int first = append ? repository.appendTasks(newTasks) : newId();
+        int id = first;
+        for (const auto& task : newTasks) {
+            if (!append) {
+                recordChange(DeferredChanges::Kind::ADD, id, task.getDescription(), task.isCompleted());
+            }
+            if (interner) {
+                tasks.emplace_back(id++, task.getDescription(), task.isCompleted(), *interner);
+            } else {
+                tasks.emplace_back(id++, task.getDescription(), task.isCompleted());
+            }
+        }
+        nextId = id;
+
+        if (!newTasks.empty()) {
+            pendingEvents.add(TaskEventType::ADDED, first, static_cast<int>(newTasks.size()));
+        }
+        if (!append && !newTasks.empty()) {
+            persist();
+        }
+        return first;
+    });
+}
+
+TaskList TaskManager::listTasks() const {
+    if (streaming) {
+        LockScope scope(*this, LockMode::SHARED);
+        return repository.loadTasks(resource, interner);
+    }
+    // Copied from a snapshot, without holding up changes
+    return snapshot().toList(resource);
+}
+
+void TaskManager::forEachTask(const TaskVisitor& visitor) const {
+    if (streaming) {
+        LockScope scope(*this, LockMode::SHARED);
+        repository.forEachTask(visitor);
+        return;
+    }
+    for (const auto& task : snapshot()) {
+        visitor(task.view());
+    }
+}
+
+bool TaskManager::markAppends(AppendMark& mark) const {
+    LockScope scope(*this, LockMode::SHARED);
+    return tailReadable && tailReadable->markAppends(mark);
+}
+
+bool TaskManager::forEachAppended(AppendMark& mark, const TaskVisitor& visitor) const {
+    LockScope scope(*this, LockMode::SHARED);
+    return tailReadable && tailReadable->forEachAppended(mark, visitor);
+}
+
+TaskSnapshot TaskManager::snapshot() const {
+    if (streaming) {
+        LockScope scope(*this, LockMode::SHARED);
+        VersionedTaskList loadedTasks(resource);
+        loadedTasks.assign(repository.loadTasks(resource, interner));
+        return loadedTasks.snapshot();
+    }
+    return readLoaded([this] {
+        return tasks.snapshot();
+    });
+}
+
+std::optional<Task> TaskManager::findTask(int id) const {
+    if (streaming) {
+        LockScope scope(*this, LockMode::SHARED);
+        std::optional<Task> found;
+        repository.forEachTask([&](const TaskView& task) {
+            if (task.id == id && !found) {
+                found.emplace(task.id, task.description, task.completed, resource);
+            }
+        });
+        return found;
+    }
+    return readLoaded([&]() -> std::optional<Task> {
+        const Task* task = tasks.find(id);
+        if (!task) {
+            return std::nullopt;
+        }
+        return Task(*task, resource);
+    });
+}
+
+std::string TaskManager::exportFile(ExportFormat format) const {
+    ReadGuard guard(*this);
+    // A save in the background may still be writing the file
+    return unsavedChanges || pendingSave.valid() ? std::string() : repository.exportFile(format);
+}
+
+TaskList TaskManager::searchTasks(std::string_view text) const {
+    TaskList found(resource);
+    if (streaming) {
+        forEachTask([&](const TaskView& task) {
+            if (containsIgnoringCase(task.description, text)) {
+                found.emplace_back(task.id, task.description, task.completed);
+            }
+        });
+        return found;
+    }
+
+    // Matches of each chunk, gathered in order once every chunk is searched
+    TaskSnapshot tasks = snapshot();
+    std::vector<std::vector<const Task*>> matches(tasks.chunkCount());
+    parallelChunks(threadPool, tasks.chunkCount(), kParallelSearchTasks / TaskVersion::kChunkSize,
+                   [&](std::size_t begin, std::size_t end) {
+                       for (std::size_t chunk = begin; chunk < end; chunk++) {
+                           for (const Task& task : tasks.chunk(chunk)) {
+                               if (containsIgnoringCase(task.getDescription(), text)) {
+                                   matches[chunk].push_back(&task);
+                               }
+                           }
+                       }
+                   });
+    for (const auto& chunk : matches) {
+        for (const Task* task : chunk) {
+            found.push_back(*task);
+        }
+    }
+    return found;
+}
+
+bool TaskManager::isStreaming() const {
+    return streaming;
+}
+
+void TaskManager::setThreadPool(WorkStealingPool* pool) {
+    threadPool = pool;
+}
+
+WorkStealingPool* TaskManager::getThreadPool() const {
+    return threadPool;
+}
+
+bool TaskManager::completeTask(int id) {
+    return change([&] {
+        if (streaming) {
+            bool completed = repository.setTaskCompleted(id, true);
+            if (completed) {
+                pendingEvents.add(TaskEventType::COMPLETED, id, 1);
+            }
+            return completed;
+        }
+        ensureLoaded();
+
+        // Find task by ID (a snapshot keeps the version it pinned)
+        Task* task = tasks.findForWrite(id);
+
+        // Task not found
+        if (!task) {
+            return false;
+        }
+
+        task->setCompleted(true);
+        pendingEvents.add(TaskEventType::COMPLETED, id, 1);
+
+        // Persist changes
+        recordChange(DeferredChanges::Kind::COMPLETE, id);
+        persist();
+
+        return true;
+    });
+}
+
+void TaskManager::clearAllTasks() {
+    return change([&] {
+        if (streaming) {
+            repository.clearTasks();
+            pendingEvents.add(TaskEventType::CLEARED);
+            return;
+        }
+
+        // Clear in-memory task list; there is nothing to read first
+        tasks.clear();
+        loaded = true;
+        pendingEvents.add(TaskEventType::CLEARED);
+
+        // Reset ID counter, once no save is using the repository
+        settleSaves(true);
+        repository.resetIdCounter();
+        nextId = 1;
+
+        // Persist empty list
+        recordChange(DeferredChanges::Kind::CLEAR, 0);
+        persist();
+    });
+}
+
+void TaskManager::setAutoSave(bool enabled) {
+    WriteGuard guard(*this);
+    autoSave = enabled;
+}
+
+bool TaskManager::isAutoSaveEnabled() const {
+    ReadGuard guard(*this);
+    return autoSave;
+}
+
+void TaskManager::deferSaves() {
+    WriteGuard guard(*this);
+    deferringThreads.push_back(std::this_thread::get_id());
+}
+
+void TaskManager::resumeSaves() {
+    WriteGuard guard(*this);
+    auto deferring = std::find(deferringThreads.begin(), deferringThreads.end(), std::this_thread::get_id());
+    if (deferring != deferringThreads.end()) {
+        deferringThreads.erase(deferring);
+    }
+}
+
+bool TaskManager::savesEachChange() const {
+    // Read under the manager, which deferSaves() changes the list under
+    return autoSave &&
+           std::find(deferringThreads.begin(), deferringThreads.end(), std::this_thread::get_id()) ==
+               deferringThreads.end();
+}
+
+void TaskManager::save() {
+    bool outermost = writer.load(std::memory_order_relaxed) != std::this_thread::get_id();
+    std::shared_future<void> saving;
+    {
+        WriteGuard guard(*this);
+        if (savesInBackground()) {
+            saving = startSave();
+        } else if (unsavedChanges) {
+            // A conflict loads the tasks under this lock, so the next try saves
+            RepositoryLockScope scope(repository, LockMode::EXCLUSIVE);
+            // Optimistic saves find out for themselves, as a conflict
+            if (!savesOptimistically()) {
+                dropIfStale();
+            }
+            retryConflicts([this] {
+                repository.saveSnapshot(tasks.snapshot());
+            });
+            unsavedChanges = false;
+            deferredChanges.clear();
+        }
+    }
+    if (saving.valid()) {
+        try {
+            saving.get();
+        } catch (...) {
+            // Marks the changes unsaved for the next save
+            WriteGuard guard(*this);
+            settleSaves(false);
+            throw;
+        }
+    } else if (outermost) {
+        syncRepository();
+    }
+}
+
+std::shared_future<void> TaskManager::saveAsync() {
+    {
+        WriteGuard guard(*this);
+        if (savesInBackground()) {
+            return startSave();
+        }
+    }
+    std::promise<void> saved;
+    try {
+        save();
+        saved.set_value();
+    } catch (...) {
+        saved.set_exception(std::current_exception());
+    }
+    return saved.get_future().share();
+}
+
+void TaskManager::setAsyncRepository(IAsyncTaskRepository* repository) {
+    WriteGuard guard(*this);
+    settleSaves(true);
+    asyncRepository = repository;
+}
+
+bool TaskManager::savesAsynchronously() const {
+    ReadGuard guard(*this);
+    return asyncRepository && !streaming;
+}
+
+bool TaskManager::savesOptimistically() const {
+    return !streaming && versioned && versioned->isOptimistic();
+}
+
+std::size_t TaskManager::getConflictCount() const {
+    ReadGuard guard(*this);
+    return deferredChanges.getConflictCount();
+}
+
+TaskEventDispatcher::SubscriptionId TaskManager::subscribe(TaskEventHandler handler,
+                                                          TaskEventDispatcher::Settings settings) {
+    // Between changes, so the subscriber hears of whole ones only
+    WriteGuard guard(*this);
+    return events.subscribe(std::move(handler), settings);
+}
+
+bool TaskManager::unsubscribe(TaskEventDispatcher::SubscriptionId id) {
+    // Not under the manager: it waits for an asynchronous handler, which may
+    // be waiting for the manager
+    return events.unsubscribe(id);
+}
+
+void TaskManager::flushEvents() {
+    events.flush();
+}
+
+TaskEventDispatcher::Stats TaskManager::getEventStats() const {
+    return events.getStats();
+}
+
+void TaskManager::sync() {
+    syncRepository();
+}
+
+bool TaskManager::hasUnsavedChanges() const {
+    ReadGuard guard(*this);
+    return unsavedChanges;
+}
+
+void TaskManager::lockRepository(LockMode mode) const {
+    if (lockable) {
+        lockable->lock(mode);
+    }
+}
+
+void TaskManager::unlockRepository() const {
+    if (lockable) {
+        lockable->unlock();
+    }
+}
+
+void TaskManager::syncRepository() const {
+    if (durable) {
+        durable->sync();
+    }
+}
+
+void TaskManager::lock(LockMode mode) const {
+    lockWriter();
+    try {
+        // The repository is called directly until unlock()
+        settleSaves(true);
+        lockRepository(mode);
+    } catch (...) {
+        unlockWriter();
+        throw;
+    }
+    if (repositoryDepth++ == 0) {
+        dropIfStale();
+    }
+}
+
+void TaskManager::unlock() const {
+    repositoryDepth--;
+    unlockRepository();
+    unlockWriter();
 }
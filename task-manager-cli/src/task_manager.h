@@ -1,25 +1,208 @@
 #ifndef TASK_MANAGER_H
 #define TASK_MANAGER_H
 
-#include <vector>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <optional>
+#include <shared_mutex>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include <memory_resource>
 #include "task.h"
+#include "deferred_changes.h"
 #include "i_task_repository.h"
+#include "i_async_task_repository.h"
+#include "repository_capabilities.h"
+#include "string_interner.h"
+#include "task_events.h"
+#include "task_snapshot.h"
+#include "work_stealing_pool.h"
 
+/**
+ * Task operations over a repository, safe to use from several threads:
+ * lookups share a reader-writer lock, changes hold it alone.
+ */
 class TaskManager {
+public:
+    // Loaded lists at least this long are searched on the thread pool
+    static constexpr std::size_t kParallelSearchTasks = 4096;
+    // Saves that conflict are tried on fresh tasks until this many have failed
+    static constexpr std::size_t kMaxSaveAttempts = DeferredChanges::kMaxAttempts;
+
 private:
+    class ReadGuard;
+    class WriteGuard;
+    class ChangeGuard;
+
     ITaskRepository& repository;
-    std::vector<Task> tasks;
+    // The repository's optional capabilities, or nullptr
+    ILockableRepository* lockable;
+    IDurableRepository* durable;
+    IVersionedRepository* versioned;
+    ITailReadableRepository* tailReadable;
+    std::pmr::memory_resource* resource;
+    StringInterner* interner;
+    // Streaming repositories keep the tasks; the list below stays empty
+    bool streaming;
+    // The list is loaded on first use, by commands that need it
+    mutable bool loaded;
+    // Published as immutable versions that snapshots pin
+    mutable VersionedTaskList tasks;
+    // IDs are handed out here so they stay unique while saves are deferred
+    mutable int nextId;
+    bool autoSave;
+    // Threads whose changes are not saved until save(), once per deferSaves()
+    std::vector<std::thread::id> deferringThreads;
+    // Set again when a save made in the background is found to have failed
+    mutable bool unsavedChanges;
+    IAsyncTaskRepository* asyncRepository;
+    // Latest save handed to the asynchronous repository, until it is seen done
+    mutable std::shared_future<void> pendingSave;
+    mutable std::shared_mutex mutex;
+    // Thread holding the mutex exclusively, and how many times it took it
+    mutable std::atomic<std::thread::id> writer;
+    mutable std::size_t writerDepth;
+    // Repository locks the writer holds; the repository is its own then
+    mutable std::size_t repositoryDepth;
+    // Threads for bulk operations, or nullptr to run them on the caller
+    WorkStealingPool* threadPool;
+    // Kept while saves are deferred, and tried again on conflict
+    DeferredChanges deferredChanges;
+    mutable TaskEventDispatcher events;
+    // Events of the writer's changes, published as it lets go
+    mutable TaskEventBuffer pendingEvents;
+
+    void persist();
+    // Whether this thread's changes are saved as they are made
+    bool savesEachChange() const;
+    void recordChange(DeferredChanges::Kind kind, int id, std::string_view description = {},
+                      bool completed = false);
+    void rebase() const;
+    template <typename Attempt>
+    auto retryConflicts(Attempt attempt);
+    bool savesInBackground() const;
+    int newId() const;
+    std::shared_future<void> startSave();
+    void settleSaves(bool wait) const;
+    void ensureLoaded() const;
+    // Under the repository's lock: catch up with tasks another process saved
+    void dropIfStale() const;
+    void lockWriter() const;
+    void unlockWriter() const;
+    void lockRepository(LockMode mode) const;
+    void unlockRepository() const;
+    void syncRepository() const;
+    template <typename Read>
+    auto readLoaded(Read read) const;
+    template <typename Change>
+    auto change(Change apply);
 
 public:
-    // Constructor
-    explicit TaskManager(ITaskRepository& repository);
+    // Constructor; tasks are allocated from resource (thread-safe if the
+    // manager is shared) and descriptions shared through interner, if given
+    explicit TaskManager(ITaskRepository& repository,
+                         std::pmr::memory_resource* resource = std::pmr::get_default_resource(),
+                         StringInterner* interner = nullptr);
+
+    // Add a new task; the rvalue form moves the description in
+    int addTask(std::string_view description);
+    int addTask(const char* description);
+    int addTask(std::pmr::string&& description);
+
+    // Add tasks with consecutive new IDs as one change; returns the first ID
+    int addTasks(const TaskList& tasks);
+
+    // Whether added tasks are appended rather than saved with the whole list
+    bool appendsDirectly() const;
+
+    // List all tasks (the copy is allocated from the manager's memory resource)
+    TaskList listTasks() const;
+
+    // Visit every task without copying the list; the visitor must not
+    // change a streaming manager
+    void forEachTask(const TaskVisitor& visitor) const;
+
+    // The repository's tail reads (see ITailReadableRepository); false
+    // when it has none
+    bool markAppends(AppendMark& mark) const;
+    bool forEachAppended(AppendMark& mark, const TaskVisitor& visitor) const;
+
+    // Cheap read view of the tasks as they are now
+    TaskSnapshot snapshot() const;
+
+    // Copy of the task with this ID, or nothing when there is none
+    std::optional<Task> findTask(int id) const;
+
+    // Tasks whose description contains text, ignoring ASCII case; long
+    // lists are searched on the thread pool
+    TaskList searchTasks(std::string_view text) const;
+
+    // The repository's file if it can be copied as this export; else empty
+    std::string exportFile(ExportFormat format) const;
+
+    // Whether tasks stay in the repository instead of in memory
+    bool isStreaming() const;
+
+    // Run bulk operations on pool's threads (nullptr: on the caller)
+    void setThreadPool(WorkStealingPool* pool);
+    WorkStealingPool* getThreadPool() const;
 
-    // Add a new task
-    int addTask(const std::string& description);
+    // Load the tasks now instead of on first use
+    void load();
 
-    // List all tasks
-    std::vector<Task> listTasks() const;
+    // Forget the loaded tasks, and any unsaved changes
+    void reload();
+
+    // Save after every mutation (the default), or only when save() is called
+    void setAutoSave(bool enabled);
+    bool isAutoSaveEnabled() const;
+
+    // Leave this thread's changes unsaved until save(), whatever the setting
+    // above, until the matching resumeSaves(); other threads' changes are
+    // saved as usual meanwhile (with this thread's along with them)
+    void deferSaves();
+    void resumeSaves();
+
+    // Persist pending changes, replayed on fresh tasks if another process saved
+    // @throws the error of the save when it failed; the changes stay unsaved
+    void save();
+
+    // Start persisting pending changes; the future is ready once they are saved
+    std::shared_future<void> saveAsync();
+
+    // Queue saves to an asynchronous repository wrapping this one (nullptr:
+    // save directly); set before the manager is shared between threads
+    void setAsyncRepository(IAsyncTaskRepository* repository);
+    bool savesAsynchronously() const;
+
+    // Whether saves compare generations instead of holding the lock throughout
+    bool savesOptimistically() const;
+
+    // Saves so far that conflicted with another writer's
+    std::size_t getConflictCount() const;
+
+    // Wait until saved changes are on the device; needed after unlock() only
+    void sync();
+
+    // Whether there are changes that have not been saved yet
+    bool hasUnsavedChanges() const;
+
+    // Hold the repository's lock, and the manager, across several calls
+    void lock(LockMode mode) const;
+    void unlock() const;
+
+    // Deliver the events of changes from the next one on to handler
+    TaskEventDispatcher::SubscriptionId subscribe(
+        TaskEventHandler handler, TaskEventDispatcher::Settings settings = TaskEventDispatcher::Settings());
+    bool unsubscribe(TaskEventDispatcher::SubscriptionId id);
+
+    // Wait until asynchronous subscribers have every event so far
+    void flushEvents();
+    TaskEventDispatcher::Stats getEventStats() const;
 
     // Complete a task by ID
     bool completeTask(int id);
@@ -28,4 +211,23 @@ public:
     void clearAllTasks();
 };
 
+/**
+ * Defers the saves of this thread's changes to a manager while it lives
+ * (see TaskManager::deferSaves()).
+ */
+class SaveDeferral {
+    TaskManager& manager;
+
+public:
+    explicit SaveDeferral(TaskManager& manager) : manager(manager) {
+        manager.deferSaves();
+    }
+    ~SaveDeferral() {
+        manager.resumeSaves();
+    }
+
+    SaveDeferral(const SaveDeferral&) = delete;
+    SaveDeferral& operator=(const SaveDeferral&) = delete;
+};
+
 #endif // TASK_MANAGER_H
@@ -0,0 +1,235 @@
+#include "task_server.h"
+#include "command_runner.h"
+#include "repository_exceptions.h"
+#include "socket_io.h"
+#include <array>
+#include <cstdint>
+#include <memory_resource>
+#include <ostream>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#ifndef _WIN32
+#include <poll.h>
+#include <sys/time.h>
+#endif
+
+namespace {
+
+// How often run() wakes up to check for stop()
+constexpr int kPollIntervalMs = 100;
+
+// A client that stops sending mid-request, or stops reading its output,
+// is dropped after this long
+constexpr int kReceiveTimeoutSeconds = 5;
+constexpr int kSendTimeoutSeconds = 5;
+
+} // namespace
+
+TaskServer::TaskServer(TaskManager& manager, CLI& cli, std::string socketPath)
+    : manager(manager), cli(cli), socketPath(std::move(socketPath)),
+      listenFd(-1), stopping(false), requestCount(0) {
+}
+
+std::size_t TaskServer::getRequestCount() const {
+    return requestCount.load();
+}
+
+void TaskServer::stop() {
+    stopping.store(true);
+}
+
+#ifdef _WIN32
+
+TaskServer::~TaskServer() {
+}
+
+void TaskServer::closeSocket() {
+}
+
+bool TaskServer::isSupported() {
+    return false;
+}
+
+void TaskServer::start() {
+    throw std::runtime_error("serve requires Unix domain sockets, which this platform does not support");
+}
+
+void TaskServer::run() {
+}
+
+void TaskServer::handleConnection(int) {
+}
+
+void TaskServer::joinConnections(bool) {
+}
+
+#else
+
+TaskServer::~TaskServer() {
+    closeSocket();
+}
+
+void TaskServer::closeSocket() {
+    if (listenFd >= 0) {
+        ::close(listenFd);
+        ::unlink(socketPath.c_str());
+        listenFd = -1;
+    }
+}
+
+bool TaskServer::isSupported() {
+    return true;
+}
+
+void TaskServer::start() {
+    sockaddr_un address;
+    if (!socket_io::makeAddress(socketPath, address)) {
+        throw std::runtime_error("Socket path is too long: " + socketPath);
+    }
+
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot create socket: " + std::string(std::strerror(errno)));
+    }
+
+    // A socket file nobody accepts on is left over from a server that died
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0) {
+        ::close(fd);
+        throw std::runtime_error("A server is already listening on " + socketPath);
+    }
+    ::close(fd);
+    ::unlink(socketPath.c_str());
+
+    fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot create socket: " + std::string(std::strerror(errno)));
+    }
+    if (::bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        ::listen(fd, SOMAXCONN) != 0) {
+        std::string error = std::strerror(errno);
+        ::close(fd);
+        throw std::runtime_error("Cannot listen on " + socketPath + ": " + error);
+    }
+    listenFd = fd;
+}
+
+void TaskServer::run() {
+    if (listenFd < 0) {
+        start();
+    }
+
+    while (!stopping.load()) {
+        pollfd pending{listenFd, POLLIN, 0};
+        int ready = ::poll(&pending, 1, kPollIntervalMs);
+        if (ready < 0 && errno != EINTR) {
+            throw std::runtime_error("Cannot wait for connections: " + std::string(std::strerror(errno)));
+        }
+
+        if (ready > 0 && (pending.revents & POLLIN)) {
+            int client = ::accept(listenFd, nullptr, nullptr);
+            if (client >= 0) {
+                // A slow client holds up only its own connection; the
+                // manager is shared between the threads
+                Connection& connection = connections.emplace_back();
+                try {
+                    connection.thread = std::thread([this, client, &connection] {
+                        handleConnection(client);
+                        ::close(client);
+                        connection.done.store(true);
+                    });
+                } catch (const std::system_error&) {
+                    connections.pop_back();
+                    handleConnection(client);
+                    ::close(client);
+                }
+            }
+        }
+        joinConnections(false);
+    }
+
+    // Stop taking requests so new invocations fall back to the file
+    closeSocket();
+    joinConnections(true);
+}
+
+void TaskServer::joinConnections(bool all) {
+    for (auto connection = connections.begin(); connection != connections.end();) {
+        if (all || connection->done.load()) {
+            connection->thread.join();
+            connection = connections.erase(connection);
+        } else {
+            ++connection;
+        }
+    }
+}
+
+void TaskServer::handleConnection(int fd) {
+    socket_io::configureSocket(fd);
+    timeval receiveTimeout{kReceiveTimeoutSeconds, 0};
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &receiveTimeout, sizeof(receiveTimeout));
+    timeval sendTimeout{kSendTimeoutSeconds, 0};
+    ::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &sendTimeout, sizeof(sendTimeout));
+
+    // Read the command line; batch and import input is received as the command reads it
+    std::uint32_t argc = 0;
+    if (!socket_io::readUint32(fd, argc) || argc == 0 || argc > 4096) {
+        return;
+    }
+    std::vector<std::string> args(argc);
+    for (auto& arg : args) {
+        if (!socket_io::readString(fd, arg)) {
+            return;
+        }
+    }
+    std::uint8_t hasInput = 0;
+    if (!socket_io::readAll(fd, &hasInput, sizeof(hasInput))) {
+        return;
+    }
+
+    std::vector<char*> argv;
+    argv.reserve(args.size());
+    for (auto& arg : args) {
+        argv.push_back(arg.data());
+    }
+
+    // Parsing allocations are released with the request
+    std::array<std::byte, 4096> buffer;
+    std::pmr::monotonic_buffer_resource requestArena(buffer.data(), buffer.size());
+
+    socket_io::ChunkReader chunks(fd, hasInput != 0);
+    std::istream in(&chunks);
+    in.exceptions(std::ios::badbit);
+    // Output goes back as it is written, however much there is
+    socket_io::ChunkWriter output(fd);
+    std::ostream out(&output);
+    CommandRunner runner(manager, cli, in);
+    std::int32_t status = 1;
+    try {
+        Command cmd = cli.parseCommand(static_cast<int>(argv.size()), argv.data(), &requestArena);
+        if (hasInput && (cmd.type == CommandType::BATCH || cmd.type == CommandType::IMPORT)) {
+            cmd.argument.assign(1, '-');
+        }
+        status = runner.execute(cmd, out);
+        // A change is acknowledged only once saved (and synced when the
+        // repository is durable), as it is without a server; the manager
+        // saves each change itself unless auto-saving was turned off
+        if (manager.hasUnsavedChanges()) {
+            manager.save();
+        }
+    } catch (const RepositoryException& e) {
+        out << "Repository Error: " << e.what() << "\n";
+    } catch (const std::exception& e) {
+        out << "Error: " << e.what() << "\n";
+    }
+    requestCount++;
+
+    // A client that has gone away just misses the rest of its output
+    if (chunks.drain() && output.finish()) {
+        socket_io::writeAll(fd, &status, sizeof(status));
+    }
+}
+
+#endif // _WIN32
@@ -0,0 +1,67 @@
+#ifndef TASK_SERVER_H
+#define TASK_SERVER_H
+
+#include <atomic>
+#include <cstddef>
+#include <list>
+#include <string>
+#include <thread>
+#include "cli.h"
+#include "task_manager.h"
+
+/**
+ * Daemon running command lines from TaskClient over a Unix domain socket
+ * against a resident TaskManager; each change is saved before the reply.
+ * Every connection is served on its own thread.
+ */
+class TaskServer {
+private:
+    struct Connection {
+        std::thread thread;
+        std::atomic<bool> done{false};
+    };
+
+    TaskManager& manager;
+    CLI& cli;
+    std::string socketPath;
+    int listenFd;
+    std::atomic<bool> stopping;
+    std::atomic<std::size_t> requestCount;
+    // Connections being served (run() only)
+    std::list<Connection> connections;
+
+    void handleConnection(int fd);
+    // Join the threads of finished connections, or of all of them
+    void joinConnections(bool all);
+    void closeSocket();
+
+public:
+    // Constructor; the manager and CLI must outlive the server
+    TaskServer(TaskManager& manager, CLI& cli, std::string socketPath);
+    ~TaskServer();
+
+    TaskServer(const TaskServer&) = delete;
+    TaskServer& operator=(const TaskServer&) = delete;
+
+    /**
+     * Bind and listen on the socket path. A stale socket file left by a
+     * server that is no longer running is replaced.
+     * @throws std::runtime_error if the socket cannot be created or another
+     *         server is already listening on the path
+     */
+    void start();
+
+    // Serve requests until stop() is called; requests under way finish first
+    void run();
+
+    // Ask run() to return; safe to call from other threads and signal handlers
+    void stop();
+
+    // Number of requests handled so far
+    std::size_t getRequestCount() const;
+
+    // Whether this platform can run the server
+    static bool isSupported();
+};
+
+#endif // TASK_SERVER_H
@@ -0,0 +1,220 @@
+#include "task_snapshot.h"
+#include <algorithm>
+
+namespace {
+
+struct Location {
+    std::size_t chunk = 0;
+    std::size_t index = 0;
+    bool found = false;
+};
+
+Location locate(const TaskVersion& version, int id) {
+    Location location;
+    if (version.sortedById) {
+        // Last chunk starting at or below the ID, then within it
+        auto chunk = std::upper_bound(version.chunks.begin(), version.chunks.end(), id,
+                                      [](int value, const std::shared_ptr<TaskChunk>& c) {
+                                          return value < c->tasks.front().getId();
+                                      });
+        if (chunk == version.chunks.begin()) {
+            return location;
+        }
+        --chunk;
+        const TaskList& tasks = (*chunk)->tasks;
+        auto task = std::lower_bound(tasks.begin(), tasks.end(), id, [](const Task& t, int value) {
+            return t.getId() < value;
+        });
+        if (task != tasks.end() && task->getId() == id) {
+            location.chunk = static_cast<std::size_t>(chunk - version.chunks.begin());
+            location.index = static_cast<std::size_t>(task - tasks.begin());
+            location.found = true;
+        }
+        return location;
+    }
+    for (std::size_t c = 0; c < version.chunks.size(); c++) {
+        const TaskList& tasks = version.chunks[c]->tasks;
+        for (std::size_t i = 0; i < tasks.size(); i++) {
+            if (tasks[i].getId() == id) {
+                location.chunk = c;
+                location.index = i;
+                location.found = true;
+                return location;
+            }
+        }
+    }
+    return location;
+}
+
+} // namespace
+
+TaskVersion::TaskVersion(const TaskVersion& other)
+    : chunks(other.chunks), size(other.size), maxId(other.maxId), sortedById(other.sortedById) {
+    for (const auto& chunk : chunks) {
+        chunk->versions.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+TaskVersion::~TaskVersion() {
+    // Released once the last reader of this version is done with the chunks
+    for (const auto& chunk : chunks) {
+        chunk->versions.fetch_sub(1, std::memory_order_release);
+    }
+}
+
+TaskSnapshot::TaskSnapshot() : TaskSnapshot(std::make_shared<const TaskVersion>()) {
+}
+
+TaskSnapshot::TaskSnapshot(std::shared_ptr<const TaskVersion> version) : version(std::move(version)) {
+    this->version->pins.fetch_add(1, std::memory_order_relaxed);
+}
+
+TaskSnapshot::TaskSnapshot(const TaskSnapshot& other) : version(other.version) {
+    version->pins.fetch_add(1, std::memory_order_relaxed);
+}
+
+TaskSnapshot& TaskSnapshot::operator=(const TaskSnapshot& other) {
+    if (this != &other) {
+        other.version->pins.fetch_add(1, std::memory_order_relaxed);
+        version->pins.fetch_sub(1, std::memory_order_release);
+        version = other.version;
+    }
+    return *this;
+}
+
+TaskSnapshot::~TaskSnapshot() {
+    // Pairs with the writer's check before it changes the version in place
+    version->pins.fetch_sub(1, std::memory_order_release);
+}
+
+std::size_t TaskSnapshot::size() const {
+    return version->size;
+}
+
+bool TaskSnapshot::empty() const {
+    return version->size == 0;
+}
+
+std::size_t TaskSnapshot::chunkCount() const {
+    return version->chunks.size();
+}
+
+const TaskList& TaskSnapshot::chunk(std::size_t index) const {
+    return version->chunks[index]->tasks;
+}
+
+TaskSnapshot::const_iterator TaskSnapshot::begin() const {
+    return const_iterator(version.get(), 0);
+}
+
+TaskSnapshot::const_iterator TaskSnapshot::end() const {
+    return const_iterator(version.get(), version->chunks.size());
+}
+
+const Task* TaskSnapshot::find(int id) const {
+    Location location = locate(*version, id);
+    return location.found ? &version->chunks[location.chunk]->tasks[location.index] : nullptr;
+}
+
+TaskList TaskSnapshot::toList(std::pmr::memory_resource* resource) const {
+    TaskList tasks(resource);
+    tasks.reserve(version->size);
+    for (const auto& chunk : version->chunks) {
+        tasks.insert(tasks.end(), chunk->tasks.begin(), chunk->tasks.end());
+    }
+    return tasks;
+}
+
+VersionedTaskList::VersionedTaskList(std::pmr::memory_resource* resource)
+    : resource(resource), current(std::make_shared<TaskVersion>()) {
+}
+
+TaskVersion& VersionedTaskList::writable() {
+    if (current->pins.load(std::memory_order_acquire) > 0) {
+        // The snapshots keep the old version; this one shares its chunks
+        current = std::make_shared<TaskVersion>(*current);
+    }
+    return *current;
+}
+
+TaskList& VersionedTaskList::writableChunk(std::size_t index) {
+    std::shared_ptr<TaskChunk>& chunk = writable().chunks[index];
+    if (chunk->versions.load(std::memory_order_acquire) > 1) {
+        auto copy = std::make_shared<TaskChunk>(TaskList(chunk->tasks, resource));
+        chunk->versions.fetch_sub(1, std::memory_order_release);
+        chunk = std::move(copy);
+    }
+    return chunk->tasks;
+}
+
+TaskList& VersionedTaskList::appendChunk() {
+    TaskVersion& version = writable();
+    if (version.chunks.empty() || version.chunks.back()->tasks.size() == TaskVersion::kChunkSize) {
+        version.chunks.push_back(std::make_shared<TaskChunk>(TaskList(resource)));
+        return version.chunks.back()->tasks;
+    }
+    return writableChunk(version.chunks.size() - 1);
+}
+
+void VersionedTaskList::appended(const Task& task) {
+    TaskVersion& version = *current;
+    if (version.size > 0 && task.getId() <= version.maxId) {
+        version.sortedById = false;
+    }
+    version.maxId = std::max(version.maxId, task.getId());
+    version.size++;
+}
+
+void VersionedTaskList::abandonAppend() {
+    TaskVersion& version = *current;
+    if (!version.chunks.empty() && version.chunks.back()->tasks.empty()) {
+        version.chunks.pop_back();
+    }
+}
+
+void VersionedTaskList::assign(TaskList&& tasks) {
+    auto version = std::make_shared<TaskVersion>();
+    for (std::size_t start = 0; start < tasks.size(); start += TaskVersion::kChunkSize) {
+        std::size_t end = std::min(tasks.size(), start + TaskVersion::kChunkSize);
+        TaskList chunk(resource);
+        chunk.reserve(end - start);
+        // Moved within one memory resource, so descriptions are not copied
+        chunk.insert(chunk.end(), std::make_move_iterator(tasks.begin() + static_cast<std::ptrdiff_t>(start)),
+                     std::make_move_iterator(tasks.begin() + static_cast<std::ptrdiff_t>(end)));
+        version->chunks.push_back(std::make_shared<TaskChunk>(std::move(chunk)));
+    }
+    version->size = tasks.size();
+    for (std::size_t i = 0; i < tasks.size(); i++) {
+        if (i > 0 && tasks[i].getId() <= version->maxId) {
+            version->sortedById = false;
+        }
+        version->maxId = i > 0 ? std::max(version->maxId, tasks[i].getId()) : tasks[i].getId();
+    }
+    current = std::move(version);
+}
+
+void VersionedTaskList::clear() {
+    current = std::make_shared<TaskVersion>();
+}
+
+const Task* VersionedTaskList::find(int id) const {
+    Location location = locate(*current, id);
+    return location.found ? &current->chunks[location.chunk]->tasks[location.index] : nullptr;
+}
+
+Task* VersionedTaskList::findForWrite(int id) {
+    Location location = locate(*current, id);
+    return location.found ? &writableChunk(location.chunk)[location.index] : nullptr;
+}
+
+std::size_t VersionedTaskList::size() const {
+    return current->size;
+}
+
+bool VersionedTaskList::isSortedById() const {
+    return current->sortedById;
+}
+
+TaskSnapshot VersionedTaskList::snapshot() const {
+    return TaskSnapshot(current);
+}
@@ -0,0 +1,182 @@
+#ifndef TASK_SNAPSHOT_H
+#define TASK_SNAPSHOT_H
+
+#include <atomic>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <memory_resource>
+#include <utility>
+#include <vector>
+#include "task.h"
+
+// Tasks of one chunk, and how many versions hold it
+struct TaskChunk {
+    TaskList tasks;
+    std::atomic<std::size_t> versions;
+
+    explicit TaskChunk(TaskList tasks) : tasks(std::move(tasks)), versions(1) {}
+};
+
+/**
+ * One version of a task list, held in chunks of up to kChunkSize tasks so a
+ * new version can share every chunk it does not change with the old one
+ */
+struct TaskVersion {
+    static constexpr std::size_t kChunkSize = 256;
+
+    // No chunk is empty, and only the last may hold fewer than kChunkSize
+    std::vector<std::shared_ptr<TaskChunk>> chunks;
+    std::size_t size = 0;
+    int maxId = 0;
+    // IDs increase through the chunks, so lookups can binary search
+    bool sortedById = true;
+    // Snapshots holding this version
+    mutable std::atomic<std::size_t> pins{0};
+
+    TaskVersion() = default;
+    // Shares the other version's chunks
+    TaskVersion(const TaskVersion& other);
+    ~TaskVersion();
+    TaskVersion& operator=(const TaskVersion&) = delete;
+};
+
+/**
+ * Read view of the tasks as they were when it was taken. Copying it is
+ * cheap (two reference counts), it needs no lock to read, and later changes
+ * to the manager never show through it. The version's memory is released
+ * with the last snapshot holding it.
+ */
+class TaskSnapshot {
+public:
+    class const_iterator {
+        const TaskVersion* version;
+        std::size_t chunk;
+        // Position in the current chunk and its end; null at the end
+        const Task* task;
+        const Task* chunkEnd;
+
+        void enterChunk() {
+            if (chunk < version->chunks.size()) {
+                const TaskList& tasks = version->chunks[chunk]->tasks;
+                task = tasks.data();
+                chunkEnd = task + tasks.size();
+            } else {
+                task = nullptr;
+                chunkEnd = nullptr;
+            }
+        }
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Task;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const Task*;
+        using reference = const Task&;
+
+        const_iterator(const TaskVersion* version, std::size_t chunk) : version(version), chunk(chunk) {
+            enterChunk();
+        }
+
+        reference operator*() const { return *task; }
+        pointer operator->() const { return task; }
+
+        const_iterator& operator++() {
+            if (++task == chunkEnd) {
+                chunk++;
+                enterChunk();
+            }
+            return *this;
+        }
+        const_iterator operator++(int) {
+            const_iterator previous = *this;
+            ++*this;
+            return previous;
+        }
+
+        bool operator==(const const_iterator& other) const { return task == other.task; }
+        bool operator!=(const const_iterator& other) const { return task != other.task; }
+    };
+
+private:
+    std::shared_ptr<const TaskVersion> version;
+
+public:
+    // An empty snapshot
+    TaskSnapshot();
+    explicit TaskSnapshot(std::shared_ptr<const TaskVersion> version);
+    TaskSnapshot(const TaskSnapshot& other);
+    TaskSnapshot& operator=(const TaskSnapshot& other);
+    ~TaskSnapshot();
+
+    std::size_t size() const;
+    bool empty() const;
+
+    const_iterator begin() const;
+    const_iterator end() const;
+
+    // The tasks in consecutive chunks, for splitting work over threads
+    std::size_t chunkCount() const;
+    const TaskList& chunk(std::size_t index) const;
+
+    // The task with this ID, or nullptr; valid as long as the snapshot
+    const Task* find(int id) const;
+
+    // Copy of the tasks, allocated from resource
+    TaskList toList(std::pmr::memory_resource* resource = std::pmr::get_default_resource()) const;
+};
+
+/**
+ * The writer's side: a task list publishing immutable versions that share
+ * chunks, copied on write while a snapshot holds them. Not synchronized.
+ */
+class VersionedTaskList {
+    std::pmr::memory_resource* resource;
+    std::shared_ptr<TaskVersion> current;
+
+    TaskVersion& writable();
+    TaskList& writableChunk(std::size_t index);
+    TaskList& appendChunk();
+    void appended(const Task& task);
+    void abandonAppend();
+
+public:
+    explicit VersionedTaskList(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    VersionedTaskList(const VersionedTaskList&) = delete;
+    VersionedTaskList& operator=(const VersionedTaskList&) = delete;
+
+    // Replace the tasks, moving them into chunks
+    void assign(TaskList&& tasks);
+    void clear();
+
+    // Construct a task at the end (allocated from the list's resource)
+    template <typename... Args>
+    Task& emplace_back(Args&&... args);
+
+    // The task with this ID, or nullptr; findForWrite copies its chunk first
+    // when a snapshot holds it
+    const Task* find(int id) const;
+    Task* findForWrite(int id);
+
+    std::size_t size() const;
+    bool isSortedById() const;
+
+    // Pin the current version
+    TaskSnapshot snapshot() const;
+};
+
+template <typename... Args>
+Task& VersionedTaskList::emplace_back(Args&&... args) {
+    TaskList& chunk = appendChunk();
+    try {
+        Task& task = chunk.emplace_back(std::forward<Args>(args)...);
+        appended(task);
+        return task;
+    } catch (...) {
+        abandonAppend();
+        throw;
+    }
+}
+
+#endif // TASK_SNAPSHOT_H
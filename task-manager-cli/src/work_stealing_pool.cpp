@@ -0,0 +1,207 @@
+#include "work_stealing_pool.h"
+
+namespace {
+
+// The pool and worker the calling thread belongs to, if any
+struct CurrentWorker {
+    const WorkStealingPool* pool = nullptr;
+    std::size_t index = 0;
+};
+
+thread_local CurrentWorker currentWorkerOfThread;
+
+} // namespace
+
+WorkStealingPool::WorkStealingPool(std::size_t threads)
+    : queued(0), nextWorker(0), jobs(0), stolen(0), sleepers(0), stopping(false) {
+    for (std::size_t i = 0; i < std::max<std::size_t>(threads, 1); i++) {
+        workers.push_back(std::make_unique<Worker>());
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& worker : workers) {
+        if (worker->thread.joinable()) {
+            worker->thread.join();
+        }
+    }
+}
+
+std::size_t WorkStealingPool::defaultThreadCount() {
+    return std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+}
+
+std::size_t WorkStealingPool::getThreadCount() const {
+    return workers.size();
+}
+
+WorkStealingPool::Stats WorkStealingPool::getStats() const {
+    Stats stats;
+    stats.jobs = jobs.load();
+    stats.stolen = stolen.load();
+    return stats;
+}
+
+std::size_t WorkStealingPool::currentWorker() const {
+    const CurrentWorker& current = currentWorkerOfThread;
+    return current.pool == this ? current.index : workers.size();
+}
+
+void WorkStealingPool::push(std::function<void()> job) {
+    std::call_once(started, [this] {
+        for (std::size_t i = 0; i < workers.size(); i++) {
+            workers[i]->thread = std::thread(&WorkStealingPool::work, this, i);
+        }
+    });
+
+    std::size_t index = currentWorker();
+    if (index == workers.size()) {
+        index = nextWorker.fetch_add(1) % workers.size();
+    }
+    {
+        Worker& worker = *workers[index];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.jobs.push_back(std::move(job));
+        queued++;
+    }
+
+    // A worker about to sleep either sees the job counted or is counted
+    // asleep here first, and then is woken under the mutex
+    if (sleepers.load() > 0) {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        wake.notify_one();
+    }
+}
+
+bool WorkStealingPool::runOne() {
+    std::size_t self = currentWorker();
+    std::function<void()> job;
+
+    if (self < workers.size()) {
+        Worker& own = *workers[self];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.jobs.empty()) {
+            job = std::move(own.jobs.back());
+            own.jobs.pop_back();
+            queued--;
+        }
+    }
+    for (std::size_t i = 1; !job && i <= workers.size(); i++) {
+        Worker& victim = *workers[(self + i) % workers.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.jobs.empty()) {
+            job = std::move(victim.jobs.front());
+            victim.jobs.pop_front();
+            queued--;
+            stolen++;
+        }
+    }
+    if (!job) {
+        return false;
+    }
+
+    job();
+    jobs++;
+    return true;
+}
+
+void WorkStealingPool::work(std::size_t index) {
+    currentWorkerOfThread = CurrentWorker{this, index};
+    while (true) {
+        if (runOne()) {
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        sleepers++;
+        wake.wait(lock, [this] {
+            return stopping || queued.load() > 0;
+        });
+        sleepers--;
+        if (stopping && queued.load() == 0) {
+            return;
+        }
+    }
+}
+
+TaskGroup::TaskGroup(WorkStealingPool* pool) : pool(pool), pending(0) {
+}
+
+TaskGroup::~TaskGroup() {
+    try {
+        wait();
+    } catch (...) {
+        // The owner is unwinding already, or chose not to wait
+    }
+}
+
+void TaskGroup::run(std::function<void()> job) {
+    if (!pool) {
+        try {
+            job();
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!error) {
+                error = std::current_exception();
+            }
+        }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending++;
+    }
+    pool->push([this, job = std::move(job)] {
+        std::exception_ptr jobError;
+        try {
+            job();
+        } catch (...) {
+            jobError = std::current_exception();
+        }
+        finish(jobError);
+    });
+}
+
+void TaskGroup::finish(std::exception_ptr jobError) {
+    // Under the mutex, so the group cannot be destroyed before this returns
+    std::lock_guard<std::mutex> lock(mutex);
+    if (jobError && !error) {
+        error = jobError;
+    }
+    if (--pending == 0) {
+        done.notify_all();
+    }
+}
+
+void TaskGroup::wait() {
+    while (pool) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (pending == 0) {
+                break;
+            }
+        }
+        // Help with queued jobs, ours or others'; block once there are none,
+        // as every job of the group has been taken by some thread
+        if (!pool->runOne()) {
+            std::unique_lock<std::mutex> lock(mutex);
+            done.wait(lock, [this] {
+                return pending == 0;
+            });
+        }
+    }
+
+    std::exception_ptr failed;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::swap(failed, error);
+    }
+    if (failed) {
+        std::rethrow_exception(failed);
+    }
+}
@@ -0,0 +1,136 @@
+#ifndef WORK_STEALING_POOL_H
+#define WORK_STEALING_POOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Threads for bulk work, each with its own deque; idle workers steal the
+ * oldest jobs of others. Jobs run through a TaskGroup.
+ */
+class WorkStealingPool {
+public:
+    struct Stats {
+        std::size_t jobs = 0;   // Jobs run
+        std::size_t stolen = 0; // Of those, taken from another thread's deque
+    };
+
+private:
+    struct Worker {
+        std::mutex mutex;
+        std::deque<std::function<void()>> jobs;
+        std::thread thread;
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::once_flag started;
+    // Jobs waiting in any deque
+    std::atomic<std::size_t> queued;
+    std::atomic<std::size_t> nextWorker;
+    std::atomic<std::size_t> jobs;
+    std::atomic<std::size_t> stolen;
+    // Workers asleep, or about to be, on wake
+    std::atomic<std::size_t> sleepers;
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+    bool stopping;
+
+    // Index of the calling thread's worker in this pool, or workers.size()
+    std::size_t currentWorker() const;
+    void push(std::function<void()> job);
+    // Run one job: the calling worker's newest, else one stolen from another
+    // deque. False when every deque is empty.
+    bool runOne();
+    void work(std::size_t index);
+
+    friend class TaskGroup;
+
+public:
+    // threads workers (at least one)
+    explicit WorkStealingPool(std::size_t threads = defaultThreadCount());
+
+    // Stops the workers; every group must have been waited for
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    // One per hardware thread
+    static std::size_t defaultThreadCount();
+
+    std::size_t getThreadCount() const;
+    Stats getStats() const;
+};
+
+/**
+ * Jobs run on a pool and joined by wait(), which rethrows the first
+ * exception; without a pool, jobs run at once on the caller.
+ */
+class TaskGroup {
+    WorkStealingPool* pool;
+    std::mutex mutex;
+    std::condition_variable done;
+    std::size_t pending;
+    std::exception_ptr error;
+
+    void finish(std::exception_ptr jobError);
+
+public:
+    explicit TaskGroup(WorkStealingPool* pool);
+
+    // Waits for jobs still running, dropping their errors
+    ~TaskGroup();
+
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+
+    void run(std::function<void()> job);
+
+    /**
+     * Wait for every job run so far
+     * @throws whatever the first failed job threw
+     */
+    void wait();
+};
+
+/**
+ * Call body(begin, end) over consecutive ranges covering [0, count), in
+ * parallel on pool, and wait for them. Ranges hold at least minChunk
+ * items and there are a few per worker, so uneven ranges even out by
+ * stealing. Without a pool, or with too few items to share, body gets the
+ * whole range on the caller.
+ */
+template <typename Body>
+void parallelChunks(WorkStealingPool* pool, std::size_t count, std::size_t minChunk, Body body) {
+    std::size_t chunk = std::max<std::size_t>(minChunk, 1);
+    if (pool) {
+        std::size_t target = pool->getThreadCount() * 4;
+        chunk = std::max(chunk, (count + target - 1) / target);
+    }
+    if (!pool || count <= chunk) {
+        if (count > 0) {
+            body(std::size_t{0}, count);
+        }
+        return;
+    }
+
+    TaskGroup group(pool);
+    for (std::size_t begin = 0; begin < count; begin += chunk) {
+        std::size_t end = std::min(count, begin + chunk);
+        group.run([&body, begin, end] {
+            body(begin, end);
+        });
+    }
+    group.wait();
+}
+
+#endif // WORK_STEALING_POOL_H
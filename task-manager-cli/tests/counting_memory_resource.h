@@ -0,0 +1,55 @@
+#ifndef COUNTING_MEMORY_RESOURCE_H
+#define COUNTING_MEMORY_RESOURCE_H
+
+#include <cstddef>
+#include <memory_resource>
+
+/**
+ * Memory resource for tests that forwards to an upstream resource and
+ * counts the allocations and bytes that went through it.
+ * Character buffers are requested with alignment 1, which tells string
+ * allocations apart from container storage.
+ */
+class CountingMemoryResource : public std::pmr::memory_resource {
+private:
+    std::pmr::memory_resource* upstream;
+    std::size_t allocations;
+    std::size_t stringAllocations;
+    std::size_t bytes;
+
+public:
+    explicit CountingMemoryResource(
+        std::pmr::memory_resource* upstream = std::pmr::new_delete_resource())
+        : upstream(upstream), allocations(0), stringAllocations(0), bytes(0) {}
+
+    std::size_t allocationCount() const { return allocations; }
+    std::size_t stringAllocationCount() const { return stringAllocations; }
+    std::size_t bytesAllocated() const { return bytes; }
+
+    // Test helper: Reset the counters
+    void reset() {
+        allocations = 0;
+        stringAllocations = 0;
+        bytes = 0;
+    }
+
+protected:
+    void* do_allocate(std::size_t size, std::size_t alignment) override {
+        ++allocations;
+        if (alignment == alignof(char)) {
+            ++stringAllocations;
+        }
+        bytes += size;
+        return upstream->allocate(size, alignment);
+    }
+
+    void do_deallocate(void* p, std::size_t size, std::size_t alignment) override {
+        upstream->deallocate(p, size, alignment);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+};
+
+#endif // COUNTING_MEMORY_RESOURCE_H
@@ -1,7 +1,7 @@
 #ifndef MOCK_TASK_REPOSITORY_H
 #define MOCK_TASK_REPOSITORY_H
 
-#include <vector>
+#include <memory_resource>
 #include "task.h"
 #include "i_task_repository.h"
 
@@ -11,27 +11,38 @@
  */
 class MockTaskRepository : public ITaskRepository {
 private:
-    std::vector<Task> tasks;
+    TaskList tasks;
     int maxId;
+    int saveCount;
+    int loadCount;
 
 public:
     // Constructor
-    MockTaskRepository() : maxId(0) {}
+    MockTaskRepository() : maxId(0), saveCount(0), loadCount(0) {}
 
     // Load tasks from memory
-    std::vector<Task> loadTasks() override {
+    TaskList loadTasks(std::pmr::memory_resource* resource = std::pmr::get_default_resource(),
+                       StringInterner* interner = nullptr) override {
+        loadCount++;
         // Update maxId based on loaded tasks
         maxId = 0;
+        TaskList loaded(resource);
         for (const auto& task : tasks) {
             if (task.getId() > maxId) {
                 maxId = task.getId();
             }
+            if (interner) {
+                loaded.emplace_back(task.getId(), task.getDescription(), task.isCompleted(), *interner);
+            } else {
+                loaded.push_back(task);
+            }
         }
-        return tasks;
+        return loaded;
     }
 
     // Save tasks to memory
-    void saveTasks(const std::vector<Task>& newTasks) override {
+    void saveTasks(const TaskList& newTasks) override {
+        saveCount++;
         tasks = newTasks;
         // Update maxId while saving
         maxId = 0;
@@ -52,6 +63,16 @@ public:
         maxId = 0;
     }
 
+    // Test helper: Number of saveTasks calls
+    int getSaveCount() const {
+        return saveCount;
+    }
+
+    // Test helper: Number of loadTasks calls
+    int getLoadCount() const {
+        return loadCount;
+    }
+
     // Test helper: Clear all tasks
     void clear() {
         tasks.clear();
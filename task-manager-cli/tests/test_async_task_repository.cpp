@@ -0,0 +1,186 @@
+#include <gtest/gtest.h>
+#include "async_task_repository.h"
+#include "mutation_queue.h"
+#include "task_manager.h"
+#include "mock_task_repository.h"
+#include <chrono>
+#include <condition_variable>
+#include <future>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Repository whose saves wait while the gate is closed, and can fail
+class GatedTaskRepository : public MockTaskRepository {
+    std::mutex mutex;
+    std::condition_variable changed;
+    bool open = true;
+    bool failing = false;
+    int started = 0;
+
+public:
+    void saveTasks(const TaskList& tasks) override {
+        std::unique_lock<std::mutex> lock(mutex);
+        started++;
+        changed.notify_all();
+        changed.wait(lock, [this] {
+            return open;
+        });
+        if (failing) {
+            throw std::runtime_error("Disk full");
+        }
+        MockTaskRepository::saveTasks(tasks);
+    }
+
+    void setOpen(bool value) {
+        std::lock_guard<std::mutex> lock(mutex);
+        open = value;
+        changed.notify_all();
+    }
+
+    void setFailing(bool value) {
+        std::lock_guard<std::mutex> lock(mutex);
+        failing = value;
+    }
+
+    // Wait until this many saves have started
+    void awaitStarted(int count) {
+        std::unique_lock<std::mutex> lock(mutex);
+        changed.wait(lock, [&] {
+            return started >= count;
+        });
+    }
+};
+
+bool isReady(const std::shared_future<void>& future) {
+    return future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
+} // namespace
+
+// Test loads and saves go through to the wrapped repository
+TEST(AsyncTaskRepositoryTest, LoadsAndSaves) {
+    MockTaskRepository repo;
+    AsyncTaskRepository async(repo);
+
+    TaskList tasks;
+    tasks.emplace_back(1, "First", false);
+    tasks.emplace_back(2, "Second", true);
+    async.saveTasks(tasks).get();
+
+    TaskList loaded = async.loadTasks().get();
+    ASSERT_EQ(loaded.size(), 2u);
+    EXPECT_EQ(loaded[1].getDescription(), "Second");
+    EXPECT_TRUE(loaded[1].isCompleted());
+    EXPECT_EQ(repo.getSaveCount(), 1);
+}
+
+// Test saves waiting behind a running save are merged into one write
+TEST(AsyncTaskRepositoryTest, WaitingSavesMerge) {
+    GatedTaskRepository repo;
+    repo.setOpen(false);
+    AsyncTaskRepository async(repo);
+
+    std::shared_future<void> first = async.saveTasks(TaskList());
+    repo.awaitStarted(1);
+    std::vector<std::shared_future<void>> waiting;
+    for (int count = 1; count <= 3; count++) {
+        TaskList tasks;
+        for (int id = 1; id <= count; id++) {
+            tasks.emplace_back(id, "Task " + std::to_string(id), false);
+        }
+        waiting.push_back(async.saveTasks(std::move(tasks)));
+    }
+    EXPECT_FALSE(isReady(first));
+    repo.setOpen(true);
+
+    first.get();
+    for (auto& saved : waiting) {
+        saved.get();
+    }
+    EXPECT_EQ(repo.getSaveCount(), 2);
+    EXPECT_EQ(repo.loadTasks().size(), 3u);
+    AsyncTaskRepository::Stats stats = async.getStats();
+    EXPECT_EQ(stats.saves, 4u);
+    EXPECT_EQ(stats.writes, 2u);
+}
+
+// Test a change returns while the previous change's save is still running
+TEST(AsyncTaskRepositoryTest, ManagerOverlapsSaves) {
+    GatedTaskRepository repo;
+    AsyncTaskRepository async(repo);
+    TaskManager manager(repo);
+    manager.addTask("First");
+    manager.setAsyncRepository(&async);
+    EXPECT_TRUE(manager.savesAsynchronously());
+
+    repo.setOpen(false);
+    EXPECT_EQ(manager.addTask("Second"), 2);
+    repo.awaitStarted(2);
+    // Made in memory while the save of "Second" waits at the gate
+    EXPECT_TRUE(manager.completeTask(1));
+    EXPECT_EQ(manager.addTask("Third"), 3);
+    EXPECT_TRUE(manager.findTask(1)->isCompleted());
+    std::shared_future<void> saved = manager.saveAsync();
+    EXPECT_FALSE(isReady(saved));
+
+    repo.setOpen(true);
+    manager.save();
+    EXPECT_TRUE(isReady(saved));
+    TaskList stored = repo.loadTasks();
+    ASSERT_EQ(stored.size(), 3u);
+    EXPECT_TRUE(stored[0].isCompleted());
+    // The first save, then one for the changes made while it ran
+    EXPECT_EQ(repo.getSaveCount(), 3);
+}
+
+// Test a failed save reaches save() and the changes are saved on the next try
+TEST(AsyncTaskRepositoryTest, FailedSaveIsTriedAgain) {
+    GatedTaskRepository repo;
+    AsyncTaskRepository async(repo);
+    TaskManager manager(repo);
+    manager.load();
+    manager.setAsyncRepository(&async);
+
+    repo.setFailing(true);
+    manager.addTask("Lost at first");
+    EXPECT_THROW(manager.save(), std::runtime_error);
+    EXPECT_TRUE(manager.hasUnsavedChanges());
+
+    repo.setFailing(false);
+    manager.save();
+    EXPECT_FALSE(manager.hasUnsavedChanges());
+    ASSERT_EQ(repo.loadTasks().size(), 1u);
+
+    // Saving directly again waits for nothing
+    manager.setAsyncRepository(nullptr);
+    manager.addTask("Direct");
+    EXPECT_EQ(repo.loadTasks().size(), 2u);
+}
+
+// Test a mutation queue completes futures once its background saves are done
+TEST(AsyncTaskRepositoryTest, MutationQueueSavesInBackground) {
+    MockTaskRepository repo;
+    AsyncTaskRepository async(repo);
+    TaskManager manager(repo);
+    manager.setAsyncRepository(&async);
+
+    std::vector<std::future<int>> added;
+    {
+        MutationQueue queue(manager, 16);
+        for (int i = 0; i < 100; i++) {
+            added.push_back(queue.addTask("Task " + std::to_string(i)));
+        }
+        EXPECT_TRUE(queue.completeTask(1).get());
+    }
+    for (int i = 0; i < 100; i++) {
+        EXPECT_EQ(added[static_cast<std::size_t>(i)].get(), i + 1);
+    }
+    TaskList stored = repo.loadTasks();
+    ASSERT_EQ(stored.size(), 100u);
+    EXPECT_TRUE(stored[0].isCompleted());
+    EXPECT_LE(async.getStats().writes, async.getStats().saves);
+}
@@ -1,5 +1,7 @@
 #include <gtest/gtest.h>
 #include "cli.h"
+#include "counting_memory_resource.h"
+#include <nlohmann/json.hpp>
 #include <sstream>
 #include <vector>
 
@@ -35,6 +37,18 @@ TEST(CLITest, ParseListCommand) {
     EXPECT_EQ(cmd.type, CommandType::LIST);
 }
 
+// Test parsing search command
+TEST(CLITest, ParseSearchCommand) {
+    const char* argv[] = {"task-manager", "search", "buy", "milk"};
+    CLI cli;
+
+    auto cmd = cli.parseCommand(4, const_cast<char**>(argv));
+
+    EXPECT_EQ(cmd.type, CommandType::SEARCH);
+    EXPECT_EQ(cmd.argument, "buy milk");
+    EXPECT_EQ(cli.parseCommand(2, const_cast<char**>(argv)).type, CommandType::INVALID);
+}
+
 // Test parsing complete command
 TEST(CLITest, ParseCompleteCommand) {
     const char* argv[] = {"task-manager", "complete", "5"};
@@ -106,7 +120,7 @@ TEST(CLITest, DisplayTasks) {
     CLI cli;
     std::stringstream ss;
     
-    std::vector<Task> tasks = {
+    TaskList tasks = {
         Task(1, "Buy groceries", false),
         Task(2, "Write code", true),
         Task(5, "Review PR", false)
@@ -128,7 +142,7 @@ TEST(CLITest, DisplayEmptyTasks) {
     CLI cli;
     std::stringstream ss;
     
-    std::vector<Task> tasks;
+    TaskList tasks;
     
     cli.displayTasks(tasks, ss);
     
@@ -157,3 +171,135 @@ TEST(CLITest, DisplayError) {
     std::string output = ss.str();
     EXPECT_TRUE(output.find("Invalid task ID") != std::string::npos);
 }
+
+// Test joining a multi-word description takes a single allocation
+TEST(CLITest, ParseAddCommandAllocatesDescriptionOnce) {
+    const char* argv[] = {"task-manager", "add", "Prepare", "the", "quarterly", "report", "draft"};
+    CLI cli;
+    CountingMemoryResource resource;
+
+    auto cmd = cli.parseCommand(7, const_cast<char**>(argv), &resource);
+
+    EXPECT_EQ(cmd.argument, "Prepare the quarterly report draft");
+    EXPECT_EQ(resource.stringAllocationCount(), 1);
+}
+
+// Test parsing batch command with file and options
+TEST(CLITest, ParseBatchCommand) {
+    const char* argv[] = {"task-manager", "batch", "--save-every=100", "commands.txt"};
+    CLI cli;
+
+    auto cmd = cli.parseCommand(4, const_cast<char**>(argv));
+
+    EXPECT_EQ(cmd.type, CommandType::BATCH);
+    EXPECT_EQ(cmd.argument, "commands.txt");
+    EXPECT_EQ(cmd.options["save-every"], "100");
+}
+
+// Test batch reads standard input by default
+TEST(CLITest, ParseBatchCommandDefaultsToStdin) {
+    const char* argv[] = {"task-manager", "batch"};
+    CLI cli;
+
+    auto cmd = cli.parseCommand(2, const_cast<char**>(argv));
+
+    EXPECT_EQ(cmd.type, CommandType::BATCH);
+    EXPECT_EQ(cmd.argument, "-");
+}
+
+// Test splitting script lines into arguments
+TEST(CLITest, SplitCommandLine) {
+    auto words = CLI::splitCommandLine("  add \"Buy groceries\" 'and milk'  now ");
+
+    ASSERT_EQ(words.size(), 4);
+    EXPECT_EQ(words[0], "add");
+    EXPECT_EQ(words[1], "Buy groceries");
+    EXPECT_EQ(words[2], "and milk");
+    EXPECT_EQ(words[3], "now");
+    EXPECT_TRUE(CLI::splitCommandLine("   ").empty());
+    EXPECT_EQ(CLI::splitCommandLine("add \"\"").size(), 2);
+}
+
+// Test list accepts a --format option
+TEST(CLITest, ParseListCommandWithFormat) {
+    const char* argv[] = {"task-manager", "list", "--format=ndjson"};
+    CLI cli;
+
+    auto cmd = cli.parseCommand(3, const_cast<char**>(argv));
+
+    EXPECT_EQ(cmd.type, CommandType::LIST);
+    EXPECT_EQ(cmd.options["format"], "ndjson");
+    EXPECT_EQ(CLI::parseOutputFormat("ndjson"), OutputFormat::NDJSON);
+    EXPECT_EQ(CLI::parseOutputFormat("csv"), OutputFormat::CSV);
+    EXPECT_EQ(CLI::parseOutputFormat("tsv"), OutputFormat::TSV);
+    EXPECT_EQ(CLI::parseOutputFormat("text"), OutputFormat::TEXT);
+    EXPECT_FALSE(CLI::parseOutputFormat("xml").has_value());
+}
+
+// Test counts accept whole decimal numbers of at least the minimum only
+TEST(CLITest, ParseCount) {
+    EXPECT_EQ(CLI::parseCount("0"), 0u);
+    EXPECT_EQ(CLI::parseCount("250"), 250u);
+    EXPECT_EQ(CLI::parseCount("4", 1), 4u);
+    EXPECT_FALSE(CLI::parseCount("0", 1));
+    EXPECT_FALSE(CLI::parseCount(""));
+    EXPECT_FALSE(CLI::parseCount("-5"));
+    EXPECT_FALSE(CLI::parseCount("+5"));
+    EXPECT_FALSE(CLI::parseCount(" 5"));
+    EXPECT_FALSE(CLI::parseCount("5ms"));
+    EXPECT_FALSE(CLI::parseCount("abc"));
+    EXPECT_FALSE(CLI::parseCount("99999999999999999999999"));
+}
+
+// Test NDJSON lines are valid JSON with escaped descriptions
+TEST(CLITest, DisplayTaskNdjsonEscapes) {
+    CLI cli;
+    std::stringstream ss;
+    std::string description = "Say \"hi\"\\now\n\ttab\x01";
+    {
+        OutputBuffer buffer(ss);
+        cli.displayTask(Task(7, description, true).view(), OutputFormat::NDJSON, buffer);
+    }
+
+    std::string line = ss.str();
+    ASSERT_EQ(line.back(), '\n');
+    EXPECT_EQ(line.find('\n'), line.size() - 1);
+    nlohmann::json j = nlohmann::json::parse(line);
+    EXPECT_EQ(j["id"], 7);
+    EXPECT_EQ(j["description"], description);
+    EXPECT_EQ(j["completed"], true);
+}
+
+// Test CSV quotes only fields that need it and doubles quotes
+TEST(CLITest, DisplayTaskCsvEscapes) {
+    CLI cli;
+    std::stringstream ss;
+    {
+        OutputBuffer buffer(ss);
+        cli.displayHeader(OutputFormat::CSV, buffer);
+        cli.displayTask(Task(1, "Plain", false).view(), OutputFormat::CSV, buffer);
+        cli.displayTask(Task(2, "Milk, eggs", true).view(), OutputFormat::CSV, buffer);
+        cli.displayTask(Task(3, "The \"big\" one\nnext", false).view(), OutputFormat::CSV, buffer);
+    }
+
+    EXPECT_EQ(ss.str(),
+              "id,description,completed\n"
+              "1,Plain,false\n"
+              "2,\"Milk, eggs\",true\n"
+              "3,\"The \"\"big\"\" one\nnext\",false\n");
+}
+
+// Test TSV escapes separators so every record stays on one line
+TEST(CLITest, DisplayTaskTsvEscapes) {
+    CLI cli;
+    std::stringstream ss;
+    {
+        OutputBuffer buffer(ss);
+        cli.displayHeader(OutputFormat::TSV, buffer);
+        cli.displayTask(Task(4, "a\tb\nc\\d\re", true).view(), OutputFormat::TSV, buffer);
+    }
+
+    EXPECT_EQ(ss.str(),
+              "id\tdescription\tcompleted\n"
+              "4\ta\\tb\\nc\\\\d\\re\ttrue\n");
+}
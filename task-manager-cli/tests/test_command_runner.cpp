@@ -0,0 +1,327 @@
+#include <gtest/gtest.h>
+#include "command_runner.h"
+#include "task_manager.h"
+#include "mock_task_repository.h"
+#include "file_task_repository.h"
+#include "cli.h"
+#include "repository_exceptions.h"
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// Repository whose file cannot be read
+class UnreadableRepository : public MockTaskRepository {
+public:
+    TaskList loadTasks(std::pmr::memory_resource* = std::pmr::get_default_resource(),
+                       StringInterner* = nullptr) override {
+        throw FileIOException("cannot read tasks");
+    }
+};
+
+// Repository that fails from the given call to getNextId() on
+class FailingRepository : public MockTaskRepository {
+    mutable int calls = 0;
+    int failFrom;
+
+public:
+    explicit FailingRepository(int failFrom) : failFrom(failFrom) {}
+
+    int getNextId() const override {
+        if (++calls >= failFrom) {
+            throw FileIOException("device gone");
+        }
+        return MockTaskRepository::getNextId();
+    }
+};
+
+} // namespace
+
+class CommandRunnerTest : public ::testing::Test {
+protected:
+    MockTaskRepository repo;
+    CLI cli;
+};
+
+// Test executing a single parsed command
+TEST_F(CommandRunnerTest, ExecuteAddCommand) {
+    TaskManager manager(repo);
+    CommandRunner runner(manager, cli);
+    const char* argv[] = {"task-manager", "add", "Buy", "groceries"};
+    Command cmd = cli.parseCommand(4, const_cast<char**>(argv));
+    std::stringstream out;
+
+    EXPECT_EQ(runner.execute(cmd, out), 0);
+
+    EXPECT_NE(out.str().find("Task added with ID: 1"), std::string::npos);
+    ASSERT_EQ(manager.listTasks().size(), 1);
+    EXPECT_EQ(manager.listTasks()[0].getDescription(), "Buy groceries");
+}
+
+// Test invalid commands fail and show help
+TEST_F(CommandRunnerTest, ExecuteInvalidCommand) {
+    TaskManager manager(repo);
+    CommandRunner runner(manager, cli);
+    const char* argv[] = {"task-manager", "bogus"};
+    Command cmd = cli.parseCommand(2, const_cast<char**>(argv));
+    std::stringstream out;
+
+    EXPECT_EQ(runner.execute(cmd, out), 1);
+
+    EXPECT_NE(out.str().find("Invalid command"), std::string::npos);
+    EXPECT_NE(out.str().find("Usage:"), std::string::npos);
+}
+
+// Test a batch runs every command against one manager and saves once
+TEST_F(CommandRunnerTest, BatchSavesOnceAtEnd) {
+    TaskManager manager(repo);
+    CommandRunner runner(manager, cli);
+    std::stringstream script("add Task one\nadd \"Task two\"\ncomplete 1\nlist\n");
+    std::stringstream out;
+
+    EXPECT_EQ(runner.runBatch(script, out), 0);
+
+    std::string output = out.str();
+    EXPECT_NE(output.find("Task added with ID: 1"), std::string::npos);
+    EXPECT_NE(output.find("Task added with ID: 2"), std::string::npos);
+    EXPECT_NE(output.find("Task 1 marked as completed"), std::string::npos);
+    EXPECT_NE(output.find("[1] [X] Task one"), std::string::npos);
+    EXPECT_NE(output.find("[2] [ ] Task two"), std::string::npos);
+    EXPECT_EQ(repo.getSaveCount(), 1);
+    EXPECT_FALSE(manager.hasUnsavedChanges());
+}
+
+// Test a batch can save every N commands
+TEST_F(CommandRunnerTest, BatchSavesEveryNCommands) {
+    TaskManager manager(repo);
+    CommandRunner runner(manager, cli);
+    std::stringstream script("add A\nadd B\nadd C\nadd D\nadd E\n");
+    std::stringstream out;
+
+    EXPECT_EQ(runner.runBatch(script, out, 2), 0);
+
+    // After commands 2 and 4, then the remainder at the end
+    EXPECT_EQ(repo.getSaveCount(), 3);
+    EXPECT_EQ(manager.listTasks().size(), 5);
+}
+
+// Test IDs stay unique while saves are deferred
+TEST_F(CommandRunnerTest, BatchAssignsUniqueIds) {
+    TaskManager manager(repo);
+    CommandRunner runner(manager, cli);
+    std::stringstream script("add A\nadd B\nclear\nadd C\nadd D\n");
+    std::stringstream out;
+
+    runner.runBatch(script, out);
+
+    TaskList tasks = manager.listTasks();
+    ASSERT_EQ(tasks.size(), 2);
+    EXPECT_EQ(tasks[0].getId(), 1);
+    EXPECT_EQ(tasks[1].getId(), 2);
+}
+
+// Test errors are reported per line and the batch continues
+TEST_F(CommandRunnerTest, BatchReportsErrorsAndContinues) {
+    TaskManager manager(repo);
+    CommandRunner runner(manager, cli);
+    std::stringstream script("complete 99\nbogus\ncomplete abc\nbatch other.txt\nadd Still runs\n");
+    std::stringstream out;
+
+    EXPECT_EQ(runner.runBatch(script, out), 1);
+
+    std::string output = out.str();
+    EXPECT_NE(output.find("Task not found: 99"), std::string::npos);
+    EXPECT_NE(output.find("Invalid command"), std::string::npos);
+    EXPECT_NE(output.find("line 3"), std::string::npos);
+    EXPECT_NE(output.find("line 4: batch cannot be nested"), std::string::npos);
+    EXPECT_EQ(output.find("Usage:"), std::string::npos);
+    ASSERT_EQ(manager.listTasks().size(), 1);
+    EXPECT_EQ(manager.listTasks()[0].getDescription(), "Still runs");
+}
+
+// Test a repository error ends the batch but auto-saving is turned back on
+TEST_F(CommandRunnerTest, BatchRestoresAutoSaveOnRepositoryError) {
+    UnreadableRepository unreadable;
+    TaskManager manager(unreadable);
+    CommandRunner runner(manager, cli);
+    std::stringstream script("add Task one\nadd Task two\n");
+    std::stringstream out;
+
+    EXPECT_THROW(runner.runBatch(script, out), FileIOException);
+    EXPECT_TRUE(manager.isAutoSaveEnabled());
+}
+
+// Test a repository error part way saves the lines before it, and says so
+TEST_F(CommandRunnerTest, BatchSavesEarlierLinesOnRepositoryError) {
+    // Asked once on loading and once per add
+    FailingRepository failing(4);
+    TaskManager manager(failing);
+    CommandRunner runner(manager, cli);
+    std::stringstream script("add Task one\nadd Task two\nadd Task three\n");
+    std::stringstream out;
+
+    EXPECT_THROW(runner.runBatch(script, out), FileIOException);
+
+    EXPECT_NE(out.str().find("line 3 stopped the batch; the changes of the 2 commands before it are saved"),
+              std::string::npos);
+    EXPECT_FALSE(manager.hasUnsavedChanges());
+    TaskList saved = failing.loadTasks();
+    ASSERT_EQ(saved.size(), 2u);
+    EXPECT_EQ(saved[1].getDescription(), "Task two");
+}
+
+// Test a malformed --save-every is reported instead of running the batch
+TEST_F(CommandRunnerTest, BatchRejectsInvalidSaveEvery) {
+    std::stringstream script("add Task\n");
+    TaskManager manager(repo);
+    CommandRunner runner(manager, cli, script);
+    const char* argv[] = {"task-manager", "batch", "--save-every=often", "-"};
+    Command cmd = cli.parseCommand(4, const_cast<char**>(argv));
+    std::stringstream out;
+
+    EXPECT_EQ(runner.execute(cmd, out), 1);
+
+    EXPECT_NE(out.str().find("Invalid --save-every: often"), std::string::npos);
+    EXPECT_TRUE(manager.listTasks().empty());
+}
+
+// Test blank lines and comments are skipped
+TEST_F(CommandRunnerTest, BatchSkipsBlankLinesAndComments) {
+    TaskManager manager(repo);
+    CommandRunner runner(manager, cli);
+    std::stringstream script("# seed tasks\n\n   \nadd Task\n");
+    std::stringstream out;
+
+    EXPECT_EQ(runner.runBatch(script, out), 0);
+    EXPECT_EQ(manager.listTasks().size(), 1);
+}
+
+// Test a batch file is loaded once and persisted to disk
+TEST_F(CommandRunnerTest, BatchFromFilePersists) {
+    std::string tasksFile = "batch_test_tasks.json";
+    std::string scriptFile = "batch_test_script.txt";
+    {
+        std::ofstream script(scriptFile);
+        script << "add First\nadd Second\ncomplete 2\n";
+    }
+    {
+        FileTaskRepository fileRepo(tasksFile);
+        TaskManager manager(fileRepo);
+        CommandRunner runner(manager, cli);
+        const char* argv[] = {"task-manager", "batch", "batch_test_script.txt"};
+        Command cmd = cli.parseCommand(3, const_cast<char**>(argv));
+        std::stringstream out;
+
+        EXPECT_EQ(runner.execute(cmd, out), 0);
+    }
+
+    FileTaskRepository fileRepo(tasksFile);
+    TaskList tasks = fileRepo.loadTasks();
+    ASSERT_EQ(tasks.size(), 2);
+    EXPECT_TRUE(tasks[1].isCompleted());
+
+    fs::remove(tasksFile);
+    fs::remove(tasksFile + ".lock");
+    fs::remove(scriptFile);
+}
+
+// Test list --format streams machine-readable records
+TEST_F(CommandRunnerTest, ListWithFormat) {
+    TaskManager manager(repo);
+    manager.addTask("Milk, eggs");
+    manager.completeTask(1);
+    CommandRunner runner(manager, cli);
+    const char* argv[] = {"task-manager", "list", "--format=csv"};
+    Command cmd = cli.parseCommand(3, const_cast<char**>(argv));
+    std::stringstream out;
+
+    EXPECT_EQ(runner.execute(cmd, out), 0);
+
+    EXPECT_EQ(out.str(), "id,description,completed\n1,\"Milk, eggs\",true\n");
+}
+
+// Test machine-readable formats print no message for an empty list
+TEST_F(CommandRunnerTest, ListWithFormatEmpty) {
+    TaskManager manager(repo);
+    CommandRunner runner(manager, cli);
+    const char* argv[] = {"task-manager", "list", "--format=ndjson"};
+    Command cmd = cli.parseCommand(3, const_cast<char**>(argv));
+    std::stringstream out;
+
+    EXPECT_EQ(runner.execute(cmd, out), 0);
+
+    EXPECT_TRUE(out.str().empty());
+}
+
+// Test an unknown format is rejected
+TEST_F(CommandRunnerTest, ListWithUnknownFormat) {
+    TaskManager manager(repo);
+    CommandRunner runner(manager, cli);
+    const char* argv[] = {"task-manager", "list", "--format=xml"};
+    Command cmd = cli.parseCommand(3, const_cast<char**>(argv));
+    std::stringstream out;
+
+    EXPECT_EQ(runner.execute(cmd, out), 1);
+
+    EXPECT_NE(out.str().find("Unknown format: xml"), std::string::npos);
+}
+
+// Test import reads standard input and reports what it added
+TEST_F(CommandRunnerTest, ImportFromInput) {
+    TaskManager manager(repo);
+    std::stringstream input("id,description,completed\n1,First,true\n2,Second,false\n");
+    CommandRunner runner(manager, cli, input);
+    const char* argv[] = {"task-manager", "import", "-"};
+    Command cmd = cli.parseCommand(3, const_cast<char**>(argv));
+    std::stringstream out;
+
+    EXPECT_EQ(runner.execute(cmd, out), 0);
+
+    EXPECT_NE(out.str().find("Imported 2 tasks (IDs 1-2)"), std::string::npos);
+    EXPECT_NE(out.str().find("tasks/s"), std::string::npos);
+    ASSERT_EQ(manager.listTasks().size(), 2);
+    EXPECT_TRUE(manager.listTasks()[0].isCompleted());
+}
+
+// Test import rejects formats it cannot read
+TEST_F(CommandRunnerTest, ImportUnknownFormat) {
+    TaskManager manager(repo);
+    CommandRunner runner(manager, cli);
+    const char* argv[] = {"task-manager", "import", "--format=text", "tasks.txt"};
+    Command cmd = cli.parseCommand(4, const_cast<char**>(argv));
+    std::stringstream out;
+
+    EXPECT_EQ(runner.execute(cmd, out), 1);
+
+    EXPECT_NE(out.str().find("Unknown format: text"), std::string::npos);
+}
+
+// Test export writes to standard output and reports file exports
+TEST_F(CommandRunnerTest, ExportCommand) {
+    TaskManager manager(repo);
+    manager.addTask("First");
+    CommandRunner runner(manager, cli);
+
+    const char* toStdout[] = {"task-manager", "export", "--format=ndjson"};
+    Command cmd = cli.parseCommand(3, const_cast<char**>(toStdout));
+    std::stringstream out;
+    EXPECT_EQ(runner.execute(cmd, out), 0);
+    EXPECT_EQ(out.str(), "{\"id\":1,\"description\":\"First\",\"completed\":false}\n");
+
+    const char* toFile[] = {"task-manager", "export", "test_runner_export.json"};
+    cmd = cli.parseCommand(3, const_cast<char**>(toFile));
+    std::stringstream fileOut;
+    EXPECT_EQ(runner.execute(cmd, fileOut), 0);
+    EXPECT_NE(fileOut.str().find("Exported 1 tasks to test_runner_export.json"), std::string::npos);
+    EXPECT_TRUE(fs::exists("test_runner_export.json"));
+    fs::remove("test_runner_export.json");
+
+    const char* binary[] = {"task-manager", "export", "--format=binary", "-"};
+    cmd = cli.parseCommand(4, const_cast<char**>(binary));
+    std::stringstream binaryOut;
+    EXPECT_EQ(runner.execute(cmd, binaryOut), 1);
+    EXPECT_NE(binaryOut.str().find("Binary exports need a destination file"), std::string::npos);
+}
@@ -0,0 +1,67 @@
+#include <gtest/gtest.h>
+#include "deferred_changes.h"
+#include "repository_exceptions.h"
+#include <string>
+#include <vector>
+
+// Test changes are made again in order, and a clear drops what came before it
+TEST(DeferredChangesTest, ReplaysInOrderFromLastClear) {
+    DeferredChanges changes;
+    changes.record(DeferredChanges::Kind::ADD, 1, "Dropped");
+    changes.record(DeferredChanges::Kind::CLEAR, 0);
+    changes.record(DeferredChanges::Kind::ADD, 1, "Kept", true);
+    changes.record(DeferredChanges::Kind::COMPLETE, 7);
+
+    std::vector<std::string> made;
+    changes.replay(
+        [&](const std::string& description, bool completed) {
+            made.push_back("add " + description + (completed ? " done" : ""));
+        },
+        [&](int id) {
+            made.push_back("complete " + std::to_string(id));
+        },
+        [&] {
+            made.push_back("clear");
+        });
+    EXPECT_EQ(made, (std::vector<std::string>{"clear", "add Kept done", "complete 7"}));
+
+    changes.clear();
+    made.clear();
+    changes.replay([&](const std::string&, bool) { made.push_back("add"); },
+                   [&](int) { made.push_back("complete"); },
+                   [&] { made.push_back("clear"); });
+    EXPECT_TRUE(made.empty());
+}
+
+// Test conflicting attempts are rebased and tried again up to the limit, and
+// nested attempts are left to the outer one
+TEST(DeferredChangesTest, RetriesConflicts) {
+    DeferredChanges changes;
+    int attempts = 0;
+    int rebases = 0;
+    int result = changes.retry(
+        [&] {
+            if (++attempts < 3) {
+                throw ConflictException("saved first");
+            }
+            return attempts;
+        },
+        [&] { rebases++; });
+    EXPECT_EQ(result, 3);
+    EXPECT_EQ(rebases, 2);
+    EXPECT_EQ(changes.getConflictCount(), 2u);
+
+    attempts = 0;
+    int nested = 0;
+    EXPECT_THROW(changes.retry(
+                     [&] {
+                         attempts++;
+                         changes.retry([&] { nested++; }, [] {});
+                         throw ConflictException("saved first");
+                     },
+                     [] {}),
+                 ConflictException);
+    EXPECT_EQ(attempts, static_cast<int>(DeferredChanges::kMaxAttempts));
+    EXPECT_EQ(nested, attempts);
+    EXPECT_EQ(changes.getConflictCount(), 2u + DeferredChanges::kMaxAttempts);
+}
@@ -24,6 +24,7 @@ protected:
         if (fs::exists(testFilePath)) {
             fs::remove(testFilePath);
         }
+        fs::remove(testFilePath + ".lock");
     }
 };
 
@@ -55,6 +56,20 @@ TEST_F(ErrorHandlingTest, CorruptedJsonNotArray) {
     }, JsonParseException);
 }
 
+// Test dictionary-encoded file referencing a missing description
+TEST_F(ErrorHandlingTest, DictionaryReferenceOutOfRange) {
+    std::ofstream file(testFilePath);
+    file << R"({"descriptions": ["Only entry"],
+               "tasks": [{"id": 1, "descriptionRef": 3, "completed": false}]})";
+    file.close();
+    
+    FileTaskRepository repo(testFilePath);
+    
+    EXPECT_THROW({
+        repo.loadTasks();
+    }, JsonParseException);
+}
+
 // Test corrupted JSON file - incomplete JSON
 TEST_F(ErrorHandlingTest, CorruptedJsonIncomplete) {
     // Create a file with incomplete JSON
@@ -100,6 +115,7 @@ TEST_F(ErrorHandlingTest, InvalidFilePathDirectory) {
     
     // Clean up
     fs::remove(dirPath);
+    fs::remove(dirPath + ".lock");
 }
 
 // Test read-only file system simulation (cannot test actual permissions on all platforms)
@@ -120,7 +136,7 @@ TEST_F(ErrorHandlingTest, SaveToInvalidPath) {
     std::string invalidPath = "/nonexistent/path/that/does/not/exist/tasks.json";
     
     FileTaskRepository repo(invalidPath);
-    std::vector<Task> tasks = {Task(1, "Test task", false)};
+    TaskList tasks = {Task(1, "Test task", false)};
     
     // Should throw when trying to save to non-existent directory
     EXPECT_THROW({
@@ -163,7 +179,7 @@ TEST_F(ErrorHandlingTest, RecoveryAfterFixingCorruptedFile) {
     goodFile.close();
     
     // Should now work
-    std::vector<Task> tasks;
+    TaskList tasks;
     EXPECT_NO_THROW({
         tasks = repo.loadTasks();
     });
@@ -208,3 +224,16 @@ TEST_F(ErrorHandlingTest, FileIOExceptionForInvalidPath) {
                     message.find("file") != std::string::npos);
     }
 }
+
+// Test appending to a corrupted file reports it instead of writing into it
+TEST_F(ErrorHandlingTest, AppendToCorruptedFile) {
+    std::ofstream file(testFilePath);
+    file << R"([{"id": 1, "description": "test")";
+    file.close();
+
+    FileTaskRepository repo(testFilePath);
+
+    EXPECT_THROW({
+        repo.appendTask("New task");
+    }, JsonParseException);
+}
@@ -0,0 +1,263 @@
+#include <gtest/gtest.h>
+#include "file_lock.h"
+#include "file_task_repository.h"
+#include "paged_task_repository.h"
+#include "repository_exceptions.h"
+#include "task_manager.h"
+#include <atomic>
+#include <filesystem>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+class FileLockTest : public ::testing::Test {
+protected:
+    std::string lockPath = "test_lock.lock";
+    std::string tasksPath = "test_lock_tasks.json";
+    std::string pagedPath = "test_lock_tasks.db";
+
+    void SetUp() override {
+        TearDown();
+    }
+
+    void TearDown() override {
+        for (const auto& path : {lockPath, tasksPath, tasksPath + ".lock", pagedPath, pagedPath + ".lock"}) {
+            fs::remove(path);
+        }
+    }
+};
+
+// Test readers share the lock and a writer gives up after the timeout
+TEST_F(FileLockTest, SharedLocksExcludeWriters) {
+    FileLock first(lockPath);
+    FileLock second(lockPath);
+    FileLock writer(lockPath, std::chrono::milliseconds(30));
+
+    EXPECT_TRUE(first.lock(LockMode::SHARED));
+    EXPECT_TRUE(second.lock(LockMode::SHARED));
+    EXPECT_THROW(writer.lock(LockMode::EXCLUSIVE), LockTimeoutException);
+    EXPECT_EQ(writer.getStats().timeouts, 1);
+    EXPECT_EQ(writer.getStats().acquisitions, 0);
+    EXPECT_GE(writer.getStats().waitSeconds, 0.03);
+
+    first.unlock();
+    second.unlock();
+    EXPECT_TRUE(writer.lock(LockMode::EXCLUSIVE));
+    EXPECT_EQ(writer.getStats().acquisitions, 1);
+    writer.unlock();
+}
+
+// Test a waiter gets the lock once the holder releases it, and the wait is reported
+TEST_F(FileLockTest, WaitsForHolder) {
+    FileLock holder(lockPath);
+    FileLock waiter(lockPath);
+    holder.lock(LockMode::EXCLUSIVE);
+
+    std::thread release([&holder] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        holder.unlock();
+    });
+    EXPECT_TRUE(waiter.lock(LockMode::SHARED));
+    release.join();
+
+    const LockStats& stats = waiter.getStats();
+    EXPECT_EQ(stats.acquisitions, 1);
+    EXPECT_EQ(stats.contended, 1);
+    EXPECT_GE(stats.maxWaitSeconds, 0.04);
+    EXPECT_EQ(stats.waitSeconds, stats.maxWaitSeconds);
+    waiter.unlock();
+}
+
+// Test nested calls count down to the outermost one, and cannot upgrade a shared lock
+TEST_F(FileLockTest, NestedCalls) {
+    FileLock lock(lockPath);
+    FileLock other(lockPath, std::chrono::milliseconds(10));
+
+    EXPECT_TRUE(lock.lock(LockMode::EXCLUSIVE));
+    EXPECT_FALSE(lock.lock(LockMode::SHARED));
+    EXPECT_EQ(lock.getDepth(), 2);
+    lock.unlock();
+    EXPECT_THROW(other.lock(LockMode::SHARED), LockTimeoutException);
+    lock.unlock();
+    EXPECT_EQ(lock.getDepth(), 0);
+    EXPECT_EQ(lock.getStats().acquisitions, 1);
+
+    lock.lock(LockMode::SHARED);
+    EXPECT_THROW(lock.lock(LockMode::EXCLUSIVE), std::logic_error);
+    EXPECT_EQ(lock.getDepth(), 1);
+    lock.unlock();
+}
+
+// Test concurrent read-modify-writes, each with its own repository as separate
+// processes would have, lose no update
+TEST_F(FileLockTest, ConcurrentWritersLoseNoUpdates) {
+    constexpr int kWriters = 4;
+    constexpr int kTasksPerWriter = 25;
+
+    // Long-lived repositories find the ID counter again after other writers
+    std::vector<std::thread> writers;
+    for (int w = 0; w < kWriters; w++) {
+        writers.emplace_back([this] {
+            FileTaskRepository repo(tasksPath);
+            TaskManager manager(repo);
+            for (int i = 0; i < kTasksPerWriter; i++) {
+                manager.addTask("Task");
+            }
+        });
+    }
+    for (auto& writer : writers) {
+        writer.join();
+    }
+
+    // Each completion loads the whole file, changes one task and saves it
+    writers.clear();
+    for (int w = 0; w < kWriters; w++) {
+        writers.emplace_back([this, w] {
+            for (int id = w + 1; id <= kWriters * kTasksPerWriter; id += kWriters) {
+                FileTaskRepository repo(tasksPath);
+                TaskManager manager(repo);
+                manager.completeTask(id);
+            }
+        });
+    }
+    for (auto& writer : writers) {
+        writer.join();
+    }
+
+    FileTaskRepository repo(tasksPath);
+    TaskList tasks = repo.loadTasks();
+    ASSERT_EQ(tasks.size(), kWriters * kTasksPerWriter);
+    std::set<int> ids;
+    for (const auto& task : tasks) {
+        ids.insert(task.getId());
+        EXPECT_TRUE(task.isCompleted()) << "Task " << task.getId();
+    }
+    EXPECT_EQ(ids.size(), tasks.size());
+}
+
+// Test a paged repository sees tasks another one appended while it was unlocked
+TEST_F(FileLockTest, PagedRepositoryRereadsChangedFile) {
+    PagedTaskRepository first(pagedPath);
+    PagedTaskRepository second(pagedPath);
+
+    EXPECT_EQ(first.appendTask("From first"), 1);
+    EXPECT_EQ(second.appendTask("From second"), 2);
+    EXPECT_EQ(first.appendTask("From first again"), 3);
+
+    PagedTaskRepository reader(pagedPath);
+    EXPECT_EQ(reader.getTaskCount(), 3);
+    EXPECT_TRUE(second.setTaskCompleted(3, true));
+    TaskList tasks = first.loadTasks();
+    ASSERT_EQ(tasks.size(), 3);
+    EXPECT_TRUE(tasks[2].isCompleted());
+}
+
+// Test a change that keeps the file's size is seen by a repository whose
+// cached page still holds the old record, however close in time it came
+TEST_F(FileLockTest, PagedRepositorySeesSameSizeChange) {
+    PagedTaskRepository first(pagedPath);
+    PagedTaskRepository second(pagedPath);
+    first.appendTask("Shared");
+    EXPECT_EQ(second.loadTasks().size(), 1);
+
+    for (bool completed : {true, false, true}) {
+        EXPECT_TRUE(first.setTaskCompleted(1, completed));
+        TaskList tasks = second.loadTasks();
+        ASSERT_EQ(tasks.size(), 1);
+        EXPECT_EQ(tasks[0].isCompleted(), completed);
+    }
+}
+
+// Test a manager holding the lock keeps other writers out until it lets go
+TEST_F(FileLockTest, ManagerHoldsLockAcrossCalls) {
+    FileTaskRepository repo(tasksPath);
+    TaskManager manager(repo);
+    FileTaskRepository otherRepo(tasksPath);
+    otherRepo.setLockTimeout(std::chrono::milliseconds(20));
+
+    manager.lock(LockMode::EXCLUSIVE);
+    manager.addTask("Held");
+    EXPECT_THROW(otherRepo.appendTask("Blocked"), LockTimeoutException);
+    EXPECT_EQ(otherRepo.getLockStats().timeouts, 1);
+    manager.unlock();
+
+    EXPECT_EQ(otherRepo.appendTask("After"), 2);
+    EXPECT_EQ(repo.getLockStats().contended, 0);
+}
+
+// Test two managers that keep the tasks loaded, as a shell or server does,
+// each see the other's saves before changing the tasks, so neither loses one
+TEST_F(FileLockTest, ResidentManagersLoseNoUpdates) {
+    {
+        FileTaskRepository seed(tasksPath);
+        TaskList tasks;
+        for (int id = 1; id <= 4; id++) {
+            tasks.emplace_back(id, "Task " + std::to_string(id), false);
+        }
+        seed.saveTasks(tasks);
+    }
+    FileTaskRepository firstRepo(tasksPath);
+    FileTaskRepository secondRepo(tasksPath);
+    TaskManager first(firstRepo);
+    TaskManager second(secondRepo);
+    first.load();
+    second.load();
+
+    EXPECT_TRUE(first.completeTask(1));
+    EXPECT_TRUE(second.completeTask(2));
+    EXPECT_EQ(first.addTask("From first"), 5);
+    EXPECT_EQ(second.addTask("From second"), 6);
+    EXPECT_TRUE(first.completeTask(6));
+    EXPECT_EQ(first.listTasks().size(), 6);
+
+    FileTaskRepository check(tasksPath);
+    TaskList tasks = check.loadTasks();
+    ASSERT_EQ(tasks.size(), 6);
+    EXPECT_TRUE(tasks[0].isCompleted());
+    EXPECT_TRUE(tasks[1].isCompleted());
+    EXPECT_FALSE(tasks[2].isCompleted());
+    EXPECT_EQ(tasks[4].getDescription(), "From first");
+    EXPECT_EQ(tasks[5].getDescription(), "From second");
+    EXPECT_TRUE(tasks[5].isCompleted());
+}
+
+// Test a manager holding changes unsaved, as a shell with a save interval
+// does, makes them again on the tasks another process saved meanwhile rather
+// than saving over them; its added tasks take the next free IDs
+TEST_F(FileLockTest, DeferredSavesKeepOtherWritersChanges) {
+    {
+        FileTaskRepository seed(tasksPath);
+        TaskList tasks;
+        for (int id = 1; id <= 4; id++) {
+            tasks.emplace_back(id, "Task " + std::to_string(id), false);
+        }
+        seed.saveTasks(tasks);
+    }
+    FileTaskRepository firstRepo(tasksPath);
+    FileTaskRepository secondRepo(tasksPath);
+    TaskManager first(firstRepo);
+    TaskManager second(secondRepo);
+    first.setAutoSave(false);
+    first.load();
+
+    EXPECT_EQ(first.addTask("Deferred"), 5);
+    EXPECT_TRUE(first.completeTask(1));
+    EXPECT_EQ(second.addTask("Saved meanwhile"), 5);
+    EXPECT_TRUE(second.completeTask(2));
+    first.save();
+    EXPECT_FALSE(first.hasUnsavedChanges());
+
+    FileTaskRepository check(tasksPath);
+    TaskList tasks = check.loadTasks();
+    ASSERT_EQ(tasks.size(), 6);
+    EXPECT_TRUE(tasks[0].isCompleted());
+    EXPECT_TRUE(tasks[1].isCompleted());
+    EXPECT_EQ(tasks[4].getDescription(), "Saved meanwhile");
+    EXPECT_EQ(tasks[5].getId(), 6);
+    EXPECT_EQ(tasks[5].getDescription(), "Deferred");
+    EXPECT_EQ(first.listTasks().size(), 6);
+}
@@ -0,0 +1,213 @@
+#include <gtest/gtest.h>
+#include "group_commit.h"
+#include "file_task_repository.h"
+#include "paged_task_repository.h"
+#include "repository_exceptions.h"
+#include "task_manager.h"
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+class GroupCommitTest : public ::testing::Test {
+protected:
+    std::string tasksPath = "test_commit_tasks.json";
+    std::string pagedPath = "test_commit_tasks.db";
+
+    void SetUp() override {
+        TearDown();
+    }
+
+    void TearDown() override {
+        for (const auto& path : {tasksPath, tasksPath + ".lock", tasksPath + ".tmp",
+                                 pagedPath, pagedPath + ".lock", pagedPath + ".tmp"}) {
+            fs::remove(path);
+        }
+    }
+};
+
+// Test a sync covers every write before it, and is skipped with none pending
+TEST_F(GroupCommitTest, SyncCoversEarlierWrites) {
+    int syncs = 0;
+    GroupCommit commit([&] { syncs++; });
+
+    commit.sync();
+    EXPECT_EQ(syncs, 0);
+
+    commit.recordWrite();
+    commit.recordWrite();
+    commit.recordWrite();
+    commit.sync();
+    commit.sync();
+    EXPECT_EQ(syncs, 1);
+
+    GroupCommit::Stats stats = commit.getStats();
+    EXPECT_EQ(stats.writes, 3u);
+    EXPECT_EQ(stats.syncs, 1u);
+}
+
+// Test callers syncing together share syncs, and none returns before its write is covered
+TEST_F(GroupCommitTest, ConcurrentCallersShareSyncs) {
+    constexpr int kThreads = 8;
+    constexpr int kWritesPerThread = 20;
+    std::atomic<int> recorded{0};
+    std::atomic<int> durable{0};
+    GroupCommit commit([&] {
+        int covered = recorded.load();
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        durable.store(covered);
+    });
+
+    std::atomic<int> uncovered{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; t++) {
+        threads.emplace_back([&] {
+            for (int i = 0; i < kWritesPerThread; i++) {
+                int write = ++recorded;
+                commit.recordWrite();
+                commit.sync();
+                if (durable.load() < write) {
+                    uncovered++;
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    EXPECT_EQ(uncovered.load(), 0);
+    GroupCommit::Stats stats = commit.getStats();
+    EXPECT_EQ(stats.writes, static_cast<std::uint64_t>(kThreads * kWritesPerThread));
+    EXPECT_LT(stats.syncs, stats.writes);
+}
+
+// Test the leader's wait ends as soon as a batch is pending, not at the window
+TEST_F(GroupCommitTest, WindowEndsAtBatchSize) {
+    constexpr int kThreads = 4;
+    GroupCommit::Settings settings;
+    settings.window = std::chrono::seconds(10);
+    settings.batchSize = kThreads;
+    GroupCommit commit([] {}, settings);
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; t++) {
+        threads.emplace_back([&] {
+            commit.recordWrite();
+            commit.sync();
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(5));
+    EXPECT_EQ(commit.getStats().syncs, 1u);
+}
+
+// Test a failed sync is reported, and the next call tries again
+TEST_F(GroupCommitTest, FailedSyncIsRetried) {
+    bool fail = true;
+    int syncs = 0;
+    GroupCommit commit([&] {
+        if (fail) {
+            throw FileIOException("disk gone");
+        }
+        syncs++;
+    });
+
+    commit.recordWrite();
+    EXPECT_THROW(commit.sync(), FileIOException);
+    fail = false;
+    commit.sync();
+    EXPECT_EQ(syncs, 1);
+}
+
+// Test durable repositories sync each change, and changes under lock() once at sync()
+TEST_F(GroupCommitTest, DurableRepositoriesSyncChanges) {
+    auto check = [](auto& repo) {
+        repo.setDurable(true);
+        TaskManager manager(repo);
+        manager.addTask("First");
+        manager.addTask("Second");
+        EXPECT_TRUE(manager.completeTask(1));
+        GroupCommit::Stats stats = repo.getSyncStats();
+        EXPECT_EQ(stats.writes, 3u);
+        EXPECT_EQ(stats.syncs, 3u);
+
+        manager.lock(LockMode::EXCLUSIVE);
+        manager.addTask("Third");
+        manager.addTask("Fourth");
+        manager.unlock();
+        EXPECT_EQ(repo.getSyncStats().syncs, 3u);
+        manager.sync();
+        EXPECT_EQ(repo.getSyncStats().syncs, 4u);
+    };
+    FileTaskRepository fileRepo(tasksPath);
+    PagedTaskRepository pagedRepo(pagedPath);
+    check(fileRepo);
+    check(pagedRepo);
+
+    // Repositories are not durable unless asked
+    FileTaskRepository plain(tasksPath);
+    TaskManager manager(plain);
+    manager.addTask("Fifth");
+    manager.sync();
+    EXPECT_EQ(plain.getSyncStats().syncs, 0u);
+}
+
+// Test a durable save replaces the file and is synced before it returns,
+// even while the lock is held
+TEST_F(GroupCommitTest, DurableSavesReplaceTheFile) {
+    auto check = [](auto& repo) {
+        repo.setDurable(true);
+        TaskList tasks;
+        tasks.emplace_back(1, "First", false);
+        tasks.emplace_back(2, "Second", true);
+
+        repo.lock(LockMode::EXCLUSIVE);
+        repo.saveTasks(tasks);
+        EXPECT_EQ(repo.getSyncStats().syncs, 1u);
+        repo.unlock();
+
+        EXPECT_EQ(repo.loadTasks().size(), 2u);
+    };
+    FileTaskRepository fileRepo(tasksPath);
+    PagedTaskRepository pagedRepo(pagedPath);
+    check(fileRepo);
+    check(pagedRepo);
+    EXPECT_FALSE(fs::exists(tasksPath + ".tmp"));
+    EXPECT_FALSE(fs::exists(pagedPath + ".tmp"));
+}
+
+// Test a save that cannot write its new file leaves the old one in place
+TEST_F(GroupCommitTest, FailedSaveKeepsTheOldFile) {
+    FileTaskRepository fileRepo(tasksPath);
+    PagedTaskRepository pagedRepo(pagedPath);
+    for (ITaskRepository* repo : {static_cast<ITaskRepository*>(&fileRepo),
+                                  static_cast<ITaskRepository*>(&pagedRepo)}) {
+        TaskManager manager(*repo);
+        manager.addTask("Kept");
+    }
+    // A directory in the way of the temporary file
+    fs::create_directory(tasksPath + ".tmp");
+    fs::create_directory(pagedPath + ".tmp");
+
+    for (ITaskRepository* repo : {static_cast<ITaskRepository*>(&fileRepo),
+                                  static_cast<ITaskRepository*>(&pagedRepo)}) {
+        TaskList tasks;
+        tasks.emplace_back(1, "Replaced", false);
+        EXPECT_THROW(repo->saveTasks(tasks), FileIOException);
+
+        TaskList kept = repo->loadTasks();
+        ASSERT_EQ(kept.size(), 1u);
+        EXPECT_EQ(kept[0].getDescription(), "Kept");
+    }
+    fs::remove(tasksPath + ".tmp");
+    fs::remove(pagedPath + ".tmp");
+}
@@ -29,10 +29,11 @@ protected:
         if (fs::exists(testFilePath)) {
             fs::remove(testFilePath);
         }
+        fs::remove(testFilePath + ".lock");
     }
     
     // Helper to verify tasks.json file content
-    std::vector<Task> readTasksFromFile() {
+    TaskList readTasksFromFile() {
         if (!fs::exists(testFilePath)) {
             return {};
         }
@@ -49,7 +50,7 @@ protected:
             throw std::runtime_error(std::string("Failed to parse JSON: ") + e.what());
         }
         
-        std::vector<Task> tasks;
+        TaskList tasks;
         for (const auto& taskJson : j) {
             tasks.push_back(Task::fromJson(taskJson));
         }
@@ -75,7 +76,7 @@ TEST_F(IntegrationTest, AddMultipleTasksAndList) {
         EXPECT_EQ(id3, 3);
         
         // List tasks and verify output
-        std::vector<Task> tasks = manager.listTasks();
+        TaskList tasks = manager.listTasks();
         ASSERT_EQ(tasks.size(), 3);
         
         EXPECT_EQ(tasks[0].getId(), 1);
@@ -101,7 +102,7 @@ TEST_F(IntegrationTest, AddMultipleTasksAndList) {
     }
     
     // Verify persistence: tasks.json should contain all tasks
-    std::vector<Task> persistedTasks = readTasksFromFile();
+    TaskList persistedTasks = readTasksFromFile();
     ASSERT_EQ(persistedTasks.size(), 3);
     EXPECT_EQ(persistedTasks[0].getDescription(), "Buy groceries");
     EXPECT_EQ(persistedTasks[1].getDescription(), "Write documentation");
@@ -133,7 +134,7 @@ TEST_F(IntegrationTest, CompleteTasksAndVerifyPersistence) {
         EXPECT_TRUE(success3);
         
         // Verify in-memory state
-        std::vector<Task> tasks = manager.listTasks();
+        TaskList tasks = manager.listTasks();
         ASSERT_EQ(tasks.size(), 3);
         EXPECT_TRUE(tasks[0].isCompleted());
         EXPECT_FALSE(tasks[1].isCompleted());
@@ -145,7 +146,7 @@ TEST_F(IntegrationTest, CompleteTasksAndVerifyPersistence) {
         FileTaskRepository repo(testFilePath);
         TaskManager manager(repo);
         
-        std::vector<Task> tasks = manager.listTasks();
+        TaskList tasks = manager.listTasks();
         ASSERT_EQ(tasks.size(), 3);
         EXPECT_TRUE(tasks[0].isCompleted());
         EXPECT_FALSE(tasks[1].isCompleted());
@@ -163,7 +164,7 @@ TEST_F(IntegrationTest, CompleteTasksAndVerifyPersistence) {
     }
     
     // Verify file content
-    std::vector<Task> persistedTasks = readTasksFromFile();
+    TaskList persistedTasks = readTasksFromFile();
     ASSERT_EQ(persistedTasks.size(), 3);
     EXPECT_TRUE(persistedTasks[0].isCompleted());
     EXPECT_FALSE(persistedTasks[1].isCompleted());
@@ -188,12 +189,12 @@ TEST_F(IntegrationTest, ClearTasksAndVerifyIdReset) {
         FileTaskRepository repo(testFilePath);
         TaskManager manager(repo);
         
-        std::vector<Task> beforeClear = manager.listTasks();
+        TaskList beforeClear = manager.listTasks();
         ASSERT_EQ(beforeClear.size(), 3);
         
         manager.clearAllTasks();
         
-        std::vector<Task> afterClear = manager.listTasks();
+        TaskList afterClear = manager.listTasks();
         EXPECT_TRUE(afterClear.empty());
     }
     
@@ -212,7 +213,7 @@ TEST_F(IntegrationTest, ClearTasksAndVerifyIdReset) {
     }
     
     // Verify file content
-    std::vector<Task> persistedTasks = readTasksFromFile();
+    TaskList persistedTasks = readTasksFromFile();
     ASSERT_EQ(persistedTasks.size(), 2);
     EXPECT_EQ(persistedTasks[0].getId(), 1);
     EXPECT_EQ(persistedTasks[1].getId(), 2);
@@ -236,7 +237,7 @@ TEST_F(IntegrationTest, CrossSessionPersistence) {
         FileTaskRepository repo(testFilePath);
         TaskManager manager(repo);
         
-        std::vector<Task> tasks = manager.listTasks();
+        TaskList tasks = manager.listTasks();
         ASSERT_EQ(tasks.size(), 3);
         
         // Verify all data persisted correctly
@@ -261,7 +262,7 @@ TEST_F(IntegrationTest, CrossSessionPersistence) {
         FileTaskRepository repo(testFilePath);
         TaskManager manager(repo);
         
-        std::vector<Task> tasks = manager.listTasks();
+        TaskList tasks = manager.listTasks();
         ASSERT_EQ(tasks.size(), 3);
         
         // Verify changes from session 2 persisted
@@ -274,7 +275,7 @@ TEST_F(IntegrationTest, CrossSessionPersistence) {
     }
     
     // Final verification
-    std::vector<Task> persistedTasks = readTasksFromFile();
+    TaskList persistedTasks = readTasksFromFile();
     ASSERT_EQ(persistedTasks.size(), 4);
     EXPECT_EQ(persistedTasks[3].getId(), 4);
     EXPECT_EQ(persistedTasks[3].getDescription(), "Task after restart");
@@ -292,7 +293,7 @@ TEST_F(IntegrationTest, CompleteWorkflow) {
     manager.addTask("Test feature");
     
     // Step 2: List tasks
-    std::vector<Task> tasks1 = manager.listTasks();
+    TaskList tasks1 = manager.listTasks();
     ASSERT_EQ(tasks1.size(), 3);
     EXPECT_FALSE(tasks1[0].isCompleted());
     EXPECT_FALSE(tasks1[1].isCompleted());
@@ -303,7 +304,7 @@ TEST_F(IntegrationTest, CompleteWorkflow) {
     manager.completeTask(2); // Implement complete
     
     // Step 4: List tasks again
-    std::vector<Task> tasks2 = manager.listTasks();
+    TaskList tasks2 = manager.listTasks();
     ASSERT_EQ(tasks2.size(), 3);
     EXPECT_TRUE(tasks2[0].isCompleted());
     EXPECT_TRUE(tasks2[1].isCompleted());
@@ -313,7 +314,7 @@ TEST_F(IntegrationTest, CompleteWorkflow) {
     manager.clearAllTasks();
     
     // Step 6: List tasks - should be empty
-    std::vector<Task> tasks3 = manager.listTasks();
+    TaskList tasks3 = manager.listTasks();
     EXPECT_TRUE(tasks3.empty());
     
     // Verify display of empty list
@@ -336,7 +337,7 @@ TEST_F(IntegrationTest, ErrorHandlingCompleteNonExistent) {
     EXPECT_FALSE(result);
     
     // Verify existing tasks unchanged
-    std::vector<Task> tasks = manager.listTasks();
+    TaskList tasks = manager.listTasks();
     ASSERT_EQ(tasks.size(), 2);
     EXPECT_FALSE(tasks[0].isCompleted());
     EXPECT_FALSE(tasks[1].isCompleted());
@@ -351,7 +352,7 @@ TEST_F(IntegrationTest, ErrorHandlingEmptyDescription) {
     int id = manager.addTask("");
     EXPECT_GT(id, 0);
     
-    std::vector<Task> tasks = manager.listTasks();
+    TaskList tasks = manager.listTasks();
     ASSERT_EQ(tasks.size(), 1);
     EXPECT_EQ(tasks[0].getDescription(), "");
 }
@@ -390,7 +391,7 @@ TEST_F(IntegrationTest, MultiSessionIdContinuity) {
         FileTaskRepository repo(testFilePath);
         TaskManager manager(repo);
         
-        std::vector<Task> tasks = manager.listTasks();
+        TaskList tasks = manager.listTasks();
         ASSERT_EQ(tasks.size(), 5);
         
         // Verify IDs are sequential
@@ -498,7 +499,7 @@ TEST_F(IntegrationTest, FileCorruptionHandling) {
     // This test documents current behavior and ensures it doesn't crash
     try {
         FileTaskRepository repo(testFilePath);
-        std::vector<Task> tasks = repo.loadTasks();
+        TaskList tasks = repo.loadTasks();
         // If we get here, corruption was handled gracefully
         SUCCEED();
     } catch (const std::exception& e) {
@@ -522,7 +523,7 @@ TEST_F(IntegrationTest, LargeNumberOfTasks) {
     }
     
     // Verify all tasks exist
-    std::vector<Task> tasks = manager.listTasks();
+    TaskList tasks = manager.listTasks();
     ASSERT_EQ(tasks.size(), 100);
     
     // Complete every other task
@@ -541,6 +542,6 @@ TEST_F(IntegrationTest, LargeNumberOfTasks) {
     }
     
     // Verify persistence
-    std::vector<Task> persistedTasks = readTasksFromFile();
+    TaskList persistedTasks = readTasksFromFile();
     ASSERT_EQ(persistedTasks.size(), 100);
 }
@@ -0,0 +1,157 @@
+#include <gtest/gtest.h>
+#include "mutation_queue.h"
+#include "task_manager.h"
+#include "mock_task_repository.h"
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Test results arrive through the futures once the change is saved
+TEST(MutationQueueTest, FuturesCarryResults) {
+    MockTaskRepository repo;
+    TaskManager manager(repo);
+    MutationQueue queue(manager);
+
+    std::future<int> first = queue.addTask("First");
+    std::future<int> second = queue.addTask("Second");
+    EXPECT_EQ(first.get(), 1);
+    EXPECT_EQ(second.get(), 2);
+    EXPECT_TRUE(queue.completeTask(2).get());
+    EXPECT_FALSE(queue.completeTask(99).get());
+
+    TaskList saved = repo.loadTasks();
+    ASSERT_EQ(saved.size(), 2);
+    EXPECT_TRUE(saved[1].isCompleted());
+}
+
+// Test changes from many threads all apply, with fewer saves than changes
+TEST(MutationQueueTest, ConcurrentProducers) {
+    constexpr int kProducers = 8;
+    constexpr int kTasksPerProducer = 250;
+    MockTaskRepository repo;
+    TaskManager manager(repo);
+    MutationQueue queue(manager, 64);
+
+    std::vector<std::vector<int>> ids(kProducers);
+    std::vector<std::thread> producers;
+    for (int p = 0; p < kProducers; p++) {
+        producers.emplace_back([&, p] {
+            std::vector<std::future<int>> pending;
+            for (int i = 0; i < kTasksPerProducer; i++) {
+                pending.push_back(queue.addTask("Task " + std::to_string(i)));
+            }
+            for (auto& id : pending) {
+                ids[p].push_back(id.get());
+            }
+        });
+    }
+    for (auto& producer : producers) {
+        producer.join();
+    }
+
+    std::set<int> unique;
+    for (const auto& producerIds : ids) {
+        // A producer's changes apply in the order it submitted them
+        for (std::size_t i = 1; i < producerIds.size(); i++) {
+            EXPECT_LT(producerIds[i - 1], producerIds[i]);
+        }
+        unique.insert(producerIds.begin(), producerIds.end());
+    }
+    EXPECT_EQ(unique.size(), static_cast<std::size_t>(kProducers * kTasksPerProducer));
+
+    MutationQueue::Stats stats = queue.getStats();
+    EXPECT_EQ(stats.mutations, static_cast<std::size_t>(kProducers * kTasksPerProducer));
+    EXPECT_LT(stats.batches, stats.mutations);
+    EXPECT_EQ(repo.getSaveCount(), static_cast<int>(stats.batches));
+    EXPECT_EQ(repo.loadTasks().size(), static_cast<std::size_t>(kProducers * kTasksPerProducer));
+}
+
+// Test stopping applies what is queued and refuses new changes
+TEST(MutationQueueTest, StopDrainsQueue) {
+    MockTaskRepository repo;
+    TaskManager manager(repo);
+    std::future<int> last;
+    {
+        MutationQueue queue(manager, 1);
+        for (int i = 0; i < 100; i++) {
+            last = queue.addTask("Task");
+        }
+        queue.stop();
+        EXPECT_THROW(queue.completeTask(1), std::logic_error);
+    }
+
+    EXPECT_EQ(last.get(), 100);
+    EXPECT_TRUE(manager.isAutoSaveEnabled());
+    EXPECT_FALSE(manager.hasUnsavedChanges());
+    EXPECT_EQ(repo.loadTasks().size(), 100);
+}
+
+// Test only the writer's batches defer their saves: changes made on the
+// manager directly meanwhile are saved at once, and the setting is the
+// caller's to change
+TEST(MutationQueueTest, DirectChangesStillSaved) {
+    MockTaskRepository repo;
+    TaskManager manager(repo);
+    MutationQueue queue(manager);
+    EXPECT_EQ(queue.addTask("Queued").get(), 1);
+    EXPECT_TRUE(manager.isAutoSaveEnabled());
+
+    EXPECT_EQ(manager.addTask("Direct"), 2);
+    EXPECT_FALSE(manager.hasUnsavedChanges());
+    EXPECT_EQ(repo.loadTasks().size(), 2u);
+
+    manager.setAutoSave(false);
+    EXPECT_EQ(queue.addTask("Queued again").get(), 3);
+    queue.stop();
+    EXPECT_FALSE(manager.isAutoSaveEnabled());
+    EXPECT_EQ(repo.loadTasks().size(), 3u);
+}
+
+// Test stopping while producers submit: every change is either refused or
+// applied and saved, and no future is left unresolved
+TEST(MutationQueueTest, StopRacingProducers) {
+    constexpr int kProducers = 4;
+    for (int round = 0; round < 50; round++) {
+        MockTaskRepository repo;
+        TaskManager manager(repo);
+        std::vector<std::vector<std::future<int>>> pending(kProducers);
+        std::atomic<bool> started{false};
+        {
+            MutationQueue queue(manager, 64);
+            std::vector<std::thread> producers;
+            for (int p = 0; p < kProducers; p++) {
+                producers.emplace_back([&, p] {
+                    try {
+                        for (int i = 0; i < 250; i++) {
+                            pending[p].push_back(queue.addTask("Task"));
+                            started = true;
+                        }
+                    } catch (const std::logic_error&) {
+                    }
+                });
+            }
+            while (!started) {
+                std::this_thread::yield();
+            }
+            queue.stop();
+            for (auto& producer : producers) {
+                producer.join();
+            }
+        }
+
+        std::set<int> ids;
+        for (auto& futures : pending) {
+            for (auto& future : futures) {
+                ASSERT_EQ(future.wait_for(std::chrono::seconds(0)), std::future_status::ready);
+                ids.insert(future.get());
+            }
+        }
+        EXPECT_EQ(manager.listTasks().size(), ids.size());
+        EXPECT_EQ(repo.loadTasks().size(), ids.size());
+    }
+}
@@ -0,0 +1,261 @@
+#include <gtest/gtest.h>
+#include "file_lock.h"
+#include "file_task_repository.h"
+#include "sharded_task_repository.h"
+#include "repository_capabilities.h"
+#include "repository_exceptions.h"
+#include "task_manager.h"
+#include "mock_task_repository.h"
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// Optimistic repository whose store always moved on since the last load
+class AlwaysConflictingRepository : public MockTaskRepository, public IVersionedRepository {
+public:
+    void saveTasks(const TaskList&) override {
+        throw ConflictException("always behind");
+    }
+    void setOptimistic(bool) override {}
+    bool isOptimistic() const override {
+        return true;
+    }
+    std::uint64_t getGeneration() const override {
+        return 0;
+    }
+    bool isStale() override {
+        return false;
+    }
+};
+
+} // namespace
+
+class OptimisticSavesTest : public ::testing::Test {
+protected:
+    std::string tasksPath = "test_optimistic_tasks.json";
+    std::string shardedPath = "test_optimistic_sharded";
+
+    void SetUp() override {
+        TearDown();
+    }
+
+    void TearDown() override {
+        fs::remove(tasksPath);
+        fs::remove(tasksPath + ".lock");
+        fs::remove(shardedPath + ".shards.json");
+        for (int shard = 0; shard < 4; shard++) {
+            std::string path = shardedPath + "." + std::to_string(shard) + ".json";
+            fs::remove(path);
+            fs::remove(path + ".lock");
+        }
+    }
+
+    void seed(int count) {
+        FileTaskRepository repository(tasksPath);
+        TaskList tasks;
+        for (int id = 1; id <= count; id++) {
+            tasks.emplace_back(id, "Task " + std::to_string(id), false);
+        }
+        repository.saveTasks(tasks);
+    }
+
+    static std::string readFile(const std::string& path) {
+        std::ifstream in(path, std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+};
+
+// Test the lock file keeps a counter across lock objects, 0 until written
+TEST_F(OptimisticSavesTest, CounterKeptInLockFile) {
+    std::string lockPath = tasksPath + ".lock";
+    {
+        FileLock lock(lockPath);
+        lock.lock(LockMode::EXCLUSIVE);
+        EXPECT_EQ(lock.readCounter(), 0u);
+        EXPECT_TRUE(lock.writeCounter(41));
+        EXPECT_TRUE(lock.writeCounter(7));
+        lock.unlock();
+    }
+    FileLock lock(lockPath);
+    lock.lock(LockMode::SHARED);
+    EXPECT_EQ(lock.readCounter(), 7u);
+    lock.unlock();
+}
+
+// Test saves and appends advance the generation, and loads see it
+TEST_F(OptimisticSavesTest, SavesAndAppendsAdvanceGeneration) {
+    seed(3);
+    FileTaskRepository repository(tasksPath);
+    EXPECT_EQ(repository.readGeneration(), 1u);
+    EXPECT_EQ(repository.getGeneration(), 0u);
+
+    repository.loadTasks();
+    EXPECT_EQ(repository.getGeneration(), 1u);
+    repository.appendTask("Appended");
+    EXPECT_EQ(repository.getGeneration(), 2u);
+    repository.saveTasks(repository.loadTasks());
+    EXPECT_EQ(repository.getGeneration(), 3u);
+    EXPECT_EQ(repository.readGeneration(), 3u);
+}
+
+// Test a rewrite by another writer is noticed by its generation, even when
+// the file keeps its size and modification time
+TEST_F(OptimisticSavesTest, SameSizeRewriteNoticed) {
+    seed(3);
+    FileTaskRepository mine(tasksPath);
+    FileTaskRepository theirs(tasksPath);
+    mine.loadTasks();
+    EXPECT_EQ(mine.getNextId(), 4);
+
+    // Task 3 becomes task 7: same length, same time stamp
+    auto time = fs::last_write_time(tasksPath);
+    std::uintmax_t size = fs::file_size(tasksPath);
+    TaskList tasks = theirs.loadTasks();
+    tasks[2] = Task(7, tasks[2].getDescription(), false);
+    theirs.saveTasks(tasks);
+    fs::last_write_time(tasksPath, time);
+    ASSERT_EQ(fs::file_size(tasksPath), size);
+
+    EXPECT_EQ(mine.appendTask("After the rewrite"), 8);
+}
+
+// Test a stale save overwrites unless optimistic, then fails until loaded again
+TEST_F(OptimisticSavesTest, StaleSaveConflicts) {
+    seed(3);
+    FileTaskRepository mine(tasksPath);
+    FileTaskRepository theirs(tasksPath);
+    TaskList stale = mine.loadTasks();
+    TaskList fresh = theirs.loadTasks();
+    fresh[0].setCompleted(true);
+    theirs.saveTasks(fresh);
+
+    mine.setOptimistic(true);
+    EXPECT_TRUE(mine.isOptimistic());
+    std::string saved = readFile(tasksPath);
+    EXPECT_THROW(mine.saveTasks(stale), ConflictException);
+    EXPECT_EQ(readFile(tasksPath), saved);
+
+    TaskList reloaded = mine.loadTasks();
+    EXPECT_TRUE(reloaded[0].isCompleted());
+    reloaded[1].setCompleted(true);
+    EXPECT_NO_THROW(mine.saveTasks(reloaded));
+
+    // Without generations checked, the stale list wins as before
+    theirs.saveTasks(fresh);
+    EXPECT_FALSE(theirs.loadTasks()[1].isCompleted());
+}
+
+// Test an append keeps a current list current but not a stale one
+TEST_F(OptimisticSavesTest, AppendKeepsStaleListBehind) {
+    seed(3);
+    FileTaskRepository mine(tasksPath);
+    FileTaskRepository theirs(tasksPath);
+    mine.setOptimistic(true);
+    TaskList tasks = mine.loadTasks();
+    mine.appendTask("Mine");
+    tasks.emplace_back(4, "Mine", false);
+    EXPECT_NO_THROW(mine.saveTasks(tasks));
+
+    theirs.appendTask("Theirs");
+    mine.appendTask("Mine again");
+    EXPECT_THROW(mine.saveTasks(tasks), ConflictException);
+    EXPECT_EQ(mine.loadTasks().size(), 6u);
+}
+
+// Test a manager's completion that conflicts is made again on the fresh tasks
+TEST_F(OptimisticSavesTest, ManagerReappliesConflictingChange) {
+    seed(3);
+    FileTaskRepository mine(tasksPath);
+    FileTaskRepository theirs(tasksPath);
+    mine.setOptimistic(true);
+    theirs.setOptimistic(true);
+    TaskManager first(mine);
+    TaskManager second(theirs);
+    EXPECT_TRUE(first.savesOptimistically());
+    first.load();
+    second.load();
+
+    EXPECT_EQ(second.addTask("Added elsewhere"), 4);
+    EXPECT_TRUE(second.completeTask(1));
+    EXPECT_TRUE(first.completeTask(2));
+    EXPECT_EQ(first.getConflictCount(), 1u);
+    EXPECT_EQ(second.getConflictCount(), 0u);
+
+    FileTaskRepository check(tasksPath);
+    TaskList saved = check.loadTasks();
+    ASSERT_EQ(saved.size(), 4u);
+    EXPECT_TRUE(saved[0].isCompleted());
+    EXPECT_TRUE(saved[1].isCompleted());
+    EXPECT_EQ(saved[3].getDescription(), "Added elsewhere");
+    EXPECT_EQ(first.listTasks().size(), 4u);
+}
+
+// Test changes deferred until save() are made again after another writer's,
+// with adds taking the next free IDs
+TEST_F(OptimisticSavesTest, DeferredChangesReplayedOnSave) {
+    seed(3);
+    FileTaskRepository mine(tasksPath);
+    FileTaskRepository theirs(tasksPath);
+    mine.setOptimistic(true);
+    TaskManager first(mine);
+    TaskManager second(theirs);
+    first.setAutoSave(false);
+
+    EXPECT_EQ(first.addTask("Deferred"), 4);
+    EXPECT_TRUE(first.completeTask(2));
+    EXPECT_EQ(second.addTask("Saved first"), 4);
+
+    first.save();
+    EXPECT_FALSE(first.hasUnsavedChanges());
+    EXPECT_EQ(first.getConflictCount(), 1u);
+
+    FileTaskRepository check(tasksPath);
+    TaskList saved = check.loadTasks();
+    ASSERT_EQ(saved.size(), 5u);
+    EXPECT_TRUE(saved[1].isCompleted());
+    EXPECT_EQ(saved[3].getDescription(), "Saved first");
+    EXPECT_EQ(saved[4].getId(), 5);
+    EXPECT_EQ(saved[4].getDescription(), "Deferred");
+}
+
+// Test a conflict in any shard stops the save before any shard is written
+TEST_F(OptimisticSavesTest, ShardedSaveChecksEveryShard) {
+    ShardedTaskRepository mine(shardedPath, 4);
+    ShardedTaskRepository theirs(shardedPath, 4);
+    mine.setOptimistic(true);
+    TaskList tasks;
+    for (int id = 1; id <= 8; id++) {
+        tasks.emplace_back(id, "Task " + std::to_string(id), false);
+    }
+    mine.saveTasks(tasks);
+
+    TaskList stale = mine.loadTasks();
+    TaskList fresh = theirs.loadTasks();
+    fresh[2].setCompleted(true); // ID 3, shard 3
+    theirs.saveTasks(fresh);
+
+    std::string shard1 = readFile(mine.getShardPath(1));
+    stale[0].setCompleted(true); // ID 1, shard 1
+    EXPECT_THROW(mine.saveTasks(stale), ConflictException);
+    EXPECT_EQ(readFile(mine.getShardPath(1)), shard1);
+
+    TaskList reloaded = mine.loadTasks();
+    reloaded[0].setCompleted(true);
+    mine.saveTasks(reloaded);
+    TaskList saved = theirs.loadTasks();
+    EXPECT_TRUE(saved[0].isCompleted());
+    EXPECT_TRUE(saved[2].isCompleted());
+}
+
+// Test the conflict is passed on once every attempt has failed
+TEST_F(OptimisticSavesTest, GivesUpAfterMaxAttempts) {
+    AlwaysConflictingRepository repository;
+    TaskManager manager(repository);
+    EXPECT_THROW(manager.addTask("Never saved"), ConflictException);
+    EXPECT_EQ(manager.getConflictCount(), TaskManager::kMaxSaveAttempts);
+}
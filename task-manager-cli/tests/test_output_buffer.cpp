@@ -0,0 +1,63 @@
+#include <gtest/gtest.h>
+#include "output_buffer.h"
+#include <climits>
+#include <sstream>
+#include <string>
+
+// Test text, characters and integers are written in order
+TEST(OutputBufferTest, AppendsTextCharactersAndIntegers) {
+    std::ostringstream out;
+    {
+        OutputBuffer buffer(out);
+        buffer.append('[');
+        buffer.append(42);
+        buffer.append(std::string_view("] "));
+        buffer.append(-7);
+        buffer.append(' ');
+        buffer.append(LLONG_MIN);
+    }
+
+    EXPECT_EQ(out.str(), "[42] -7 " + std::to_string(LLONG_MIN));
+}
+
+// Test nothing reaches the stream until the buffer fills or is flushed
+TEST(OutputBufferTest, WritesOnFlush) {
+    std::ostringstream out;
+    OutputBuffer buffer(out);
+
+    buffer.append(std::string_view("pending"));
+    EXPECT_TRUE(out.str().empty());
+
+    buffer.flush();
+    EXPECT_EQ(out.str(), "pending");
+}
+
+// Test a small buffer flushes as it fills without losing bytes
+TEST(OutputBufferTest, FlushesWhenFull) {
+    std::ostringstream out;
+    std::string expected;
+    {
+        OutputBuffer buffer(out, 32);
+        for (int i = 0; i < 100; i++) {
+            buffer.append(i);
+            buffer.append(std::string_view(" item,"));
+            expected += std::to_string(i) + " item,";
+        }
+    }
+
+    EXPECT_EQ(out.str(), expected);
+}
+
+// Test text larger than the buffer is written through
+TEST(OutputBufferTest, WritesLargeTextThrough) {
+    std::ostringstream out;
+    std::string large(1000, 'x');
+    {
+        OutputBuffer buffer(out, 64);
+        buffer.append('<');
+        buffer.append(large);
+        buffer.append('>');
+    }
+
+    EXPECT_EQ(out.str(), "<" + large + ">");
+}
@@ -0,0 +1,230 @@
+#include <gtest/gtest.h>
+#include "paged_task_repository.h"
+#include "page_cache.h"
+#include "task_manager.h"
+#include "repository_exceptions.h"
+#include "task.h"
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+class PagedTaskRepositoryTest : public ::testing::Test {
+protected:
+    std::string testFilePath;
+
+    void SetUp() override {
+        testFilePath = "test_paged_tasks.db";
+        if (fs::exists(testFilePath)) {
+            fs::remove(testFilePath);
+        }
+    }
+
+    void TearDown() override {
+        if (fs::exists(testFilePath)) {
+            fs::remove(testFilePath);
+        }
+        fs::remove(testFilePath + ".lock");
+    }
+
+    // Helper to collect streamed tasks
+    std::vector<std::pair<int, std::string>> collect(PagedTaskRepository& repo) {
+        std::vector<std::pair<int, std::string>> result;
+        repo.forEachTask([&](const TaskView& task) {
+            result.emplace_back(task.id, std::string(task.description));
+        });
+        return result;
+    }
+};
+
+// Test a new file is created empty
+TEST_F(PagedTaskRepositoryTest, CreatesEmptyFile) {
+    PagedTaskRepository repo(testFilePath);
+
+    EXPECT_TRUE(fs::exists(testFilePath));
+    EXPECT_EQ(fs::file_size(testFilePath), PagedTaskRepository::kPageSize);
+    EXPECT_EQ(repo.getTaskCount(), 0);
+    EXPECT_EQ(repo.getNextId(), 1);
+    EXPECT_TRUE(repo.supportsStreaming());
+}
+
+// Test appended tasks are streamed back in order with sequential IDs
+TEST_F(PagedTaskRepositoryTest, AppendAndStream) {
+    PagedTaskRepository repo(testFilePath);
+
+    EXPECT_EQ(repo.appendTask("Task 1"), 1);
+    EXPECT_EQ(repo.appendTask("Task 2"), 2);
+    EXPECT_EQ(repo.appendTask("Task 3"), 3);
+
+    auto tasks = collect(repo);
+    ASSERT_EQ(tasks.size(), 3);
+    EXPECT_EQ(tasks[0], std::make_pair(1, std::string("Task 1")));
+    EXPECT_EQ(tasks[2], std::make_pair(3, std::string("Task 3")));
+}
+
+// Test tasks and the ID counter persist across instances
+TEST_F(PagedTaskRepositoryTest, PersistsAcrossInstances) {
+    {
+        PagedTaskRepository repo(testFilePath);
+        repo.appendTask("Persistent task");
+        repo.appendTask("Another task");
+        repo.setTaskCompleted(2, true);
+    }
+
+    PagedTaskRepository repo(testFilePath);
+    TaskList tasks = repo.loadTasks();
+    ASSERT_EQ(tasks.size(), 2);
+    EXPECT_EQ(tasks[0].getDescription(), "Persistent task");
+    EXPECT_FALSE(tasks[0].isCompleted());
+    EXPECT_TRUE(tasks[1].isCompleted());
+    EXPECT_EQ(repo.getNextId(), 3);
+}
+
+// Test many tasks span pages and stay reachable with a one-page cache
+TEST_F(PagedTaskRepositoryTest, ManyTasksWithTinyCache) {
+    {
+        PagedTaskRepository repo(testFilePath, PagedTaskRepository::kPageSize);
+        for (int i = 1; i <= 2000; i++) {
+            repo.appendTask("Task number " + std::to_string(i));
+        }
+        EXPECT_GT(fs::file_size(testFilePath), 10 * PagedTaskRepository::kPageSize);
+    }
+
+    PagedTaskRepository repo(testFilePath, PagedTaskRepository::kPageSize);
+    EXPECT_TRUE(repo.setTaskCompleted(1, true));
+    EXPECT_TRUE(repo.setTaskCompleted(1234, true));
+    EXPECT_TRUE(repo.setTaskCompleted(2000, true));
+    EXPECT_FALSE(repo.setTaskCompleted(2001, true));
+
+    int count = 0;
+    int completed = 0;
+    repo.forEachTask([&](const TaskView& task) {
+        count++;
+        EXPECT_EQ(task.description, "Task number " + std::to_string(task.id));
+        if (task.completed) {
+            completed++;
+        }
+    });
+    EXPECT_EQ(count, 2000);
+    EXPECT_EQ(completed, 3);
+}
+
+// Test completing by ID reads a bounded number of pages when IDs are sorted
+TEST_F(PagedTaskRepositoryTest, CompleteUsesBinarySearch) {
+    PagedTaskRepository repo(testFilePath, PagedTaskRepository::kPageSize);
+    for (int i = 1; i <= 5000; i++) {
+        repo.appendTask("Task number " + std::to_string(i));
+    }
+
+    std::size_t missesBefore = repo.getCacheStats().misses;
+    EXPECT_TRUE(repo.setTaskCompleted(2500, true));
+    std::size_t misses = repo.getCacheStats().misses - missesBefore;
+
+    // log2 of roughly 40 data pages, plus the page holding the task
+    EXPECT_LE(misses, 8);
+}
+
+// Test unsorted IDs from saveTasks are still found
+TEST_F(PagedTaskRepositoryTest, SaveTasksWithUnsortedIds) {
+    PagedTaskRepository repo(testFilePath);
+    TaskList tasks = {
+        Task(5, "Task 5", false),
+        Task(1, "Task 1", false),
+        Task(3, "Task 3", false)
+    };
+    repo.saveTasks(tasks);
+
+    EXPECT_TRUE(repo.setTaskCompleted(3, true));
+    EXPECT_FALSE(repo.setTaskCompleted(4, true));
+    EXPECT_EQ(repo.getNextId(), 6);
+
+    TaskList loaded = repo.loadTasks();
+    ASSERT_EQ(loaded.size(), 3);
+    EXPECT_EQ(loaded[0].getId(), 5);
+    EXPECT_TRUE(loaded[2].isCompleted());
+}
+
+// Test clearing removes tasks and resets the ID counter
+TEST_F(PagedTaskRepositoryTest, ClearTasks) {
+    PagedTaskRepository repo(testFilePath);
+    repo.appendTask("Task 1");
+    repo.appendTask("Task 2");
+
+    repo.clearTasks();
+
+    EXPECT_EQ(repo.getTaskCount(), 0);
+    EXPECT_TRUE(collect(repo).empty());
+    EXPECT_EQ(repo.appendTask("New task"), 1);
+    EXPECT_EQ(fs::file_size(testFilePath), 2 * PagedTaskRepository::kPageSize);
+}
+
+// Test oversized descriptions are rejected
+TEST_F(PagedTaskRepositoryTest, RejectsOversizedDescription) {
+    PagedTaskRepository repo(testFilePath);
+    std::string description(PagedTaskRepository::kMaxDescriptionSize + 1, 'x');
+
+    EXPECT_THROW(repo.appendTask(description), RepositoryException);
+    EXPECT_EQ(repo.appendTask(std::string(PagedTaskRepository::kMaxDescriptionSize, 'x')), 1);
+}
+
+// Test files that are not paged task files are rejected
+TEST_F(PagedTaskRepositoryTest, RejectsInvalidFile) {
+    std::ofstream file(testFilePath);
+    file << "[]";
+    file.close();
+
+    EXPECT_THROW(PagedTaskRepository repo(testFilePath), RepositoryException);
+}
+
+// Test TaskManager streams through the repository instead of loading it
+TEST_F(PagedTaskRepositoryTest, TaskManagerStreams) {
+    PagedTaskRepository repo(testFilePath);
+    TaskManager manager(repo);
+
+    EXPECT_TRUE(manager.isStreaming());
+    EXPECT_EQ(manager.addTask("Task 1"), 1);
+    EXPECT_EQ(manager.addTask(std::pmr::string("Task 2")), 2);
+    EXPECT_TRUE(manager.completeTask(2));
+    EXPECT_FALSE(manager.completeTask(3));
+
+    std::vector<int> ids;
+    manager.forEachTask([&](const TaskView& task) {
+        ids.push_back(task.id);
+    });
+    EXPECT_EQ(ids, (std::vector<int>{1, 2}));
+
+    TaskList tasks = manager.listTasks();
+    ASSERT_EQ(tasks.size(), 2);
+    EXPECT_TRUE(tasks[1].isCompleted());
+
+    manager.clearAllTasks();
+    EXPECT_TRUE(manager.listTasks().empty());
+    EXPECT_EQ(manager.addTask("New task"), 1);
+}
+
+// Test the page cache never holds more pages than its budget
+TEST(PageCacheTest, EvictsLeastRecentlyUsedPage) {
+    std::string path = "test_page_cache.bin";
+    {
+        std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+        PageCache cache(file, 64, 128);
+        EXPECT_EQ(cache.getCapacity(), 2);
+
+        cache.getPage(0)[0] = 'a';
+        cache.markDirty(0);
+        cache.getPage(1)[0] = 'b';
+        cache.markDirty(1);
+        cache.getPage(0);      // 0 is now most recently used
+        cache.getPage(2);      // evicts page 1, writing it back
+
+        EXPECT_EQ(cache.getStats().evictions, 1);
+        EXPECT_EQ(cache.getStats().writes, 1);
+        EXPECT_EQ(cache.getPage(1)[0], 'b');
+        EXPECT_EQ(cache.getStats().hits, 1);
+
+        cache.flush();
+    }
+    fs::remove(path);
+}
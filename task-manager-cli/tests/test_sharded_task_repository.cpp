@@ -0,0 +1,175 @@
+#include <gtest/gtest.h>
+#include "sharded_task_repository.h"
+#include "file_task_repository.h"
+#include "repository_exceptions.h"
+#include "task_manager.h"
+#include "work_stealing_pool.h"
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+class ShardedTaskRepositoryTest : public ::testing::Test {
+protected:
+    std::string basePath = "test_sharded_tasks";
+
+    void SetUp() override {
+        TearDown();
+    }
+
+    void TearDown() override {
+        fs::remove(basePath + ".shards.json");
+        for (int shard = 0; shard < 8; shard++) {
+            std::string path = basePath + "." + std::to_string(shard) + ".json";
+            fs::remove(path);
+            fs::remove(path + ".lock");
+        }
+    }
+
+    static std::string readFile(const std::string& path) {
+        std::ifstream in(path, std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+
+    static TaskList makeTasks(int count) {
+        TaskList tasks;
+        for (int id = 1; id <= count; id++) {
+            tasks.emplace_back(id, "Task " + std::to_string(id), id % 5 == 0);
+        }
+        return tasks;
+    }
+};
+
+// Test tasks are spread over the shard files and load back in ID order
+TEST_F(ShardedTaskRepositoryTest, RoundTripInIdOrder) {
+    {
+        ShardedTaskRepository repository(basePath, 4);
+        repository.saveTasks(makeTasks(100));
+        EXPECT_EQ(repository.getLastWritten(), 4u);
+    }
+    for (std::size_t shard = 0; shard < 4; shard++) {
+        FileTaskRepository file(basePath + "." + std::to_string(shard) + ".json");
+        TaskList tasks = file.loadTasks();
+        ASSERT_EQ(tasks.size(), 25u);
+        for (const auto& task : tasks) {
+            EXPECT_EQ(static_cast<std::size_t>(task.getId()) % 4, shard);
+        }
+    }
+
+    ShardedTaskRepository repository(basePath, 4);
+    TaskList tasks = repository.loadTasks();
+    ASSERT_EQ(tasks.size(), 100u);
+    for (int i = 0; i < 100; i++) {
+        EXPECT_EQ(tasks[static_cast<std::size_t>(i)].getId(), i + 1);
+    }
+    EXPECT_TRUE(tasks[4].isCompleted());
+    EXPECT_EQ(tasks[99].getDescription(), "Task 100");
+    EXPECT_EQ(repository.getNextId(), 101);
+}
+
+// Test runs of IDs share a shard when routing by range
+TEST_F(ShardedTaskRepositoryTest, RangeRouting) {
+    ShardedTaskRepository repository(basePath, 3, ShardRouting::RANGE, 10);
+    EXPECT_EQ(repository.getShard(1), 0u);
+    EXPECT_EQ(repository.getShard(10), 0u);
+    EXPECT_EQ(repository.getShard(11), 1u);
+    EXPECT_EQ(repository.getShard(30), 2u);
+    EXPECT_EQ(repository.getShard(31), 0u);
+
+    repository.saveTasks(makeTasks(25));
+    TaskList tasks = repository.loadTasks();
+    ASSERT_EQ(tasks.size(), 25u);
+    EXPECT_EQ(tasks[24].getId(), 25);
+}
+
+// Test a save rewrites only the shards whose tasks changed
+TEST_F(ShardedTaskRepositoryTest, SaveWritesOnlyChangedShards) {
+    ShardedTaskRepository repository(basePath, 4);
+    repository.saveTasks(makeTasks(100));
+    std::string untouched = readFile(repository.getShardPath(2));
+
+    TaskList tasks = repository.loadTasks();
+    repository.saveTasks(tasks);
+    EXPECT_EQ(repository.getLastWritten(), 0u);
+
+    tasks[0].setCompleted(true); // ID 1, shard 1
+    repository.saveTasks(tasks);
+    EXPECT_EQ(repository.getLastWritten(), 1u);
+    EXPECT_EQ(readFile(repository.getShardPath(2)), untouched);
+
+    tasks.emplace_back(101, "New", false); // Shard 1 again
+    tasks.emplace_back(102, "Newer", false); // Shard 2
+    repository.saveTasks(tasks);
+    EXPECT_EQ(repository.getLastWritten(), 2u);
+    EXPECT_EQ(repository.loadTasks().size(), 102u);
+}
+
+// Test a shard another instance wrote is written again rather than skipped
+TEST_F(ShardedTaskRepositoryTest, ShardWrittenElsewhereIsNotSkipped) {
+    ShardedTaskRepository first(basePath, 4);
+    first.saveTasks(makeTasks(20));
+    TaskList mine = first.loadTasks();
+
+    ShardedTaskRepository second(basePath, 4);
+    TaskList theirs = second.loadTasks();
+    theirs[2].setCompleted(true); // ID 3, shard 3
+    second.saveTasks(theirs);
+
+    first.saveTasks(mine);
+    EXPECT_EQ(first.getLastWritten(), 1u);
+    EXPECT_FALSE(second.loadTasks()[2].isCompleted());
+}
+
+// Test the manager hands out IDs that are unique across shards and sessions
+TEST_F(ShardedTaskRepositoryTest, ManagerAllocatesGlobalIds) {
+    {
+        ShardedTaskRepository repository(basePath, 4);
+        TaskManager manager(repository);
+        for (int i = 1; i <= 10; i++) {
+            EXPECT_EQ(manager.addTask("Task " + std::to_string(i)), i);
+            EXPECT_EQ(repository.getLastWritten(), 1u);
+        }
+        EXPECT_TRUE(manager.completeTask(7));
+        EXPECT_EQ(repository.getLastWritten(), 1u);
+    }
+    ShardedTaskRepository repository(basePath, 4);
+    TaskManager manager(repository);
+    EXPECT_EQ(manager.addTask("Eleventh"), 11);
+    EXPECT_TRUE(manager.findTask(7)->isCompleted());
+    EXPECT_EQ(manager.listTasks().size(), 11u);
+
+    manager.clearAllTasks();
+    EXPECT_EQ(manager.addTask("After clear"), 1);
+}
+
+// Test shards load in parallel on a pool with the same result
+TEST_F(ShardedTaskRepositoryTest, LoadsShardsOnPool) {
+    WorkStealingPool pool(4);
+    ShardedTaskRepository repository(basePath, 8);
+    repository.setThreadPool(&pool);
+    repository.saveTasks(makeTasks(1000));
+    EXPECT_EQ(repository.getLastWritten(), 8u);
+
+    TaskList tasks = repository.loadTasks();
+    ASSERT_EQ(tasks.size(), 1000u);
+    for (int i = 0; i < 1000; i++) {
+        ASSERT_EQ(tasks[static_cast<std::size_t>(i)].getId(), i + 1);
+    }
+    EXPECT_GT(pool.getStats().jobs, 0u);
+}
+
+// Test files sharded one way cannot be opened another way
+TEST_F(ShardedTaskRepositoryTest, RejectsDifferentSharding) {
+    {
+        ShardedTaskRepository repository(basePath, 4);
+        repository.saveTasks(makeTasks(10));
+    }
+    EXPECT_THROW(ShardedTaskRepository(basePath, 2), RepositoryException);
+    EXPECT_THROW(ShardedTaskRepository(basePath, 4, ShardRouting::RANGE), RepositoryException);
+    EXPECT_NO_THROW(ShardedTaskRepository(basePath, 4, ShardRouting::HASH, 7));
+    EXPECT_EQ(parseShardRouting("range"), ShardRouting::RANGE);
+    EXPECT_FALSE(parseShardRouting("modulo").has_value());
+}
@@ -0,0 +1,146 @@
+#include <gtest/gtest.h>
+#include "shell.h"
+#include "task_manager.h"
+#include "mock_task_repository.h"
+#include "cli.h"
+#include "repository_exceptions.h"
+#include <chrono>
+#include <sstream>
+
+namespace {
+
+// Repository whose saves fail
+class UnwritableRepository : public MockTaskRepository {
+public:
+    void saveTasks(const TaskList&) override {
+        throw FileIOException("disk full");
+    }
+};
+
+} // namespace
+
+class ShellTest : public ::testing::Test {
+protected:
+    MockTaskRepository repo;
+    CLI cli;
+};
+
+// Test commands run against the resident manager and are saved once on exit
+TEST_F(ShellTest, RunsCommandsAndSavesOnExit) {
+    TaskManager manager(repo);
+    Shell shell(manager, cli, std::chrono::hours(1));
+    std::istringstream in(
+        "add \"Buy groceries\"\n"
+        "add Write code\n"
+        "complete 1\n"
+        "list\n"
+        "exit\n"
+        "add Never run\n");
+    std::stringstream out;
+
+    EXPECT_EQ(shell.run(in, out, false), 0);
+
+    std::string output = out.str();
+    EXPECT_NE(output.find("Task added with ID: 2"), std::string::npos);
+    EXPECT_NE(output.find("[1] [X] Buy groceries"), std::string::npos);
+    EXPECT_EQ(repo.getSaveCount(), 1);
+    EXPECT_EQ(repo.loadTasks().size(), 2);
+    EXPECT_TRUE(manager.isAutoSaveEnabled());
+}
+
+// Test end of input leaves the shell like exit does
+TEST_F(ShellTest, SavesAtEndOfInput) {
+    TaskManager manager(repo);
+    Shell shell(manager, cli, std::chrono::hours(1));
+    std::istringstream in("add First\n");
+    std::stringstream out;
+
+    shell.run(in, out, false);
+
+    EXPECT_EQ(repo.getSaveCount(), 1);
+}
+
+// Test a failed save on exit is reported and leaves auto-saving as it was
+TEST_F(ShellTest, ReportsFailedSaveOnExit) {
+    UnwritableRepository unwritable;
+    TaskManager manager(unwritable);
+    Shell shell(manager, cli, std::chrono::hours(1));
+    std::istringstream in("add First\n");
+    std::stringstream out;
+
+    EXPECT_EQ(shell.run(in, out, false), 1);
+
+    EXPECT_NE(out.str().find("Save failed, changes not saved: File I/O error: disk full"), std::string::npos);
+    EXPECT_TRUE(manager.hasUnsavedChanges());
+    EXPECT_TRUE(manager.isAutoSaveEnabled());
+}
+
+// Test a zero interval saves after every change
+TEST_F(ShellTest, ZeroSaveIntervalSavesEachChange) {
+    TaskManager manager(repo);
+    Shell shell(manager, cli, std::chrono::milliseconds(0));
+    std::istringstream in("add First\nadd Second\nlist\n");
+    std::stringstream out;
+
+    shell.run(in, out, false);
+
+    EXPECT_EQ(repo.getSaveCount(), 2);
+}
+
+// Test the save built-in writes pending changes immediately
+TEST_F(ShellTest, SaveBuiltIn) {
+    TaskManager manager(repo);
+    Shell shell(manager, cli, std::chrono::hours(1));
+    std::istringstream in("add First\nsave\nsave\n");
+    std::stringstream out;
+
+    shell.run(in, out, false);
+
+    EXPECT_NE(out.str().find("Changes saved"), std::string::npos);
+    EXPECT_EQ(repo.getSaveCount(), 1);
+}
+
+// Test timing output can be switched on and off
+TEST_F(ShellTest, TimingToggle) {
+    TaskManager manager(repo);
+    Shell shell(manager, cli);
+    std::istringstream in("list\ntiming on\nlist\ntiming off\nlist\n");
+    std::stringstream out;
+
+    shell.run(in, out, false);
+
+    std::string output = out.str();
+    EXPECT_NE(output.find("Timing is on"), std::string::npos);
+    EXPECT_NE(output.find(" ms)"), std::string::npos);
+    EXPECT_EQ(output.find(" ms)"), output.rfind(" ms)"));
+}
+
+// Test errors are reported and the shell keeps going
+TEST_F(ShellTest, ErrorsDoNotEndSession) {
+    TaskManager manager(repo);
+    Shell shell(manager, cli);
+    std::istringstream in("bogus\ncomplete abc\nshell\nadd Still here\n");
+    std::stringstream out;
+
+    EXPECT_EQ(shell.run(in, out, false), 0);
+
+    std::string output = out.str();
+    EXPECT_NE(output.find("Invalid command"), std::string::npos);
+    EXPECT_NE(output.find("shell cannot be started from the shell"), std::string::npos);
+    EXPECT_NE(output.find("Task added with ID: 1"), std::string::npos);
+    EXPECT_EQ(output.find("Usage:"), std::string::npos);
+}
+
+// Test the prompt is printed before each command
+TEST_F(ShellTest, PrintsPrompt) {
+    TaskManager manager(repo);
+    Shell shell(manager, cli);
+    std::istringstream in("help\n");
+    std::stringstream out;
+
+    shell.run(in, out);
+
+    std::string output = out.str();
+    EXPECT_EQ(output.rfind("task> ", 0), 0u);
+    EXPECT_NE(output.find("timing on|off"), std::string::npos);
+}
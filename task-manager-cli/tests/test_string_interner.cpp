@@ -0,0 +1,86 @@
+#include <gtest/gtest.h>
+#include "string_interner.h"
+#include "task.h"
+#include "counting_memory_resource.h"
+#include <string>
+
+// Test interning the same string twice returns the same stored copy
+TEST(StringInternerTest, IdenticalStringsShareStorage) {
+    StringInterner interner;
+
+    const std::string_view& first = interner.intern("Rotate logs");
+    const std::string_view& second = interner.intern(std::string("Rotate logs"));
+
+    EXPECT_EQ(&first, &second);
+    EXPECT_EQ(first.data(), second.data());
+    EXPECT_EQ(first, "Rotate logs");
+    EXPECT_EQ(interner.size(), 1);
+}
+
+// Test distinct strings are stored separately
+TEST(StringInternerTest, DistinctStringsAreStoredSeparately) {
+    StringInterner interner;
+
+    const std::string_view& first = interner.intern("Rotate logs");
+    const std::string_view& second = interner.intern("Renew certificates");
+
+    EXPECT_NE(first.data(), second.data());
+    EXPECT_EQ(interner.size(), 2);
+}
+
+// Test stored views stay valid while the table grows
+TEST(StringInternerTest, ViewsStayValidWhenTableGrows) {
+    StringInterner interner;
+    const std::string_view& first = interner.intern("First description");
+
+    for (int i = 0; i < 1000; i++) {
+        interner.intern("Description " + std::to_string(i));
+    }
+
+    EXPECT_EQ(first, "First description");
+    EXPECT_EQ(&interner.intern("First description"), &first);
+}
+
+// Test the counters report the storage saved by duplicates
+TEST(StringInternerTest, StatsReportSavedBytes) {
+    StringInterner interner;
+
+    for (int i = 0; i < 10; i++) {
+        interner.intern("Rotate logs");
+    }
+    interner.intern("Renew certificates");
+
+    const StringInterner::Stats& stats = interner.getStats();
+    EXPECT_EQ(stats.references, 11);
+    EXPECT_EQ(stats.uniqueStrings, 2);
+    EXPECT_EQ(stats.storedBytes, std::string("Rotate logs").size() + std::string("Renew certificates").size());
+    EXPECT_EQ(stats.savedBytes, 9 * std::string("Rotate logs").size());
+}
+
+// Test the empty string can be interned
+TEST(StringInternerTest, InternEmptyString) {
+    StringInterner interner;
+
+    EXPECT_EQ(interner.intern(""), "");
+    EXPECT_EQ(interner.size(), 1);
+}
+
+// Test tasks built through an interner share one description buffer
+TEST(StringInternerTest, TasksShareInternedDescription) {
+    StringInterner interner;
+    CountingMemoryResource resource;
+    TaskList tasks(&resource);
+
+    for (int i = 1; i <= 100; i++) {
+        tasks.emplace_back(i, "Rotate the application logs nightly", false, interner);
+    }
+
+    EXPECT_EQ(tasks[0].getDescription().data(), tasks[99].getDescription().data());
+    EXPECT_TRUE(tasks[0].hasInternedDescription());
+    EXPECT_EQ(resource.stringAllocationCount(), 0);
+    EXPECT_EQ(interner.size(), 1);
+
+    // Copies keep sharing the interned description
+    Task copy = tasks[50];
+    EXPECT_EQ(copy.getDescription().data(), tasks[0].getDescription().data());
+}
@@ -1,5 +1,6 @@
 #include <gtest/gtest.h>
 #include "task.h"
+#include "counting_memory_resource.h"
 #include <nlohmann/json.hpp>
 
 using json = nlohmann::json;
@@ -69,3 +70,51 @@ TEST(TaskTest, JsonRoundTrip) {
     EXPECT_EQ(restored.getDescription(), original.getDescription());
     EXPECT_EQ(restored.isCompleted(), original.isCompleted());
 }
+
+// Test task storage is allocated from the provided memory resource
+TEST(TaskTest, UsesProvidedMemoryResource) {
+    CountingMemoryResource resource;
+    Task task(1, "A description long enough to need heap storage", false, &resource);
+
+    EXPECT_EQ(task.get_allocator().resource(), &resource);
+    EXPECT_EQ(resource.allocationCount(), 1);
+}
+
+// Test pmr containers hand their memory resource down to the tasks they hold
+TEST(TaskTest, TaskListPropagatesMemoryResource) {
+    CountingMemoryResource resource;
+    TaskList tasks(&resource);
+
+    Task task(1, "Task created with the default resource", false);
+    tasks.push_back(task);
+
+    EXPECT_EQ(tasks[0].get_allocator().resource(), &resource);
+    EXPECT_EQ(tasks[0].getDescription(), "Task created with the default resource");
+}
+
+// Test the rvalue constructor adopts the description buffer instead of copying it
+TEST(TaskTest, RvalueDescriptionIsMovedNotCopied) {
+    CountingMemoryResource resource;
+    std::pmr::string description("A description long enough to need heap storage", &resource);
+    resource.reset();
+
+    Task task(1, std::move(description), false, &resource);
+
+    EXPECT_EQ(resource.stringAllocationCount(), 0);
+    EXPECT_EQ(task.getDescription(), "A description long enough to need heap storage");
+}
+
+// Test fromJson copies the description exactly once, into the target resource
+TEST(TaskTest, FromJsonAllocatesDescriptionOnce) {
+    json j = {
+        {"id", 3},
+        {"description", "A description long enough to need heap storage"},
+        {"completed", false}
+    };
+    CountingMemoryResource resource;
+
+    Task task = Task::fromJson(j, &resource);
+
+    EXPECT_EQ(resource.stringAllocationCount(), 1);
+    EXPECT_EQ(task.getDescription(), "A description long enough to need heap storage");
+}
@@ -0,0 +1,222 @@
+#include <gtest/gtest.h>
+#include "task_events.h"
+#include "task_manager.h"
+#include "file_task_repository.h"
+#include "mock_task_repository.h"
+#include <chrono>
+#include <filesystem>
+#include <future>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+class TaskEventsTest : public ::testing::Test {
+protected:
+    MockTaskRepository repository;
+    TaskManager manager{repository};
+    std::vector<std::vector<TaskEvent>> batches;
+
+    TaskEventHandler recorder() {
+        return [this](const std::vector<TaskEvent>& batch) {
+            batches.push_back(batch);
+        };
+    }
+
+    std::vector<TaskEvent> received() const {
+        std::vector<TaskEvent> all;
+        for (const auto& batch : batches) {
+            all.insert(all.end(), batch.begin(), batch.end());
+        }
+        return all;
+    }
+};
+
+// Test each change is published as a typed event with the IDs it affected
+TEST_F(TaskEventsTest, PublishesTypedEvents) {
+    manager.subscribe(recorder());
+    manager.addTask("First");
+    TaskList more;
+    more.emplace_back(0, "Second", false);
+    more.emplace_back(0, "Third", true);
+    manager.addTasks(more);
+    EXPECT_TRUE(manager.completeTask(2));
+    EXPECT_FALSE(manager.completeTask(99));
+    manager.clearAllTasks();
+
+    std::vector<TaskEvent> events = received();
+    ASSERT_EQ(events.size(), 4u);
+    EXPECT_EQ(batches.size(), 4u);
+    EXPECT_EQ(events[0].type, TaskEventType::ADDED);
+    EXPECT_EQ(events[0].firstId, 1);
+    EXPECT_EQ(events[0].count, 1);
+    EXPECT_EQ(events[1].type, TaskEventType::ADDED);
+    EXPECT_EQ(events[1].firstId, 2);
+    EXPECT_EQ(events[1].count, 2);
+    EXPECT_EQ(events[2].type, TaskEventType::COMPLETED);
+    EXPECT_EQ(events[2].firstId, 2);
+    EXPECT_EQ(events[3].type, TaskEventType::CLEARED);
+    for (std::size_t i = 0; i < events.size(); i++) {
+        EXPECT_EQ(events[i].sequence, i + 1);
+    }
+    EXPECT_STREQ(taskEventTypeName(TaskEventType::COMPLETED), "completed");
+}
+
+// Test nothing is recorded without subscribers, and nothing after unsubscribing
+TEST_F(TaskEventsTest, OnlySubscribersPayForEvents) {
+    manager.addTask("Unheard");
+    EXPECT_EQ(manager.getEventStats().events, 0u);
+
+    auto id = manager.subscribe(recorder());
+    manager.addTask("Heard");
+    EXPECT_TRUE(manager.unsubscribe(id));
+    EXPECT_FALSE(manager.unsubscribe(id));
+    manager.addTask("Unheard again");
+
+    ASSERT_EQ(received().size(), 1u);
+    EXPECT_EQ(received()[0].firstId, 2);
+    EXPECT_EQ(manager.getEventStats().events, 1u);
+    EXPECT_EQ(manager.getEventStats().batches, 1u);
+}
+
+// Test changes made under lock() are published together at unlock(), in
+// batches of at most maxBatch
+TEST_F(TaskEventsTest, LockedChangesBatched) {
+    TaskEventDispatcher::Settings settings;
+    settings.maxBatch = 2;
+    manager.subscribe(recorder(), settings);
+
+    manager.lock(LockMode::EXCLUSIVE);
+    for (int i = 0; i < 5; i++) {
+        manager.addTask("Task " + std::to_string(i));
+    }
+    EXPECT_TRUE(batches.empty());
+    manager.unlock();
+
+    ASSERT_EQ(batches.size(), 3u);
+    EXPECT_EQ(batches[0].size(), 2u);
+    EXPECT_EQ(batches[2].size(), 1u);
+    EXPECT_EQ(batches[2][0].firstId, 5);
+}
+
+// Test a synchronous handler may read the manager and change it, its own
+// change following in a batch of its own
+TEST_F(TaskEventsTest, HandlerMayUseManager) {
+    std::vector<std::string> seen;
+    manager.subscribe([&](const std::vector<TaskEvent>& batch) {
+        batches.push_back(batch);
+        for (const auto& event : batch) {
+            if (event.type == TaskEventType::ADDED) {
+                seen.emplace_back(manager.findTask(event.firstId)->getDescription());
+                if (event.firstId == 1) {
+                    manager.completeTask(1);
+                }
+            }
+        }
+    });
+    manager.addTask("Watched");
+
+    ASSERT_EQ(batches.size(), 2u);
+    EXPECT_EQ(batches[1][0].type, TaskEventType::COMPLETED);
+    ASSERT_EQ(seen.size(), 1u);
+    EXPECT_EQ(seen[0], "Watched");
+    EXPECT_TRUE(manager.findTask(1)->isCompleted());
+}
+
+// Test a handler that throws neither fails the change nor stops other subscribers
+TEST_F(TaskEventsTest, ThrowingHandlerIsContained) {
+    manager.subscribe([](const std::vector<TaskEvent>&) {
+        throw std::runtime_error("subscriber failed");
+    });
+    manager.subscribe(recorder());
+    EXPECT_EQ(manager.addTask("Still added"), 1);
+    EXPECT_EQ(received().size(), 1u);
+}
+
+// Test a slow asynchronous subscriber does not hold up changes, and gets
+// every event in order once it catches up
+TEST_F(TaskEventsTest, AsyncSubscriberDoesNotBlockChanges) {
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future().share();
+    std::mutex mutex;
+    std::vector<TaskEvent> events;
+    std::size_t calls = 0;
+    TaskEventDispatcher::Settings settings;
+    settings.delivery = TaskEventDispatcher::Delivery::ASYNC;
+    manager.subscribe([&](const std::vector<TaskEvent>& batch) {
+        released.wait();
+        std::lock_guard<std::mutex> lock(mutex);
+        events.insert(events.end(), batch.begin(), batch.end());
+        calls++;
+    }, settings);
+
+    for (int i = 0; i < 100; i++) {
+        manager.addTask("Task " + std::to_string(i));
+    }
+    release.set_value();
+    manager.flushEvents();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    ASSERT_EQ(events.size(), 100u);
+    for (int i = 0; i < 100; i++) {
+        EXPECT_EQ(events[static_cast<std::size_t>(i)].firstId, i + 1);
+    }
+    // The first call held everything up, so the rest came in few batches
+    EXPECT_LT(calls, 100u);
+}
+
+// Test an asynchronous subscription gathers events for its window, up to maxBatch
+TEST_F(TaskEventsTest, AsyncWindowGathersBatches) {
+    std::mutex mutex;
+    std::vector<std::size_t> sizes;
+    TaskEventDispatcher::Settings settings;
+    settings.delivery = TaskEventDispatcher::Delivery::ASYNC;
+    settings.maxBatch = 8;
+    settings.window = std::chrono::seconds(10);
+    manager.subscribe([&](const std::vector<TaskEvent>& batch) {
+        std::lock_guard<std::mutex> lock(mutex);
+        sizes.push_back(batch.size());
+    }, settings);
+
+    // A full batch goes out at once, without waiting out the window
+    for (int i = 0; i < 16; i++) {
+        manager.addTask("Task " + std::to_string(i));
+    }
+    manager.flushEvents();
+    std::lock_guard<std::mutex> lock(mutex);
+    ASSERT_EQ(sizes.size(), 2u);
+    EXPECT_EQ(sizes[0], 8u);
+    EXPECT_EQ(sizes[1], 8u);
+}
+
+// Test a conflicting optimistic save tells subscribers to read the tasks again
+TEST(TaskEventsConflictTest, ConflictPublishesReload) {
+    std::string path = "test_events_tasks.json";
+    fs::remove(path);
+    fs::remove(path + ".lock");
+    {
+        FileTaskRepository mine(path);
+        FileTaskRepository theirs(path);
+        mine.setOptimistic(true);
+        TaskManager first(mine);
+        TaskManager second(theirs);
+        first.addTask("One");
+        first.addTask("Two");
+        first.load();
+        second.completeTask(1);
+
+        std::vector<TaskEvent> events;
+        first.subscribe([&](const std::vector<TaskEvent>& batch) {
+            events.insert(events.end(), batch.begin(), batch.end());
+        });
+        EXPECT_TRUE(first.completeTask(2));
+        ASSERT_EQ(events.size(), 2u);
+        EXPECT_EQ(events[0].type, TaskEventType::RELOADED);
+        EXPECT_EQ(events[1].type, TaskEventType::COMPLETED);
+        EXPECT_EQ(events[1].firstId, 2);
+    }
+    fs::remove(path);
+    fs::remove(path + ".lock");
+}
@@ -0,0 +1,179 @@
+#include <gtest/gtest.h>
+#include "task_exporter.h"
+#include "task_manager.h"
+#include "mock_task_repository.h"
+#include "file_task_repository.h"
+#include "paged_task_repository.h"
+#include "cli.h"
+#include "work_stealing_pool.h"
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+
+namespace fs = std::filesystem;
+
+class TaskExporterTest : public ::testing::Test {
+protected:
+    MockTaskRepository repo;
+    CLI cli;
+    std::string jsonPath = "test_export_tasks.json";
+    std::string exportPath = "test_export_out";
+
+    void TearDown() override {
+        for (const auto& path : {jsonPath, exportPath, exportPath + ".tmp", jsonPath + ".lock", exportPath + ".lock"}) {
+            fs::remove(path);
+        }
+    }
+
+    static std::string readFile(const std::string& path) {
+        std::ifstream file(path, std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+
+    // A tasks.json with three tasks, the second completed
+    void writeTasksFile(bool dictionary = false) {
+        FileTaskRepository fileRepo(jsonPath);
+        fileRepo.setDictionaryEncoding(dictionary);
+        TaskList tasks;
+        tasks.emplace_back(1, "First", false);
+        tasks.emplace_back(2, "Quote \" and\nnewline", true);
+        tasks.emplace_back(5, "Third", false);
+        fileRepo.saveTasks(tasks);
+    }
+};
+
+// Test NDJSON goes to a stream one object per line
+TEST_F(TaskExporterTest, StreamsNdjson) {
+    TaskManager manager(repo);
+    manager.addTask("First");
+    manager.addTask("Tab\there");
+    manager.completeTask(2);
+    std::ostringstream out;
+
+    TaskExporter::Result result = TaskExporter(manager, cli).exportToStream(out, ExportFormat::NDJSON);
+
+    EXPECT_EQ(result.tasks, 2);
+    EXPECT_EQ(out.str(), "{\"id\":1,\"description\":\"First\",\"completed\":false}\n"
+                         "{\"id\":2,\"description\":\"Tab\\there\",\"completed\":true}\n");
+}
+
+// Test a JSON export of an empty list is still a valid array
+TEST_F(TaskExporterTest, StreamsEmptyJsonArray) {
+    TaskManager manager(repo);
+    std::ostringstream out;
+
+    TaskExporter(manager, cli).exportToStream(out, ExportFormat::JSON);
+
+    EXPECT_EQ(out.str(), "[]\n");
+}
+
+// Test blocks formatted on a pool join into the text one thread writes
+TEST_F(TaskExporterTest, FormatsBlocksOnPool) {
+    TaskManager manager(repo);
+    manager.setAutoSave(false);
+    TaskList tasks;
+    for (int i = 1; i <= 3 * static_cast<int>(TaskExporter::kBlockSize) + 100; i++) {
+        tasks.emplace_back(0, "Task \"" + std::to_string(i) + "\"", i % 3 == 0);
+    }
+    manager.addTasks(tasks);
+    WorkStealingPool pool(3);
+
+    for (ExportFormat format : {ExportFormat::JSON, ExportFormat::NDJSON}) {
+        std::ostringstream expected;
+        manager.setThreadPool(nullptr);
+        TaskExporter(manager, cli).exportToStream(expected, format);
+
+        std::ostringstream out;
+        manager.setThreadPool(&pool);
+        TaskExporter::Result result = TaskExporter(manager, cli).exportToStream(out, format);
+
+        EXPECT_EQ(result.tasks, tasks.size());
+        EXPECT_TRUE(out.str() == expected.str());
+    }
+    EXPECT_GT(pool.getStats().jobs, 0u);
+}
+
+// Test binary exports are refused for streams
+TEST_F(TaskExporterTest, BinaryNeedsFile) {
+    TaskManager manager(repo);
+    std::ostringstream out;
+    EXPECT_THROW(TaskExporter(manager, cli).exportToStream(out, ExportFormat::BINARY),
+                 std::invalid_argument);
+}
+
+// Test a plain tasks.json is copied as is for a JSON export
+TEST_F(TaskExporterTest, CopiesMatchingFile) {
+    writeTasksFile();
+    FileTaskRepository fileRepo(jsonPath);
+    TaskManager manager(fileRepo);
+
+    TaskExporter::Result result = TaskExporter(manager, cli).exportToFile(exportPath, ExportFormat::JSON);
+
+    EXPECT_TRUE(result.copied);
+    EXPECT_EQ(readFile(exportPath), readFile(jsonPath));
+    EXPECT_EQ(result.bytes, fs::file_size(jsonPath));
+    EXPECT_FALSE(fs::exists(exportPath + ".tmp"));
+}
+
+// Test pending changes and dictionary-encoded files are streamed instead of copied
+TEST_F(TaskExporterTest, StreamsWhenFileDoesNotMatch) {
+    writeTasksFile(true);
+    {
+        FileTaskRepository fileRepo(jsonPath);
+        TaskManager manager(fileRepo);
+        TaskExporter::Result result = TaskExporter(manager, cli).exportToFile(exportPath, ExportFormat::JSON);
+        EXPECT_FALSE(result.copied);
+        EXPECT_EQ(result.tasks, 3);
+    }
+
+    writeTasksFile();
+    FileTaskRepository fileRepo(jsonPath);
+    TaskManager manager(fileRepo);
+    manager.setAutoSave(false);
+    manager.addTask("Unsaved");
+    TaskExporter::Result result = TaskExporter(manager, cli).exportToFile(exportPath, ExportFormat::JSON);
+    EXPECT_FALSE(result.copied);
+    EXPECT_EQ(result.tasks, 4);
+
+    // The export is itself a loadable tasks file
+    FileTaskRepository exported(exportPath);
+    TaskList tasks = exported.loadTasks();
+    ASSERT_EQ(tasks.size(), 4);
+    EXPECT_EQ(tasks[1].getDescription(), "Quote \" and\nnewline");
+    EXPECT_TRUE(tasks[1].isCompleted());
+    EXPECT_EQ(tasks[3].getId(), 6);
+    EXPECT_EQ(tasks[3].getDescription(), "Unsaved");
+}
+
+// Test a binary export is paged storage with the same IDs and status
+TEST_F(TaskExporterTest, ExportsBinary) {
+    writeTasksFile();
+    FileTaskRepository fileRepo(jsonPath);
+    TaskManager manager(fileRepo);
+
+    TaskExporter::Result result = TaskExporter(manager, cli).exportToFile(exportPath, ExportFormat::BINARY);
+
+    EXPECT_FALSE(result.copied);
+    EXPECT_EQ(result.tasks, 3);
+    PagedTaskRepository exported(exportPath);
+    TaskList tasks = exported.loadTasks();
+    ASSERT_EQ(tasks.size(), 3);
+    EXPECT_EQ(tasks[2].getId(), 5);
+    EXPECT_TRUE(tasks[1].isCompleted());
+    EXPECT_EQ(exported.getNextId(), 6);
+}
+
+// Test exporting over the tasks file itself is refused and leaves it intact
+TEST_F(TaskExporterTest, RefusesOwnFile) {
+    writeTasksFile();
+    std::string before = readFile(jsonPath);
+    FileTaskRepository fileRepo(jsonPath);
+    TaskManager manager(fileRepo);
+
+    EXPECT_THROW(TaskExporter(manager, cli).exportToFile(jsonPath, ExportFormat::NDJSON),
+                 std::runtime_error);
+
+    EXPECT_EQ(readFile(jsonPath), before);
+}
@@ -0,0 +1,139 @@
+#include <gtest/gtest.h>
+#include "task_follower.h"
+#include "task_manager.h"
+#include "file_task_repository.h"
+#include "cli.h"
+#include <chrono>
+#include <filesystem>
+#include <functional>
+#include <sstream>
+#include <string>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+class TaskFollowerTest : public ::testing::Test {
+protected:
+    std::string testFilePath = "test_follow_tasks.json";
+    CLI cli;
+
+    void SetUp() override {
+        fs::remove(testFilePath);
+        FileTaskRepository repo(testFilePath);
+        TaskList tasks;
+        tasks.emplace_back(1, "First", false);
+        tasks.emplace_back(2, "Second", false);
+        repo.saveTasks(tasks);
+    }
+
+    void TearDown() override {
+        fs::remove(testFilePath);
+        fs::remove(testFilePath + ".lock");
+    }
+
+    // Wait up to five seconds for a condition
+    static bool waitFor(const std::function<bool()>& condition) {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (!condition()) {
+            if (std::chrono::steady_clock::now() > deadline) {
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        return true;
+    }
+
+    // Follow the file while another writer adds a task, completes one and
+    // clears the list; returns everything the follower printed
+    std::string follow(bool polling, OutputFormat format = OutputFormat::TEXT) {
+        FileTaskRepository repo(testFilePath);
+        TaskManager manager(repo);
+        TaskFollower follower(manager, cli, testFilePath, format);
+        if (polling) {
+            follower.setPolling(std::chrono::milliseconds(20));
+        }
+        std::ostringstream out;
+        std::thread thread([&] { follower.run(out); });
+        EXPECT_TRUE(waitFor([&] { return follower.isWatching(); }));
+
+        // Each change is made once the previous one has been seen
+        FileTaskRepository writerRepo(testFilePath);
+        TaskManager writer(writerRepo);
+        writer.addTask("Third");
+        EXPECT_TRUE(waitFor([&] { return follower.getRefreshCount() >= 1; }));
+        writer.completeTask(1);
+        EXPECT_TRUE(waitFor([&] { return follower.getRefreshCount() >= 2; }));
+        writer.clearAllTasks();
+        EXPECT_TRUE(waitFor([&] { return follower.getRefreshCount() >= 3; }));
+
+        follower.stop();
+        thread.join();
+        EXPECT_FALSE(follower.isWatching());
+        return out.str();
+    }
+};
+
+// Test only added and changed tasks are printed after the initial list
+TEST_F(TaskFollowerTest, PrintsChangesWithInotify) {
+    EXPECT_EQ(follow(false), "[1] [ ] First\n"
+                             "[2] [ ] Second\n"
+                             "[3] [ ] Third\n"
+                             "[1] [X] First\n"
+                             "3 tasks removed\n");
+}
+
+// Test the polling fallback reports the same changes
+TEST_F(TaskFollowerTest, PrintsChangesWhenPolling) {
+    EXPECT_EQ(follow(true), "[1] [ ] First\n"
+                            "[2] [ ] Second\n"
+                            "[3] [ ] Third\n"
+                            "[1] [X] First\n"
+                            "3 tasks removed\n");
+}
+
+// Test machine-readable formats print the header once and no removal notes
+TEST_F(TaskFollowerTest, FollowsInCsv) {
+    EXPECT_EQ(follow(false, OutputFormat::CSV), "id,description,completed\n"
+                                                "1,First,false\n"
+                                                "2,Second,false\n"
+                                                "3,Third,false\n"
+                                                "1,First,true\n");
+}
+
+// Test adds appended in place are read from the end of the file, and any
+// other change still re-reads the whole store
+TEST_F(TaskFollowerTest, ReadsOnlyAppendedTasks) {
+    FileTaskRepository repo(testFilePath);
+    TaskManager manager(repo);
+    TaskFollower follower(manager, cli, testFilePath);
+    follower.setPolling(std::chrono::milliseconds(20));
+    std::ostringstream out;
+    std::thread thread([&] { follower.run(out); });
+    EXPECT_TRUE(waitFor([&] { return follower.isWatching(); }));
+
+    FileTaskRepository writerRepo(testFilePath);
+    writerRepo.appendTask("Third");
+    EXPECT_TRUE(waitFor([&] { return follower.getRefreshCount() >= 1; }));
+    EXPECT_EQ(follower.getTailReadCount(), 1);
+
+    TaskManager writer(writerRepo);
+    writer.completeTask(1);
+    EXPECT_TRUE(waitFor([&] { return follower.getRefreshCount() >= 2; }));
+    EXPECT_EQ(follower.getTailReadCount(), 1);
+
+    TaskList more;
+    more.emplace_back(0, "Fourth", false);
+    more.emplace_back(0, "Fifth", true);
+    writerRepo.appendTasks(more);
+    EXPECT_TRUE(waitFor([&] { return follower.getRefreshCount() >= 3; }));
+    EXPECT_EQ(follower.getTailReadCount(), 2);
+
+    follower.stop();
+    thread.join();
+    EXPECT_EQ(out.str(), "[1] [ ] First\n"
+                         "[2] [ ] Second\n"
+                         "[3] [ ] Third\n"
+                         "[1] [X] First\n"
+                         "[4] [ ] Fourth\n"
+                         "[5] [X] Fifth\n");
+}
@@ -0,0 +1,220 @@
+#include <gtest/gtest.h>
+#include "task_importer.h"
+#include "task_manager.h"
+#include "mock_task_repository.h"
+#include "file_task_repository.h"
+#include "paged_task_repository.h"
+#include "work_stealing_pool.h"
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+namespace fs = std::filesystem;
+
+class TaskImporterTest : public ::testing::Test {
+protected:
+    MockTaskRepository repo;
+};
+
+// Test CSV as list --format=csv writes it, with quoted commas, quotes and line breaks
+TEST_F(TaskImporterTest, ImportsCsv) {
+    TaskManager manager(repo);
+    manager.addTask("Existing");
+    std::stringstream in("id,description,completed\n"
+                         "7,\"Hello, world\",true\n"
+                         "8,\"Two\nlines \"\"quoted\"\"\",false\r\n"
+                         "\n"
+                         "9,Plain,\n");
+
+    TaskImporter::Result result = TaskImporter(manager).run(in);
+
+    EXPECT_TRUE(result.error.empty());
+    EXPECT_EQ(result.tasks, 3);
+    EXPECT_EQ(result.firstId, 2);
+    TaskList tasks = manager.listTasks();
+    ASSERT_EQ(tasks.size(), 4);
+    EXPECT_EQ(tasks[1].getId(), 2);
+    EXPECT_EQ(tasks[1].getDescription(), "Hello, world");
+    EXPECT_TRUE(tasks[1].isCompleted());
+    EXPECT_EQ(tasks[2].getDescription(), "Two\nlines \"quoted\"");
+    EXPECT_FALSE(tasks[2].isCompleted());
+    EXPECT_EQ(tasks[3].getId(), 4);
+    EXPECT_EQ(tasks[3].getDescription(), "Plain");
+}
+
+// Test TSV is detected from the header and unescaped
+TEST_F(TaskImporterTest, ImportsTsv) {
+    TaskManager manager(repo);
+    std::stringstream in("description\tcompleted\n"
+                         "Tab\\there\t1\n"
+                         "Back\\\\slash\\nnewline\t0\n");
+
+    TaskImporter::Result result = TaskImporter(manager).run(in);
+
+    EXPECT_TRUE(result.error.empty());
+    TaskList tasks = manager.listTasks();
+    ASSERT_EQ(tasks.size(), 2);
+    EXPECT_EQ(tasks[0].getDescription(), "Tab\there");
+    EXPECT_TRUE(tasks[0].isCompleted());
+    EXPECT_EQ(tasks[1].getDescription(), "Back\\slash\nnewline");
+}
+
+// Test NDJSON is detected, unescaped, and unknown members are skipped
+TEST_F(TaskImporterTest, ImportsNdjson) {
+    TaskManager manager(repo);
+    std::stringstream in("{\"id\":5,\"description\":\"Caf\\u00e9 \\\"au lait\\\"\",\"completed\":true}\n"
+                         "{\"tags\":{\"description\":1},\"description\":\"Second\"}\n");
+
+    TaskImporter::Result result = TaskImporter(manager).run(in);
+
+    EXPECT_TRUE(result.error.empty());
+    TaskList tasks = manager.listTasks();
+    ASSERT_EQ(tasks.size(), 2);
+    EXPECT_EQ(tasks[0].getId(), 1);
+    EXPECT_EQ(tasks[0].getDescription(), "Caf\xc3\xa9 \"au lait\"");
+    EXPECT_TRUE(tasks[0].isCompleted());
+    EXPECT_EQ(tasks[1].getDescription(), "Second");
+    EXPECT_FALSE(tasks[1].isCompleted());
+}
+
+// Test a malformed record stops the import, keeping what came before it
+TEST_F(TaskImporterTest, MalformedRecordKeepsEarlierTasks) {
+    TaskManager manager(repo);
+    std::stringstream in("{\"description\":\"Good\"}\n"
+                         "{\"description\":42}\n"
+                         "{\"description\":\"Never read\"}\n");
+
+    TaskImporter::Result result = TaskImporter(manager).run(in);
+
+    EXPECT_EQ(result.error, "line 2: \"description\" must be a string");
+    EXPECT_EQ(result.tasks, 1);
+    ASSERT_EQ(manager.listTasks().size(), 1);
+    EXPECT_EQ(repo.loadTasks().size(), 1);
+}
+
+// Test NDJSON parsed on a pool keeps the input order across blocks and
+// stops at the first malformed record
+TEST_F(TaskImporterTest, ParsesNdjsonOnPool) {
+    WorkStealingPool pool(4);
+    TaskManager manager(repo);
+    manager.setThreadPool(&pool);
+    std::stringstream in;
+    for (int i = 1; i <= 3000; i++) {
+        if (i == 2500) {
+            in << "{\"description\":false}\n";
+        } else {
+            in << "{\"description\":\"Task " << i << "\",\"completed\":" << (i % 2 == 0 ? "true" : "false") << "}\n";
+        }
+    }
+
+    TaskImporter::Result result = TaskImporter(manager, 1000).run(in);
+
+    EXPECT_EQ(result.error, "line 2500: \"description\" must be a string");
+    EXPECT_EQ(result.tasks, 2499);
+    TaskList tasks = manager.listTasks();
+    ASSERT_EQ(tasks.size(), 2499);
+    for (int i = 1; i <= 2499; i++) {
+        ASSERT_EQ(tasks[i - 1].getDescription(), "Task " + std::to_string(i));
+        ASSERT_EQ(tasks[i - 1].isCompleted(), i % 2 == 0);
+    }
+}
+
+// Test CSV without a description column and with bad values is rejected
+TEST_F(TaskImporterTest, RejectsBadCsv) {
+    TaskManager manager(repo);
+    std::stringstream noDescription("id,completed\n1,true\n");
+    EXPECT_EQ(TaskImporter(manager).run(noDescription).error,
+              "line 1: header has no \"description\" column");
+
+    std::stringstream badCompleted("description,completed\nTask,maybe\n");
+    EXPECT_EQ(TaskImporter(manager).run(badCompleted).error,
+              "line 2: invalid completed value: maybe");
+
+    std::stringstream unterminated("description\n\"Open quote\n");
+    EXPECT_EQ(TaskImporter(manager).run(unterminated).error,
+              "line 2: unterminated quoted field");
+
+    EXPECT_TRUE(manager.listTasks().empty());
+}
+
+// Test an in-memory repository is saved once for the whole import
+TEST_F(TaskImporterTest, SavesOnceWhenNotAppending) {
+    TaskManager manager(repo);
+    std::stringstream in;
+    for (int i = 0; i < 100; i++) {
+        in << "{\"description\":\"Task " << i << "\"}\n";
+    }
+
+    TaskImporter::Result result = TaskImporter(manager, 8).run(in);
+
+    EXPECT_EQ(result.tasks, 100);
+    EXPECT_EQ(repo.getSaveCount(), 1);
+    EXPECT_TRUE(manager.isAutoSaveEnabled());
+    EXPECT_EQ(repo.loadTasks().size(), 100);
+}
+
+// Test a plain tasks.json is appended to block by block without being loaded
+TEST_F(TaskImporterTest, AppendsBlocksToJsonFile) {
+    std::string path = "test_import_tasks.json";
+    fs::remove(path);
+    {
+        FileTaskRepository seed(path);
+        TaskList tasks;
+        tasks.emplace_back(1, "Existing", false);
+        seed.saveTasks(tasks);
+    }
+
+    FileTaskRepository fileRepo(path);
+    TaskManager manager(fileRepo);
+    std::stringstream in;
+    in << "description\n";
+    for (int i = 0; i < 25; i++) {
+        in << "Task " << i << "\n";
+    }
+    TaskImporter::Result result = TaskImporter(manager, 10).run(in);
+
+    EXPECT_TRUE(result.error.empty());
+    EXPECT_EQ(result.firstId, 2);
+    FileTaskRepository reopened(path);
+    TaskList tasks = reopened.loadTasks();
+    ASSERT_EQ(tasks.size(), 26);
+    EXPECT_EQ(tasks[25].getId(), 26);
+    EXPECT_EQ(tasks[25].getDescription(), "Task 24");
+    EXPECT_EQ(reopened.getNextId(), 27);
+    fs::remove(path);
+    fs::remove(path + ".lock");
+}
+
+// Test paged storage takes the import in blocks with consecutive IDs
+TEST_F(TaskImporterTest, AppendsBlocksToPagedStorage) {
+    std::string path = "test_import_tasks.db";
+    fs::remove(path);
+    {
+        PagedTaskRepository pagedRepo(path, 4 * PagedTaskRepository::kPageSize);
+        TaskManager manager(pagedRepo);
+        manager.addTask("Existing");
+        std::stringstream in;
+        for (int i = 0; i < 5000; i++) {
+            in << "{\"description\":\"Task " << i << "\",\"completed\":" << (i % 2 ? "true" : "false") << "}\n";
+        }
+
+        TaskImporter::Result result = TaskImporter(manager, 1000).run(in);
+
+        EXPECT_TRUE(result.error.empty());
+        EXPECT_EQ(result.firstId, 2);
+        EXPECT_EQ(pagedRepo.getTaskCount(), 5001);
+    }
+
+    PagedTaskRepository reopened(path);
+    EXPECT_EQ(reopened.getTaskCount(), 5001);
+    EXPECT_EQ(reopened.getNextId(), 5002);
+    int expected = 1;
+    bool ordered = true;
+    reopened.forEachTask([&](const TaskView& task) {
+        ordered = ordered && task.id == expected++;
+    });
+    EXPECT_TRUE(ordered);
+    fs::remove(path);
+    fs::remove(path + ".lock");
+}
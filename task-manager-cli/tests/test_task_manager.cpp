@@ -2,7 +2,16 @@
 #include "task_manager.h"
 #include "mock_task_repository.h"
 #include "file_task_repository.h"
+#include "cli.h"
+#include "counting_memory_resource.h"
 #include <filesystem>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <set>
+#include <thread>
+#include <vector>
 
 namespace fs = std::filesystem;
 
@@ -25,6 +34,7 @@ protected:
         if (fs::exists(testFilePath)) {
             fs::remove(testFilePath);
         }
+        fs::remove(testFilePath + ".lock");
     }
 };
 
@@ -37,7 +47,7 @@ TEST_F(TaskManagerTest, AddTask) {
     
     EXPECT_EQ(taskId, 1);
     
-    std::vector<Task> tasks = manager.listTasks();
+    TaskList tasks = manager.listTasks();
     ASSERT_EQ(tasks.size(), 1);
     EXPECT_EQ(tasks[0].getId(), 1);
     EXPECT_EQ(tasks[0].getDescription(), "Buy groceries");
@@ -57,7 +67,7 @@ TEST_F(TaskManagerTest, AddMultipleTasks) {
     EXPECT_EQ(id2, 2);
     EXPECT_EQ(id3, 3);
     
-    std::vector<Task> tasks = manager.listTasks();
+    TaskList tasks = manager.listTasks();
     ASSERT_EQ(tasks.size(), 3);
 }
 
@@ -70,7 +80,7 @@ TEST_F(TaskManagerTest, AddTaskEmptyDescription) {
     
     EXPECT_EQ(taskId, 1);
     
-    std::vector<Task> tasks = manager.listTasks();
+    TaskList tasks = manager.listTasks();
     ASSERT_EQ(tasks.size(), 1);
     EXPECT_EQ(tasks[0].getDescription(), "");
 }
@@ -80,7 +90,7 @@ TEST_F(TaskManagerTest, ListTasksEmpty) {
     MockTaskRepository repo;
     TaskManager manager(repo);
     
-    std::vector<Task> tasks = manager.listTasks();
+    TaskList tasks = manager.listTasks();
     EXPECT_TRUE(tasks.empty());
 }
 
@@ -94,7 +104,7 @@ TEST_F(TaskManagerTest, CompleteTask) {
     bool success = manager.completeTask(1);
     EXPECT_TRUE(success);
     
-    std::vector<Task> tasks = manager.listTasks();
+    TaskList tasks = manager.listTasks();
     ASSERT_EQ(tasks.size(), 1);
     EXPECT_TRUE(tasks[0].isCompleted());
 }
@@ -119,7 +129,7 @@ TEST_F(TaskManagerTest, CompleteSpecificTask) {
     
     manager.completeTask(2);
     
-    std::vector<Task> tasks = manager.listTasks();
+    TaskList tasks = manager.listTasks();
     ASSERT_EQ(tasks.size(), 3);
     EXPECT_FALSE(tasks[0].isCompleted()); // Task 1
     EXPECT_TRUE(tasks[1].isCompleted());  // Task 2
@@ -141,7 +151,7 @@ TEST_F(TaskManagerPersistenceTest, PersistenceAcrossRestarts) {
         FileTaskRepository repo(testFilePath);
         TaskManager manager(repo);
         
-        std::vector<Task> tasks = manager.listTasks();
+        TaskList tasks = manager.listTasks();
         ASSERT_EQ(tasks.size(), 1);
         EXPECT_EQ(tasks[0].getDescription(), "Persistent task");
         EXPECT_TRUE(tasks[0].isCompleted());
@@ -243,7 +253,7 @@ TEST_F(TaskManagerTest, TaskOrderingPreserved) {
     manager.addTask("Second task");
     manager.addTask("Third task");
     
-    std::vector<Task> tasks = manager.listTasks();
+    TaskList tasks = manager.listTasks();
     ASSERT_EQ(tasks.size(), 3);
     EXPECT_EQ(tasks[0].getDescription(), "First task");
     EXPECT_EQ(tasks[1].getDescription(), "Second task");
@@ -263,7 +273,7 @@ TEST_F(TaskManagerTest, CompleteMultipleTasks) {
     manager.completeTask(2);
     manager.completeTask(4);
     
-    std::vector<Task> tasks = manager.listTasks();
+    TaskList tasks = manager.listTasks();
     ASSERT_EQ(tasks.size(), 4);
     EXPECT_FALSE(tasks[0].isCompleted());
     EXPECT_TRUE(tasks[1].isCompleted());
@@ -280,10 +290,259 @@ TEST_F(TaskManagerTest, RepositorySavesCorrectly) {
     
     // Verify the repository persists correctly by creating a new manager instance
     TaskManager manager2(repo);
-    std::vector<Task> tasks = manager2.listTasks();
+    TaskList tasks = manager2.listTasks();
     
     ASSERT_EQ(tasks.size(), 1);
     EXPECT_EQ(tasks[0].getId(), 1);
     EXPECT_EQ(tasks[0].getDescription(), "Test task");
     EXPECT_FALSE(tasks[0].isCompleted());
 }
+
+// Test the manager allocates task storage from the memory resource it was given
+TEST_F(TaskManagerTest, AllocatesFromProvidedMemoryResource) {
+    MockTaskRepository repo;
+    CountingMemoryResource resource;
+    TaskManager manager(repo, &resource);
+
+    manager.addTask("A task description that does not fit in the small string buffer");
+
+    TaskList tasks = manager.listTasks();
+    ASSERT_EQ(tasks.size(), 1);
+    EXPECT_EQ(tasks.get_allocator().resource(), &resource);
+    EXPECT_EQ(tasks[0].get_allocator().resource(), &resource);
+    EXPECT_GT(resource.allocationCount(), 0);
+}
+
+// Test a whole command can run out of a single monotonic arena
+TEST_F(TaskManagerPersistenceTest, RunsOnMonotonicArena) {
+    // The null upstream makes any allocation outside the arena buffer throw
+    std::array<std::byte, 16 * 1024> buffer;
+    std::pmr::monotonic_buffer_resource arena(buffer.data(), buffer.size(),
+                                              std::pmr::null_memory_resource());
+    {
+        FileTaskRepository repo(testFilePath);
+        TaskManager manager(repo, &arena);
+
+        manager.addTask("Task 1");
+        manager.addTask("Task 2");
+        manager.completeTask(1);
+
+        TaskList tasks = manager.listTasks();
+        ASSERT_EQ(tasks.size(), 2);
+        EXPECT_TRUE(tasks[0].isCompleted());
+    }
+}
+
+// Test a description is allocated once end to end, from CLI parsing to the task list
+TEST_F(TaskManagerTest, SingleAllocationPerNewDescription) {
+    MockTaskRepository repo;
+    CountingMemoryResource resource;
+    TaskManager manager(repo, &resource);
+    CLI cli;
+
+    const char* argv[] = {"task-manager", "add", "Rotate", "the", "application", "logs"};
+    for (int i = 0; i < 10; i++) {
+        Command cmd = cli.parseCommand(6, const_cast<char**>(argv), &resource);
+        manager.addTask(std::move(cmd.argument));
+    }
+
+    EXPECT_EQ(resource.stringAllocationCount(), 10);
+    ASSERT_EQ(manager.listTasks().size(), 10);
+}
+
+// Test tasks added with an interner share the stored description
+TEST_F(TaskManagerTest, AddTaskWithInternerSharesDescriptions) {
+    MockTaskRepository repo;
+    StringInterner interner;
+    TaskManager manager(repo, std::pmr::get_default_resource(), &interner);
+
+    manager.addTask("Rotate logs");
+    manager.addTask(std::pmr::string("Rotate logs"));
+    manager.addTask("Renew certificates");
+
+    TaskList tasks = manager.listTasks();
+    ASSERT_EQ(tasks.size(), 3);
+    EXPECT_EQ(tasks[0].getDescription().data(), tasks[1].getDescription().data());
+    EXPECT_EQ(tasks[2].getDescription(), "Renew certificates");
+    EXPECT_EQ(interner.size(), 2);
+}
+
+// Test constructing a manager does not read the repository
+TEST_F(TaskManagerTest, ConstructionDoesNotLoad) {
+    MockTaskRepository repo;
+    TaskManager manager(repo);
+
+    EXPECT_EQ(repo.getLoadCount(), 0);
+
+    manager.listTasks();
+    manager.listTasks();
+    EXPECT_EQ(repo.getLoadCount(), 1);
+}
+
+// Test clearing writes an empty list without reading the old one
+TEST_F(TaskManagerTest, ClearDoesNotLoad) {
+    MockTaskRepository repo;
+    repo.saveTasks(TaskList{Task(1, "Old task", false)});
+    TaskManager manager(repo);
+
+    manager.clearAllTasks();
+
+    EXPECT_EQ(repo.getLoadCount(), 0);
+    EXPECT_TRUE(manager.listTasks().empty());
+    EXPECT_EQ(manager.addTask("New task"), 1);
+}
+
+// Test adding through a repository that appends needs only the ID counter
+TEST_F(TaskManagerPersistenceTest, AddAppendsWithoutLoading) {
+    {
+        FileTaskRepository repo(testFilePath);
+        repo.saveTasks(TaskList{Task(1, "First", false), Task(7, "Seventh", true)});
+    }
+
+    // Counts full loads of the file
+    class CountingFileRepository : public FileTaskRepository {
+    public:
+        using FileTaskRepository::FileTaskRepository;
+        int loads = 0;
+        TaskList loadTasks(std::pmr::memory_resource* resource, StringInterner* interner) override {
+            loads++;
+            return FileTaskRepository::loadTasks(resource, interner);
+        }
+    };
+
+    CountingFileRepository repo(testFilePath);
+    TaskManager manager(repo);
+
+    EXPECT_EQ(manager.addTask("Eighth"), 8);
+    EXPECT_EQ(manager.addTask(std::pmr::string("Ninth")), 9);
+    EXPECT_EQ(repo.loads, 0);
+
+    TaskList tasks = manager.listTasks();
+    EXPECT_EQ(repo.loads, 1);
+    ASSERT_EQ(tasks.size(), 4);
+    EXPECT_EQ(tasks[3].getDescription(), "Ninth");
+
+    // Once loaded, new tasks are still appended rather than rewriting the file
+    EXPECT_EQ(manager.addTask("Tenth"), 10);
+    EXPECT_EQ(manager.listTasks().size(), 5);
+    FileTaskRepository reader(testFilePath);
+    EXPECT_EQ(reader.loadTasks().size(), 5);
+}
+
+// Test looking up a task copies it out, and reports IDs that do not exist
+TEST_F(TaskManagerTest, FindTask) {
+    MockTaskRepository repo;
+    TaskManager manager(repo);
+    manager.addTask("First");
+    manager.addTask("Second");
+    manager.completeTask(2);
+
+    std::optional<Task> task = manager.findTask(2);
+    ASSERT_TRUE(task.has_value());
+    EXPECT_EQ(task->getDescription(), "Second");
+    EXPECT_TRUE(task->isCompleted());
+    EXPECT_FALSE(manager.findTask(3).has_value());
+}
+
+// Test readers of the loaded list do not wait for each other
+TEST_F(TaskManagerTest, ReadersRunInParallel) {
+    MockTaskRepository repo;
+    TaskManager manager(repo);
+    manager.addTask("Shared");
+
+    // Each reader stays in its visitor until the other one is in its own,
+    // which only finishes if both hold the manager at once
+    std::atomic<int> inside{0};
+    auto read = [&] {
+        manager.forEachTask([&](const TaskView&) {
+            inside++;
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+            while (inside.load() < 2 && std::chrono::steady_clock::now() < deadline) {
+                std::this_thread::yield();
+            }
+        });
+    };
+    std::thread other(read);
+    read();
+    other.join();
+
+    EXPECT_EQ(inside.load(), 2);
+}
+
+// Test concurrent writers get unique IDs and readers always see a whole list
+TEST_F(TaskManagerTest, ConcurrentReadersAndWriters) {
+    constexpr int kWriters = 4;
+    constexpr int kReaders = 4;
+    constexpr int kTasksPerWriter = 200;
+    MockTaskRepository repo;
+    TaskManager manager(repo);
+    manager.setAutoSave(false);
+
+    std::atomic<bool> consistent{true};
+    std::atomic<int> writersDone{0};
+    std::vector<std::thread> threads;
+    for (int w = 0; w < kWriters; w++) {
+        threads.emplace_back([&] {
+            for (int i = 0; i < kTasksPerWriter; i++) {
+                int id = manager.addTask("Task");
+                if (i % 2 == 0) {
+                    manager.completeTask(id);
+                }
+            }
+            writersDone++;
+        });
+    }
+    for (int r = 0; r < kReaders; r++) {
+        threads.emplace_back([&] {
+            while (writersDone.load() < kWriters) {
+                // IDs are handed out in order, so any whole list is 1..n
+                TaskList tasks = manager.listTasks();
+                for (std::size_t i = 0; i < tasks.size(); i++) {
+                    if (tasks[i].getId() != static_cast<int>(i) + 1) {
+                        consistent = false;
+                    }
+                }
+                if (!tasks.empty() && !manager.findTask(static_cast<int>(tasks.size())).has_value()) {
+                    consistent = false;
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    EXPECT_TRUE(consistent.load());
+    TaskList tasks = manager.listTasks();
+    ASSERT_EQ(tasks.size(), kWriters * kTasksPerWriter);
+    std::set<int> ids;
+    int completed = 0;
+    for (const auto& task : tasks) {
+        ids.insert(task.getId());
+        completed += task.isCompleted() ? 1 : 0;
+    }
+    EXPECT_EQ(ids.size(), tasks.size());
+    EXPECT_EQ(completed, kWriters * kTasksPerWriter / 2);
+}
+
+// Test a thread holding the manager's lock keeps other threads' changes out
+// while it can still call into the manager itself
+TEST_F(TaskManagerTest, LockKeepsOtherThreadsOut) {
+    MockTaskRepository repo;
+    TaskManager manager(repo);
+
+    std::atomic<bool> added{false};
+    manager.lock(LockMode::EXCLUSIVE);
+    std::thread other([&] {
+        manager.addTask("Other");
+        added = true;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_FALSE(added.load());
+    EXPECT_EQ(manager.addTask("Holder"), 1);
+    manager.unlock();
+    other.join();
+
+    EXPECT_TRUE(added.load());
+    EXPECT_EQ(manager.listTasks().size(), 2);
+}
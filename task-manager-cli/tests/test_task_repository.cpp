@@ -1,8 +1,11 @@
 #include <gtest/gtest.h>
 #include "file_task_repository.h"
 #include "task.h"
+#include "counting_memory_resource.h"
 #include <filesystem>
 #include <fstream>
+#include <iterator>
+#include <nlohmann/json.hpp>
 
 namespace fs = std::filesystem;
 
@@ -24,13 +27,14 @@ protected:
         if (fs::exists(testFilePath)) {
             fs::remove(testFilePath);
         }
+        fs::remove(testFilePath + ".lock");
     }
 };
 
 // Test loading from non-existent file (should create empty file)
 TEST_F(TaskRepositoryTest, LoadFromNonExistentFile) {
     FileTaskRepository repo(testFilePath);
-    std::vector<Task> tasks = repo.loadTasks();
+    TaskList tasks = repo.loadTasks();
     
     EXPECT_TRUE(tasks.empty());
     EXPECT_TRUE(fs::exists(testFilePath));
@@ -40,7 +44,7 @@ TEST_F(TaskRepositoryTest, LoadFromNonExistentFile) {
 TEST_F(TaskRepositoryTest, SaveAndLoadTasks) {
     FileTaskRepository repo(testFilePath);
     
-    std::vector<Task> tasksToSave = {
+    TaskList tasksToSave = {
         Task(1, "Task 1", false),
         Task(2, "Task 2", true),
         Task(3, "Task 3", false)
@@ -48,7 +52,7 @@ TEST_F(TaskRepositoryTest, SaveAndLoadTasks) {
     
     repo.saveTasks(tasksToSave);
     
-    std::vector<Task> loadedTasks = repo.loadTasks();
+    TaskList loadedTasks = repo.loadTasks();
     
     ASSERT_EQ(loadedTasks.size(), 3);
     EXPECT_EQ(loadedTasks[0].getId(), 1);
@@ -75,7 +79,7 @@ TEST_F(TaskRepositoryTest, LoadFromExistingFile) {
     file.close();
     
     FileTaskRepository repo(testFilePath);
-    std::vector<Task> tasks = repo.loadTasks();
+    TaskList tasks = repo.loadTasks();
     
     ASSERT_EQ(tasks.size(), 2);
     EXPECT_EQ(tasks[0].getId(), 10);
@@ -99,7 +103,7 @@ TEST_F(TaskRepositoryTest, GetNextIdEmpty) {
 TEST_F(TaskRepositoryTest, GetNextIdWithExistingTasks) {
     FileTaskRepository repo(testFilePath);
     
-    std::vector<Task> tasks = {
+    TaskList tasks = {
         Task(1, "Task 1", false),
         Task(5, "Task 5", false),
         Task(3, "Task 3", false)
@@ -115,10 +119,10 @@ TEST_F(TaskRepositoryTest, GetNextIdWithExistingTasks) {
 TEST_F(TaskRepositoryTest, SaveEmptyList) {
     FileTaskRepository repo(testFilePath);
     
-    std::vector<Task> emptyTasks;
+    TaskList emptyTasks;
     repo.saveTasks(emptyTasks);
     
-    std::vector<Task> loadedTasks = repo.loadTasks();
+    TaskList loadedTasks = repo.loadTasks();
     EXPECT_TRUE(loadedTasks.empty());
 }
 
@@ -127,17 +131,17 @@ TEST_F(TaskRepositoryTest, MultipleSaveLoadCycles) {
     FileTaskRepository repo(testFilePath);
     
     // First save
-    std::vector<Task> tasks1 = {Task(1, "First", false)};
+    TaskList tasks1 = {Task(1, "First", false)};
     repo.saveTasks(tasks1);
     
     // Second save (overwrites)
-    std::vector<Task> tasks2 = {
+    TaskList tasks2 = {
         Task(1, "First", true),
         Task(2, "Second", false)
     };
     repo.saveTasks(tasks2);
     
-    std::vector<Task> loaded = repo.loadTasks();
+    TaskList loaded = repo.loadTasks();
     
     ASSERT_EQ(loaded.size(), 2);
     EXPECT_TRUE(loaded[0].isCompleted()); // Should reflect the update
@@ -149,7 +153,7 @@ TEST_F(TaskRepositoryTest, ResetIdCounter) {
     FileTaskRepository repo(testFilePath);
     
     // Add some tasks with high IDs
-    std::vector<Task> tasks = {
+    TaskList tasks = {
         Task(5, "Task 5", false),
         Task(10, "Task 10", false)
     };
@@ -173,3 +177,217 @@ TEST_F(TaskRepositoryTest, ResetIdCounterOnEmpty) {
     
     EXPECT_EQ(repo.getNextId(), 1);
 }
+
+// Test loaded tasks are allocated from the provided memory resource
+TEST_F(TaskRepositoryTest, LoadTasksUsesProvidedMemoryResource) {
+    FileTaskRepository repo(testFilePath);
+    TaskList tasks = {
+        Task(1, "First task with a description past the small string buffer", false),
+        Task(2, "Second task with a description past the small string buffer", true)
+    };
+    repo.saveTasks(tasks);
+
+    CountingMemoryResource resource;
+    TaskList loaded = repo.loadTasks(&resource);
+
+    ASSERT_EQ(loaded.size(), 2);
+    EXPECT_EQ(loaded.get_allocator().resource(), &resource);
+    EXPECT_EQ(loaded[0].get_allocator().resource(), &resource);
+    EXPECT_EQ(loaded[1].get_allocator().resource(), &resource);
+    EXPECT_GT(resource.allocationCount(), 0);
+}
+
+// Test loading copies each description exactly once
+TEST_F(TaskRepositoryTest, LoadTasksAllocatesOncePerDescription) {
+    FileTaskRepository repo(testFilePath);
+    TaskList tasks = {
+        Task(1, "First task with a description past the small string buffer", false),
+        Task(2, "Second task with a description past the small string buffer", true),
+        Task(3, "Third task with a description past the small string buffer", false)
+    };
+    repo.saveTasks(tasks);
+
+    CountingMemoryResource resource;
+    TaskList loaded = repo.loadTasks(&resource);
+
+    ASSERT_EQ(loaded.size(), 3);
+    EXPECT_EQ(resource.stringAllocationCount(), 3);
+}
+
+// Test dictionary-encoded files round-trip tasks
+TEST_F(TaskRepositoryTest, DictionaryEncodingRoundTrip) {
+    FileTaskRepository repo(testFilePath);
+    repo.setDictionaryEncoding(true);
+
+    TaskList tasks = {
+        Task(1, "Rotate logs", false),
+        Task(2, "Renew certificates", true),
+        Task(3, "Rotate logs", true)
+    };
+    repo.saveTasks(tasks);
+
+    FileTaskRepository reader(testFilePath);
+    TaskList loaded = reader.loadTasks();
+
+    EXPECT_TRUE(reader.usesDictionaryEncoding());
+    ASSERT_EQ(loaded.size(), 3);
+    EXPECT_EQ(loaded[0].getId(), 1);
+    EXPECT_EQ(loaded[0].getDescription(), "Rotate logs");
+    EXPECT_FALSE(loaded[0].isCompleted());
+    EXPECT_EQ(loaded[1].getDescription(), "Renew certificates");
+    EXPECT_TRUE(loaded[1].isCompleted());
+    EXPECT_EQ(loaded[2].getDescription(), "Rotate logs");
+    EXPECT_EQ(reader.getNextId(), 4);
+}
+
+// Test identical descriptions are written once in a dictionary section
+TEST_F(TaskRepositoryTest, DictionaryEncodingWritesDescriptionsOnce) {
+    FileTaskRepository repo(testFilePath);
+    repo.setDictionaryEncoding(true);
+
+    TaskList tasks;
+    for (int i = 1; i <= 50; i++) {
+        tasks.emplace_back(i, i % 2 ? "Rotate logs" : "Renew certificates", false);
+    }
+    repo.saveTasks(tasks);
+
+    std::ifstream file(testFilePath);
+    nlohmann::json j;
+    file >> j;
+    ASSERT_TRUE(j.is_object());
+    EXPECT_EQ(j["descriptions"].size(), 2);
+    EXPECT_EQ(j["tasks"].size(), 50);
+
+    const FileTaskRepository::DictionaryStats& stats = repo.getDictionaryStats();
+    EXPECT_EQ(stats.descriptions, 50);
+    EXPECT_EQ(stats.uniqueDescriptions, 2);
+    EXPECT_EQ(stats.savedBytes, 24 * std::string("Rotate logs").size() +
+                                24 * std::string("Renew certificates").size());
+}
+
+// Test dictionary-encoded file is smaller than the plain array for repeated descriptions
+TEST_F(TaskRepositoryTest, DictionaryEncodingShrinksRepeatedDescriptions) {
+    TaskList tasks;
+    for (int i = 1; i <= 200; i++) {
+        tasks.emplace_back(i, "Rotate the application logs and archive them", false);
+    }
+
+    FileTaskRepository plain(testFilePath);
+    plain.saveTasks(tasks);
+    auto plainSize = fs::file_size(testFilePath);
+
+    FileTaskRepository dictionary(testFilePath);
+    dictionary.setDictionaryEncoding(true);
+    dictionary.saveTasks(tasks);
+    auto dictionarySize = fs::file_size(testFilePath);
+
+    EXPECT_LT(dictionarySize, plainSize);
+}
+
+// Test loading through an interner shares storage between identical descriptions
+TEST_F(TaskRepositoryTest, LoadTasksWithInterner) {
+    FileTaskRepository repo(testFilePath);
+    repo.setDictionaryEncoding(true);
+    TaskList tasks = {
+        Task(1, "Rotate the application logs", false),
+        Task(2, "Rotate the application logs", false)
+    };
+    repo.saveTasks(tasks);
+
+    StringInterner interner;
+    CountingMemoryResource resource;
+    TaskList loaded = repo.loadTasks(&resource, &interner);
+
+    ASSERT_EQ(loaded.size(), 2);
+    EXPECT_EQ(loaded[0].getDescription().data(), loaded[1].getDescription().data());
+    EXPECT_EQ(resource.stringAllocationCount(), 0);
+    EXPECT_EQ(interner.size(), 1);
+}
+
+// Test appending writes the task into the existing file
+TEST_F(TaskRepositoryTest, AppendTaskToExistingFile) {
+    {
+        FileTaskRepository writer(testFilePath);
+        writer.saveTasks(TaskList{Task(3, "Third", false), Task(12, "Twelfth", true), Task(5, "Fifth", false)});
+    }
+
+    // A fresh repository scans the IDs to continue after the largest
+    FileTaskRepository repo(testFilePath);
+    EXPECT_TRUE(repo.supportsAppend());
+    EXPECT_EQ(repo.appendTask("Say \"hi\""), 13);
+    EXPECT_EQ(repo.appendTask("Another"), 14);
+
+    FileTaskRepository reader(testFilePath);
+    TaskList tasks = reader.loadTasks();
+    ASSERT_EQ(tasks.size(), 5);
+    EXPECT_EQ(tasks[3].getId(), 13);
+    EXPECT_EQ(tasks[3].getDescription(), "Say \"hi\"");
+    EXPECT_FALSE(tasks[3].isCompleted());
+    EXPECT_EQ(tasks[4].getId(), 14);
+}
+
+// Test appending to an empty array and to a missing file
+TEST_F(TaskRepositoryTest, AppendTaskToEmptyAndMissingFile) {
+    FileTaskRepository repo(testFilePath);
+    EXPECT_EQ(repo.appendTask("Created the file"), 1);
+
+    std::ofstream(testFilePath) << "[ ]  \n\n";
+    FileTaskRepository emptyRepo(testFilePath);
+    EXPECT_EQ(emptyRepo.appendTask("Into empty array"), 1);
+    EXPECT_EQ(emptyRepo.appendTask("Second"), 2);
+
+    TaskList tasks = FileTaskRepository(testFilePath).loadTasks();
+    ASSERT_EQ(tasks.size(), 2);
+    EXPECT_EQ(tasks[0].getDescription(), "Into empty array");
+}
+
+// Test dictionary-encoded files are rewritten in their own format
+TEST_F(TaskRepositoryTest, AppendTaskToDictionaryFile) {
+    {
+        FileTaskRepository writer(testFilePath);
+        writer.setDictionaryEncoding(true);
+        writer.saveTasks(TaskList{Task(1, "Rotate logs", false)});
+    }
+
+    FileTaskRepository repo(testFilePath);
+    EXPECT_EQ(repo.appendTask("Rotate logs"), 2);
+
+    FileTaskRepository reader(testFilePath);
+    TaskList tasks = reader.loadTasks();
+    EXPECT_TRUE(reader.usesDictionaryEncoding());
+    ASSERT_EQ(tasks.size(), 2);
+    EXPECT_EQ(tasks[1].getDescription(), "Rotate logs");
+}
+
+// Test a file an append was cut short in loads its whole records, and the
+// next append writes it whole again
+TEST_F(TaskRepositoryTest, RecoversFromShortAppendWrite) {
+    {
+        FileTaskRepository writer(testFilePath);
+        writer.saveTasks(TaskList{Task(1, "First", false), Task(2, "Second", true)});
+    }
+    std::string whole;
+    {
+        std::ifstream file(testFilePath, std::ios::binary);
+        whole.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+    std::string kept = whole.substr(0, whole.rfind(']'));
+    kept.erase(kept.find_last_not_of(" \n") + 1);
+
+    // Writes ended part way into a record with a "}" in its description,
+    // and just after the comma over the old closing bracket
+    for (const std::string& torn : {kept + ",\n  {\"completed\":false,\"description\":\"a } b",
+                                    kept + ",]"}) {
+        std::ofstream(testFilePath, std::ios::binary | std::ios::trunc) << torn;
+
+        TaskList tasks = FileTaskRepository(testFilePath).loadTasks();
+        ASSERT_EQ(tasks.size(), 2u);
+        EXPECT_EQ(tasks[1].getDescription(), "Second");
+
+        FileTaskRepository repo(testFilePath);
+        EXPECT_EQ(repo.appendTask("Third"), 3);
+        tasks = FileTaskRepository(testFilePath).loadTasks();
+        ASSERT_EQ(tasks.size(), 3u);
+        EXPECT_EQ(tasks[2].getDescription(), "Third");
+    }
+}
@@ -0,0 +1,276 @@
+#include <gtest/gtest.h>
+#include "task_server.h"
+#include "task_client.h"
+#include "task_manager.h"
+#include "mock_task_repository.h"
+#include "cli.h"
+#include "socket_io.h"
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+class TaskServerTest : public ::testing::Test {
+protected:
+    MockTaskRepository repo;
+    CLI cli;
+    std::string socketPath;
+
+    void SetUp() override {
+        if (!TaskServer::isSupported()) {
+            GTEST_SKIP() << "Unix domain sockets are not available";
+        }
+        // Keep the path short; socket addresses are limited to about 100 bytes
+        socketPath = (fs::temp_directory_path() / "task-manager-test.sock").string();
+        fs::remove(socketPath);
+    }
+
+    void TearDown() override {
+        fs::remove(socketPath);
+    }
+
+    // Forward a command line the way main does
+    std::optional<int> send(std::vector<const char*> args, std::ostream& out,
+                            std::istream& in = std::cin) {
+        args.insert(args.begin(), "task-manager");
+        char** argv = const_cast<char**>(args.data());
+        Command cmd = cli.parseCommand(static_cast<int>(args.size()), argv);
+        return TaskClient::forward(socketPath, cmd, static_cast<int>(args.size()), argv, out, in);
+    }
+};
+
+// Test forwarding reports that no server is running so the caller falls back
+TEST_F(TaskServerTest, ForwardWithoutServerFallsBack) {
+    std::stringstream out;
+
+    EXPECT_FALSE(send({"list"}, out).has_value());
+    EXPECT_TRUE(out.str().empty());
+}
+
+// Test only commands that touch the tasks are forwarded
+TEST_F(TaskServerTest, ShouldForwardTaskCommands) {
+    Command cmd;
+    cmd.type = CommandType::ADD;
+    EXPECT_TRUE(TaskClient::shouldForward(cmd));
+    cmd.type = CommandType::BATCH;
+    EXPECT_TRUE(TaskClient::shouldForward(cmd));
+    cmd.type = CommandType::SERVE;
+    EXPECT_FALSE(TaskClient::shouldForward(cmd));
+    cmd.type = CommandType::HELP;
+    EXPECT_FALSE(TaskClient::shouldForward(cmd));
+}
+
+#ifndef _WIN32
+// Test storage settings in the environment keep commands off the server
+TEST_F(TaskServerTest, LocalSettingsPreventForwarding) {
+    EXPECT_FALSE(TaskClient::hasLocalSettings());
+
+    ::setenv("TASK_MANAGER_SOCKET", socketPath.c_str(), 1);
+    EXPECT_FALSE(TaskClient::hasLocalSettings());
+
+    ::setenv("TASK_MANAGER_STORAGE", "paged", 1);
+    EXPECT_TRUE(TaskClient::hasLocalSettings());
+
+    ::unsetenv("TASK_MANAGER_STORAGE");
+    ::unsetenv("TASK_MANAGER_SOCKET");
+    EXPECT_FALSE(TaskClient::hasLocalSettings());
+}
+#endif // _WIN32
+
+// Test commands run against the resident manager and each change is saved
+// before the client hears back
+TEST_F(TaskServerTest, ServesCommandsAndSavesBeforeReplying) {
+    TaskManager manager(repo);
+    TaskServer server(manager, cli, socketPath);
+    server.start();
+    std::thread serverThread([&server] { server.run(); });
+
+    std::stringstream addOut;
+    EXPECT_EQ(send({"add", "Buy", "groceries"}, addOut), 0);
+    EXPECT_NE(addOut.str().find("Task added with ID: 1"), std::string::npos);
+    EXPECT_EQ(repo.getSaveCount(), 1);
+
+    std::stringstream completeOut;
+    EXPECT_EQ(send({"complete", "1"}, completeOut), 0);
+    EXPECT_EQ(repo.getSaveCount(), 2);
+
+    std::stringstream missingOut;
+    EXPECT_EQ(send({"complete", "42"}, missingOut), 1);
+    EXPECT_NE(missingOut.str().find("Task not found: 42"), std::string::npos);
+
+    std::stringstream listOut;
+    EXPECT_EQ(send({"list"}, listOut), 0);
+    EXPECT_NE(listOut.str().find("Buy groceries"), std::string::npos);
+
+    server.stop();
+    serverThread.join();
+
+    // Reads and failed changes write nothing
+    EXPECT_EQ(repo.getSaveCount(), 2);
+    EXPECT_EQ(server.getRequestCount(), 4);
+    TaskList saved = repo.loadTasks();
+    ASSERT_EQ(saved.size(), 1);
+    EXPECT_TRUE(saved[0].isCompleted());
+    EXPECT_FALSE(fs::exists(socketPath));
+}
+
+// Test a manager that does not save on its own still saves before the reply
+TEST_F(TaskServerTest, SavesPendingChangesBeforeReplying) {
+    TaskManager manager(repo);
+    manager.setAutoSave(false);
+    TaskServer server(manager, cli, socketPath);
+    server.start();
+    std::thread serverThread([&server] { server.run(); });
+
+    std::stringstream out;
+    EXPECT_EQ(send({"add", "First"}, out), 0);
+    EXPECT_EQ(repo.getSaveCount(), 1);
+    EXPECT_FALSE(manager.hasUnsavedChanges());
+
+    server.stop();
+    serverThread.join();
+}
+
+#ifndef _WIN32
+// Test a client that stalls part way through its request holds up only its
+// own connection
+TEST_F(TaskServerTest, StalledClientDoesNotBlockOthers) {
+    TaskManager manager(repo);
+    TaskServer server(manager, cli, socketPath);
+    server.start();
+    std::thread serverThread([&server] { server.run(); });
+
+    sockaddr_un address;
+    ASSERT_TRUE(socket_io::makeAddress(socketPath, address));
+    int stalled = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    ASSERT_GE(stalled, 0);
+    ASSERT_EQ(::connect(stalled, reinterpret_cast<sockaddr*>(&address), sizeof(address)), 0);
+    ASSERT_TRUE(socket_io::writeUint32(stalled, 2));
+
+    auto start = std::chrono::steady_clock::now();
+    std::stringstream out;
+    EXPECT_EQ(send({"add", "Served"}, out), 0);
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(2));
+    EXPECT_NE(out.str().find("Task added with ID: 1"), std::string::npos);
+
+    ::close(stalled);
+    server.stop();
+    serverThread.join();
+    EXPECT_EQ(server.getRequestCount(), 1);
+}
+#endif // _WIN32
+
+// Test batch scripts are read by the client and run by the server
+TEST_F(TaskServerTest, ForwardsBatchInput) {
+    TaskManager manager(repo);
+    TaskServer server(manager, cli, socketPath);
+    server.start();
+    std::thread serverThread([&server] { server.run(); });
+
+    std::istringstream script("add First task\nadd Second task\ncomplete 1\n");
+    std::stringstream out;
+    EXPECT_EQ(send({"batch"}, out, script), 0);
+
+    server.stop();
+    serverThread.join();
+
+    TaskList tasks = manager.listTasks();
+    ASSERT_EQ(tasks.size(), 2);
+    EXPECT_TRUE(tasks[0].isCompleted());
+    EXPECT_EQ(tasks[1].getDescription(), "Second task");
+}
+
+// Test an import larger than one chunk streams through to the server
+TEST_F(TaskServerTest, StreamsImportInput) {
+    TaskManager manager(repo);
+    TaskServer server(manager, cli, socketPath);
+    server.start();
+    std::thread serverThread([&server] { server.run(); });
+
+    std::stringstream csv;
+    csv << "id,description,completed\n";
+    for (int id = 1; id <= 20000; id++) {
+        csv << id << ",Imported task number " << id << ",false\n";
+    }
+    ASSERT_GT(csv.str().size(), 4 * 64 * 1024u);
+    std::stringstream out;
+    EXPECT_EQ(send({"import", "-"}, out, csv), 0);
+
+    server.stop();
+    serverThread.join();
+
+    EXPECT_NE(out.str().find("Imported 20000 tasks"), std::string::npos);
+    TaskList tasks = manager.listTasks();
+    ASSERT_EQ(tasks.size(), 20000);
+    EXPECT_EQ(tasks.back().getDescription(), "Imported task number 20000");
+}
+
+// Test output larger than a chunk streams back while input is still being sent
+TEST_F(TaskServerTest, StreamsOutputAlongsideInput) {
+    TaskManager manager(repo);
+    TaskServer server(manager, cli, socketPath);
+    server.start();
+    std::thread serverThread([&server] { server.run(); });
+
+    std::stringstream script;
+    for (int id = 1; id <= 20000; id++) {
+        script << "add Scripted task " << id << "\n";
+    }
+    std::stringstream batchOut;
+    EXPECT_EQ(send({"batch"}, batchOut, script), 0);
+    EXPECT_NE(batchOut.str().find("Task added with ID: 20000"), std::string::npos);
+
+    std::stringstream listOut;
+    EXPECT_EQ(send({"list"}, listOut), 0);
+
+    server.stop();
+    serverThread.join();
+
+    EXPECT_GT(listOut.str().size(), 4 * 64 * 1024u);
+    EXPECT_NE(listOut.str().find("[20000] [ ] Scripted task 20000\n"), std::string::npos);
+}
+
+// Test a relative export destination is sent as an absolute path
+TEST_F(TaskServerTest, ExportPathIsMadeAbsolute) {
+    TaskManager manager(repo);
+    manager.addTask("First");
+    TaskServer server(manager, cli, socketPath);
+    server.start();
+    std::thread serverThread([&server] { server.run(); });
+
+    std::stringstream out;
+    EXPECT_EQ(send({"export", "--format=ndjson", "test_server_export.ndjson"}, out), 0);
+
+    server.stop();
+    serverThread.join();
+
+    std::string expected = fs::absolute("test_server_export.ndjson").string();
+    EXPECT_NE(out.str().find("to " + expected), std::string::npos);
+    EXPECT_TRUE(fs::exists(expected));
+    fs::remove(expected);
+}
+
+// Test a second server cannot take over a socket that is in use
+TEST_F(TaskServerTest, StartFailsWhenServerIsRunning) {
+    TaskManager manager(repo);
+    TaskServer first(manager, cli, socketPath);
+    first.start();
+
+    TaskServer second(manager, cli, socketPath);
+    EXPECT_THROW(second.start(), std::runtime_error);
+}
+
+// Test a socket file left behind by a dead server is replaced
+TEST_F(TaskServerTest, StartReplacesStaleSocket) {
+    std::ofstream(socketPath) << "stale";
+
+    TaskManager manager(repo);
+    TaskServer server(manager, cli, socketPath);
+    EXPECT_NO_THROW(server.start());
+}
@@ -0,0 +1,121 @@
+#include <gtest/gtest.h>
+#include "task_snapshot.h"
+#include "task_manager.h"
+#include "mock_task_repository.h"
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+TaskList makeTasks(int count) {
+    TaskList tasks;
+    for (int id = 1; id <= count; id++) {
+        tasks.emplace_back(id, "Task " + std::to_string(id), false);
+    }
+    return tasks;
+}
+
+} // namespace
+
+// Test a snapshot keeps its version while the list changes in place and chunk by chunk
+TEST(TaskSnapshotTest, SnapshotKeepsItsVersion) {
+    constexpr int kTasks = 3 * static_cast<int>(TaskVersion::kChunkSize) + 10;
+    VersionedTaskList list;
+    list.assign(makeTasks(kTasks));
+
+    TaskSnapshot before = list.snapshot();
+    list.findForWrite(5)->setCompleted(true);
+    list.emplace_back(kTasks + 1, "Added", false);
+    TaskSnapshot after = list.snapshot();
+    list.findForWrite(kTasks)->setCompleted(true);
+    list.clear();
+
+    EXPECT_EQ(list.size(), 0u);
+    ASSERT_EQ(before.size(), static_cast<std::size_t>(kTasks));
+    EXPECT_FALSE(before.find(5)->isCompleted());
+    EXPECT_EQ(before.find(kTasks + 1), nullptr);
+
+    ASSERT_EQ(after.size(), static_cast<std::size_t>(kTasks + 1));
+    EXPECT_TRUE(after.find(5)->isCompleted());
+    EXPECT_FALSE(after.find(kTasks)->isCompleted());
+    EXPECT_EQ(after.find(kTasks + 1)->getDescription(), "Added");
+
+    int expected = 1;
+    for (const auto& task : after) {
+        EXPECT_EQ(task.getId(), expected++);
+    }
+    EXPECT_EQ(expected, kTasks + 2);
+    EXPECT_EQ(after.toList().size(), after.size());
+}
+
+// Test lookups across chunks, in order and out of order
+TEST(TaskSnapshotTest, FindAcrossChunks) {
+    VersionedTaskList list;
+    list.assign(makeTasks(5000));
+    EXPECT_TRUE(list.isSortedById());
+    EXPECT_EQ(list.find(1)->getId(), 1);
+    EXPECT_EQ(list.find(1024)->getId(), 1024);
+    EXPECT_EQ(list.find(1025)->getId(), 1025);
+    EXPECT_EQ(list.find(5000)->getId(), 5000);
+    EXPECT_EQ(list.find(0), nullptr);
+    EXPECT_EQ(list.find(5001), nullptr);
+
+    list.emplace_back(3, "Duplicate ID out of order", false);
+    EXPECT_FALSE(list.isSortedById());
+    EXPECT_EQ(list.find(4999)->getId(), 4999);
+    EXPECT_EQ(list.size(), 5001u);
+}
+
+// Test a manager's snapshot does not see later changes, and a visitor may change the manager
+TEST(TaskSnapshotTest, ManagerSnapshots) {
+    MockTaskRepository repo;
+    TaskManager manager(repo);
+    manager.addTask("First");
+    manager.addTask("Second");
+
+    TaskSnapshot snapshot = manager.snapshot();
+    manager.completeTask(1);
+    manager.addTask("Third");
+    EXPECT_EQ(snapshot.size(), 2u);
+    EXPECT_FALSE(snapshot.find(1)->isCompleted());
+
+    // Visits run over a snapshot, without holding the manager
+    int visited = 0;
+    manager.forEachTask([&](const TaskView& task) {
+        manager.completeTask(task.id);
+        visited++;
+    });
+    EXPECT_EQ(visited, 3);
+    EXPECT_TRUE(manager.findTask(3)->isCompleted());
+}
+
+// Test a writer keeps going while a reader walks a snapshot
+TEST(TaskSnapshotTest, ListingDoesNotBlockWriters) {
+    MockTaskRepository repo;
+    TaskManager manager(repo);
+    manager.setAutoSave(false);
+    manager.addTasks(makeTasks(2000));
+
+    std::atomic<bool> listing{false};
+    std::atomic<bool> written{false};
+    std::thread reader([&] {
+        manager.forEachTask([&](const TaskView&) {
+            listing.store(true);
+            // Holds the visit open until the writer got through
+            while (!written.load()) {
+                std::this_thread::yield();
+            }
+        });
+    });
+    while (!listing.load()) {
+        std::this_thread::yield();
+    }
+    EXPECT_TRUE(manager.completeTask(1));
+    EXPECT_EQ(manager.addTask("During listing"), 2001);
+    written.store(true);
+    reader.join();
+
+    EXPECT_EQ(manager.listTasks().size(), 2001u);
+}
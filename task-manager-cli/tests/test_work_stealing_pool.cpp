@@ -0,0 +1,245 @@
+#include <gtest/gtest.h>
+#include "work_stealing_pool.h"
+#include "file_task_repository.h"
+#include "repository_exceptions.h"
+#include "task_manager.h"
+#include "mock_task_repository.h"
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+std::string readFile(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+} // namespace
+
+// Test wait returns once every job of the group has run
+TEST(WorkStealingPoolTest, RunsEveryJobOfAGroup) {
+    WorkStealingPool pool(4);
+    std::atomic<int> ran{0};
+    TaskGroup group(&pool);
+    for (int i = 0; i < 1000; i++) {
+        group.run([&] {
+            ran++;
+        });
+    }
+    group.wait();
+    EXPECT_EQ(ran.load(), 1000);
+
+    // The group can be used again
+    group.run([&] {
+        ran++;
+    });
+    group.wait();
+    EXPECT_EQ(ran.load(), 1001);
+}
+
+// Test jobs waiting for groups of their own, more deeply than there are workers
+TEST(WorkStealingPoolTest, NestedGroupsDoNotDeadlock) {
+    WorkStealingPool pool(2);
+    std::atomic<int> leaves{0};
+    TaskGroup outer(&pool);
+    for (int i = 0; i < 8; i++) {
+        outer.run([&] {
+            TaskGroup middle(&pool);
+            for (int j = 0; j < 8; j++) {
+                middle.run([&] {
+                    parallelChunks(&pool, 64, 1, [&](std::size_t begin, std::size_t end) {
+                        leaves += static_cast<int>(end - begin);
+                    });
+                });
+            }
+            middle.wait();
+        });
+    }
+    outer.wait();
+    EXPECT_EQ(leaves.load(), 8 * 8 * 64);
+}
+
+// Test jobs spawned on one worker are stolen by the others
+TEST(WorkStealingPoolTest, IdleWorkersSteal) {
+    WorkStealingPool pool(4);
+    std::mutex mutex;
+    std::set<std::thread::id> threads;
+    TaskGroup group(&pool);
+    group.run([&] {
+        TaskGroup spawned(&pool);
+        for (int i = 0; i < 64; i++) {
+            spawned.run([&] {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                std::lock_guard<std::mutex> lock(mutex);
+                threads.insert(std::this_thread::get_id());
+            });
+        }
+        spawned.wait();
+    });
+    group.wait();
+
+    EXPECT_GT(threads.size(), 1u);
+    EXPECT_GT(pool.getStats().stolen, 0u);
+}
+
+// Test the first error reaches wait, after the other jobs have run
+TEST(WorkStealingPoolTest, WaitRethrowsFirstError) {
+    WorkStealingPool pool(3);
+    std::atomic<int> ran{0};
+    TaskGroup group(&pool);
+    for (int i = 0; i < 100; i++) {
+        group.run([&, i] {
+            ran++;
+            if (i == 50) {
+                throw std::runtime_error("Job failed");
+            }
+        });
+    }
+    EXPECT_THROW(group.wait(), std::runtime_error);
+    EXPECT_EQ(ran.load(), 100);
+    EXPECT_NO_THROW(group.wait());
+}
+
+// Test chunks cover the range once each, and run on the caller without a pool
+TEST(WorkStealingPoolTest, ParallelChunksCoverRange) {
+    WorkStealingPool pool(3);
+    std::vector<int> visits(10000, 0);
+    parallelChunks(&pool, visits.size(), 7, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; i++) {
+            visits[i]++;
+        }
+    });
+    for (int count : visits) {
+        ASSERT_EQ(count, 1);
+    }
+
+    std::vector<std::pair<std::size_t, std::size_t>> calls;
+    parallelChunks(nullptr, 10, 1, [&](std::size_t begin, std::size_t end) {
+        calls.emplace_back(begin, end);
+    });
+    ASSERT_EQ(calls.size(), 1u);
+    EXPECT_EQ(calls[0], std::make_pair(std::size_t{0}, std::size_t{10}));
+
+    TaskGroup direct(nullptr);
+    bool ran = false;
+    direct.run([&] {
+        ran = true;
+    });
+    EXPECT_TRUE(ran);
+}
+
+class ParallelRepositoryTest : public ::testing::Test {
+protected:
+    std::string tasksPath = "test_parallel_tasks.json";
+
+    void SetUp() override {
+        TearDown();
+    }
+
+    void TearDown() override {
+        fs::remove(tasksPath);
+        fs::remove(tasksPath + ".lock");
+    }
+
+    // Enough tasks to pass both thresholds, with descriptions that need escaping
+    static TaskList makeTasks() {
+        TaskList tasks;
+        for (int id = 1; id <= 20000; id++) {
+            std::string description = "Task " + std::to_string(id);
+            if (id % 3 == 0) {
+                description += " with \"quotes\", [brackets], {braces} and a \\ backslash";
+            }
+            if (id % 7 == 0) {
+                description += " café\n";
+            }
+            tasks.emplace_back(id, description, id % 2 == 0);
+        }
+        return tasks;
+    }
+};
+
+// Test a file parsed and formatted on the pool matches one done on a single thread
+TEST_F(ParallelRepositoryTest, LoadAndSaveMatchSingleThread) {
+    TaskList tasks = makeTasks();
+    {
+        FileTaskRepository repository(tasksPath);
+        repository.saveTasks(tasks);
+    }
+    std::string sequential = readFile(tasksPath);
+    ASSERT_GE(sequential.size(), FileTaskRepository::kParallelLoadBytes);
+
+    WorkStealingPool pool(4);
+    FileTaskRepository repository(tasksPath);
+    repository.setThreadPool(&pool);
+    TaskList loaded = repository.loadTasks();
+    ASSERT_EQ(loaded.size(), tasks.size());
+    for (std::size_t i = 0; i < tasks.size(); i++) {
+        ASSERT_EQ(loaded[i].getId(), tasks[i].getId());
+        ASSERT_EQ(loaded[i].getDescription(), tasks[i].getDescription());
+        ASSERT_EQ(loaded[i].isCompleted(), tasks[i].isCompleted());
+    }
+    EXPECT_EQ(repository.getNextId(), 20001);
+    EXPECT_GT(pool.getStats().jobs, 0u);
+
+    repository.saveTasks(loaded);
+    EXPECT_EQ(readFile(tasksPath), sequential);
+
+    // A snapshot is formatted a chunk at a time
+    TaskManager manager(repository);
+    manager.load();
+    repository.saveSnapshot(manager.snapshot());
+    EXPECT_EQ(readFile(tasksPath), sequential);
+}
+
+// Test a malformed task in a large file is reported as on a single thread
+TEST_F(ParallelRepositoryTest, MalformedPieceFailsLoad) {
+    {
+        FileTaskRepository repository(tasksPath);
+        repository.saveTasks(makeTasks());
+    }
+    std::string text = readFile(tasksPath);
+    std::size_t middle = text.find("\"id\": 10000");
+    ASSERT_NE(middle, std::string::npos);
+    text.replace(middle, 11, "\"id\": 10000,,");
+    std::ofstream(tasksPath, std::ios::binary) << text;
+
+    WorkStealingPool pool(4);
+    FileTaskRepository repository(tasksPath);
+    repository.setThreadPool(&pool);
+    EXPECT_THROW(repository.loadTasks(), JsonParseException);
+}
+
+// Test a search over many chunks on the pool finds what a single thread does
+TEST(ParallelSearchTest, SearchMatchesSingleThread) {
+    MockTaskRepository repo;
+    TaskManager manager(repo);
+    TaskList tasks;
+    for (int i = 1; i <= 20000; i++) {
+        tasks.emplace_back(0, i % 7 == 0 ? "Buy Milk " + std::to_string(i) : "Task " + std::to_string(i), false);
+    }
+    manager.addTasks(tasks);
+
+    TaskList sequential = manager.searchTasks("milk");
+    WorkStealingPool pool(4);
+    manager.setThreadPool(&pool);
+    TaskList parallel = manager.searchTasks("milk");
+
+    ASSERT_EQ(sequential.size(), 20000u / 7);
+    ASSERT_EQ(parallel.size(), sequential.size());
+    for (std::size_t i = 0; i < parallel.size(); i++) {
+        EXPECT_EQ(parallel[i].getId(), sequential[i].getId());
+    }
+    EXPECT_EQ(parallel[0].getDescription(), "Buy Milk 7");
+    EXPECT_TRUE(manager.searchTasks("no such task").empty());
+}